@@ -0,0 +1,87 @@
+/*
+ * Fimex, CDMCachingReader.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef CDMCACHINGREADER_H_
+#define CDMCACHINGREADER_H_
+
+#include "fimex/CDMReader.h"
+
+#include <memory>
+
+namespace MetNoFimex {
+
+/**
+ * @headerfile fimex/CDMCachingReader.h
+ */
+/**
+ * Pass-through reader keeping the most recently read data-slices in memory.
+ *
+ * Readers further down in a chain often request the same slices several times,
+ * e.g. both components of a vector, the previous time-step for de-accumulation,
+ * or the same surface-pressure for several vertical interpolations. Placing
+ * a CDMCachingReader in front of such a reader serves repeated requests
+ * from memory.
+ *
+ * Slices are cached by variable name and unlimited-position or SliceBuilder
+ * start/size, up to a total size in bytes. The least recently used slices
+ * are evicted first. All slices are returned as copies, so callers may modify
+ * the data.
+ */
+class CDMCachingReader : public CDMReader
+{
+public:
+    struct Statistics
+    {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t bytes;    //!< currently cached bytes
+        size_t maxBytes; //!< maximum size of the cache
+    };
+
+    /**
+     * @param dataReader the reader to cache
+     * @param maxBytes the maximum size of all cached slices, 0 disables caching
+     */
+    CDMCachingReader(CDMReader_p dataReader, size_t maxBytes);
+    ~CDMCachingReader();
+
+    DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos) override;
+    DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb) override;
+
+    /** @return hit/miss statistics of the cache */
+    Statistics getStatistics() const;
+
+    /** remove all cached slices */
+    void clear();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> p_;
+};
+
+typedef std::shared_ptr<CDMCachingReader> CDMCachingReader_p;
+
+} // namespace MetNoFimex
+
+#endif /* CDMCACHINGREADER_H_ */
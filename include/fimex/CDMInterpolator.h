@@ -104,6 +104,9 @@ private:
     void changeProjectionByProjectionParameters(int method, const std::string& proj_input, const std::vector<double>& out_x_axis, const std::vector<double>& out_y_axis, const std::string& out_x_axis_unit, const std::string& out_y_axis_unit, CDMDataType out_x_axis_type, CDMDataType out_y_axis_type);
     void changeProjectionByCoordinates(int method, const std::string& proj_input, const std::vector<double>& out_x_axis, const std::vector<double>& out_y_axis, const std::string& out_x_axis_unit, const std::string& out_y_axis_unit, CDMDataType out_x_axis_type, CDMDataType out_y_axis_type);
     void changeProjectionByForwardInterpolation(int method, const std::string& proj_input, const std::vector<double>& out_x_axis, const std::vector<double>& out_y_axis, const std::string& out_x_axis_unit, const std::string& out_y_axis_unit, CDMDataType out_x_axis_type, CDMDataType out_y_axis_type);
+    void changeProjectionByConservativeRemapping(const std::string& proj_input, const std::vector<double>& out_x_axis, const std::vector<double>& out_y_axis,
+                                                 const std::string& out_x_axis_unit, const std::string& out_y_axis_unit, CDMDataType out_x_axis_type,
+                                                 CDMDataType out_y_axis_type);
 
     void changeProjectionByProjectionParametersToLatLonTemplate(int method,
                                                                 const std::string& proj_input,
@@ -134,6 +137,16 @@ private:
      */
     void warnUnlessAllXYSpatialVectorsHaveSameHorizontalId(const std::string& horizontalId) const;
 
+    /**
+     * @return the interpolation of a projected variable, or a 0-pointer if the variable is not projected
+     */
+    CachedInterpolationInterface_p findCachedInterpolation(const std::string& varName) const;
+
+    /**
+     * interpolate the input data of a projected variable, as read by ci->getInputDataSlice
+     */
+    DataPtr interpolateSlice(const std::string& varName, const SliceBuilder& sb, CachedInterpolationInterface_p ci, DataPtr data);
+
 public:
     CDMInterpolator(CDMReader_p dataReader);
     virtual ~CDMInterpolator();
@@ -148,6 +161,11 @@ public:
      *
      */
     virtual DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb);
+    /**
+     * @brief retrieve the input data of all requests with one call to the underlying
+     * dataReader and interpolate the slices in parallel
+     */
+    std::vector<DataPtr> getDataSlices(const DataSliceRequest_v& requests) override;
 
     /**
      * @brief change the (main) projection of the dataReaders cdm to this new projection
@@ -275,6 +293,15 @@ public:
      * @param dist distance in meter
      */
     virtual void setDistanceOfInterest(double dist);
+    /**
+     * set a directory to persistently cache interpolation weights between runs
+     * with the same input and output grids. An empty directory disables the cache.
+     * To have effect, this function must be set before calling changeProjection()
+     *
+     * @param directory existing, writable directory
+     * @throw CDMException if the directory does not exist
+     */
+    virtual void setWeightsCacheDirectory(const std::string& directory);
     /**
      * add a process to the internal list of preprocesses, run on fields before interpolation
      *
@@ -290,7 +317,11 @@ public:
 };
 
 /**
- * convert the data inplace to an array useful for interpolation (i.e. badValue->nan)
+ * convert the data to an array useful for interpolation (i.e. badValue->nan)
+ *
+ * The conversion is done inplace if inData is float and does not share its
+ * memory with slices, see Data::asFloat(). Use only the returned array,
+ * inData might or might not be changed.
  * @param inData
  * @param badValue
  * @return
@@ -299,6 +330,8 @@ extern shared_array<float> data2InterpolationArray(const DataPtr& inData, double
 
 /**
  * convert the data from an interpolation-array (with NaNs) to one used as DataPtr, e.g. correct datatype and badvalue/fillvalue
+ *
+ * For newType CDM_FLOAT, iData is converted inplace and used by the returned data.
  * @param newType
  * @param iData
  * @param size
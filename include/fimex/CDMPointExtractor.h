@@ -0,0 +1,84 @@
+/*
+ * Fimex, CDMPointExtractor.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef CDMPOINTEXTRACTOR_H_
+#define CDMPOINTEXTRACTOR_H_
+
+#include "fimex/CDMReader.h"
+
+#include <memory>
+#include <vector>
+
+namespace MetNoFimex {
+
+/**
+ * @headerfile fimex/CDMPointExtractor.h
+ */
+/**
+ * Extract time-series at a list of points (stations) from gridded data.
+ *
+ * The grid cells enclosing each point and their weights are computed once
+ * from the longitude/latitude of the grid, using a kd-tree, so that any grid
+ * with known coordinates, e.g. curvilinear model grids, can be used. The
+ * horizontal dimensions of all gridded variables are replaced by a single
+ * point-dimension, and the points get the variables longitude and latitude.
+ *
+ * When reading, only small boxes of the grid around groups of nearby points
+ * are read from the input, so the amount of input data grows with the number
+ * of points, and not with the size of the grid.
+ *
+ * Vectors in x/y direction stay relative to the input grid.
+ */
+class CDMPointExtractor : public CDMReader
+{
+public:
+    /**
+     * @param dataReader the gridded input
+     * @param method MIFI_INTERPOL_NEAREST_NEIGHBOR or MIFI_INTERPOL_BILINEAR
+     * @param lonVals longitudes of the points in degrees_east
+     * @param latVals latitudes of the points in degrees_north
+     * @param pointDimName name of the new dimension of the points
+     * @throw CDMException if no horizontal coordinate system with longitude and latitude is found
+     */
+    CDMPointExtractor(CDMReader_p dataReader, int method, const std::vector<double>& lonVals, const std::vector<double>& latVals,
+                      const std::string& pointDimName = "station");
+    ~CDMPointExtractor();
+
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos = 0) override;
+    DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb) override;
+    /**
+     * @brief read the input of all requests with one call to the underlying dataReader
+     */
+    std::vector<DataPtr> getDataSlices(const DataSliceRequest_v& requests) override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> p_;
+};
+
+typedef std::shared_ptr<CDMPointExtractor> CDMPointExtractor_p;
+
+} // namespace MetNoFimex
+
+#endif /* CDMPOINTEXTRACTOR_H_ */
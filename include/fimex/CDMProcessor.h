@@ -52,6 +52,8 @@ public:
      * mark a variable for accumulation along the unlimited dimension, i.e.
      * vnew(0) = vold(0)
      * vnew(n) = vold(n)+vold(n-1)
+     * The running sum is kept per variable, so reading the time steps in
+     * order reads each input slice only once.
      * @param varName name of the variable to de-accumulate
      * @warning does not handle fill-values unless those are NaNs
      */
@@ -59,6 +61,8 @@ public:
     /**
      * mark a variable for de-accumulation along the unlimited dimension, i.e.
      * vnew(n) = vold(n)-vold(n-1)
+     * The last input slice is kept per variable, so reading the time steps
+     * in order reads each input slice only once.
      * @param varName name of the variable to de-accumulate
      * @warning does not handle fill-values unless those are NaNs
      */
@@ -87,6 +91,11 @@ public:
     virtual DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos);
 
 private:
+    template <typename T>
+    DataPtr accumulateSlice(const std::string& varName, size_t unLimDimPos, DataPtr data);
+    template <typename T>
+    DataPtr deAccumulateSlice(const std::string& varName, size_t unLimDimPos, DataPtr data, bool keepSlice);
+
     struct CDMProcessorImpl;
     std::unique_ptr<CDMProcessorImpl> p_;
 };
@@ -26,9 +26,11 @@
 
 #include "fimex/CDMReaderDecl.h"
 #include "fimex/DataDecl.h"
+#include "fimex/SliceBuilder.h"
 #include "fimex/UnitsConverterDecl.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace MetNoFimex
@@ -36,7 +38,24 @@ namespace MetNoFimex
 /* forward declarations */
 class CDM;
 class CDMVariable;
-class SliceBuilder;
+
+/**
+ * @headerfile fimex/CDMReader.h
+ */
+/**
+ * @brief request of a data-slice of a variable, see CDMReader::getDataSlices
+ */
+struct DataSliceRequest
+{
+    DataSliceRequest(const std::string& varName, const SliceBuilder& sb)
+        : varName(varName)
+        , sb(sb)
+    {
+    }
+    std::string varName;
+    SliceBuilder sb;
+};
+typedef std::vector<DataSliceRequest> DataSliceRequest_v;
 
 /**
  * @headerfile fimex/CDMReader.h
@@ -119,6 +138,19 @@ public:
      */
     virtual DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb);
 
+    /**
+     * @brief read several data-slices at once
+     *
+     * Readers may use the knowledge of all requested slices, e.g. to share work
+     * between the variables, to read in file order, or to evaluate the variables
+     * in parallel. The default implementation reads the slices one by one.
+     *
+     * @param requests variables and SliceBuilders generated from this CDMReaders CDM
+     * @return the data of each request, in the order of the requests
+     * @throw CDMException as getDataSlice
+     */
+    virtual std::vector<DataPtr> getDataSlices(const DataSliceRequest_v& requests);
+
     /**
      * @brief data-reading function to be called from the CDMWriter
      *
@@ -219,6 +251,19 @@ protected:
 
     virtual DataPtr getDataSliceFromMemory(const CDMVariable& variable, const SliceBuilder& sb);
 
+    /**
+     * Read one request of getDataSlices. A complete slice along the unlimited
+     * dimension is read with getDataSlice(varName, unLimDimPos), other requests with
+     * getDataSlice(varName, sb).
+     */
+    DataPtr readDataSliceRequest(const DataSliceRequest& request);
+
+    /**
+     * Read all requests with readDataSliceRequest, in parallel when compiled with OpenMP.
+     * This can be used to implement getDataSlices for thread-safe readers.
+     */
+    std::vector<DataPtr> readDataSliceRequestsParallel(const DataSliceRequest_v& requests);
+
     void getScaleAndOffsetOf(const std::string& varName, double& scale, double& offset) const;
 
 private:
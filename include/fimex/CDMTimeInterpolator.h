@@ -31,6 +31,7 @@
 #include "fimex/coordSys/CoordSysDecl.h"
 
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace MetNoFimex {
@@ -54,6 +55,15 @@ public:
      */
     DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos = 0) override;
 
+    /**
+     * @brief retrieve data from the underlying dataReader and interpolate the values to the new time-axis
+     *
+     * Only the requested subset of the bracketing input time-steps is read,
+     * and input time-steps are read only once per request.
+     * The time-axis does not need to be the unlimited dimension.
+     */
+    DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb) override;
+
     /**
      * change the time-axis from from the one given to a new specification
      * @param timeSpec string of time-specification
@@ -62,7 +72,29 @@ public:
      */
     virtual void changeTimeAxis(const std::string& timeSpec);
 
+    /**
+     * Keep the input time-steps of the current time-interval in memory, so that
+     * consecutive output time-steps between the same two input time-steps read
+     * them only once. One time-window is kept per variable and spatial subset,
+     * the least recently used windows are dropped when the memory limit is
+     * exceeded. The window is dropped after the last output time-step.
+     *
+     * @param maxBytes maximum memory of all time-windows, 0 disables the cache; default is 64MB
+     */
+    void setTimeWindowCacheSize(size_t maxBytes);
+
+    /**
+     * In batch mode, a request for one output time-step interpolates all output
+     * time-steps between the same two input time-steps at once. The other output
+     * time-steps are kept in the time-window cache until they are requested.
+     * Default is off.
+     */
+    void setBatchMode(bool batch);
+
 private:
+    DataPtr getTimeDataSlice(const std::string& varName, const std::string& timeAxis, const SliceBuilder& sb);
+    DataPtr interpolateTimeSteps(const std::string& varName, const std::string& timeAxis, const std::string& key, const SliceBuilder& sb);
+
     CDMReader_p dataReader_;
 
     // map each new time-position to the closest time-positions in the old times
@@ -73,6 +105,9 @@ private:
 
     // store the datareaders times as doubles of the new units
     std::map<std::string, std::vector<double> > dataReaderTimesInNewUnits_;
+
+    struct Impl;
+    std::unique_ptr<Impl> p_;
 };
 
 } // namespace MetNoFimex
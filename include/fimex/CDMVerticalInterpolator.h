@@ -77,8 +77,23 @@ public:
      */
     virtual DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos = 0);
 
+    /**
+     * retrieve data from the underlying dataReader and interpolate the values to the new vertical levels
+     *
+     * Only the columns and levels in the slice are read and interpolated.
+     */
+    virtual DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb);
+
+    /**
+     * Forward the requests without vertical change to the dataReader in one call, and
+     * interpolate the other requests in parallel. The first request of each coordinate
+     * system is interpolated before the others, so that the others can reuse its
+     * interpolation plan.
+     */
+    std::vector<DataPtr> getDataSlices(const DataSliceRequest_v& requests) override;
+
 private:
-    DataPtr getLevelDataSlice(CoordinateSystem_cp cs, const std::string& varName, size_t unLimDimPos);
+    DataPtr getLevelDataSlice(CoordinateSystem_cp cs, const std::string& varName, const SliceBuilder& sb);
 
 private:
     CDMReader_p dataReader_;
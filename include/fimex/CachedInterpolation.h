@@ -29,10 +29,16 @@
 #include "fimex/SliceBuilder.h"
 
 #include "fimex/SharedArray.h"
+#include "fimex/SparseInterpolationMatrix.h"
+
+#include <cstdint>
+#include <iosfwd>
 
 namespace MetNoFimex
 {
 
+class CDM;
+
 /**
  * @headerfile fimex/CachedInterpolation.h
  */
@@ -72,6 +78,19 @@ public:
     /** @return y-size of output array */
     size_t getOutY() const { return outY; }
 
+    /** @return name of the x-dimension of the input */
+    const std::string& getXDimName() const { return _xDimName; }
+
+    /** @return name of the y-dimension of the input */
+    const std::string& getYDimName() const { return _yDimName; }
+
+    /**
+     * Express this interpolation as a sparse matrix from the (reduced) input layer to the output layer.
+     *
+     * @return the matrix, or 0 if the interpolation is not linear, e.g. a forward median
+     */
+    virtual SparseInterpolationMatrix_cp sparseMatrix() const;
+
     /**
      * Read the input data from the reader, which is later used for the interpolateValues() function. This function will eventually reduce the
      * domain of the input data if createReducedDomain was called earlier.
@@ -92,6 +111,15 @@ public:
      */
     virtual DataPtr getInputDataSlice(CDMReader_p reader, const std::string& varName, const SliceBuilder& sb) const;
 
+    /**
+     * Create the slicebuilder used by getInputDataSlice(reader, varName, sb).
+     * @param inputCdm the cdm of the input reader
+     * @param varName
+     * @param sb a slicebuilder to reduce other than the horizontal dimensions
+     * @return slicebuilder for inputCdm
+     */
+    SliceBuilder getInputSliceBuilder(const CDM& inputCdm, const std::string& varName, const SliceBuilder& sb) const;
+
     virtual DataPtr getOutputDataSlice(DataPtr data, const SliceBuilder& sb) const;
 
     /**
@@ -100,6 +128,32 @@ public:
      */
     ReducedInterpolationDomain_p reducedDomain() const { return reducedDomain_; }
 
+    /**
+     * Check if this interpolation can be written with write().
+     */
+    bool isSerializable() const { return serializationType() != 0; }
+
+    /**
+     * Write the complete state of this interpolation, including the reduced domain,
+     * to a versioned binary stream. It can be restored with readCachedInterpolation().
+     *
+     * @param out binary output stream
+     * @throw CDMException if this interpolation cannot be serialized
+     */
+    void write(std::ostream& out) const;
+
+protected:
+    /**
+     * @return a unique, non-zero id of the serialized interpolation type, or 0 if serialization is not supported;
+     * by default, linear interpolations are serialized as sparse matrix
+     */
+    virtual int serializationType() const;
+
+    /**
+     * Write the method-specific state, called by write() after the common part.
+     */
+    virtual void writeWeights(std::ostream& out) const;
+
 private:
     std::string _xDimName, _yDimName;
 
@@ -117,16 +171,43 @@ CachedInterpolationInterface_p createCachedInterpolation(const std::string& xDim
                                                          const std::vector<double>& pointsOnXAxis, const std::vector<double>& pointsOnYAxis, size_t inX,
                                                          size_t inY, size_t outX, size_t outY);
 
+/**
+ * Restore a CachedInterpolationInterface written with CachedInterpolationInterface::write().
+ *
+ * @param data start of the serialized interpolation, e.g. a memory-mapped file
+ * @param size number of bytes available at data
+ * @throw CDMException if the data is truncated, has an unknown format version or an unknown interpolation type
+ */
+CachedInterpolationInterface_p readCachedInterpolation(const char* data, size_t size);
+
+/**
+ * Convert a linear interpolation to a CachedSparseInterpolation.
+ *
+ * @throw CDMException if the interpolation is not linear
+ */
+CachedInterpolationInterface_p createSparseInterpolation(const CachedInterpolationInterface& ci);
+
 /**
  * Container to cache projection details to speed up
  * interpolation of lots of fields.
+ *
+ * The input offsets and the separable weights of each output point are
+ * computed once. Output points are then interpolated in cache-sized tiles,
+ * for all z-levels of a tile before the next tile, with contiguous writes.
  */
 class CachedInterpolation : public CachedInterpolationInterface
 {
 private:
     std::vector<double> pointsOnXAxis;
     std::vector<double> pointsOnYAxis;
-    int (*func)(const float* infield, float* outvalues, const double x, const double y, const int ix, const int iy, const int iz);
+    int funcType;
+    //! position of the lower-left input point of each output point
+    std::vector<uint32_t> offsets_;
+    //! bilinear only, neighbours used by each output point, see InterpolationKernels.h
+    std::vector<uint8_t> steps_;
+    //! weight planes of size outX*outY, 2 (x, y) for bilinear, 8 (4 x, 4 y) for bicubic
+    std::vector<float> weights_;
+
 public:
     /**
      * @param funcType {@link interpolation.h} interpolation method
@@ -141,6 +222,15 @@ public:
                         const std::vector<double> &pointsOnXAxis, const std::vector<double> &pointsOnYAxis,
                         size_t inX, size_t inY, size_t outX, size_t outY);
 
+    /**
+     * Restore a CachedInterpolation with an already reduced input domain, e.g. from readCachedInterpolation().
+     *
+     * @param reducedDomain the reduced domain, pointsOnXAxis/pointsOnYAxis and inX/inY are relative to this domain; may be 0
+     */
+    CachedInterpolation(const std::string& xDimName, const std::string& yDimName, int funcType, const std::vector<double>& pointsOnXAxis,
+                        const std::vector<double>& pointsOnYAxis, size_t inX, size_t inY, size_t outX, size_t outY,
+                        ReducedInterpolationDomain_p reducedDomain);
+
     /**
      * Actually interpolate the data. The data will be interpolated as floats internally.
      *
@@ -150,7 +240,21 @@ public:
      */
     shared_array<float> interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const override;
 
+    SparseInterpolationMatrix_cp sparseMatrix() const override;
+
+protected:
+    int serializationType() const override;
+    void writeWeights(std::ostream& out) const override;
+
 private:
+    /**
+     * Compute offsets and weights from pointsOnXAxis and pointsOnYAxis.
+     * It must be run after the domain has been reduced.
+     */
+    void initWeights();
+    void initBilinearWeights();
+    void initBicubicWeights();
+
     /**
      * Create a reduced domain for later generation of a slicebuild to read a smaller domain.
      * It should be run immediately after creating the CachedInterpolation.
@@ -179,6 +283,15 @@ public:
     CachedNNInterpolation(const std::string& xDimName, const std::string& yDimName, const std::vector<double>& pointsOnXAxis,
                           const std::vector<double>& pointsOnYAxis, size_t inX, size_t inY, size_t outX, size_t outY);
 
+    /**
+     * Restore a CachedNNInterpolation, e.g. from readCachedInterpolation().
+     *
+     * @param pointsInIn position in the (reduced) input layer for each output point
+     * @param reducedDomain the reduced domain, pointsInIn and inX/inY are relative to this domain; may be 0
+     */
+    CachedNNInterpolation(const std::string& xDimName, const std::string& yDimName, const std::vector<size_t>& pointsInIn, size_t inX, size_t inY,
+                          size_t outX, size_t outY, ReducedInterpolationDomain_p reducedDomain);
+
     /**
      * Actually interpolate the data. The data will be interpolated as floats internally.
      *
@@ -187,6 +300,42 @@ public:
      * @param newSize return the size of the output-array
      */
     shared_array<float> interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const override;
+
+    SparseInterpolationMatrix_cp sparseMatrix() const override;
+
+protected:
+    int serializationType() const override;
+    void writeWeights(std::ostream& out) const override;
+};
+
+/**
+ * Interpolation with a sparse matrix, e.g. restored from a serialized linear
+ * interpolation without an own serialization type, or from createSparseInterpolation().
+ */
+class CachedSparseInterpolation : public CachedInterpolationInterface
+{
+public:
+    /**
+     * @param matrix the interpolation matrix from the (reduced) input layer of size inX*inY to the output layer of size outX*outY
+     * @param reducedDomain the reduced domain, inX/inY are relative to this domain; may be 0
+     * @throw CDMException if the matrix size does not match the input and output sizes
+     */
+    CachedSparseInterpolation(const std::string& xDimName, const std::string& yDimName, SparseInterpolationMatrix_cp matrix, size_t inX, size_t inY,
+                              size_t outX, size_t outY, ReducedInterpolationDomain_p reducedDomain);
+
+    /**
+     * Actually interpolate the data. The data will be interpolated as floats internally.
+     *
+     * @param inData the input data
+     * @param size the size of the input data array
+     * @param newSize return the size of the output-array
+     */
+    shared_array<float> interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const override;
+
+    SparseInterpolationMatrix_cp sparseMatrix() const override;
+
+private:
+    SparseInterpolationMatrix_cp matrix_;
 };
 
 } // namespace MetNoFimex
@@ -61,6 +61,15 @@ public:
     /// @brief printing of the current data to ostream, with optional separator
     virtual void toStream(std::ostream&, const std::string& separator = "") const = 0;
 
+    /*
+     * The asXXX() functions return a new array if the type differs from the
+     * datatype, and the memory of the data otherwise. Memory shared with
+     * slices of the data, see slice(), is always copied, so that writing into
+     * the returned array cannot change other Data. Writing into the returned
+     * array changes this Data only for the same type and without shared
+     * memory; use getDataPtr() or setValues() to modify the data.
+     */
+
     /// @brief retrieve data as char
     virtual shared_array<char> asChar() const = 0;
 
@@ -143,6 +152,10 @@ public:
          * All parameters must be vectors of the same size (dimension of array).
          * The first dimension is the fastest moving index (fortran arrays)
          *
+         * If the slice is a contiguous part of the data, the returned data shares
+         * the memory with this data. Modifications of either data copy the memory
+         * before writing (copy-on-write), so the result behaves like a copy.
+         *
          * @param orgDimSize the dimensions of this vector. The product of all orgDimSizes must equal to data.size.
          * @param startDims The start-position in the original data to fetch data from
          * @param outputDimSize the size of the output data
@@ -104,7 +104,7 @@ find_closest_neighbor_distinct_elements(InputIterator start, InputIterator end,
     const double maxDiff = std::numeric_limits<value_t>::max();
     if (lowDiff < 0)
         lowDiff = maxDiff;
-    if (highDiff < 0)
+    if (highDiff <= 0) // x == *start is not a higher neighbor
         highDiff = maxDiff;
     while (++cur != end) {
         const value_t diff = x - *cur;
@@ -63,6 +63,10 @@ public:
     virtual ~GribCDMReader();
     virtual DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos);
     virtual DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb);
+    /**
+     * Read the requests in the order of their grib-messages in the files.
+     */
+    std::vector<DataPtr> getDataSlices(const DataSliceRequest_v& requests) override;
     /**
      * Read a initialized cdmGribReader xml-document
      * @param configXML
@@ -104,6 +108,15 @@ private:
      * @param select can be "all", "definedOnly"
      */
     void initSelectParameters(const std::string& select);
+
+    /**
+     * find the messages of all xy-layers of a slice, invalid messages for missing layers
+     */
+    std::vector<GribFileMessage> findSliceMessages(const std::string& varName, const SliceBuilder& sb) const;
+    /**
+     * read the messages found by findSliceMessages
+     */
+    DataPtr readSliceMessages(const std::string& varName, const SliceBuilder& sb, const std::vector<GribFileMessage>& slices);
     /**
      * find the node in the xml-config corresponding to the GribFileMessage
      * @return 0 if not found, otherwise a valid node
@@ -34,6 +34,7 @@
 #include <cstdio>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <regex>
 #include <vector>
 
@@ -44,6 +45,38 @@ struct grib_handle;
 
 namespace MetNoFimex {
 
+/**
+ * Cache of memory-mapped grib-files, avoiding to re-open and re-read
+ * a file for each message. Files stay mapped as long as the cache exists.
+ * The cache may be shared between threads.
+ */
+class GribFileCache
+{
+public:
+    GribFileCache();
+    ~GribFileCache();
+
+    /**
+     * Map a file into memory, or get the existing mapping. The file is
+     * mapped again if the existing mapping is smaller than minSize, i.e. the
+     * file has grown. The size is not checked otherwise, so a file must not be
+     * truncated while it is mapped.
+     *
+     * @param fileName the local filename, without 'file:' prefix
+     * @param minSize the size needed by the read, e.g. the message position + 1
+     * @param size output, the size of the mapping
+     * @return the start of the file in memory, or 0 if the file cannot be mapped
+     */
+    const char* map(const std::string& fileName, size_t minSize, size_t& size);
+
+private:
+    GribFileCache(const GribFileCache&) = delete;
+    GribFileCache& operator=(const GribFileCache&) = delete;
+
+    struct Impl;
+    std::unique_ptr<Impl> p_;
+};
+
 class GribFileMessage
 {
 public:
@@ -111,6 +144,20 @@ public:
      * @return the actual amount of data read
      */
     size_t readData(std::vector<double>& data, double missingValue) const;
+    /**
+     * Read the data as readData(), but take the message from a file in the cache, which
+     * avoids opening the file for each message.
+     */
+    size_t readData(std::vector<double>& data, double missingValue, GribFileCache& cache) const;
+    /**
+     * Read the data as readData(), but directly into the memory at data.
+     * @param data the storage the data will be read to
+     * @param size the maximum number of values to read
+     * @param missingValue the missing- / fill-value the returned data will have
+     * @param cache cache of open files
+     * @return the actual amount of data read
+     */
+    size_t readData(double* data, size_t size, double missingValue, GribFileCache& cache) const;
     /**
      * Read the level-data from the underlying source to the vector levelData. In contrast to readData(), the
      * levelData does not need to be pre-allocated, since levelData usually are small (a few hundred (in grib1 limited to 256)).
@@ -120,6 +167,10 @@ public:
      */
     size_t readLevelData(std::vector<double>& levelData, double missingValue, bool asimofHeader=false) const;
 private:
+    /// open the grib-handle of this message, using the cache if not null
+    std::shared_ptr<grib_handle> openHandle(GribFileCache* cache) const;
+    size_t readData(double* data, size_t size, double missingValue, GribFileCache* cache) const;
+
     std::string fileURL_;
     off_t filePos_;
     size_t msgPos_; // for multiMessages: multimessages
@@ -56,6 +56,10 @@ public:
     virtual ~NetCDF_CDMReader();
     virtual DataPtr getDataSlice(const std::string& varName, size_t unLimDimPos);
     virtual DataPtr getDataSlice(const std::string& varName, const SliceBuilder& sb);
+    /**
+     * @brief read the requests of each variable in file order, coalescing requests within the same chunks
+     */
+    virtual std::vector<DataPtr> getDataSlices(const DataSliceRequest_v& requests);
     virtual void sync();
     virtual void putDataSlice(const std::string& varName, size_t unLimDimPos, const DataPtr data);
     virtual void putDataSlice(const std::string& varName, const SliceBuilder& sb, const DataPtr data);
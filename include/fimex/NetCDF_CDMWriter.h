@@ -28,6 +28,7 @@
 #include "fimex/CDM.h"
 #include <map>
 #include <string>
+#include <vector>
 
 namespace MetNoFimex
 {
@@ -84,6 +85,18 @@ private:
     NcVarIdMap defineVariables(const NcDimIdMap& dimMap);
     void writeAttributes(const NcVarIdMap& varMap);
     void writeData(const NcVarIdMap& varMap);
+    //! write data with read-ahead of up to readAheadBytes, reading and writing in parallel
+    void writeDataPipelined(const NcVarIdMap& varMap);
+
+    struct SliceTask;
+    struct BatchBudget;
+    bool initSliceTask(SliceTask& task, const CDMVariable& var, int varId, long long unLimDimPos, int unLimDimId);
+    DataPtr readSlice(const SliceTask& task);
+    //! convert data read for the task to the output
+    DataPtr prepareSlice(const SliceTask& task, DataPtr data);
+    //! read slices along the unlimited dimension with CDMReader::getDataSlices in batches limited by budget, and write them
+    void readAndWriteSlices(const std::vector<SliceTask>& tasks, BatchBudget& budget);
+    void writeSlice(const SliceTask& task, DataPtr data);
 
     DataPtr convertData(const CDMVariable& var, DataPtr data);
 
@@ -95,6 +108,7 @@ private:
     std::map<std::string, unsigned int> variableCompression;
     std::map<std::string, unsigned int> dimensionChunkSize;
     std::map<std::string, std::string> dimensionNameChanges;
+    size_t readAheadBytes;
 };
 
 }
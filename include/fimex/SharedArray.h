@@ -58,6 +58,15 @@ public:
     {
     }
 
+    /**
+     * Aliasing constructor: share ownership with other, but point to content,
+     * usually an element within other.
+     */
+    shared_array(const shared_array& other, T* content)
+        : holder_(other.holder_, content)
+    {
+    }
+
     shared_array& operator=(const shared_array& other)
     {
         holder_ = other.holder_;
@@ -66,6 +75,9 @@ public:
 
     operator bool() const { return static_cast<bool>(holder_); }
 
+    long use_count() const { return holder_.use_count(); }
+    bool unique() const { return use_count() == 1; }
+
     T* get() { return holder_.get(); }
     const T* get() const { return holder_.get(); }
 
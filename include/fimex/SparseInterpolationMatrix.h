@@ -0,0 +1,122 @@
+/*
+ * Fimex, SparseInterpolationMatrix.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef SPARSEINTERPOLATIONMATRIX_H_
+#define SPARSEINTERPOLATIONMATRIX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace MetNoFimex {
+
+/**
+ * @headerfile fimex/SparseInterpolationMatrix.h
+ */
+/**
+ * Horizontal interpolation as a sparse matrix in compressed sparse row (CSR)
+ * format. Each row is an output point, with the positions of the input points
+ * in the input layer (y*inX + x) and their weights.
+ *
+ * All linear interpolation methods can be expressed as such a matrix, see
+ * CachedInterpolationInterface::sparseMatrix(), and all of them are then
+ * applied with the same multithreaded kernel to all z-levels.
+ */
+class SparseInterpolationMatrix
+{
+public:
+    /**
+     * Handling of undefined (nan) input values.
+     */
+    enum Flags {
+        /** undefined input values are ignored, by default they make the output undefined */
+        SKIP_MISSING = 1,
+        /** divide the output by the sum of the weights of the used input values, e.g. for a mean */
+        NORMALIZE = 2
+    };
+
+    /**
+     * Create an empty matrix, to be filled with addWeight() and endRow().
+     * @param inSize number of points in an input layer
+     * @param flags combination of #Flags
+     */
+    explicit SparseInterpolationMatrix(size_t inSize, int flags = 0);
+
+    /**
+     * Restore a matrix from its CSR arrays.
+     * @throw CDMException if the arrays are inconsistent
+     */
+    SparseInterpolationMatrix(size_t inSize, int flags, const std::vector<uint64_t>& rowStart, const std::vector<uint32_t>& columns,
+                              const std::vector<float>& weights);
+
+    /**
+     * Add an input point to the current row.
+     * @param in position in the input layer
+     * @param weight weight of the input point
+     */
+    void addWeight(size_t in, float weight);
+
+    /**
+     * Finish the current row, i.e. output point. A row without weights gives undefined output.
+     */
+    void endRow();
+
+    /** @return number of output points */
+    size_t rows() const { return rowStart_.size() - 1; }
+    /** @return number of points in an input layer */
+    size_t inSize() const { return inSize_; }
+    /** @return number of weights */
+    size_t nonZeros() const { return columns_.size(); }
+    /** @return the #Flags */
+    int flags() const { return flags_; }
+
+    /** @return start of each row in columns()/weights(), size rows()+1 */
+    const std::vector<uint64_t>& rowStart() const { return rowStart_; }
+    /** @return input positions */
+    const std::vector<uint32_t>& columns() const { return columns_; }
+    /** @return weights */
+    const std::vector<float>& weights() const { return weights_; }
+
+    /**
+     * Apply the matrix to inZ input layers.
+     *
+     * @param in inZ*inSize() input values
+     * @param inZ number of layers
+     * @param out inZ*rows() output values
+     */
+    void apply(const float* in, size_t inZ, float* out) const;
+
+private:
+    size_t inSize_;
+    int flags_;
+    std::vector<uint64_t> rowStart_;
+    std::vector<uint32_t> columns_;
+    std::vector<float> weights_;
+};
+
+typedef std::shared_ptr<const SparseInterpolationMatrix> SparseInterpolationMatrix_cp;
+
+} // namespace MetNoFimex
+
+#endif /* SPARSEINTERPOLATIONMATRIX_H_ */
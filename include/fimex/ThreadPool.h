@@ -41,6 +41,18 @@ extern "C" {
   */
 extern int mifi_setNumThreads(int n);
 
+/**
+  * @brief Limit the number of threads used by each parallel loop of a processing stage.
+  *
+  * The limit applies within the number of threads set by mifi_setNumThreads,
+  * e.g. to read input with fewer threads than used for interpolation.
+  *
+  * @param stage one of "read", "interpolate" or "write"
+  * @param n the maximum number of threads, if 0, no stage limit
+  * @return MIFI_OK or MIFI_ERROR for an unknown stage
+  */
+extern int mifi_setStageNumThreads(const char* stage, int n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,6 +28,8 @@
 
 #include "fimex/UnitsConverterDecl.h"
 
+#include <cstddef>
+
 namespace MetNoFimex
 {
 
@@ -48,6 +50,20 @@ public:
     virtual double convert(double from) = 0;
     virtual float convert(float from) = 0;
 
+    /**
+     * convert an array of values from the input unit to an output-unit
+     *
+     * Values equal to fillValue or nan are copied unchanged. This is much
+     * faster than calling convert() for each value.
+     *
+     * @param from n values in the 'from' unit
+     * @param to n values in the 'to' unit, might be identical to from
+     * @param n number of values
+     * @param fillValue undefined value, not converted
+     */
+    virtual void convert(const double* from, double* to, size_t n, double fillValue);
+    virtual void convert(const float* from, float* to, size_t n, float fillValue);
+
     /**
      * check if the converter is linear (representable by scale & offset)
      */
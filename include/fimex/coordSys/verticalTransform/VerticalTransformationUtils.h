@@ -91,6 +91,7 @@ private:
 };
 
 SliceBuilder adaptSliceBuilder(const CDM& cdm, const std::string& varName, const SliceBuilder& sbOrig);
+SliceBuilder adaptSliceBuilder(const CDM& cdm, const std::vector<std::string>& shape, const SliceBuilder& sb);
 SliceBuilder adaptSliceBuilder(const CDM& cdm, VerticalConverter_p converter, const SliceBuilder& sb);
 
 DataPtr getSliceData(CDMReader_p reader, const SliceBuilder& sbOrig, const std::string& varName, const std::string& unit);
@@ -37,7 +37,7 @@ extern "C" {
 /**
  * Convert interpolation methods in string-format to mifi_interpol_method (see mifi_constants.h)
  * @param stringMethod one of nearestneighbor, bilinear,bicubic, forward_max, forward_min, forward_mean,
- *    forward_median, forward_sum, coord_nearestneighbor, coord_kdtree
+ *    forward_median, forward_sum, coord_nearestneighbor, coord_kdtree, conservative
  * @return mifi_interpol_method enum, or MIFI_INTERPOL_UNKNOWN on error
  */
 extern int mifi_string_to_interpolation_method(const char* stringMethod);
@@ -143,7 +143,12 @@ enum mifi_interpol_method {
       * forward interpolation, min over all input-cells, thus propagating undefined values,
       * i.e. value+undef=undef
       */
-     MIFI_INTERPOL_FORWARD_UNDEF_MIN
+     MIFI_INTERPOL_FORWARD_UNDEF_MIN,
+     /**
+      * first-order conservative remapping, area-weighted mean over the overlap of
+      * the input-cells with the output-cell, skipping undefined input-cells
+      */
+     MIFI_INTERPOL_CONSERVATIVE
 };
 
 /**
@@ -49,7 +49,8 @@ enum InterpolationMethod {
   ForwardUndefMean = MIFI_INTERPOL_FORWARD_UNDEF_MEAN,
   ForwardUndefMedian = MIFI_INTERPOL_FORWARD_UNDEF_MEDIAN,
   ForwardUndefMax = MIFI_INTERPOL_FORWARD_UNDEF_MAX,
-  ForwardUndefMin = MIFI_INTERPOL_FORWARD_UNDEF_MIN
+  ForwardUndefMin = MIFI_INTERPOL_FORWARD_UNDEF_MIN,
+  Conservative = MIFI_INTERPOL_CONSERVATIVE
 };
 
 CDMInterpolator_p createInterpolator(CDMReader_p reader)
@@ -102,7 +103,8 @@ void pyfimex0_CDMInterpolator(py::module m)
         .value("FORWARD_UNDEF_MEAN", ForwardUndefMean)
         .value("FORWARD_UNDEF_MEDIAN", ForwardUndefMedian)
         .value("FORWARD_UNDEF_MAX", ForwardUndefMax)
-        .value("FORWARD_UNDEF_MIN", ForwardUndefMin);
+        .value("FORWARD_UNDEF_MIN", ForwardUndefMin)
+        .value("CONSERVATIVE", Conservative);
 
     py::class_<CDMInterpolator, CDMInterpolator_p, CDMReader>(m, "_CDMInterpolator")
         .def("changeProjection", changeProjection1,
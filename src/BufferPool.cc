@@ -0,0 +1,267 @@
+/*
+ * Fimex, BufferPool.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace MetNoFimex {
+
+namespace {
+
+//! number of buffers kept per thread
+const size_t threadCacheBuffers = 4;
+
+//! bytes kept per thread, larger buffers go directly to the global cache
+const size_t threadCacheMaxBytes = 64 * 1024 * 1024;
+
+//! round up to a size-class with 4 classes per power of two
+size_t sizeClass(size_t bytes)
+{
+    size_t shift = 0;
+    while ((bytes >> shift) > 7)
+        shift += 1;
+    const size_t mantissa = (bytes + (size_t(1) << shift) - 1) >> shift;
+    return mantissa << shift;
+}
+
+struct ThreadCache;
+
+struct GlobalPool
+{
+    std::mutex mutex;
+    std::multimap<size_t, void*> buffers;
+    //! bytes kept in the global cache and all thread caches, limited by maxBytes
+    std::atomic<size_t> cachedBytes;
+    std::atomic<size_t> maxBytes;
+    std::atomic<size_t> allocations;
+    std::atomic<size_t> reuses;
+
+    //! registered thread caches, lock before ThreadCache::mutex and mutex
+    std::mutex registryMutex;
+    std::vector<ThreadCache*> threadCaches;
+
+    GlobalPool()
+        : cachedBytes(0)
+        , maxBytes(256 * 1024 * 1024)
+        , allocations(0)
+        , reuses(0)
+    {
+    }
+
+    bool reserve(size_t capacity);
+    void* take(size_t capacity);
+    void put(void* buffer, size_t capacity);
+    void shrink();
+};
+
+GlobalPool& globalPool()
+{
+    // never destroyed, buffers might be released during static destruction
+    static GlobalPool* pool = new GlobalPool;
+    return *pool;
+}
+
+//! account for capacity in cachedBytes, fails if this exceeds maxBytes
+bool GlobalPool::reserve(size_t capacity)
+{
+    size_t cached = cachedBytes;
+    do {
+        if (cached + capacity > maxBytes)
+            return false;
+    } while (!cachedBytes.compare_exchange_weak(cached, cached + capacity));
+    return true;
+}
+
+void* GlobalPool::take(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = buffers.find(capacity);
+    if (it == buffers.end())
+        return 0;
+    void* buffer = it->second;
+    buffers.erase(it);
+    cachedBytes -= capacity;
+    return buffer;
+}
+
+//! add a buffer already accounted for by reserve()
+void GlobalPool::put(void* buffer, size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.insert(std::make_pair(capacity, buffer));
+}
+
+void GlobalPool::shrink()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // free the largest buffers first
+    while (cachedBytes > maxBytes && !buffers.empty()) {
+        auto it = --buffers.end();
+        cachedBytes -= it->first;
+        ::operator delete(it->second);
+        buffers.erase(it);
+    }
+}
+
+thread_local bool threadCacheDestroyed = false;
+
+//! most recently released buffers of this thread, the lock is only contended by flush()
+struct ThreadCache
+{
+    std::mutex mutex;
+    std::vector<std::pair<size_t, void*>> buffers;
+    size_t bytes;
+
+    ThreadCache()
+        : bytes(0)
+    {
+        GlobalPool& pool = globalPool();
+        std::lock_guard<std::mutex> lock(pool.registryMutex);
+        pool.threadCaches.push_back(this);
+    }
+
+    ~ThreadCache()
+    {
+        threadCacheDestroyed = true;
+        GlobalPool& pool = globalPool();
+        std::lock_guard<std::mutex> lock(pool.registryMutex);
+        pool.threadCaches.erase(std::find(pool.threadCaches.begin(), pool.threadCaches.end(), this));
+        flush();
+    }
+
+    void* take(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = buffers.size(); i > 0; --i) {
+            if (buffers[i - 1].first == capacity) {
+                void* buffer = buffers[i - 1].second;
+                buffers.erase(buffers.begin() + (i - 1));
+                bytes -= capacity;
+                return buffer;
+            }
+        }
+        return 0;
+    }
+
+    //! add a buffer already accounted for by GlobalPool::reserve()
+    void put(void* buffer, size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!buffers.empty() && (buffers.size() == threadCacheBuffers || bytes + capacity > threadCacheMaxBytes)) {
+            globalPool().put(buffers.front().second, buffers.front().first);
+            bytes -= buffers.front().first;
+            buffers.erase(buffers.begin());
+        }
+        buffers.push_back(std::make_pair(capacity, buffer));
+        bytes += capacity;
+    }
+
+    //! move all buffers to the global cache
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& b : buffers)
+            globalPool().put(b.second, b.first);
+        buffers.clear();
+        bytes = 0;
+    }
+};
+
+ThreadCache* threadCache()
+{
+    if (threadCacheDestroyed)
+        return 0;
+    static thread_local ThreadCache cache;
+    return &cache;
+}
+
+} // namespace
+
+void* allocatePooledBuffer(size_t bytes, size_t& capacity)
+{
+    capacity = sizeClass(bytes);
+    GlobalPool& pool = globalPool();
+    void* buffer = 0;
+    if (ThreadCache* tc = threadCache()) {
+        buffer = tc->take(capacity);
+        if (buffer)
+            pool.cachedBytes -= capacity;
+    }
+    if (!buffer)
+        buffer = pool.take(capacity);
+    if (buffer) {
+        pool.reuses += 1;
+    } else {
+        buffer = ::operator new(capacity);
+        pool.allocations += 1;
+    }
+    return buffer;
+}
+
+void releasePooledBuffer(void* buffer, size_t capacity)
+{
+    GlobalPool& pool = globalPool();
+    if (!pool.reserve(capacity)) {
+        ::operator delete(buffer);
+    } else if (capacity <= threadCacheMaxBytes && threadCache()) {
+        threadCache()->put(buffer, capacity);
+    } else {
+        pool.put(buffer, capacity);
+    }
+}
+
+void setBufferPoolMaxBytes(size_t maxBytes)
+{
+    GlobalPool& pool = globalPool();
+    pool.maxBytes = maxBytes;
+    {
+        std::lock_guard<std::mutex> lock(pool.registryMutex);
+        for (ThreadCache* tc : pool.threadCaches)
+            tc->flush();
+    }
+    pool.shrink();
+}
+
+size_t getBufferPoolMaxBytes()
+{
+    return globalPool().maxBytes;
+}
+
+BufferPoolStatistics getBufferPoolStatistics()
+{
+    GlobalPool& pool = globalPool();
+    BufferPoolStatistics stats;
+    stats.allocations = pool.allocations;
+    stats.reuses = pool.reuses;
+    stats.cachedBytes = pool.cachedBytes;
+    return stats;
+}
+
+} // namespace MetNoFimex
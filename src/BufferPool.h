@@ -0,0 +1,113 @@
+/*
+ * Fimex, BufferPool.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef FIMEX_BUFFERPOOL_H_
+#define FIMEX_BUFFERPOOL_H_
+
+#include "fimex/SharedArray.h"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace MetNoFimex {
+
+/*
+ * Pool of large memory buffers, used for the data-slices passed through
+ * the interpolation chain.
+ *
+ * Buffers are grouped in size-classes (4 per power of two). Released buffers
+ * are kept in a small per-thread cache, and in a global cache. Both caches
+ * together are limited to getBufferPoolMaxBytes(). Buffers smaller than
+ * bufferPoolMinBytes are not pooled.
+ */
+
+//! statistics of the buffer pool
+struct BufferPoolStatistics
+{
+    size_t allocations; //!< buffers allocated from the system
+    size_t reuses;      //!< buffers served from the pool
+    size_t cachedBytes; //!< bytes currently kept in the global and thread caches
+};
+
+//! minimum buffer size in bytes for pooling
+const size_t bufferPoolMinBytes = 64 * 1024;
+
+/**
+ * Get a buffer of at least bytes from the pool.
+ * @param bytes requested size, at least bufferPoolMinBytes
+ * @param capacity the real size of the buffer, to be passed to releasePooledBuffer
+ */
+void* allocatePooledBuffer(size_t bytes, size_t& capacity);
+
+/**
+ * Return a buffer from allocatePooledBuffer to the pool.
+ */
+void releasePooledBuffer(void* buffer, size_t capacity);
+
+/**
+ * Limit the memory kept in the caches of the pool. The thread caches
+ * are moved to the global cache, which is then shrunk to maxBytes.
+ * 0 disables the caches and frees all cached buffers.
+ */
+void setBufferPoolMaxBytes(size_t maxBytes);
+size_t getBufferPoolMaxBytes();
+
+BufferPoolStatistics getBufferPoolStatistics();
+
+/**
+ * Deleter for shared_array, returning the buffer to the pool.
+ */
+struct PooledBufferDeleter
+{
+    size_t capacity;
+    template <typename T>
+    void operator()(T* buffer) const
+    {
+        releasePooledBuffer(buffer, capacity);
+    }
+};
+
+/**
+ * Create an uninitialized shared_array, using the buffer pool for large
+ * arrays of arithmetic types.
+ */
+template <typename T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, shared_array<T>>::type make_pooled_array(size_t size)
+{
+    const size_t bytes = size * sizeof(T);
+    if (bytes < bufferPoolMinBytes)
+        return shared_array<T>(new T[size]);
+    PooledBufferDeleter deleter;
+    T* buffer = static_cast<T*>(allocatePooledBuffer(bytes, deleter.capacity));
+    return shared_array<T>(buffer, deleter);
+}
+
+template <typename T>
+inline typename std::enable_if<!std::is_arithmetic<T>::value, shared_array<T>>::type make_pooled_array(size_t size)
+{
+    return shared_array<T>(new T[size]);
+}
+
+} // namespace MetNoFimex
+
+#endif /* FIMEX_BUFFERPOOL_H_ */
@@ -0,0 +1,172 @@
+/*
+ * Fimex, CDMCachingReader.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "fimex/CDMCachingReader.h"
+
+#include "fimex/CDM.h"
+#include "fimex/Data.h"
+#include "fimex/Logger.h"
+#include "fimex/SliceBuilder.h"
+
+#include "MutexLock.h"
+
+#include <functional>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+
+namespace MetNoFimex {
+
+static Logger_p logger = getLogger("fimex.CDMCachingReader");
+
+namespace {
+size_t dataBytes(DataPtr data)
+{
+    return data->size() * data->bytes_for_one();
+}
+} // namespace
+
+struct CDMCachingReader::Impl
+{
+    typedef std::pair<std::string, DataPtr> Entry;
+    typedef std::list<Entry> EntryList;
+
+    CDMReader_p dataReader;
+    SharedMutex mutex;
+    //! most recently used first
+    EntryList entries;
+    std::unordered_map<std::string, EntryList::iterator> index;
+    Statistics stats;
+
+    Impl()
+        : mutex("caching reader")
+    {
+    }
+
+    DataPtr find(const std::string& key);
+    void insert(const std::string& key, DataPtr data);
+    DataPtr get(const std::string& key, std::function<DataPtr()> read);
+};
+
+DataPtr CDMCachingReader::Impl::find(const std::string& key)
+{
+    ExclusiveLock lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        stats.misses += 1;
+        return DataPtr();
+    }
+    stats.hits += 1;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void CDMCachingReader::Impl::insert(const std::string& key, DataPtr data)
+{
+    const size_t bytes = dataBytes(data);
+    ExclusiveLock lock(mutex);
+    if (bytes > stats.maxBytes || index.find(key) != index.end())
+        return;
+    while (stats.bytes + bytes > stats.maxBytes) {
+        const Entry& last = entries.back();
+        stats.bytes -= dataBytes(last.second);
+        stats.evictions += 1;
+        index.erase(last.first);
+        entries.pop_back();
+    }
+    entries.push_front(std::make_pair(key, data));
+    index[key] = entries.begin();
+    stats.bytes += bytes;
+}
+
+DataPtr CDMCachingReader::Impl::get(const std::string& key, std::function<DataPtr()> read)
+{
+    if (stats.maxBytes == 0)
+        return read();
+
+    DataPtr data = find(key);
+    if (!data) {
+        // read outside the lock, concurrent misses of the same slice read twice
+        data = read();
+        insert(key, data);
+    }
+    // the cached data must not be modified by the caller
+    return data->clone();
+}
+
+CDMCachingReader::CDMCachingReader(CDMReader_p dataReader, size_t maxBytes)
+    : p_(new Impl)
+{
+    p_->dataReader = dataReader;
+    p_->stats.hits = p_->stats.misses = p_->stats.evictions = p_->stats.bytes = 0;
+    p_->stats.maxBytes = maxBytes;
+    *cdm_ = dataReader->getCDM();
+}
+
+CDMCachingReader::~CDMCachingReader()
+{
+    const Statistics& s = p_->stats;
+    LOG4FIMEX(logger, Logger::INFO, "slice cache hits: " << s.hits << ", misses: " << s.misses << ", evictions: " << s.evictions);
+}
+
+DataPtr CDMCachingReader::getDataSlice(const std::string& varName, size_t unLimDimPos)
+{
+    const CDMVariable& variable = cdm_->getVariable(varName);
+    if (variable.hasData())
+        return getDataSliceFromMemory(variable, unLimDimPos);
+
+    std::ostringstream key;
+    key << varName << '#' << unLimDimPos;
+    return p_->get(key.str(), [&]() { return p_->dataReader->getDataSlice(varName, unLimDimPos); });
+}
+
+DataPtr CDMCachingReader::getDataSlice(const std::string& varName, const SliceBuilder& sb)
+{
+    const CDMVariable& variable = cdm_->getVariable(varName);
+    if (variable.hasData())
+        return getDataSliceFromMemory(variable, sb);
+
+    std::ostringstream key;
+    key << varName;
+    const std::vector<size_t>& start = sb.getDimensionStartPositions();
+    const std::vector<size_t>& size = sb.getDimensionSizes();
+    for (size_t i = 0; i < start.size(); ++i)
+        key << '|' << start[i] << ':' << size[i];
+    return p_->get(key.str(), [&]() { return p_->dataReader->getDataSlice(varName, sb); });
+}
+
+CDMCachingReader::Statistics CDMCachingReader::getStatistics() const
+{
+    ExclusiveLock lock(p_->mutex);
+    return p_->stats;
+}
+
+void CDMCachingReader::clear()
+{
+    ExclusiveLock lock(p_->mutex);
+    p_->entries.clear();
+    p_->index.clear();
+    p_->stats.bytes = 0;
+}
+
+} // namespace MetNoFimex
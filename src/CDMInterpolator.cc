@@ -29,6 +29,11 @@
 // fimex
 //
 #include "CachedForwardInterpolation.h"
+#include "ConservativeRemapping.h"
+#include "GridPointIndex.h"
+#include "InterpolationWeightsCache.h"
+#include "ProjectionCache.h"
+#include "TaskScheduler.h"
 #include "fimex/CDM.h"
 #include "fimex/CDMException.h"
 #include "fimex/CDMFileReaderFactory.h"
@@ -47,8 +52,6 @@
 #include "fimex/interpolation.h"
 #include "fimex/min_max.h"
 
-#include "nanoflann/nanoflann.hpp"
-
 // PROJ.4
 //
 #ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
@@ -113,11 +116,29 @@ struct CDMInterpolator::Impl
     // horizontalId, cachedVectorReprojection
     typedef map<string, CachedVectorReprojection_p> cachedVectorReprojection_t;
     cachedVectorReprojection_t cachedVectorReprojection;
+    // persistent storage of cachedInterpolation, may be null
+    InterpolationWeightsCache_p weightsCache;
 };
 
 namespace {
 const std::string LAT_LON_PROJSTR = MIFI_WGS84_LATLON_PROJ4;
 Logger_p logger = getLogger("fimex.CDMInterpolator");
+
+/**
+ * Fetch the interpolation from the persistent cache, or create and store it.
+ */
+CachedInterpolationInterface_p cachedOrCreateInterpolation(const InterpolationWeightsCache_p& cache, const InterpolationWeightsKey& key,
+                                                           const std::function<CachedInterpolationInterface_p()>& create)
+{
+    if (cache) {
+        if (CachedInterpolationInterface_p ci = cache->get(key))
+            return ci;
+    }
+    CachedInterpolationInterface_p ci = create();
+    if (cache)
+        cache->put(key, *ci);
+    return ci;
+}
 } // namespace
 
 CDMInterpolator::CDMInterpolator(CDMReader_p dataReader)
@@ -145,6 +166,11 @@ shared_array<float> data2InterpolationArray(const DataPtr& inData, double badVal
 
 DataPtr interpolationArray2Data(CDMDataType newType, shared_array<float> iData, size_t size, double badValue)
 {
+    if (newType == CDM_FLOAT) {
+        // convert inplace, avoiding another copy of the data
+        mifi_nanf2bad(&iData[0], &iData[size], badValue);
+        return createData(size, iData);
+    }
     DataPtr d = createData(size, iData);
     return d->convertDataType(MIFI_UNDEFINED_F, 1., 0., newType, badValue, 1., 0.);
 }
@@ -163,28 +189,35 @@ void processArray_(vector<InterpolatorProcess2d_p> processes, float* array, size
 {
     if (processes.size() == 0) return; // nothing to do
 
-    int nz = static_cast<int>(size / (nx*ny));
+    const size_t nz = size / (nx * ny);
     assert((nz*nx*ny) == size);
 
-#ifdef _OPENMP
-#pragma omp parallel default(shared) if (nz >= 4)
-    {
-#pragma omp for nowait
-#endif
-    for (int z = 0; z < nz; z++) { // using int instead of size_t because of openMP < 3.0
-        // find the start of the slice
-        float* arrayPos = array + (z*nx*ny);
-        for (size_t i = 0; i < processes.size(); i++) {
-            processes[i]->operator()(arrayPos, nx, ny);
-        }
-    }
-#ifdef _OPENMP
-    }
-#endif
-    return;
+    parallelFor(
+        nz,
+        [&](size_t z) {
+            // find the start of the slice
+            float* arrayPos = array + (z * nx * ny);
+            for (size_t i = 0; i < processes.size(); i++) {
+                processes[i]->operator()(arrayPos, nx, ny);
+            }
+        },
+        TASK_STAGE_INTERPOLATE);
 }
 } // namespace
 
+CachedInterpolationInterface_p CDMInterpolator::findCachedInterpolation(const std::string& varName) const
+{
+    Impl::projectionVariables_t::const_iterator itP = p_->projectionVariables.find(varName);
+    if (itP == p_->projectionVariables.end())
+        return CachedInterpolationInterface_p();
+
+    const string& horizontalId = itP->second;
+    Impl::cachedInterpolation_t::const_iterator itCI = p_->cachedInterpolation.find(horizontalId);
+    if (itCI == p_->cachedInterpolation.end())
+        throw CDMException("no cached interpolation for " + varName + "(" + horizontalId + ")");
+    return itCI->second;
+}
+
 DataPtr CDMInterpolator::getDataSlice(const std::string& varName, const SliceBuilder& sb)
 {
     LOG4FIMEX(logger, Logger::DEBUG, "interpolating '"<< varName << "' with sliceBuilder" );
@@ -192,22 +225,66 @@ DataPtr CDMInterpolator::getDataSlice(const std::string& varName, const SliceBui
     if (variable.hasData())
         return getDataSliceFromMemory(variable, sb);
 
-    Impl::projectionVariables_t::const_iterator itP = p_->projectionVariables.find(varName);
-    if (itP == p_->projectionVariables.end()) {
+    CachedInterpolationInterface_p ci = findCachedInterpolation(varName);
+    if (!ci) {
         // no projection, just forward
         return p_->dataReader->getDataSlice(varName, sb);
     }
+    return interpolateSlice(varName, sb, ci, ci->getInputDataSlice(p_->dataReader, varName, sb));
+}
 
-    const string& horizontalId = itP->second;
-    Impl::cachedInterpolation_t::iterator itCI = p_->cachedInterpolation.find(horizontalId);
-    if (itCI == p_->cachedInterpolation.end())
-        throw CDMException("no cached interpolation for " + varName + "(" + horizontalId + ")");
+std::vector<DataPtr> CDMInterpolator::getDataSlices(const DataSliceRequest_v& requests)
+{
+    std::vector<DataPtr> results(requests.size());
+    std::vector<CachedInterpolationInterface_p> cis(requests.size());
+
+    // collect the input of all requests not held in memory
+    DataSliceRequest_v inputRequests;
+    std::vector<size_t> inputIndex;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const DataSliceRequest& r = requests[i];
+        const CDMVariable& variable = cdm_->getVariable(r.varName);
+        if (variable.hasData()) {
+            results[i] = getDataSliceFromMemory(variable, r.sb);
+            continue;
+        }
+        cis[i] = findCachedInterpolation(r.varName);
+        if (cis[i])
+            inputRequests.push_back(DataSliceRequest(r.varName, cis[i]->getInputSliceBuilder(p_->dataReader->getCDM(), r.varName, r.sb)));
+        else
+            inputRequests.push_back(r); // no projection, just forward
+        inputIndex.push_back(i);
+    }
+    std::vector<DataPtr> inputs = p_->dataReader->getDataSlices(inputRequests);
+
+    std::vector<size_t> interpolate;
+    for (size_t j = 0; j < inputIndex.size(); ++j) {
+        const size_t i = inputIndex[j];
+        if (cis[i])
+            interpolate.push_back(j);
+        else
+            results[i] = inputs[j];
+    }
+
+    parallelFor(
+        interpolate.size(),
+        [&](size_t k) {
+            const size_t j = interpolate[k];
+            const size_t i = inputIndex[j];
+            results[i] = interpolateSlice(requests[i].varName, requests[i].sb, cis[i], inputs[j]);
+            inputs[j].reset();
+        },
+        TASK_STAGE_INTERPOLATE);
+    return results;
+}
 
-    CachedInterpolationInterface_p ci = itCI->second;
-    DataPtr data = ci->getInputDataSlice(p_->dataReader, varName, sb);
+DataPtr CDMInterpolator::interpolateSlice(const std::string& varName, const SliceBuilder& sb, CachedInterpolationInterface_p ci, DataPtr data)
+{
     if (data->size() == 0)
         return data;
 
+    const CDMVariable& variable = cdm_->getVariable(varName);
+    const string& horizontalId = p_->projectionVariables.find(varName)->second;
     const double badValue = cdm_->getFillValue(varName);
     shared_array<float> array = data2InterpolationArray(data, badValue);
     processArray_(p_->preprocesses, array.get(), data->size(), ci->getInX(), ci->getInY());
@@ -280,6 +357,13 @@ const std::string& CDMInterpolator::getLongitudeName() const {
 void CDMInterpolator::setDistanceOfInterest(double dist) {
     p_->maxDistance = dist;
 }
+void CDMInterpolator::setWeightsCacheDirectory(const std::string& directory)
+{
+    if (directory.empty())
+        p_->weightsCache.reset();
+    else
+        p_->weightsCache = std::make_shared<InterpolationWeightsCache>(directory);
+}
 double CDMInterpolator::getMaxDistanceOfInterest(const vector<double>& out_x_axis, const vector<double>& out_y_axis, bool isMetric) const
 {
     if (p_->maxDistance > 0) return p_->maxDistance;
@@ -421,6 +505,9 @@ void CDMInterpolator::changeProjection(int method, const string& proj_input, con
     case MIFI_INTERPOL_FORWARD_UNDEF_MAX:
     case MIFI_INTERPOL_FORWARD_UNDEF_MIN:
         changeProjectionByForwardInterpolation(method, proj_input, out_x_axis, out_y_axis, out_x_axis_unit, out_y_axis_unit, out_x_axis_type, out_y_axis_type); break;
+    case MIFI_INTERPOL_CONSERVATIVE:
+        changeProjectionByConservativeRemapping(proj_input, out_x_axis, out_y_axis, out_x_axis_unit, out_y_axis_unit, out_x_axis_type, out_y_axis_type);
+        break;
     default: throw CDMException("unknown projection method: " + type2string(method));
     }
 }
@@ -476,6 +563,7 @@ void CDMInterpolator::changeProjection(int method,
     case MIFI_INTERPOL_FORWARD_MEDIAN:
     case MIFI_INTERPOL_FORWARD_MAX:
     case MIFI_INTERPOL_FORWARD_MIN:
+    case MIFI_INTERPOL_CONSERVATIVE:
         throw CDMException(
                 "projection method: " + type2string(method)
                         + ", not supported");
@@ -680,6 +768,7 @@ void CDMInterpolator::changeProjection(int method, CDMReader_p tmplReader, const
         case MIFI_INTERPOL_FORWARD_MEDIAN:
         case MIFI_INTERPOL_FORWARD_MAX:
         case MIFI_INTERPOL_FORWARD_MIN:
+        case MIFI_INTERPOL_CONSERVATIVE:
             throw CDMException("projection method: " + type2string(method) + ", not supported");
             break;
         default:
@@ -914,127 +1003,40 @@ void changeCDM(CDM& cdm, const string& proj_input, const map<string, CoordinateS
     }
 }
 
-// internal setup for nanoflann kd-tree
-template <typename T>
-struct PointCloud
-{
-        struct Point
-        {
-                T  x,y,z;
-        };
-
-        std::vector<Point>  pts;
-
-        // Must return the number of data points
-        inline size_t kdtree_get_point_count() const { return pts.size(); }
-
-        // Returns the distance between the vector "p1[0:size-1]" and the data point with index "idx_p2" stored in the class:
-        inline T kdtree_distance(const T* p1, const size_t idx_p2, size_t) const
-        {
-                T d0=p1[0]-pts[idx_p2].x;
-                T d1=p1[1]-pts[idx_p2].y;
-                T d2=p1[2]-pts[idx_p2].z;
-                return d0*d0+d1*d1+d2*d2;
-        }
-
-        // Returns the dim'th component of the idx'th point in the class:
-        // Since this is inlined and the "dim" argument is typically an immediate value, the
-        //  "if/else's" are actually solved at compile time.
-        inline T kdtree_get_pt(const size_t idx, int dim) const
-        {
-                if (dim==0) return pts[idx].x;
-                else if (dim==1) return pts[idx].y;
-                else return pts[idx].z;
-        }
-
-        // Optional bounding-box computation: return false to default to a standard bbox computation loop.
-        //   Return true if the BBOX was already computed by the class and returned in "bb" so it can be avoided to redo it again.
-        //   Look at bb.size() to find out the expected dimensionality (e.g. 2 or 3 for point clouds)
-        template <class BBOX>
-        bool kdtree_get_bbox(BBOX&) const
-        {
-            return false;
-        }
-};
-
 void flannTranslatePointsToClosestInputCell(double maxDist, vector<double>& pointsOnXAxis, vector<double>& pointsOnYAxis, size_t xAxisSize, size_t yAxisSize, double* lonVals, double* latVals, size_t orgXDimSize, size_t orgYDimSize)
 {
     // pointsOnXAxis and pointsOnYAxis as well as lonVals and latVals are now represented in rad
 
-    using namespace nanoflann;
     LOG4FIMEX(logger, Logger::DEBUG, "maximum allowed distance from cell-center: " << maxDist);
     assert(maxDist != 0);
 
     // all calculations on a sphere with unit 1
     maxDist /= MIFI_EARTH_RADIUS_M;
 
-
     time_t start = time(0);
-    PointCloud<double> cloud;
-    cloud.pts.resize(orgXDimSize*orgYDimSize);
-    for (size_t ix = 0; ix < orgXDimSize; ix++) {
-        for (size_t iy = 0; iy < orgYDimSize; iy++) {
-            size_t pos = ix+iy*orgXDimSize;
-            if (!(std::isnan(latVals[pos]) || std::isnan(lonVals[pos]))) {
-                double sinLat = sin(latVals[pos]);
-                double cosLat = cos(latVals[pos]);
-                double sinLon = sin(lonVals[pos]);
-                double cosLon = cos(lonVals[pos]);
-                cloud.pts[pos].x = cosLat * cosLon;
-                cloud.pts[pos].y = cosLat * sinLon;
-                cloud.pts[pos].z = sinLat;
-            } else {
-                cloud.pts[pos].x = MIFI_UNDEFINED_D;
-                cloud.pts[pos].y = MIFI_UNDEFINED_D;
-                cloud.pts[pos].z = MIFI_UNDEFINED_D;
-            }
-        }
-    }
-    // construct a kd-tree index:
-    typedef KDTreeSingleIndexAdaptor<L2_Simple_Adaptor<double, PointCloud<double> > ,
-                                     PointCloud<double>,
-                                     3 /* dim */> my_kd_tree_t;
-    my_kd_tree_t index(3 /*dim*/, cloud, KDTreeSingleIndexAdaptorParams(12 /* max leaf */) );
-    index.buildIndex();
+    const GridPointIndex index(lonVals, latVals, orgXDimSize, orgYDimSize);
     LOG4FIMEX(logger, Logger::DEBUG, "finished loading kdTree after " << (time(0) - start) << "s");
 
-    // using square since distance is not sqrt
-    const double search_radius = maxDist * maxDist;
-    nanoflann::SearchParams params;
-    params.sorted = true;
-    for (size_t i = 0; i < pointsOnXAxis.size(); i++) {
-        double sinLat = sin(pointsOnYAxis[i]);
-        double cosLat = cos(pointsOnYAxis[i]);
-        double sinLon = sin(pointsOnXAxis[i]);
-        double cosLon = cos(pointsOnXAxis[i]);
-        const double query_pt[3] = { cosLat * cosLon,
-                                     cosLat * sinLon,
-                                     sinLat };
-
-        std::vector<std::pair<size_t,double> > ret_matches;
-        const size_t nMatches = index.radiusSearch(&query_pt[0], search_radius, ret_matches, params);
-        if (nMatches > 0) {
-            size_t pos = ret_matches.at(0).first; // pos = ix+orgXDimSize*iy =>
-            size_t ix = pos % orgXDimSize;
-            size_t iy = pos / orgXDimSize;
-            //LOG4FIMEX(logger, Logger::DEBUG, "found (" << RAD_TO_DEG*pointsOnXAxis[i] << "," << RAD_TO_DEG*pointsOnYAxis[i] << ") at (" << ix << "," << iy << ") dist: " << ret_matches.at(0).second);
-            pointsOnXAxis[i] = ix;
-            pointsOnYAxis[i] = iy;
+    vector<size_t> positions(pointsOnXAxis.size());
+    index.findClosest(&pointsOnXAxis[0], &pointsOnYAxis[0], positions.size(), maxDist, &positions[0]);
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (positions[i] != GridPointIndex::npos) {
+            pointsOnXAxis[i] = positions[i] % orgXDimSize;
+            pointsOnYAxis[i] = positions[i] / orgXDimSize;
         } else {
             // set to any value outside the axes (0 - x/y-size)
             pointsOnXAxis[i] = -1000;
             pointsOnYAxis[i] = -1000;
         }
     }
-    LOG4FIMEX(logger, Logger::DEBUG, "finished flannKDTranslatePointsToClosestInputCell");
+    LOG4FIMEX(logger, Logger::DEBUG, "finished flannKDTranslatePointsToClosestInputCell after " << (time(0) - start) << "s");
 }
 
 double getGridDistance(vector<double>& pointsOnXAxis, vector<double>& pointsOnYAxis, double* lonVals, double* latVals, size_t orgXDimSize, size_t orgYDimSize) {
     // try to determine a average grid-distance, take some example points, evaluate the max,
     // multiply that with a number slightly bigger than 1 (i use 1.414
     // and define that as grid distance
-    vector<double> samples;
-    int steps;
+    size_t steps;
     size_t stepSize;
     if (orgXDimSize * orgYDimSize > 1000) {
         steps = 53; // unusual grid-dimension
@@ -1043,12 +1045,9 @@ double getGridDistance(vector<double>& pointsOnXAxis, vector<double>& pointsOnYA
         stepSize = 1;
         steps = orgXDimSize * orgYDimSize;
     }
-#ifdef _OPENMP
-#pragma omp parallel default(none) firstprivate(steps, stepSize, orgXDimSize, orgYDimSize) shared(samples, pointsOnXAxis, pointsOnYAxis, lonVals, latVals) if (steps > 4)
-    {
-#pragma omp for nowait
-#endif
-    for (int ik = 0; ik < steps; ik++) { // using int instead of size_t because of openMP < 3.0
+    // one slot per sample instead of a shared list, undefined samples stay nan
+    vector<double> samples(steps, MIFI_UNDEFINED_D);
+    parallelFor(steps, [&](size_t ik) {
         size_t samplePos = ik * stepSize;
         double lon0 = lonVals[samplePos];
         double lat0 = latVals[samplePos];
@@ -1073,19 +1072,10 @@ double getGridDistance(vector<double>& pointsOnXAxis, vector<double>& pointsOnYA
                     }
                 }
             }
-#ifdef _OPENMP
-#pragma omp critical (cdminterpolator_getgriddistance)
-            {
-#endif
-            samples.push_back(min_cos_d);
-#ifdef _OPENMP
-            }
-#endif
+            samples[ik] = min_cos_d;
         }
-    }
-#ifdef _OPENMP
-    }
-#endif
+    }, TASK_STAGE_INTERPOLATE);
+    samples.erase(std::remove_if(samples.begin(), samples.end(), [](double d) { return std::isnan(d); }), samples.end());
     double max_grid_d = acos(*(min_element(samples.begin(), samples.end())));
     max_grid_d *= 1.414; // allow a bit larger extrapolation (diagonal = sqrt(2))
     if (max_grid_d > MIFI_PI) max_grid_d = MIFI_PI;
@@ -1129,62 +1119,56 @@ void fastTranslatePointsToClosestInputCell(vector<double>& pointsOnXAxis, vector
     }
     // sort latlons by latitudes
     sort(latlons.begin(), latlons.end());
-#ifdef _OPENMP
-#pragma omp parallel default(none) shared(pointsOnXAxis,pointsOnYAxis,latlons, min_grid_cos_d)
-    {
-#pragma omp for nowait
-#endif
-    for (int i = 0; i < static_cast<int>(pointsOnXAxis.size()); i++) { // using int instead of size_t because of openMP < 3.0
-        //                   lat                   lon
-        LL_POINT p(pointsOnYAxis[i], pointsOnXAxis[i], -1., -1.);
-        size_t steps = 0;
-        double min_cos_d = min_grid_cos_d; // max allowed distance
-        double min_d = acos(min_cos_d);
-        vector<LL_POINT>::const_iterator it = lower_bound(latlons.begin(), latlons.end(), p);
-        vector<LL_POINT>::const_iterator it2 = it;
-        // loop until end
-        while (it != latlons.end()) {
-            steps++;
-            double dlon = it->lon - p.lon;
-            if (fabs(it->lat - p.lat) > min_d) {
-                it = latlons.end(); // all successing
-            } else {
-                double cos_d = cos(it->lat) * cos(p.lat) * cos(dlon) + sin(it->lat) * sin(p.lat);
-                if (cos_d > min_cos_d) { // closer distance
-                    min_cos_d = cos_d;
-                    min_d = acos(min_cos_d);
-                    p.x = it->x;
-                    p.y = it->y;
-                }
-                it++;
-            }
-        }
-        // loop until beginning
-        if (it2 != latlons.begin()) {
-            do {
+    parallelForRange(pointsOnXAxis.size(), 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            //                   lat                   lon
+            LL_POINT p(pointsOnYAxis[i], pointsOnXAxis[i], -1., -1.);
+            size_t steps = 0;
+            double min_cos_d = min_grid_cos_d; // max allowed distance
+            double min_d = acos(min_cos_d);
+            vector<LL_POINT>::const_iterator it = lower_bound(latlons.begin(), latlons.end(), p);
+            vector<LL_POINT>::const_iterator it2 = it;
+            // loop until end
+            while (it != latlons.end()) {
                 steps++;
-                it2--;
-                double dlon = it2->lon - p.lon;
-                if (fabs(it2->lat - p.lat) > min_d) {
-                    it2 = latlons.begin(); // all successing
+                double dlon = it->lon - p.lon;
+                if (fabs(it->lat - p.lat) > min_d) {
+                    it = latlons.end(); // all successing
                 } else {
-                    double cos_d = cos(it2->lat) * cos(p.lat) * cos(dlon) + sin(it2->lat) * sin(p.lat);
+                    double cos_d = cos(it->lat) * cos(p.lat) * cos(dlon) + sin(it->lat) * sin(p.lat);
                     if (cos_d > min_cos_d) { // closer distance
                         min_cos_d = cos_d;
                         min_d = acos(min_cos_d);
-                        p.x = it2->x;
-                        p.y = it2->y;
+                        p.x = it->x;
+                        p.y = it->y;
                     }
+                    it++;
                 }
-            } while (it2 != latlons.begin());
-        }
+            }
+            // loop until beginning
+            if (it2 != latlons.begin()) {
+                do {
+                    steps++;
+                    it2--;
+                    double dlon = it2->lon - p.lon;
+                    if (fabs(it2->lat - p.lat) > min_d) {
+                        it2 = latlons.begin(); // all successing
+                    } else {
+                        double cos_d = cos(it2->lat) * cos(p.lat) * cos(dlon) + sin(it2->lat) * sin(p.lat);
+                        if (cos_d > min_cos_d) { // closer distance
+                            min_cos_d = cos_d;
+                            min_d = acos(min_cos_d);
+                            p.x = it2->x;
+                            p.y = it2->y;
+                        }
+                    }
+                } while (it2 != latlons.begin());
+            }
 
-        pointsOnYAxis[i] = p.y;
-        pointsOnXAxis[i] = p.x;
-    }
-#ifdef _OPENMP
-    }
-#endif
+            pointsOnYAxis[i] = p.y;
+            pointsOnXAxis[i] = p.x;
+        }
+    }, TASK_STAGE_INTERPOLATE);
 }
 
 /**
@@ -1218,6 +1202,40 @@ void transform_deg2rad(Iter begin, Iter end)
     typedef typename std::iterator_traits<Iter>::value_type Value;
     std::transform(begin, end, begin, std::bind1st(std::multiplies<Value>(), static_cast<Value>(DEG_TO_RAD)));
 }
+
+/**
+ * find the x and y dimensions of the longitude and latitude values of cs, and
+ * convert longitude and latitude axes of a latitude_longitude projection to matrices
+ * @param purpose name of the interpolation, used in error messages
+ */
+void lonLatValsOnXYDimensions(const CDM& orgCDM, CoordinateSystem_cp cs, const string& latitude, const string& purpose, shared_array<double>& lonVals,
+                              shared_array<double>& latVals, size_t& lonLatSize, string& orgXDimName, string& orgYDimName, size_t& orgXDimSize,
+                              size_t& orgYDimSize)
+{
+    const bool latLonProj = (cs->hasProjection() && (cs->getProjection()->getName() == "latitude_longitude"));
+    if (!latLonProj && cs->getGeoYAxis()->getName() == latitude) {
+        // x and y axis not properly defined, guessing
+        const vector<string>& latShape = orgCDM.getVariable(latitude).getShape();
+        if (latShape.size() != 2) {
+            throw CDMException("latitude needs 2 dims for " + purpose);
+        }
+        orgXDimName = latShape[0];
+        orgYDimName = latShape[1];
+    } else {
+        orgXDimName = cs->getGeoXAxis()->getName();
+        orgYDimName = cs->getGeoYAxis()->getName();
+    }
+    LOG4FIMEX(logger, Logger::DEBUG, "x and y axis: " << orgXDimName << "," << orgYDimName);
+    orgXDimSize = orgCDM.getDimension(orgXDimName).getLength();
+    orgYDimSize = orgCDM.getDimension(orgYDimName).getLength();
+    if (latLonProj) {
+        // create new latVals and lonVals as a matrix
+        lonLatVals2Matrix(lonVals, latVals, orgXDimSize, orgYDimSize);
+        lonLatSize = orgXDimSize * orgYDimSize;
+    }
+    if (lonLatSize != orgXDimSize * orgYDimSize)
+        throw CDMException("bad orgX/YSize");
+}
 } // namespace
 
 void CDMInterpolator::changeProjectionByForwardInterpolation(int method, const string& proj_input, const vector<double>& out_x_axis,
@@ -1267,32 +1285,10 @@ void CDMInterpolator::changeProjectionByForwardInterpolation(int method, const s
         transform_deg2rad(&orgYVals[0], &orgYVals[0] + orgXYSize);
         transform_deg2rad(&orgXVals[0], &orgXVals[0] + orgXYSize);
 
-        // FIXME the following part also appears in "changeProjectionByCoordinates"
         string orgXDimName, orgYDimName;
-        bool latLonProj = (cs->hasProjection() && (cs->getProjection()->getName() == "latitude_longitude"));
-        if (!latLonProj && cs->getGeoYAxis()->getName() == latitude) {
-            // x and y axis not properly defined, guessing
-            vector<string> latShape = p_->dataReader->getCDM().getVariable(latitude).getShape();
-            if (latShape.size() != 2) {
-                throw CDMException("latitude needs 2 dims for forward interpolation");
-            }
-            orgXDimName = latShape[0];
-            orgYDimName = latShape[1];
-        } else {
-            orgXDimName = cs->getGeoXAxis()->getName();
-            orgYDimName = cs->getGeoYAxis()->getName();
-        }
-        LOG4FIMEX(logger, Logger::DEBUG, "x and y axis: " << orgXDimName << "," << orgYDimName);
-        size_t orgXDimSize = p_->dataReader->getCDM().getDimension(orgXDimName).getLength();
-        size_t orgYDimSize = p_->dataReader->getCDM().getDimension(orgYDimName).getLength();
-        if (latLonProj) {
-            // create new latVals and lonVals as a matrix
-            lonLatVals2Matrix(orgXVals, orgYVals, orgXDimSize, orgYDimSize);
-            orgXYSize = orgXDimSize * orgYDimSize;
-        }
-        if (orgXYSize != orgXDimSize * orgYDimSize)
-            throw CDMException("bad orgX/YSize");
-        // FIXME end of identical part
+        size_t orgXDimSize, orgYDimSize;
+        lonLatValsOnXYDimensions(p_->dataReader->getCDM(), cs, latitude, "forward interpolation", orgXVals, orgYVals, orgXYSize, orgXDimName, orgYDimName, orgXDimSize,
+                                 orgYDimSize);
 
         // translate all input points to output-coordinates, stored in lonVals and latVals
         LOG4FIMEX(logger, Logger::DEBUG, "start reprojection of coordinates");
@@ -1316,6 +1312,65 @@ void CDMInterpolator::changeProjectionByForwardInterpolation(int method, const s
     }
 }
 
+void CDMInterpolator::changeProjectionByConservativeRemapping(const string& proj_input, const vector<double>& out_x_axis, const vector<double>& out_y_axis,
+                                                              const string& out_x_axis_unit, const string& out_y_axis_unit, CDMDataType out_x_axis_type,
+                                                              CDMDataType out_y_axis_type)
+{
+    // translate temporary new axes from deg2rad if required
+    vector<double> outXAxis = out_x_axis;
+    vector<double> outYAxis = out_y_axis;
+    std::regex degree(".*degree.*");
+    const bool xIsLongitude = std::regex_match(out_x_axis_unit, degree);
+    if (xIsLongitude)
+        transform_deg2rad(outXAxis.begin(), outXAxis.end());
+    if (std::regex_match(out_y_axis_unit, degree))
+        transform_deg2rad(outYAxis.begin(), outYAxis.end());
+
+    map<string, CoordinateSystem_cp> csMap = findBestCoordinateSystemsAndProjectionVars(false);
+
+    changeCDM(*cdm_.get(), proj_input, csMap, p_->projectionVariables, out_x_axis, out_y_axis, out_x_axis_unit, out_y_axis_unit, out_x_axis_type,
+              out_y_axis_type, getLongitudeName(), getLatitudeName());
+
+    for (map<string, CoordinateSystem_cp>::iterator csIt = csMap.begin(); csIt != csMap.end(); ++csIt) {
+        CoordinateSystem_cp cs = csIt->second;
+        const string& latitude = cs->findAxisOfType(CoordinateAxis::Lat)->getName();
+        const string& longitude = cs->findAxisOfType(CoordinateAxis::Lon)->getName();
+
+        shared_array<double> orgXVals, orgYVals;
+        size_t orgXYSize, orgXSize;
+        extractValues(p_->dataReader->getScaledData(longitude), orgXVals, orgXSize);
+        extractValues(p_->dataReader->getScaledData(latitude), orgYVals, orgXYSize);
+        assert(orgXYSize == orgXSize);
+
+        string orgXDimName, orgYDimName;
+        size_t orgXDimSize, orgYDimSize;
+        lonLatValsOnXYDimensions(p_->dataReader->getCDM(), cs, latitude, "conservative remapping", orgXVals, orgYVals, orgXYSize, orgXDimName, orgYDimName, orgXDimSize,
+                                 orgYDimSize);
+
+        InterpolationWeightsKey key;
+        key.add("conservative").add(proj_input).add(orgXDimName).add(orgYDimName);
+        key.add(orgXVals.get(), orgXYSize).add(orgYVals.get(), orgXYSize);
+        key.add(outXAxis).add(outYAxis);
+
+        p_->cachedInterpolation[csIt->first] = cachedOrCreateInterpolation(p_->weightsCache, key, [&]() {
+            // translate the input cell centres to output-coordinates
+            LOG4FIMEX(logger, Logger::DEBUG, "start reprojection of coordinates");
+            transform_deg2rad(&orgYVals[0], &orgYVals[0] + orgXYSize);
+            transform_deg2rad(&orgXVals[0], &orgXVals[0] + orgXYSize);
+            if (MIFI_OK != mifi_project_values(LAT_LON_PROJSTR.c_str(), proj_input.c_str(), &orgXVals[0], &orgYVals[0], orgXYSize)) {
+                throw CDMException("unable to project axes from " + LAT_LON_PROJSTR + " to " + proj_input);
+            }
+            LOG4FIMEX(logger, Logger::DEBUG, "creating conservative remapping " << orgXDimSize << "x" << orgYDimSize << " => " << outXAxis.size() << "x"
+                                                                                << outYAxis.size());
+            return createConservativeInterpolation(orgXDimName, orgYDimName, &orgXVals[0], &orgYVals[0], orgXDimSize, orgYDimSize, outXAxis, outYAxis,
+                                                   xIsLongitude);
+        });
+    }
+    if (hasXYSpatialVectors()) {
+        LOG4FIMEX(logger, Logger::WARN, "vector data found, but not possible to interpolate with conservative remapping");
+    }
+}
+
 void CDMInterpolator::changeProjectionByCoordinates(int method, const string& proj_input, const vector<double>& out_x_axis, const vector<double>& out_y_axis,
                                                     const string& out_x_axis_unit, const string& out_y_axis_unit, CDMDataType out_x_axis_type,
                                                     CDMDataType out_y_axis_type)
@@ -1375,29 +1430,36 @@ void CDMInterpolator::changeProjectionByCoordinates(int method, const string& pr
             lonLatVals2Matrix(lonVals, latVals, orgXDimSize, orgYDimSize);
         }
 
-        // get output axes expressed in latitude, longitude
-        const size_t fieldSize = outXAxis.size() * outYAxis.size();
-        vector<double> pointsOnXAxis(fieldSize);
-        vector<double> pointsOnYAxis(fieldSize);
-        if (MIFI_OK != mifi_project_axes(proj_input.c_str(), LAT_LON_PROJSTR.c_str(), &outXAxis[0], &outYAxis[0], outXAxis.size(), outYAxis.size(),
-                                         &pointsOnXAxis[0], &pointsOnYAxis[0])) {
-            throw CDMException("unable to project axes from latlon to " + proj_input);
-        }
-        if (method == MIFI_INTERPOL_COORD_NN) {
-            fastTranslatePointsToClosestInputCell(pointsOnXAxis, pointsOnYAxis, &lonVals[0], &latVals[0], orgXDimSize, orgYDimSize);
-        } else if (method == MIFI_INTERPOL_COORD_NN_KD) {
-            double maxDistance = getMaxDistanceOfInterest(out_x_axis, out_y_axis, isMetric);
-            flannTranslatePointsToClosestInputCell(maxDistance, pointsOnXAxis, pointsOnYAxis, outXAxis.size(), outYAxis.size(), &lonVals[0], &latVals[0],
-                                                   orgXDimSize, orgYDimSize);
-        } else {
-            throw CDMException("unkown interpolation method for coordinates: " + type2string(method));
-        }
+        const double maxDistance = (method == MIFI_INTERPOL_COORD_NN_KD) ? getMaxDistanceOfInterest(out_x_axis, out_y_axis, isMetric) : 0;
+        InterpolationWeightsKey key;
+        key.add("coordinates").add(method).add(proj_input).add(orgXDimName).add(orgYDimName);
+        key.add(lonVals.get(), orgXDimSize * orgYDimSize).add(latVals.get(), orgXDimSize * orgYDimSize);
+        key.add(outXAxis).add(outYAxis).add(&maxDistance, 1);
+
+        p_->cachedInterpolation[csIt->first] = cachedOrCreateInterpolation(p_->weightsCache, key, [&]() {
+            // get output axes expressed in latitude, longitude
+            const size_t fieldSize = outXAxis.size() * outYAxis.size();
+            vector<double> pointsOnXAxis(fieldSize);
+            vector<double> pointsOnYAxis(fieldSize);
+            if (MIFI_OK != mifi_project_axes(proj_input.c_str(), LAT_LON_PROJSTR.c_str(), &outXAxis[0], &outYAxis[0], outXAxis.size(), outYAxis.size(),
+                                             &pointsOnXAxis[0], &pointsOnYAxis[0])) {
+                throw CDMException("unable to project axes from latlon to " + proj_input);
+            }
+            if (method == MIFI_INTERPOL_COORD_NN) {
+                fastTranslatePointsToClosestInputCell(pointsOnXAxis, pointsOnYAxis, &lonVals[0], &latVals[0], orgXDimSize, orgYDimSize);
+            } else if (method == MIFI_INTERPOL_COORD_NN_KD) {
+                flannTranslatePointsToClosestInputCell(maxDistance, pointsOnXAxis, pointsOnYAxis, outXAxis.size(), outYAxis.size(), &lonVals[0],
+                                                       &latVals[0], orgXDimSize, orgYDimSize);
+            } else {
+                throw CDMException("unkown interpolation method for coordinates: " + type2string(method));
+            }
 
-        LOG4FIMEX(logger, Logger::DEBUG,
-                  "creating cached coordinate interpolation matrix " << orgXDimSize << "x" << orgYDimSize << " => " << out_x_axis.size() << "x"
-                                                                     << out_y_axis.size());
-        p_->cachedInterpolation[csIt->first] = createCachedInterpolation(orgXDimName, orgYDimName, method, pointsOnXAxis, pointsOnYAxis, orgXDimSize,
-                                                                         orgYDimSize, out_x_axis.size(), out_y_axis.size());
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "creating cached coordinate interpolation matrix " << orgXDimSize << "x" << orgYDimSize << " => " << out_x_axis.size() << "x"
+                                                                         << out_y_axis.size());
+            return createCachedInterpolation(orgXDimName, orgYDimName, method, pointsOnXAxis, pointsOnYAxis, orgXDimSize, orgYDimSize, out_x_axis.size(),
+                                             out_y_axis.size());
+        });
     }
 
     if (hasXYSpatialVectors()) {
@@ -1442,37 +1504,44 @@ void CDMInterpolator::changeProjectionByProjectionParameters(int method, const s
         extractValues(p_->dataReader->getScaledDataInUnit(orgXAxisName, orgUnit), orgXAxisValsArray, orgXAxisSize);
         extractValues(p_->dataReader->getScaledDataInUnit(orgYAxisName, orgUnit), orgYAxisValsArray, orgYAxisSize);
 
-        // calculate the mapping from the new projection points to the original axes pointsOnXAxis(x_new, y_new), pointsOnYAxis(x_new, y_new)
-        const size_t fieldSize = outXAxis.size() * outYAxis.size();
-        vector<double> pointsOnXAxis(fieldSize);
-        vector<double> pointsOnYAxis(fieldSize);
         const std::string orgProjStr = cs->getProjection()->getProj4String();
-        if (MIFI_OK != mifi_project_axes(proj_input.c_str(), orgProjStr.c_str(), &outXAxis[0], &outYAxis[0], outXAxis.size(), outYAxis.size(),
-                                         &pointsOnXAxis[0], &pointsOnYAxis[0])) {
-            throw CDMException("unable to project axes from " + orgProjStr + " to " + proj_input);
-        }
-        LOG4FIMEX(logger, Logger::DEBUG,
-                  "mifi_project_axes: " << proj_input << "," << orgProjStr << "," << outXAxis[0] << "," << outYAxis[0] << " => " << pointsOnXAxis[0] << ","
-                                        << pointsOnYAxis[0]);
-
-        // translate original axes from deg2rad if required
-        int miupXAxis = MIFI_PROJ_AXIS;
-        int miupYAxis = MIFI_PROJ_AXIS;
-        if (cs->getProjection()->isDegree()) {
-            miupXAxis = MIFI_LONGITUDE;
-            transform_deg2rad(&orgXAxisValsArray[0], &orgXAxisValsArray[0] + orgXAxisSize);
-            miupYAxis = MIFI_LATITUDE;
-            transform_deg2rad(&orgYAxisValsArray[0], &orgYAxisValsArray[0] + orgYAxisSize);
-        }
-        // translate coordinates (in rad or m) to indices
-        mifi_points2position(&pointsOnXAxis[0], fieldSize, orgXAxisValsArray.get(), orgXAxisSize, miupXAxis);
-        mifi_points2position(&pointsOnYAxis[0], fieldSize, orgYAxisValsArray.get(), orgYAxisSize, miupYAxis);
-
-        LOG4FIMEX(logger, Logger::DEBUG,
-                  "creating cached projection interpolation matrix " << orgXAxisSize << "x" << orgYAxisSize << " => " << out_x_axis.size() << "x"
-                                                                     << out_y_axis.size());
-        p_->cachedInterpolation[csIt->first] = createCachedInterpolation(orgXAxisName, orgYAxisName, method, pointsOnXAxis, pointsOnYAxis, orgXAxisSize,
-                                                                         orgYAxisSize, out_x_axis.size(), out_y_axis.size());
+        InterpolationWeightsKey key;
+        key.add("projection").add(method).add(proj_input).add(orgProjStr).add(orgXAxisName).add(orgYAxisName);
+        key.add(orgXAxisValsArray.get(), orgXAxisSize).add(orgYAxisValsArray.get(), orgYAxisSize);
+        key.add(outXAxis).add(outYAxis);
+
+        p_->cachedInterpolation[csIt->first] = cachedOrCreateInterpolation(p_->weightsCache, key, [&]() {
+            // calculate the mapping from the new projection points to the original axes pointsOnXAxis(x_new, y_new), pointsOnYAxis(x_new, y_new)
+            const size_t fieldSize = outXAxis.size() * outYAxis.size();
+            vector<double> pointsOnXAxis(fieldSize);
+            vector<double> pointsOnYAxis(fieldSize);
+            if (MIFI_OK != mifi_project_axes(proj_input.c_str(), orgProjStr.c_str(), &outXAxis[0], &outYAxis[0], outXAxis.size(), outYAxis.size(),
+                                             &pointsOnXAxis[0], &pointsOnYAxis[0])) {
+                throw CDMException("unable to project axes from " + orgProjStr + " to " + proj_input);
+            }
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "mifi_project_axes: " << proj_input << "," << orgProjStr << "," << outXAxis[0] << "," << outYAxis[0] << " => " << pointsOnXAxis[0]
+                                            << "," << pointsOnYAxis[0]);
+
+            // translate original axes from deg2rad if required
+            int miupXAxis = MIFI_PROJ_AXIS;
+            int miupYAxis = MIFI_PROJ_AXIS;
+            if (cs->getProjection()->isDegree()) {
+                miupXAxis = MIFI_LONGITUDE;
+                transform_deg2rad(&orgXAxisValsArray[0], &orgXAxisValsArray[0] + orgXAxisSize);
+                miupYAxis = MIFI_LATITUDE;
+                transform_deg2rad(&orgYAxisValsArray[0], &orgYAxisValsArray[0] + orgYAxisSize);
+            }
+            // translate coordinates (in rad or m) to indices
+            mifi_points2position(&pointsOnXAxis[0], fieldSize, orgXAxisValsArray.get(), orgXAxisSize, miupXAxis);
+            mifi_points2position(&pointsOnYAxis[0], fieldSize, orgYAxisValsArray.get(), orgYAxisSize, miupYAxis);
+
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "creating cached projection interpolation matrix " << orgXAxisSize << "x" << orgYAxisSize << " => " << out_x_axis.size() << "x"
+                                                                         << out_y_axis.size());
+            return createCachedInterpolation(orgXAxisName, orgYAxisName, method, pointsOnXAxis, pointsOnYAxis, orgXAxisSize, orgYAxisSize, out_x_axis.size(),
+                                             out_y_axis.size());
+        });
         warnUnlessAllXYSpatialVectorsHaveSameHorizontalId(csIt->first);
 
         if (hasXYSpatialVectors()) {
@@ -1751,43 +1820,50 @@ void CDMInterpolator::changeProjectionByProjectionParametersToLatLonTemplate(int
         // as template data is in degrees we have to do deg2rad
         shared_array<double> tmplLatArray = tmplLatVals->asDouble();
         shared_array<double> tmplLonArray = tmplLonVals->asDouble();
-        vector<double> latY(tmplLatArray.get(), tmplLatArray.get()+tmplLatVals->size());
-        vector<double> lonX(tmplLonArray.get(), tmplLonArray.get()+tmplLonVals->size());
-        transform_deg2rad(&latY[0], &latY[0] + tmplLatVals->size());
-        transform_deg2rad(&lonX[0], &lonX[0] + tmplLonVals->size());
 
-        // calculate the mapping from the new projection points to the original axes pointsOnXAxis(x_new, y_new), pointsOnYAxis(x_new, y_new)
+        InterpolationWeightsKey key;
+        key.add("latlon-template").add(method).add(tmpl_proj_input).add(orgProjStr).add(def.xAxisName).add(def.yAxisName);
+        key.add(orgXAxisArray.get(), def.xAxisData->size()).add(orgYAxisArray.get(), def.yAxisData->size());
+        key.add(tmplLonArray.get(), tmplLonVals->size()).add(tmplLatArray.get(), tmplLatVals->size());
+        key.add(out_x_axis.size()).add(out_y_axis.size());
 
-        // projects lat / lon from template to axis-projection found in model file
-        // we want to get template lat/long expressed in terms of the original projection
-        if (MIFI_OK != mifi_project_values(tmpl_proj_input.c_str(), orgProjStr.c_str(), &lonX[0], &latY[0], tmplLatVals->size())) {
-            throw CDMException("unable to project values from "+orgProjStr+ " to " +tmpl_proj_input.c_str());
-        }
-        LOG4FIMEX(logger, Logger::DEBUG,
-                  "mifi_project_values: " << tmpl_proj_input << "," << orgProjStr << "," << out_x_axis[0] << "," << out_y_axis[0] << " => " << lonX[0] << ","
-                                          << latY[0]);
-
-        // now latVals and lonVals are given in original-input coordinates
-        // check if we have to translate original axes from deg2rad
-        int miupXAxis = MIFI_PROJ_AXIS;
-        int miupYAxis = MIFI_PROJ_AXIS;
-
-        if (csp->isDegree()) {
-            miupXAxis = MIFI_LONGITUDE;
-            transform_deg2rad(orgXAxisArray.get(), orgXAxisArray.get() + def.xAxisData->size());
-            miupYAxis = MIFI_LATITUDE;
-            transform_deg2rad(orgYAxisArray.get(), orgYAxisArray.get() + def.yAxisData->size());
-        }
+        p_->cachedInterpolation[csi->first] = cachedOrCreateInterpolation(p_->weightsCache, key, [&]() {
+            vector<double> latY(tmplLatArray.get(), tmplLatArray.get() + tmplLatVals->size());
+            vector<double> lonX(tmplLonArray.get(), tmplLonArray.get() + tmplLonVals->size());
+
+            // calculate the mapping from the new projection points to the original axes pointsOnXAxis(x_new, y_new), pointsOnYAxis(x_new, y_new)
 
-        // translate coordinates (in radians) to indices
-        mifi_points2position(&latY[0], tmplLatVals->size(), orgYAxisArray.get(), def.yAxisData->size(), miupYAxis);
-        mifi_points2position(&lonX[0], tmplLonVals->size(), orgXAxisArray.get(), def.xAxisData->size(), miupXAxis);
+            // projects lat / lon (converted to radian in the same pass) from template to axis-projection found in model file
+            // we want to get template lat/long expressed in terms of the original projection
+            if (MIFI_OK != mifi_project_values_scaled(tmpl_proj_input.c_str(), orgProjStr.c_str(), &lonX[0], &latY[0], tmplLatVals->size(), DEG_TO_RAD, 1)) {
+                throw CDMException("unable to project values from " + orgProjStr + " to " + tmpl_proj_input.c_str());
+            }
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "mifi_project_values: " << tmpl_proj_input << "," << orgProjStr << "," << out_x_axis[0] << "," << out_y_axis[0] << " => " << lonX[0]
+                                              << "," << latY[0]);
+
+            // now latVals and lonVals are given in original-input coordinates
+            // check if we have to translate original axes from deg2rad
+            int miupXAxis = MIFI_PROJ_AXIS;
+            int miupYAxis = MIFI_PROJ_AXIS;
+
+            if (csp->isDegree()) {
+                miupXAxis = MIFI_LONGITUDE;
+                transform_deg2rad(orgXAxisArray.get(), orgXAxisArray.get() + def.xAxisData->size());
+                miupYAxis = MIFI_LATITUDE;
+                transform_deg2rad(orgYAxisArray.get(), orgYAxisArray.get() + def.yAxisData->size());
+            }
 
-        LOG4FIMEX(logger, Logger::DEBUG, "creating cached projection interpolation matrix ("<< csi->first << ") "
-                  << def.xAxisData->size() << "x" << def.yAxisData->size()
-                  << " => " << out_x_axis.size() << "x" << out_y_axis.size());
-        p_->cachedInterpolation[csi->first] = createCachedInterpolation(def.xAxisName, def.yAxisName, method, lonX, latY, def.xAxisData->size(),
-                                                                        def.yAxisData->size(), out_x_axis.size(), out_y_axis.size());
+            // translate coordinates (in radians) to indices
+            mifi_points2position(&latY[0], tmplLatVals->size(), orgYAxisArray.get(), def.yAxisData->size(), miupYAxis);
+            mifi_points2position(&lonX[0], tmplLonVals->size(), orgXAxisArray.get(), def.xAxisData->size(), miupXAxis);
+
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "creating cached projection interpolation matrix (" << csi->first << ") " << def.xAxisData->size() << "x" << def.yAxisData->size()
+                                                                          << " => " << out_x_axis.size() << "x" << out_y_axis.size());
+            return createCachedInterpolation(def.xAxisName, def.yAxisName, method, lonX, latY, def.xAxisData->size(), def.yAxisData->size(),
+                                             out_x_axis.size(), out_y_axis.size());
+        });
 
         warnUnlessAllXYSpatialVectorsHaveSameHorizontalId(csi->first);
 
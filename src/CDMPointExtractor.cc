@@ -0,0 +1,590 @@
+/*
+ * Fimex, CDMPointExtractor.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "fimex/CDMPointExtractor.h"
+
+#include "GridPointIndex.h"
+#include "TaskScheduler.h"
+#include "fimex/CDM.h"
+#include "fimex/CDMException.h"
+#include "fimex/CDMInterpolator.h"
+#include "fimex/CDMReaderUtils.h"
+#include "fimex/Data.h"
+#include "fimex/Logger.h"
+#include "fimex/SliceBuilder.h"
+#include "fimex/Type2String.h"
+#include "fimex/coordSys/CoordinateSystem.h"
+#include "fimex/interpolation.h"
+#include "fimex/mifi_constants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+
+namespace MetNoFimex {
+
+using namespace std;
+
+namespace {
+
+Logger_p logger = getLogger("fimex.CDMPointExtractor");
+
+//! points in the same block of the input grid are read together in one box
+const size_t POINT_BLOCK_SIZE = 64;
+
+//! input cells and weights of one point
+struct PointWeights
+{
+    size_t count; //!< number of cells, 0 if the point is outside the grid
+    size_t ix[4];
+    size_t iy[4];
+    float w[4];
+};
+
+//! box of the input grid read for a group of points
+struct ReadBox
+{
+    size_t x0, y0, nx, ny;
+    vector<size_t> points;
+};
+
+//! point extraction of one horizontal coordinate system
+struct PointPlan
+{
+    string xDim;
+    string yDim;
+    vector<PointWeights> weights;
+    vector<ReadBox> boxes;
+};
+
+typedef std::shared_ptr<PointPlan> PointPlan_p;
+
+double distanceSquare(const double* a, const double* b)
+{
+    const double d0 = a[0] - b[0], d1 = a[1] - b[1], d2 = a[2] - b[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+double dot(const double* a, const double* b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/**
+ * Find the grid cells and weights for a point at lon/lat (radian). The point must be within
+ * the distance of the closest grid point to its neighbours. For bilinear interpolation, the
+ * position inside the cell is found in the plane spanned by the cell's edges.
+ */
+PointWeights findPointWeights(const GridPointIndex& index, int method, double lon, double lat)
+{
+    PointWeights pw;
+    pw.count = 0;
+    size_t ix, iy;
+    if (!index.findClosest(lon, lat, 0, ix, iy))
+        return pw;
+
+    double q[3], p[3];
+    GridPointIndex::lonLat2Sphere(lon, lat, q);
+    index.point(ix, iy, p);
+    double maxDist = 0;
+    for (size_t y = (iy > 0 ? iy - 1 : 0); y <= iy + 1 && y < index.ny(); ++y) {
+        for (size_t x = (ix > 0 ? ix - 1 : 0); x <= ix + 1 && x < index.nx(); ++x) {
+            if (index.isValid(x, y)) {
+                double n[3];
+                index.point(x, y, n);
+                maxDist = std::max(maxDist, distanceSquare(p, n));
+            }
+        }
+    }
+    if (maxDist == 0 || distanceSquare(q, p) > maxDist)
+        return pw;
+
+    if (method == MIFI_INTERPOL_BILINEAR) {
+        // try the cells with the closest point as corner, use the one containing the point
+        double bestOutside = std::numeric_limits<double>::max();
+        size_t bestX = 0, bestY = 0;
+        double bestFx = 0, bestFy = 0;
+        for (size_t y0 = (iy > 0 ? iy - 1 : 0); y0 <= iy && y0 + 1 < index.ny(); ++y0) {
+            for (size_t x0 = (ix > 0 ? ix - 1 : 0); x0 <= ix && x0 + 1 < index.nx(); ++x0) {
+                if (!(index.isValid(x0, y0) && index.isValid(x0 + 1, y0) && index.isValid(x0, y0 + 1) && index.isValid(x0 + 1, y0 + 1)))
+                    continue;
+                double p00[3], p10[3], p01[3];
+                index.point(x0, y0, p00);
+                index.point(x0 + 1, y0, p10);
+                index.point(x0, y0 + 1, p01);
+                double a[3], b[3], d[3];
+                for (int k = 0; k < 3; ++k) {
+                    a[k] = p10[k] - p00[k];
+                    b[k] = p01[k] - p00[k];
+                    d[k] = q[k] - p00[k];
+                }
+                const double aa = dot(a, a), ab = dot(a, b), bb = dot(b, b);
+                const double det = aa * bb - ab * ab;
+                if (det <= 0)
+                    continue;
+                const double ad = dot(a, d), bd = dot(b, d);
+                const double fx = (bb * ad - ab * bd) / det;
+                const double fy = (aa * bd - ab * ad) / det;
+                const double outside = std::max(std::max(-fx, fx - 1), std::max(-fy, fy - 1));
+                if (outside < bestOutside) {
+                    bestOutside = outside;
+                    bestX = x0;
+                    bestY = y0;
+                    bestFx = std::min(1., std::max(0., fx));
+                    bestFy = std::min(1., std::max(0., fy));
+                }
+            }
+        }
+        if (bestOutside != std::numeric_limits<double>::max()) {
+            const double w[4] = {(1 - bestFx) * (1 - bestFy), bestFx * (1 - bestFy), (1 - bestFx) * bestFy, bestFx * bestFy};
+            for (size_t c = 0; c < 4; ++c) {
+                // corners without weight must not be read, they might be undefined
+                if (w[c] > 0) {
+                    pw.ix[pw.count] = bestX + (c % 2);
+                    pw.iy[pw.count] = bestY + (c / 2);
+                    pw.w[pw.count] = w[c];
+                    pw.count += 1;
+                }
+            }
+            return pw;
+        }
+        // no complete cell, e.g. at undefined grid-points, use the closest point
+    }
+    pw.count = 1;
+    pw.ix[0] = ix;
+    pw.iy[0] = iy;
+    pw.w[0] = 1;
+    return pw;
+}
+
+/**
+ * group the points by blocks of the input grid, and find the box of cells needed by each group
+ */
+vector<ReadBox> createReadBoxes(const vector<PointWeights>& weights)
+{
+    map<pair<size_t, size_t>, size_t> blockBoxes;
+    vector<ReadBox> boxes;
+    vector<size_t> x1, y1;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        const PointWeights& pw = weights[i];
+        if (pw.count == 0)
+            continue;
+        const size_t minX = *std::min_element(pw.ix, pw.ix + pw.count), maxX = *std::max_element(pw.ix, pw.ix + pw.count);
+        const size_t minY = *std::min_element(pw.iy, pw.iy + pw.count), maxY = *std::max_element(pw.iy, pw.iy + pw.count);
+        const pair<size_t, size_t> block(minX / POINT_BLOCK_SIZE, minY / POINT_BLOCK_SIZE);
+        map<pair<size_t, size_t>, size_t>::iterator it = blockBoxes.find(block);
+        if (it == blockBoxes.end()) {
+            it = blockBoxes.insert(make_pair(block, boxes.size())).first;
+            ReadBox box;
+            box.x0 = minX;
+            box.y0 = minY;
+            boxes.push_back(box);
+            x1.push_back(maxX);
+            y1.push_back(maxY);
+        }
+        const size_t b = it->second;
+        boxes[b].x0 = std::min(boxes[b].x0, minX);
+        boxes[b].y0 = std::min(boxes[b].y0, minY);
+        x1[b] = std::max(x1[b], maxX);
+        y1[b] = std::max(y1[b], maxY);
+        boxes[b].points.push_back(i);
+    }
+    for (size_t b = 0; b < boxes.size(); ++b) {
+        boxes[b].nx = x1[b] - boxes[b].x0 + 1;
+        boxes[b].ny = y1[b] - boxes[b].y0 + 1;
+    }
+    return boxes;
+}
+
+vector<double> degreeValuesInRadian(CDMReader_p reader, const string& varName)
+{
+    DataPtr data = reader->getScaledData(varName);
+    shared_array<double> vals = data->asDouble();
+    vector<double> rad(vals.get(), vals.get() + data->size());
+    for (size_t i = 0; i < rad.size(); ++i)
+        rad[i] *= MIFI_PI / 180;
+    return rad;
+}
+
+/**
+ * find the horizontal dimensions of the coordinate-system and the longitude and latitude
+ * of all grid-points in radian, x varying fastest
+ */
+void getGridLonLat(CDMReader_p reader, CoordinateSystem_cp cs, string& xDim, string& yDim, vector<double>& lonVals, vector<double>& latVals)
+{
+    const CDM& cdm = reader->getCDM();
+    const string& longitude = cs->findAxisOfType(CoordinateAxis::Lon)->getName();
+    const string& latitude = cs->findAxisOfType(CoordinateAxis::Lat)->getName();
+    const vector<string>& lonShape = cdm.getVariable(longitude).getShape();
+    const vector<string>& latShape = cdm.getVariable(latitude).getShape();
+    const vector<double> lon = degreeValuesInRadian(reader, longitude);
+    const vector<double> lat = degreeValuesInRadian(reader, latitude);
+    if (lonShape.size() == 1 && latShape.size() == 1) {
+        // latitude-longitude grid, create the matrix
+        xDim = lonShape[0];
+        yDim = latShape[0];
+        lonVals.resize(lon.size() * lat.size());
+        latVals.resize(lon.size() * lat.size());
+        for (size_t y = 0; y < lat.size(); ++y) {
+            std::copy(lon.begin(), lon.end(), lonVals.begin() + y * lon.size());
+            std::fill(latVals.begin() + y * lon.size(), latVals.begin() + (y + 1) * lon.size(), lat[y]);
+        }
+    } else if (lonShape.size() == 2 && lonShape == latShape) {
+        xDim = lonShape[0];
+        yDim = lonShape[1];
+        lonVals = lon;
+        latVals = lat;
+    } else {
+        throw CDMException("cannot use longitude '" + longitude + "' and latitude '" + latitude + "' for point extraction");
+    }
+}
+
+string uniqueVariableName(const CDM& cdm, const string& name)
+{
+    string unique = name;
+    for (int i = 1; cdm.hasVariable(unique) || cdm.hasDimension(unique); ++i)
+        unique = name + type2string(i);
+    return unique;
+}
+
+} // namespace
+
+struct CDMPointExtractor::Impl
+{
+    CDMReader_p dataReader;
+    string pointDim;
+    // varName -> horizontalId
+    map<string, string> pointVariables;
+    // horizontalId -> plan
+    map<string, PointPlan_p> plans;
+
+    PointPlan_p findPlan(const string& varName) const;
+    DataPtr extract(const CDM& cdm, const string& varName, const SliceBuilder& sb, const PointPlan& plan, const vector<size_t>& boxes,
+                    const vector<DataPtr>& inputs, size_t firstInput) const;
+};
+
+PointPlan_p CDMPointExtractor::Impl::findPlan(const string& varName) const
+{
+    map<string, string>::const_iterator itV = pointVariables.find(varName);
+    if (itV == pointVariables.end())
+        return PointPlan_p();
+    return plans.find(itV->second)->second;
+}
+
+CDMPointExtractor::CDMPointExtractor(CDMReader_p dataReader, int method, const vector<double>& lonVals, const vector<double>& latVals,
+                                     const string& pointDimName)
+    : p_(new Impl())
+{
+    if (method != MIFI_INTERPOL_NEAREST_NEIGHBOR && method != MIFI_INTERPOL_BILINEAR)
+        throw CDMException("point extraction method not supported: " + type2string(method));
+    if (lonVals.size() != latVals.size())
+        throw CDMException("number of longitude and latitude values differs: " + type2string(lonVals.size()) + " != " + type2string(latVals.size()));
+
+    p_->dataReader = dataReader;
+    p_->pointDim = pointDimName;
+    // make sure lat/lon points exist for all projections
+    generateProjectionCoordinates(dataReader);
+    map<string, CoordinateSystem_cp> csMap;
+    vector<string> incompatibleVariables;
+    if (0 == findBestHorizontalCoordinateSystems(false, dataReader, csMap, p_->pointVariables, incompatibleVariables))
+        throw CDMException("no coordinate-systems with longitude and latitude found");
+
+    *cdm_ = dataReader->getCDM();
+    for (const string& v : incompatibleVariables) {
+        LOG4FIMEX(logger, Logger::WARN, "removing variable " << v << " since it is not compatible with the point coordinates");
+        cdm_->removeVariable(v);
+        p_->pointVariables.erase(v);
+    }
+    if (cdm_->hasDimension(pointDimName))
+        throw CDMException("point dimension '" + pointDimName + "' exists already");
+
+    vector<double> pointLon(lonVals.size()), pointLat(latVals.size());
+    for (size_t i = 0; i < lonVals.size(); ++i) {
+        pointLon[i] = lonVals[i] * MIFI_PI / 180;
+        pointLat[i] = latVals[i] * MIFI_PI / 180;
+    }
+
+    for (const auto& csi : csMap) {
+        PointPlan_p plan = std::make_shared<PointPlan>();
+        vector<double> gridLon, gridLat;
+        getGridLonLat(dataReader, csi.second, plan->xDim, plan->yDim, gridLon, gridLat);
+        const size_t nx = cdm_->getDimension(plan->xDim).getLength();
+        const size_t ny = cdm_->getDimension(plan->yDim).getLength();
+        if (gridLon.size() != nx * ny)
+            throw CDMException("longitude/latitude do not match the dimensions " + plan->xDim + "," + plan->yDim);
+
+        const GridPointIndex index(&gridLon[0], &gridLat[0], nx, ny);
+        plan->weights.resize(pointLon.size());
+        parallelFor(
+            pointLon.size(), [&](size_t i) { plan->weights[i] = findPointWeights(index, method, pointLon[i], pointLat[i]); }, TASK_STAGE_INTERPOLATE);
+        plan->boxes = createReadBoxes(plan->weights);
+        if (logger->isEnabledFor(Logger::DEBUG)) {
+            size_t cells = 0;
+            for (const ReadBox& box : plan->boxes)
+                cells += box.nx * box.ny;
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "points on " << plan->xDim << "," << plan->yDim << ": " << plan->boxes.size() << " boxes with " << cells << " of " << nx * ny << " cells");
+        }
+        p_->plans[csi.first] = plan;
+    }
+
+    // change the shape of the point variables, and remove all other variables on the grid
+    set<string> gridMappings;
+    for (map<string, string>::iterator it = p_->pointVariables.begin(); it != p_->pointVariables.end();) {
+        const PointPlan& plan = *p_->plans[it->second];
+        CDMVariable& var = cdm_->getVariable(it->first);
+        vector<string> shape = var.getShape();
+        vector<string>::iterator x = std::find(shape.begin(), shape.end(), plan.xDim);
+        vector<string>::iterator y = std::find(shape.begin(), shape.end(), plan.yDim);
+        if (x == shape.end() || y == shape.end()) {
+            // e.g. the coordinate axes
+            p_->pointVariables.erase(it++);
+            continue;
+        }
+        *x = pointDimName;
+        shape.erase(std::find(shape.begin(), shape.end(), plan.yDim));
+        var.setShape(shape);
+        CDMAttribute gridMapping;
+        if (cdm_->getAttribute(it->first, "grid_mapping", gridMapping)) {
+            gridMappings.insert(gridMapping.getStringValue());
+            cdm_->removeAttribute(it->first, "grid_mapping");
+        }
+        ++it;
+    }
+    for (const auto& pi : p_->plans) {
+        for (const CDMVariable& v : CDM::VarVec(cdm_->getVariables())) {
+            const vector<string>& shape = v.getShape();
+            if (std::find(shape.begin(), shape.end(), pi.second->xDim) != shape.end() ||
+                std::find(shape.begin(), shape.end(), pi.second->yDim) != shape.end()) {
+                LOG4FIMEX(logger, Logger::DEBUG, "removing grid variable " << v.getName());
+                cdm_->removeVariable(v.getName());
+            }
+        }
+        cdm_->removeDimension(pi.second->xDim);
+        cdm_->removeDimension(pi.second->yDim);
+    }
+    for (const string& gm : gridMappings) {
+        if (cdm_->hasVariable(gm))
+            cdm_->removeVariable(gm);
+    }
+
+    // add the points
+    cdm_->addDimension(CDMDimension(pointDimName, lonVals.size()));
+    const vector<string> pointShape(1, pointDimName);
+    const string lonName = uniqueVariableName(*cdm_, "longitude");
+    CDMVariable lonVar(lonName, CDM_DOUBLE, pointShape);
+    lonVar.setData(createData(CDM_DOUBLE, lonVals.begin(), lonVals.end()));
+    cdm_->addVariable(lonVar);
+    cdm_->addAttribute(lonName, CDMAttribute("standard_name", "longitude"));
+    cdm_->addAttribute(lonName, CDMAttribute("units", "degrees_east"));
+    const string latName = uniqueVariableName(*cdm_, "latitude");
+    CDMVariable latVar(latName, CDM_DOUBLE, pointShape);
+    latVar.setData(createData(CDM_DOUBLE, latVals.begin(), latVals.end()));
+    cdm_->addVariable(latVar);
+    cdm_->addAttribute(latName, CDMAttribute("standard_name", "latitude"));
+    cdm_->addAttribute(latName, CDMAttribute("units", "degrees_north"));
+    for (const auto& pv : p_->pointVariables)
+        cdm_->addOrReplaceAttribute(pv.first, CDMAttribute("coordinates", lonName + " " + latName));
+    cdm_->addOrReplaceAttribute(CDM::globalAttributeNS(), CDMAttribute("featureType", "timeSeries"));
+}
+
+CDMPointExtractor::~CDMPointExtractor() {}
+
+DataPtr CDMPointExtractor::getDataSlice(const string& varName, size_t unLimDimPos)
+{
+    const CDMVariable& variable = cdm_->getVariable(varName);
+    if (variable.hasData())
+        return getDataSliceFromMemory(variable, unLimDimPos);
+    if (!p_->findPlan(varName))
+        return p_->dataReader->getDataSlice(varName, unLimDimPos);
+
+    SliceBuilder sb(*cdm_, varName);
+    if (const CDMDimension* unlimDim = cdm_->getUnlimitedDim()) {
+        if (cdm_->hasUnlimitedDim(variable))
+            sb.setStartAndSize(unlimDim->getName(), unLimDimPos, 1);
+    }
+    return getDataSlice(varName, sb);
+}
+
+DataPtr CDMPointExtractor::getDataSlice(const string& varName, const SliceBuilder& sb)
+{
+    return getDataSlices(DataSliceRequest_v(1, DataSliceRequest(varName, sb))).front();
+}
+
+vector<DataPtr> CDMPointExtractor::getDataSlices(const DataSliceRequest_v& requests)
+{
+    vector<DataPtr> results(requests.size());
+    vector<PointPlan_p> plans(requests.size());
+    vector<vector<size_t>> boxes(requests.size());
+    vector<size_t> firstInput(requests.size());
+
+    // collect the boxes of all requests
+    const CDM& inputCdm = p_->dataReader->getCDM();
+    DataSliceRequest_v inputRequests;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const DataSliceRequest& r = requests[i];
+        const CDMVariable& variable = cdm_->getVariable(r.varName);
+        if (variable.hasData()) {
+            results[i] = getDataSliceFromMemory(variable, r.sb);
+            continue;
+        }
+        firstInput[i] = inputRequests.size();
+        plans[i] = p_->findPlan(r.varName);
+        if (!plans[i]) {
+            inputRequests.push_back(r); // not on a grid, just forward
+            continue;
+        }
+        const PointPlan& plan = *plans[i];
+        SliceBuilder inputSb(inputCdm, r.varName);
+        size_t pointStart = 0, pointSize = 0;
+        const vector<string> dimNames = r.sb.getDimensionNames();
+        for (size_t d = 0; d < dimNames.size(); ++d) {
+            if (dimNames[d] == p_->pointDim) {
+                pointStart = r.sb.getDimensionStartPositions()[d];
+                pointSize = r.sb.getDimensionSizes()[d];
+            } else {
+                inputSb.setStartAndSize(dimNames[d], r.sb.getDimensionStartPositions()[d], r.sb.getDimensionSizes()[d]);
+            }
+        }
+        for (size_t b = 0; b < plan.boxes.size(); ++b) {
+            const ReadBox& box = plan.boxes[b];
+            const bool requested = std::any_of(box.points.begin(), box.points.end(),
+                                               [pointStart, pointSize](size_t p) { return p >= pointStart && p < pointStart + pointSize; });
+            if (requested) {
+                inputSb.setStartAndSize(plan.xDim, box.x0, box.nx);
+                inputSb.setStartAndSize(plan.yDim, box.y0, box.ny);
+                inputRequests.push_back(DataSliceRequest(r.varName, inputSb));
+                boxes[i].push_back(b);
+            }
+        }
+    }
+    const vector<DataPtr> inputs = p_->dataReader->getDataSlices(inputRequests);
+
+    parallelFor(
+        requests.size(),
+        [&](size_t i) {
+            if (results[i])
+                return;
+            if (!plans[i])
+                results[i] = inputs[firstInput[i]];
+            else
+                results[i] = p_->extract(*cdm_, requests[i].varName, requests[i].sb, *plans[i], boxes[i], inputs, firstInput[i]);
+        },
+        TASK_STAGE_INTERPOLATE);
+    return results;
+}
+
+DataPtr CDMPointExtractor::Impl::extract(const CDM& cdm, const string& varName, const SliceBuilder& sb, const PointPlan& plan, const vector<size_t>& boxes,
+                                         const vector<DataPtr>& inputs, size_t firstInput) const
+{
+    // output layout: strides of the point dimension and of the other dimensions
+    const vector<string> outDims = sb.getDimensionNames();
+    const vector<size_t>& outStart = sb.getDimensionStartPositions();
+    const vector<size_t>& outSizes = sb.getDimensionSizes();
+    size_t outSize = 1, pointStart = 0, pointSize = 1, pointStride = 0;
+    vector<string> otherDims;
+    vector<size_t> otherSizes, otherOutStrides;
+    for (size_t d = 0; d < outDims.size(); ++d) {
+        if (outDims[d] == pointDim) {
+            pointStart = outStart[d];
+            pointSize = outSizes[d];
+            pointStride = outSize;
+        } else {
+            otherDims.push_back(outDims[d]);
+            otherSizes.push_back(outSizes[d]);
+            otherOutStrides.push_back(outSize);
+        }
+        outSize *= outSizes[d];
+    }
+    size_t nOther = 1;
+    for (size_t s : otherSizes)
+        nOther *= s;
+
+    const double badValue = cdm.getFillValue(varName);
+    shared_array<float> out(new float[outSize]);
+    std::fill(out.get(), out.get() + outSize, MIFI_UNDEFINED_F);
+
+    const vector<string>& inShape = dataReader->getCDM().getVariable(varName).getShape();
+    for (size_t k = 0; k < boxes.size(); ++k) {
+        const ReadBox& box = plan.boxes[boxes[k]];
+        DataPtr data = inputs[firstInput + k];
+        if (!data || data->size() == 0)
+            continue;
+        const shared_array<float> in = data2InterpolationArray(data, badValue);
+
+        // input layout of the box
+        size_t inSize = 1, xStride = 0, yStride = 0;
+        vector<size_t> otherInStrides;
+        for (size_t d = 0; d < inShape.size(); ++d) {
+            if (inShape[d] == plan.xDim) {
+                xStride = inSize;
+                inSize *= box.nx;
+            } else if (inShape[d] == plan.yDim) {
+                yStride = inSize;
+                inSize *= box.ny;
+            } else {
+                otherInStrides.push_back(inSize);
+                inSize *= otherSizes.at(otherInStrides.size() - 1);
+            }
+        }
+        if (inSize != data->size())
+            throw CDMException("unexpected size of input data for point extraction of " + varName);
+
+        // offsets of all combinations of the other dimensions
+        vector<size_t> inBase(nOther), outBase(nOther);
+        vector<size_t> pos(otherSizes.size(), 0);
+        for (size_t o = 0; o < nOther; ++o) {
+            size_t ib = 0, ob = 0;
+            for (size_t d = 0; d < pos.size(); ++d) {
+                ib += pos[d] * otherInStrides[d];
+                ob += pos[d] * otherOutStrides[d];
+            }
+            inBase[o] = ib;
+            outBase[o] = ob;
+            for (size_t d = 0; d < pos.size() && ++pos[d] == otherSizes[d]; ++d)
+                pos[d] = 0;
+        }
+
+        for (size_t p : box.points) {
+            if (p < pointStart || p >= pointStart + pointSize)
+                continue;
+            const PointWeights& pw = plan.weights[p];
+            size_t offsets[4];
+            for (size_t c = 0; c < pw.count; ++c)
+                offsets[c] = (pw.ix[c] - box.x0) * xStride + (pw.iy[c] - box.y0) * yStride;
+            const size_t outPos = (p - pointStart) * pointStride;
+            for (size_t o = 0; o < nOther; ++o) {
+                const float* layer = &in[inBase[o]];
+                float value = 0;
+                for (size_t c = 0; c < pw.count; ++c)
+                    value += pw.w[c] * layer[offsets[c]];
+                out[outBase[o] + outPos] = value;
+            }
+        }
+    }
+    return interpolationArray2Data(cdm.getVariable(varName).getDataType(), out, outSize, badValue);
+}
+
+} // namespace MetNoFimex
@@ -39,8 +39,12 @@
 #include "fimex/coordSys/verticalTransform/HybridSigmaPressure1.h"
 #include "fimex/interpolation.h"
 
+#include "BufferPool.h"
+#include "MutexLock.h"
+
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <functional>
 #include <set>
 
@@ -55,11 +59,12 @@ typedef map<string, CoordinateSystem_cp> CoordSysMap;
 
 typedef std::shared_ptr<CachedVectorReprojection> CachedVectorReprojection_p;
 
-struct SliceCache {
-    string varName;
+//! slice of a variable at an unlimited position, used as running state for (de-)accumulation
+struct RunningSlice {
     size_t ulimDimPos;
     DataPtr data;
 };
+typedef map<string, RunningSlice> RunningSliceMap;
 
 struct VerticalVelocityComps {
     string wVarName;
@@ -96,7 +101,11 @@ struct CDMProcessor::CDMProcessorImpl
     map<string, pair<string, string> > rotateLatLonVectorY;
     // horizontalId -> cachedVectorReprojection
     map<string, CachedVectorReprojection_p> cachedVectorReprojection;
-    SliceCache sliceCache;
+    OmpMutex runningMutex;
+    // variable -> sum of the slices up to ulimDimPos
+    RunningSliceMap accumulated;
+    // variable -> slice at ulimDimPos, before deaccumulation
+    RunningSliceMap deaccumulatePrevious;
     VerticalVelocityComps vvComp;
 };
 
@@ -470,27 +479,175 @@ struct UnScaleOffset : public std::unary_function<double, T>
     }
 };
 
-static void replaceNanWith0(shared_array<double> dp, size_t n)
+namespace {
+
+template <typename T>
+shared_array<T> valuesAs(DataPtr data);
+template <>
+shared_array<float> valuesAs<float>(DataPtr data)
+{
+    return data->asFloat();
+}
+template <>
+shared_array<double> valuesAs<double>(DataPtr data)
+{
+    return data->asDouble();
+}
+
+//! copy of the slice of the first time step, with undef replaced by 0
+template <typename T>
+DataPtr firstStepOf(DataPtr data)
+{
+    const size_t n = data->size();
+    if (n == 0)
+        return data;
+    const shared_array<T> d = valuesAs<T>(data);
+    shared_array<T> out = make_pooled_array<T>(n);
+    for (size_t i = 0; i < n; ++i)
+        out[i] = std::isnan(d[i]) ? 0 : d[i];
+    return createData(n, out);
+}
+
+//! values of data in an array not shared with data, or with the reader of data
+template <typename T>
+shared_array<T> privateValuesAs(DataPtr data);
+template <>
+shared_array<float> privateValuesAs<float>(DataPtr data)
+{
+    return (data->getDataType() == CDM_FLOAT) ? data->clone()->asFloat() : data->asFloat();
+}
+template <>
+shared_array<double> privateValuesAs<double>(DataPtr data)
+{
+    return (data->getDataType() == CDM_DOUBLE) ? data->clone()->asDouble() : data->asDouble();
+}
+
+//! add the values of data to the running sum total of size n, total must be private
+template <typename T>
+void addSliceValues(shared_array<T>& total, size_t& n, DataPtr data)
 {
-    mifi_nand2bad(&dp[0], &dp[0]+n, 0);
+    const size_t size = data->size();
+    if (size == 0)
+        return;
+    if (n == 0) {
+        total = privateValuesAs<T>(data);
+        n = size;
+        return;
+    }
+    if (n != size)
+        throw CDMException("accumulate: slices with different sizes");
+    const shared_array<T> d = valuesAs<T>(data);
+    for (size_t i = 0; i < n; ++i)
+        total[i] += d[i];
 }
 
-// add d2 to d1 and return d1
-static void addDataP2Data(DataPtr& data, DataPtr& dataP, bool addingFirstTimeStep) {
+//! data - previous, in a new array
+template <typename T>
+DataPtr subtractSlices(DataPtr data, DataPtr previous)
+{
+    const size_t n = data->size();
+    if (n != previous->size())
+        throw CDMException("deaccumulate: slices with different sizes");
+    const shared_array<T> d = valuesAs<T>(data);
+    const shared_array<T> p = valuesAs<T>(previous);
+    shared_array<T> out = make_pooled_array<T>(n);
+    for (size_t i = 0; i < n; ++i)
+        out[i] = d[i] - p[i];
+    return createData(n, out);
+}
+
+//! data sharing the values of a cached slice, copy-on-write
+DataPtr shareSlice(DataPtr data)
+{
+    const size_t n = data->size();
+    if (n == 0)
+        return data;
+    const vector<size_t> size(1, n);
+    return data->slice(size, vector<size_t>(1, 0), size);
+}
+
+bool findRunningSlice(OmpMutex& mutex, const RunningSliceMap& slices, const string& varName, RunningSlice& slice)
+{
+    OmpScopedLock lock(mutex);
+    RunningSliceMap::const_iterator it = slices.find(varName);
+    if (it == slices.end())
+        return false;
+    slice = it->second;
+    return true;
+}
+
+void setRunningSlice(OmpMutex& mutex, RunningSliceMap& slices, const string& varName, size_t ulimDimPos, DataPtr data)
+{
+    OmpScopedLock lock(mutex);
+    RunningSlice& slice = slices[varName];
+    slice.ulimDimPos = ulimDimPos;
+    slice.data = data;
+}
+
+} // namespace
+
+template <typename T>
+DataPtr CDMProcessor::accumulateSlice(const std::string& varName, size_t unLimDimPos, DataPtr data)
+{
+    if (unLimDimPos == 0) { // cannot accumulate first
+        setRunningSlice(p_->runningMutex, p_->accumulated, varName, 0, firstStepOf<T>(data));
+        return data;
+    }
+
+    // continue from the running sum of this variable, or from the first time step
+    size_t start = 1;
+    DataPtr sum;
+    RunningSlice running;
+    if (findRunningSlice(p_->runningMutex, p_->accumulated, varName, running) && running.ulimDimPos <= unLimDimPos) {
+        if (running.ulimDimPos == unLimDimPos)
+            return shareSlice(running.data);
+        start = running.ulimDimPos + 1;
+        sum = running.data;
+    } else {
+        sum = firstStepOf<T>(p_->dataReader->getDataSlice(varName, 0));
+    }
+    // one private copy of the running sum, the slices of the reader are only read
+    shared_array<T> total;
+    size_t n = 0;
+    addSliceValues<T>(total, n, sum);
+    for (size_t i = start; i < unLimDimPos; ++i)
+        addSliceValues<T>(total, n, p_->dataReader->getDataSlice(varName, i));
+    addSliceValues<T>(total, n, data);
+    sum = (n == 0) ? data : createData(n, total);
+
+    setRunningSlice(p_->runningMutex, p_->accumulated, varName, unLimDimPos, sum);
+    return shareSlice(sum);
+}
+
+template <typename T>
+DataPtr CDMProcessor::deAccumulateSlice(const std::string& varName, size_t unLimDimPos, DataPtr data, bool keepSlice)
+{
+    if (unLimDimPos == 0) { // cannot deaccumulate first
+        if (keepSlice) {
+            setRunningSlice(p_->runningMutex, p_->deaccumulatePrevious, varName, 0, data);
+            return shareSlice(data);
+        }
+        return data;
+    }
+
+    DataPtr dataP;
+    RunningSlice running;
+    if (keepSlice && findRunningSlice(p_->runningMutex, p_->deaccumulatePrevious, varName, running) && running.ulimDimPos + 1 == unLimDimPos)
+        dataP = running.data;
+    else
+        dataP = p_->dataReader->getDataSlice(varName, unLimDimPos - 1);
+    if (keepSlice)
+        setRunningSlice(p_->runningMutex, p_->deaccumulatePrevious, varName, unLimDimPos, data);
+
     if ((data->size() != 0) && (dataP->size() != 0)) {
-        assert(data->size() == dataP->size());
-        shared_array<double> d = data->asDouble();
-        shared_array<double> dp = dataP->asDouble();
-        if (addingFirstTimeStep) {
+        if (unLimDimPos == 1) {
             // in step 0, replace undef with 0
-            replaceNanWith0(dp, dataP->size());
+            dataP = firstStepOf<T>(dataP);
         }
-        // this might modify the original data in the reader
-        std::transform(&d[0], &d[0]+data->size(), &dp[0], &d[0], std::plus<double>());
-        data = createData(data->size(), d);
-    } else if (dataP->size() != 0) {
-        data = dataP; // data->size was 0
+        // the kept slice is only read, the difference is a new array
+        return subtractSlices<T>(data, dataP);
     }
+    return keepSlice ? shareSlice(data) : data;
 }
 
 DataPtr CDMProcessor::getDataSlice(const std::string& varName, size_t unLimDimPos)
@@ -534,50 +691,20 @@ DataPtr CDMProcessor::getDataSlice(const std::string& varName, size_t unLimDimPo
         data = p_->dataReader->getDataSlice(varName, unLimDimPos);
     }
 
-    // accumulation
-    if (p_->accumulateVars.find(varName) != p_->accumulateVars.end()) {
+    // accumulation and deaccumulation, in float for float variables
+    const bool accumulate = (p_->accumulateVars.find(varName) != p_->accumulateVars.end());
+    const bool deaccumulate = (p_->deaccumulateVars.find(varName) != p_->deaccumulateVars.end());
+    const bool asFloat = (accumulate || deaccumulate) && (p_->dataReader->getCDM().getVariable(varName).getDataType() == CDM_FLOAT);
+    if (accumulate) {
         LOG4FIMEX(logger, Logger::DEBUG, varName << " at slice " << unLimDimPos << " accumulate");
-        if (unLimDimPos > 0) { // cannot accumulate first
-            size_t start = 0;
-            if (p_->sliceCache.varName == varName && p_->sliceCache.ulimDimPos <= unLimDimPos) {
-                start = p_->sliceCache.ulimDimPos + 1;
-                if (p_->sliceCache.ulimDimPos == unLimDimPos) {
-                    data = p_->sliceCache.data;
-                } else {
-                    DataPtr dataP = p_->sliceCache.data;
-                    addDataP2Data(data, dataP, false);
-                }
-            }
-            // data contains last slice + eventually cache
-            for (size_t i = start; i <= unLimDimPos-1; ++i) {
-                DataPtr dataP = p_->dataReader->getDataSlice(varName, i);
-                addDataP2Data(data, dataP, i == 0);
-            }
-            // fill the cache
-            p_->sliceCache.varName = varName;
-            p_->sliceCache.ulimDimPos = unLimDimPos;
-            p_->sliceCache.data = data;
-        }
+        data = asFloat ? accumulateSlice<float>(varName, unLimDimPos, data) : accumulateSlice<double>(varName, unLimDimPos, data);
     }
-
-    // deaccumulation
-    if (p_->deaccumulateVars.find(varName) != p_->deaccumulateVars.end()) {
+    if (deaccumulate) {
         LOG4FIMEX(logger, Logger::DEBUG, varName << " at slice " << unLimDimPos << " deaccumulate");
-        if (unLimDimPos != 0) { // cannot deaccumulate first
-            DataPtr dataP = p_->dataReader->getDataSlice(varName, unLimDimPos-1);
-            if ((data->size() != 0) && (dataP->size() != 0)) {
-                assert(data->size() == dataP->size());
-                shared_array<double> d = data->asDouble();
-                shared_array<double> dp = dataP->asDouble();
-                if (unLimDimPos == 1) {
-                    // in step 0, replace undef with 0
-                    replaceNanWith0(dp, dataP->size());
-                }
-                // this might modify the original data in the reader
-                std::transform(&d[0], &d[0]+data->size(), &dp[0], &d[0], std::minus<double>());
-                data = createData(data->size(), d);
-            }
-        }
+        // the running slice must be the raw slice from the reader, not the accumulated one
+        const bool keepSlice = !accumulate;
+        data = asFloat ? deAccumulateSlice<float>(varName, unLimDimPos, data, keepSlice)
+                       : deAccumulateSlice<double>(varName, unLimDimPos, data, keepSlice);
     }
 
     if (p_->rotateLatLonVectorX.find(varName) != p_->rotateLatLonVectorX.end()
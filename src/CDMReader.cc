@@ -32,6 +32,8 @@
 #include "fimex/UnitsConverter.h"
 #include "fimex/mifi_constants.h"
 
+#include "TaskScheduler.h"
+
 #include <cassert>
 #include <functional>
 #include <numeric>
@@ -144,6 +146,47 @@ DataPtr CDMReader::getDataSlice(const std::string& varName, const SliceBuilder&
     return retData;
 }
 
+std::vector<DataPtr> CDMReader::getDataSlices(const DataSliceRequest_v& requests)
+{
+    std::vector<DataPtr> data;
+    data.reserve(requests.size());
+    for (const DataSliceRequest& r : requests)
+        data.push_back(readDataSliceRequest(r));
+    return data;
+}
+
+DataPtr CDMReader::readDataSliceRequest(const DataSliceRequest& request)
+{
+    const CDMVariable& variable = cdm_->getVariable(request.varName);
+    const CDMDimension* unLimDim = cdm_->getUnlimitedDim();
+    if (!variable.hasData() && unLimDim && cdm_->hasUnlimitedDim(variable)) {
+        const std::vector<std::string> dimNames = request.sb.getDimensionNames();
+        const std::vector<size_t>& start = request.sb.getDimensionStartPositions();
+        const std::vector<size_t>& size = request.sb.getDimensionSizes();
+        const std::vector<size_t>& maxSize = request.sb.getMaxDimensionSizes();
+        bool completeSlice = true;
+        size_t unLimDimPos = 0;
+        for (size_t i = 0; completeSlice && i < dimNames.size(); ++i) {
+            if (dimNames[i] == unLimDim->getName()) {
+                unLimDimPos = start[i];
+                completeSlice = (size[i] == 1);
+            } else {
+                completeSlice = (start[i] == 0 && size[i] == maxSize[i]);
+            }
+        }
+        if (completeSlice)
+            return getDataSlice(request.varName, unLimDimPos);
+    }
+    return getDataSlice(request.varName, request.sb);
+}
+
+std::vector<DataPtr> CDMReader::readDataSliceRequestsParallel(const DataSliceRequest_v& requests)
+{
+    std::vector<DataPtr> data(requests.size());
+    parallelFor(requests.size(), [&](size_t i) { data[i] = readDataSliceRequest(requests[i]); }, TASK_STAGE_READ);
+    return data;
+}
+
 DataPtr CDMReader::getData(const std::string& varName)
 {
     const CDMVariable& variable = cdm_->getVariable(varName);
@@ -204,15 +247,8 @@ DataPtr CDMReader::scaleDataOf(const std::string& varName, DataPtr data, UnitsCo
 DataPtr CDMReader::scaleDataToUnitOf(const std::string& varName, DataPtr data, const std::string& newUnit)
 {
     std::string myUnit = cdm_->getUnits(varName);
-    UnitsConverter_p uc = Units().getConverter(myUnit, newUnit);
-    if (uc->isLinear()) {
-        // performance optimization, >3x faster
-        double unitOffset = 0.;
-        double unitScale = 1.;
-        uc->getScaleOffset(unitScale, unitOffset);
-        return scaleDataOf(varName, data, unitScale, unitOffset);
-    }
-    return scaleDataOf(varName, data, uc);
+    // linear converters are merged into scale and offset by convertDataType
+    return scaleDataOf(varName, data, Units().getConverter(myUnit, newUnit));
 }
 
 DataPtr CDMReader::getScaledDataSlice(const std::string& varName, size_t unLimDimPos)
@@ -254,9 +290,13 @@ DataPtr CDMReader::getDataSliceFromMemory(const CDMVariable& variable, size_t un
             // cut out the unlimited dim data
             std::vector<size_t> dims = getDimsSlice(variable.getName());
             size_t sliceSize = accumulate(dims.begin(), dims.end(), 1, std::multiplies<size_t>());
+            if (data->getDataType() == variable.getDataType() && (unLimDimPos + 1) * sliceSize <= data->size()) {
+                // shares the memory, copy-on-write
+                return data->slice({data->size()}, {unLimDimPos * sliceSize}, {sliceSize});
+            }
             return createDataSlice(variable.getDataType(), *data, unLimDimPos * sliceSize, sliceSize);
         } else {
-            return data->clone();
+            return data->slice({data->size()}, {0}, {data->size()});
         }
     } else {
         return DataPtr();
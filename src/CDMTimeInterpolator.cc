@@ -31,15 +31,21 @@
 #include "fimex/Data.h"
 #include "fimex/DataUtils.h"
 #include "fimex/Logger.h"
+#include "fimex/SliceBuilder.h"
 #include "fimex/TimeSpec.h"
 #include "fimex/Units.h"
 #include "fimex/coordSys/CoordinateSystem.h"
 #include "fimex/interpolation.h"
 
+#include "BufferPool.h"
+#include "MutexLock.h"
+
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <list>
 #include <set>
+#include <sstream>
 #include <utility>
 
 namespace MetNoFimex {
@@ -69,8 +75,194 @@ static std::string getTimeAxis(const CoordinateSystem_cp_v& cs, const std::strin
     return std::string();
 }
 
+namespace {
+//! one time-step of the input, with the values converted to float when needed
+struct TimeStep
+{
+    DataPtr data;
+    shared_array<float> values;
+
+    const float* floats()
+    {
+        if (!values && data->size() != 0)
+            values = data->asFloat();
+        return values.get();
+    }
+
+    //! memory used by data and, for non-float data, the converted values
+    size_t bytes() const
+    {
+        if (!data)
+            return 0;
+        size_t b = data->size() * data->bytes_for_one();
+        if (values && data->getDataType() != CDM_FLOAT)
+            b += data->size() * sizeof(float);
+        return b;
+    }
+};
+
+size_t dataBytes(const DataPtr& data)
+{
+    return data ? data->size() * data->bytes_for_one() : 0;
+}
+} // namespace
+
+struct CDMTimeInterpolator::Impl
+{
+    //! input and output time-steps of one variable and spatial subset
+    struct TimeWindow
+    {
+        std::string key;
+        std::map<size_t, TimeStep> inputs; //!< by input time-position
+        std::map<size_t, DataPtr> outputs; //!< by output time-position, batch mode only
+        size_t bytes;
+
+        TimeWindow()
+            : bytes(0)
+        {
+        }
+    };
+    typedef std::list<TimeWindow> WindowList;
+
+    SharedMutex mutex;
+    //! most recently used first
+    WindowList windows;
+    size_t cachedBytes;
+    size_t maxBytes;
+    bool batchMode;
+
+    Impl()
+        : mutex("time interpolator")
+        , cachedBytes(0)
+        , maxBytes(64 * 1024 * 1024)
+        , batchMode(false)
+    {
+    }
+
+    TimeWindow* window(const std::string& key, bool create);
+    void shrink();
+    bool findInput(const std::string& key, size_t orgPos, TimeStep& step);
+    void addInput(const std::string& key, size_t orgPos, const TimeStep& step, size_t firstNeeded);
+    DataPtr takeOutput(const std::string& key, size_t pos);
+    void addOutputs(const std::string& key, const std::map<size_t, DataPtr>& outputs);
+    void finish(const std::string& key);
+};
+
+//! find the window for key, or create it when data will be added, mutex must be locked
+CDMTimeInterpolator::Impl::TimeWindow* CDMTimeInterpolator::Impl::window(const std::string& key, bool create)
+{
+    if (maxBytes == 0)
+        return 0;
+    WindowList::iterator it = windows.begin();
+    while (it != windows.end() && it->key != key)
+        ++it;
+    if (it != windows.end()) {
+        windows.splice(windows.begin(), windows, it);
+    } else if (!create) {
+        return 0;
+    } else {
+        windows.push_front(TimeWindow());
+        windows.front().key = key;
+    }
+    return &windows.front();
+}
+
+//! drop the least recently used windows until maxBytes is reached, mutex must be locked
+void CDMTimeInterpolator::Impl::shrink()
+{
+    while (cachedBytes > maxBytes && !windows.empty()) {
+        cachedBytes -= windows.back().bytes;
+        windows.pop_back();
+    }
+}
+
+bool CDMTimeInterpolator::Impl::findInput(const std::string& key, size_t orgPos, TimeStep& step)
+{
+    ExclusiveLock lock(mutex);
+    if (TimeWindow* w = window(key, false)) {
+        std::map<size_t, TimeStep>::const_iterator it = w->inputs.find(orgPos);
+        if (it != w->inputs.end()) {
+            step = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CDMTimeInterpolator::Impl::addInput(const std::string& key, size_t orgPos, const TimeStep& step, size_t firstNeeded)
+{
+    ExclusiveLock lock(mutex);
+    if (TimeWindow* w = window(key, true)) {
+        const std::map<size_t, TimeStep>::iterator needed = w->inputs.lower_bound(firstNeeded);
+        for (std::map<size_t, TimeStep>::iterator it = w->inputs.begin(); it != needed; ++it) {
+            w->bytes -= it->second.bytes();
+            cachedBytes -= it->second.bytes();
+        }
+        w->inputs.erase(w->inputs.begin(), needed);
+        TimeStep& cached = w->inputs[orgPos];
+        w->bytes += step.bytes() - cached.bytes();
+        cachedBytes += step.bytes() - cached.bytes();
+        cached = step;
+        shrink();
+    }
+}
+
+DataPtr CDMTimeInterpolator::Impl::takeOutput(const std::string& key, size_t pos)
+{
+    DataPtr data;
+    ExclusiveLock lock(mutex);
+    if (TimeWindow* w = window(key, false)) {
+        std::map<size_t, DataPtr>::iterator it = w->outputs.find(pos);
+        if (it != w->outputs.end()) {
+            data = it->second;
+            w->bytes -= dataBytes(data);
+            cachedBytes -= dataBytes(data);
+            w->outputs.erase(it);
+            if (w->outputs.empty() && w->inputs.empty())
+                windows.pop_front();
+        }
+    }
+    return data;
+}
+
+void CDMTimeInterpolator::Impl::addOutputs(const std::string& key, const std::map<size_t, DataPtr>& outputs)
+{
+    ExclusiveLock lock(mutex);
+    if (TimeWindow* w = window(key, true)) {
+        for (const auto& o : w->outputs) {
+            w->bytes -= dataBytes(o.second);
+            cachedBytes -= dataBytes(o.second);
+        }
+        w->outputs = outputs;
+        for (const auto& o : w->outputs) {
+            w->bytes += dataBytes(o.second);
+            cachedBytes += dataBytes(o.second);
+        }
+        shrink();
+    }
+}
+
+//! drop the input time-steps of key, and the window when all outputs have been taken
+void CDMTimeInterpolator::Impl::finish(const std::string& key)
+{
+    ExclusiveLock lock(mutex);
+    for (WindowList::iterator it = windows.begin(); it != windows.end(); ++it) {
+        if (it->key == key) {
+            for (const auto& i : it->inputs) {
+                it->bytes -= i.second.bytes();
+                cachedBytes -= i.second.bytes();
+            }
+            it->inputs.clear();
+            if (it->outputs.empty())
+                windows.erase(it);
+            return;
+        }
+    }
+}
+
 CDMTimeInterpolator::CDMTimeInterpolator(CDMReader_p dataReader)
    : dataReader_(dataReader)
+   , p_(new Impl)
 {
     coordSystems_ = listCoordinateSystems(dataReader_);
     *cdm_ = dataReader_->getCDM();
@@ -88,11 +280,24 @@ CDMTimeInterpolator::~CDMTimeInterpolator()
 {
 }
 
+void CDMTimeInterpolator::setTimeWindowCacheSize(size_t maxBytes)
+{
+    ExclusiveLock lock(p_->mutex);
+    p_->maxBytes = maxBytes;
+    p_->shrink();
+}
+
+void CDMTimeInterpolator::setBatchMode(bool batch)
+{
+    ExclusiveLock lock(p_->mutex);
+    p_->batchMode = batch;
+}
+
 DataPtr CDMTimeInterpolator::getDataSlice(const std::string& varName, size_t unLimDimPos)
 {
     const std::string timeAxis = getTimeAxis(coordSystems_, varName);
     LOG4FIMEX(logger, Logger::DEBUG, "getting time-interpolated data-slice for " << varName << " with time-axis: " << timeAxis);
-    if (timeAxis.empty() || (dataReaderTimesInNewUnits_.find(timeAxis)->second.size() == 0)) {
+    if (timeAxis.empty() || (timeChangeMap_.find(timeAxis) == timeChangeMap_.end())) {
         // not time-axis or "changeTimeAxis" never called
         // no changes, simply forward
         return dataReader_->getDataSlice(varName, unLimDimPos);
@@ -103,43 +308,200 @@ DataPtr CDMTimeInterpolator::getDataSlice(const std::string& varName, size_t unL
         return getDataSliceFromMemory(variable, unLimDimPos);
     }
 
-    // interpolate the data
+    SliceBuilder sb(*cdm_, varName);
+    if (cdm_->hasUnlimitedDim(variable))
+        sb.setStartAndSize(cdm_->getUnlimitedDim()->getName(), unLimDimPos, 1);
+    return getTimeDataSlice(varName, timeAxis, sb);
+}
+
+DataPtr CDMTimeInterpolator::getDataSlice(const std::string& varName, const SliceBuilder& sb)
+{
+    const std::string timeAxis = getTimeAxis(coordSystems_, varName);
+    LOG4FIMEX(logger, Logger::DEBUG, "getting time-interpolated data-slice for " << varName << " with time-axis: " << timeAxis);
+    if (timeAxis.empty() || (timeChangeMap_.find(timeAxis) == timeChangeMap_.end())) {
+        return dataReader_->getDataSlice(varName, sb);
+    }
+
+    const CDMVariable& variable = cdm_->getVariable(varName);
+    if (variable.hasData()) {
+        return getDataSliceFromMemory(variable, sb);
+    }
+
+    return getTimeDataSlice(varName, timeAxis, sb);
+}
+
+namespace {
+//! key of the time-window of a request: variable and spatial subset
+std::string timeWindowKey(const std::string& varName, const std::string& timeAxis, const SliceBuilder& sb)
+{
+    std::ostringstream key;
+    key << varName;
+    const std::vector<std::string> dimNames = sb.getDimensionNames();
+    const std::vector<size_t>& start = sb.getDimensionStartPositions();
+    const std::vector<size_t>& size = sb.getDimensionSizes();
+    for (size_t i = 0; i < dimNames.size(); ++i) {
+        if (dimNames[i] != timeAxis)
+            key << '|' << start[i] << ':' << size[i];
+    }
+    return key.str();
+}
+} // namespace
+
+DataPtr CDMTimeInterpolator::getTimeDataSlice(const std::string& varName, const std::string& timeAxis, const SliceBuilder& sb)
+{
+    const std::vector<std::string> dimNames = sb.getDimensionNames();
+    if (std::find(dimNames.begin(), dimNames.end(), timeAxis) == dimNames.end())
+        throw CDMException("getDataSlice for " + varName + ": time-axis '" + timeAxis + "' is not a dimension of the variable");
+
+    size_t timeStart, timeSize;
+    sb.getStartAndSize(timeAxis, timeStart, timeSize);
+    const std::string key = timeWindowKey(varName, timeAxis, sb);
+    const std::vector<std::pair<size_t, size_t>>& timeMapping = timeChangeMap_.find(timeAxis)->second;
+    if (timeSize != 1 || !p_->batchMode) {
+        DataPtr data = interpolateTimeSteps(varName, timeAxis, key, sb);
+        if (timeStart + timeSize == timeMapping.size())
+            p_->finish(key);
+        return data;
+    }
+
+    if (DataPtr data = p_->takeOutput(key, timeStart))
+        return data;
+
+    // all output time-steps between the same input time-steps
+    const std::pair<size_t, size_t>& org = timeMapping.at(timeStart);
+    size_t first = timeStart, last = timeStart + 1;
+    while (first > 0 && timeMapping[first - 1] == org)
+        first -= 1;
+    while (last < timeMapping.size() && timeMapping[last] == org)
+        last += 1;
+    if (last - first == 1) {
+        DataPtr data = interpolateTimeSteps(varName, timeAxis, key, sb);
+        if (last == timeMapping.size())
+            p_->finish(key);
+        return data;
+    }
+
+    LOG4FIMEX(logger, Logger::DEBUG, "interpolating " << varName << " at time-steps " << first << " to " << last - 1 << " in one batch");
+    SliceBuilder sbBatch(sb);
+    sbBatch.setStartAndSize(timeAxis, first, last - first);
+    DataPtr batch = interpolateTimeSteps(varName, timeAxis, key, sbBatch);
+
+    const std::vector<size_t>& batchSizes = sbBatch.getDimensionSizes();
+    const size_t timeIdx = std::find(dimNames.begin(), dimNames.end(), timeAxis) - dimNames.begin();
+    std::vector<size_t> stepStart(dimNames.size(), 0);
+    std::map<size_t, DataPtr> outputs;
     DataPtr data;
+    for (size_t pos = first; pos < last; ++pos) {
+        stepStart[timeIdx] = pos - first;
+        DataPtr step = batch->slice(batchSizes, stepStart, sb.getDimensionSizes());
+        if (pos == timeStart)
+            data = step;
+        else
+            outputs[pos] = step;
+    }
+    p_->addOutputs(key, outputs);
+    if (last == timeMapping.size())
+        p_->finish(key);
+    return data;
+}
 
-    // if unlimdim = time-axis, fetch all needed original slices
-    const CDMDimension& timeDim = cdm_->getDimension(timeAxis);
-    if (timeDim.isUnlimited()) {
-        double currentTime = getDataSliceFromMemory(cdm_->getVariable(timeAxis), unLimDimPos)->asDouble()[0];
-        // interpolate and return the time-slices
-        pair<size_t, size_t> orgTimes = timeChangeMap_.find(timeAxis)->second.at(unLimDimPos);
-        double d1Time = dataReaderTimesInNewUnits_.find(timeDim.getName())->second.at(orgTimes.first);
-        double d2Time = dataReaderTimesInNewUnits_.find(timeDim.getName())->second.at(orgTimes.second);
-        DataPtr d1 = dataReader_->getDataSlice(varName, orgTimes.first);
-        DataPtr d2 = dataReader_->getDataSlice(varName, orgTimes.second);
-        LOG4FIMEX(logger, Logger::DEBUG, "interpolation between " << d1Time << " and " << d2Time << " at " << currentTime);
-        // convert if both slices are defined, otherwise, simply use the defined one or return undefined
-        if (d1->size() == 0) {
-            data = d2;
-        } else if (d2->size() == 0) {
-            data = d1;
-        } else if (d1->size() == d2->size()) {
-            shared_array<float> out(new float[d1->size()]);
-            mifi_get_values_linear_weak_extrapol_f(d1->asFloat().get(), d2->asFloat().get(), out.get(), d1->size(), d1Time, d2Time, currentTime);
-            data = createData(d1->size(), out);
+DataPtr CDMTimeInterpolator::interpolateTimeSteps(const std::string& varName, const std::string& timeAxis, const std::string& key, const SliceBuilder& sb)
+{
+    const std::vector<std::string> dimNames = sb.getDimensionNames();
+    const std::vector<size_t>& dimStarts = sb.getDimensionStartPositions();
+    const std::vector<size_t>& dimSizes = sb.getDimensionSizes();
+
+    // the output is laid out as [outer][time][inner], inner is fastest
+    size_t timeStart = 0, timeSize = 0;
+    size_t inner = 1, outer = 1;
+    bool afterTime = false;
+    SliceBuilder sbIn(dataReader_->getCDM(), varName);
+    for (size_t i = 0; i < dimNames.size(); ++i) {
+        if (dimNames[i] == timeAxis) {
+            timeStart = dimStarts[i];
+            timeSize = dimSizes[i];
+            afterTime = true;
         } else {
-            throw CDMException("getDataSlice for " + varName + ": got slices with different size");
+            sbIn.setStartAndSize(dimNames[i], dimStarts[i], dimSizes[i]);
+            (afterTime ? outer : inner) *= dimSizes[i];
         }
-    } else {
-        // TODO
-        // else get original slice, subslice the needed time-slices
-        // interpolate and return the time-slices
-        throw CDMException("TimeDimension != unlimited dimension not implemented yet in CDMTimeInterpolator");
     }
-    return data;
+    const size_t stepSize = inner * outer;
+
+    const std::vector<std::pair<size_t, size_t>>& timeMapping = timeChangeMap_.find(timeAxis)->second;
+    const std::vector<double>& orgTimes = dataReaderTimesInNewUnits_.find(timeAxis)->second;
+    const shared_array<double> newTimes = cdm_->getVariable(timeAxis).getData()->asDouble();
+
+    // input time-steps, shared by consecutive output time-steps of this and the following requests
+    std::map<size_t, TimeStep> inSteps;
+    auto readStep = [&](size_t orgPos, size_t firstNeeded) -> TimeStep& {
+        std::map<size_t, TimeStep>::iterator it = inSteps.find(orgPos);
+        if (it == inSteps.end()) {
+            TimeStep step;
+            if (!p_->findInput(key, orgPos, step)) {
+                sbIn.setStartAndSize(timeAxis, orgPos, 1);
+                step.data = dataReader_->getDataSlice(varName, sbIn);
+                if (step.data->size() != 0 && step.data->size() != stepSize)
+                    throw CDMException("getDataSlice for " + varName + ": got slices with different size");
+                step.floats(); // convert only once for all requests
+                p_->addInput(key, orgPos, step, firstNeeded);
+            }
+            it = inSteps.insert(std::make_pair(orgPos, step)).first;
+        }
+        return it->second;
+    };
+
+    shared_array<float> out;
+    if (timeSize != 1)
+        out = make_pooled_array<float>(stepSize * timeSize);
+    for (size_t t = 0; t < timeSize; ++t) {
+        const double currentTime = newTimes[timeStart + t];
+        const std::pair<size_t, size_t>& org = timeMapping.at(timeStart + t);
+        // input time-steps before the current pair are not needed any longer
+        inSteps.erase(inSteps.begin(), inSteps.lower_bound(org.first));
+        TimeStep& s1 = readStep(org.first, org.first);
+        TimeStep& s2 = readStep(org.second, org.first);
+        const double d1Time = orgTimes.at(org.first);
+        const double d2Time = orgTimes.at(org.second);
+        LOG4FIMEX(logger, Logger::DEBUG, "interpolation between " << d1Time << " and " << d2Time << " at " << currentTime);
+
+        if (timeSize == 1) {
+            // convert if both slices are defined, otherwise, simply use the defined one or return undefined
+            // the time-steps may be cached, return a copy
+            if (s1.data->size() == 0)
+                return s2.data->clone();
+            if (s2.data->size() == 0)
+                return s1.data->clone();
+            out = make_pooled_array<float>(stepSize);
+            mifi_get_values_linear_weak_extrapol_f(s1.floats(), s2.floats(), out.get(), stepSize, d1Time, d2Time, currentTime);
+            return createData(stepSize, out);
+        }
+
+        const float* v1 = s1.floats();
+        const float* v2 = s2.floats();
+        if (!v1)
+            v1 = v2;
+        if (!v2)
+            v2 = v1;
+        for (size_t o = 0; o < outer; ++o) {
+            float* outStep = &out[(o * timeSize + t) * inner];
+            if (v1) {
+                mifi_get_values_linear_weak_extrapol_f(v1 + o * inner, v2 + o * inner, outStep, inner, d1Time, d2Time, currentTime);
+            } else {
+                std::fill(outStep, outStep + inner, MIFI_UNDEFINED_F);
+            }
+        }
+    }
+    return createData(stepSize * timeSize, out);
 }
 
 void CDMTimeInterpolator::changeTimeAxis(const string& timeSpec)
 {
+    {
+        ExclusiveLock lock(p_->mutex);
+        p_->windows.clear();
+        p_->cachedBytes = 0;
+    }
     // changing time-axes
     const CDM& orgCDM = dataReader_->getCDM();
     const CDM::VarVec& vars = orgCDM.getVariables();
@@ -30,7 +30,6 @@
 #include "fimex/CDMInterpolator.h" // for data <-> interpolationArray
 #include "fimex/CDMReaderUtils.h"
 #include "fimex/Data.h"
-#include "fimex/FindNeighborElements.h"
 #include "fimex/Logger.h"
 #include "fimex/StringUtils.h"
 #include "fimex/coordSys/CoordinateAxis.h"
@@ -38,15 +37,21 @@
 #include "fimex/interpolation.h"
 #include "fimex/vertical_coordinate_transformations.h"
 
+#include "BufferPool.h"
+#include "MutexLock.h"
+#include "TaskScheduler.h"
+#include "VerticalInterpolationPlan.h"
 #include "coordSys/CoordSysUtils.h"
 
 #include "fimex/ArrayLoop.h"
-#include "leap_iterator.h"
 #include "fimex/coordSys/verticalTransform/VerticalTransformationUtils.h"
 
 #include <algorithm>
 #include <iterator>
+#include <list>
 #include <regex>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -134,8 +139,51 @@ struct CDMVerticalInterpolator::Impl
 
     bool ignoreValidityMin;
     bool ignoreValidityMax;
+
+    // recently used interpolation plans, most recent first
+    SharedMutex plansMutex;
+    std::list<std::pair<std::string, VerticalInterpolationPlan_cp>> plans;
+    size_t plansBytes;
+
+    Impl()
+        : plansMutex("vertical interpolation plans")
+        , plansBytes(0)
+    {
+    }
+
+    VerticalInterpolationPlan_cp findPlan(const std::string& key);
+    void addPlan(const std::string& key, VerticalInterpolationPlan_cp plan);
 };
 
+//! maximum memory of the cached vertical interpolation plans
+const size_t maxPlansBytes = 256 * 1024 * 1024;
+
+VerticalInterpolationPlan_cp CDMVerticalInterpolator::Impl::findPlan(const std::string& key)
+{
+    ExclusiveLock lock(plansMutex);
+    for (auto it = plans.begin(); it != plans.end(); ++it) {
+        if (it->first == key) {
+            plans.splice(plans.begin(), plans, it);
+            return plans.front().second;
+        }
+    }
+    return VerticalInterpolationPlan_cp();
+}
+
+void CDMVerticalInterpolator::Impl::addPlan(const std::string& key, VerticalInterpolationPlan_cp plan)
+{
+    const size_t bytes = plan->bytes();
+    ExclusiveLock lock(plansMutex);
+    if (bytes > maxPlansBytes)
+        return;
+    while (!plans.empty() && plansBytes + bytes > maxPlansBytes) {
+        plansBytes -= plans.back().second->bytes();
+        plans.pop_back();
+    }
+    plans.push_front(std::make_pair(key, plan));
+    plansBytes += bytes;
+}
+
 CDMVerticalInterpolator::CDMVerticalInterpolator(CDMReader_p dataReader, const string& verticalType, const string& verticalInterpolationMethod)
     : dataReader_(dataReader)
     , pimpl_(new Impl())
@@ -310,10 +358,71 @@ DataPtr CDMVerticalInterpolator::getDataSlice(const std::string& varName, size_t
         return dataReader_->getDataSlice(varName, unLimDimPos);
     }
 
-    return getLevelDataSlice(csI, varName, unLimDimPos);
+    SliceBuilder sb(*cdm_, varName);
+    setUnLimDimPos(*cdm_, sb, unLimDimPos);
+    return getLevelDataSlice(csI, varName, sb);
+}
+
+DataPtr CDMVerticalInterpolator::getDataSlice(const std::string& varName, const SliceBuilder& sb)
+{
+    const CDMVariable& variable = cdm_->getVariable(varName);
+    if (variable.hasData()) {
+        return getDataSliceFromMemory(variable, sb);
+    }
+    CoordinateSystem_cp csI = findCompleteCoordinateSystemFor(pimpl_->changeCoordSys, varName);
+    if (csI.get() == 0) {
+        LOG4FIMEX(logger, Logger::DEBUG, "no cs change for var='" << varName << "'");
+        // no level to change, propagate to the dataReader_
+        return dataReader_->getDataSlice(varName, sb);
+    }
+
+    return getLevelDataSlice(csI, varName, sb);
+}
+
+std::vector<DataPtr> CDMVerticalInterpolator::getDataSlices(const DataSliceRequest_v& requests)
+{
+    std::vector<DataPtr> results(requests.size());
+    std::vector<CoordinateSystem_cp> css(requests.size());
+    DataSliceRequest_v forwardRequests;
+    std::vector<size_t> forwardIndex;
+    std::set<std::string> csIds;
+    std::vector<size_t> first, others;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const DataSliceRequest& r = requests[i];
+        const CDMVariable& variable = cdm_->getVariable(r.varName);
+        if (variable.hasData()) {
+            results[i] = getDataSliceFromMemory(variable, r.sb);
+        } else if ((css[i] = findCompleteCoordinateSystemFor(pimpl_->changeCoordSys, r.varName))) {
+            if (csIds.insert(css[i]->id()).second)
+                first.push_back(i);
+            else
+                others.push_back(i);
+        } else {
+            forwardRequests.push_back(r);
+            forwardIndex.push_back(i);
+        }
+    }
+
+    if (!forwardRequests.empty()) {
+        std::vector<DataPtr> forwarded = dataReader_->getDataSlices(forwardRequests);
+        for (size_t j = 0; j < forwardIndex.size(); ++j)
+            results[forwardIndex[j]] = forwarded[j];
+    }
+
+    for (size_t i : first)
+        results[i] = getLevelDataSlice(css[i], requests[i].varName, requests[i].sb);
+
+    parallelFor(
+        others.size(),
+        [&](size_t k) {
+            const size_t i = others[k];
+            results[i] = getLevelDataSlice(css[i], requests[i].varName, requests[i].sb);
+        },
+        TASK_STAGE_INTERPOLATE);
+    return results;
 }
 
-DataPtr CDMVerticalInterpolator::getLevelDataSlice(CoordinateSystem_cp csI, const std::string& varName, size_t unLimDimPos)
+DataPtr CDMVerticalInterpolator::getLevelDataSlice(CoordinateSystem_cp csI, const std::string& varName, const SliceBuilder& sb)
 {
     LOG4FIMEX(logger, Logger::DEBUG, "getLevelDataSlice(.. '" << varName << "' ..)");
     if (!csI->hasVerticalTransformation()) {
@@ -321,104 +430,34 @@ DataPtr CDMVerticalInterpolator::getLevelDataSlice(CoordinateSystem_cp csI, cons
     }
 
     VerticalConverter_p iConverter = verticalConverter(csI, dataReader_, pimpl_->verticalType);
-    DataPtr iVerticalData = verticalData4D(iConverter, dataReader_->getCDM(), unLimDimPos);
-
     VerticalConverter_p oConverter;
-    DataPtr oVerticalData;
-    if (pimpl_->templateCS) {
+    if (pimpl_->templateCS)
         oConverter = verticalConverter(pimpl_->templateCS, dataReader_, pimpl_->verticalType);
-        oVerticalData = verticalData4D(oConverter, dataReader_->getCDM(), unLimDimPos);
-    }
-
-    int (*intFunc)(const float* infieldA, const float* infieldB, float* outfield, const size_t n, const double a, const double b, const double x) = 0;
-    switch (pimpl_->verticalInterpolationMethod) {
-    case MIFI_VINT_METHOD_LIN: intFunc = &mifi_get_values_linear_f; break;
-    case MIFI_VINT_METHOD_LIN_WEAK_EXTRA: intFunc = &mifi_get_values_linear_weak_extrapol_f; break;
-    case MIFI_VINT_METHOD_LIN_NO_EXTRA: intFunc = &mifi_get_values_linear_no_extrapol_f; break;
-    case MIFI_VINT_METHOD_LIN_CONST_EXTRA: intFunc = &mifi_get_values_linear_const_extrapol_f; break;
-    case MIFI_VINT_METHOD_LOG: intFunc = &mifi_get_values_log_f; break;
-    case MIFI_VINT_METHOD_LOGLOG: intFunc = &mifi_get_values_log_log_f; break;
-    case MIFI_VINT_METHOD_NN: intFunc = &mifi_get_values_nearest_f; break;
-    }
 
     const std::string& geoZi = csI->getGeoZAxis()->getName();
     const std::string& geoZo = pimpl_->templateCS ? pimpl_->templateCS->getGeoZAxis()->getName() : pimpl_->vAxis;
 
-    ArrayDims siData = makeArrayDims(dataReader_->getCDM(), varName);
-    ArrayDims siVertical = makeArrayDims(dataReader_->getCDM(), iConverter);
-    ArrayDims soData = makeArrayDims(getCDM(), varName);
+    // the input needs all levels of the requested columns
+    const CDM& rcdm = dataReader_->getCDM();
+    const SliceBuilder sbiData = adaptSliceBuilder(rcdm, varName, sb);
+    const SliceBuilder sbiVertical = adaptSliceBuilder(rcdm, iConverter, sb);
+
+    ArrayDims siData = makeArrayDims(sbiData);
+    ArrayDims siVertical = makeArrayDims(sbiVertical);
+    ArrayDims soData = makeArrayDims(sb);
     ArrayDims soVertical;
-    ArrayDims sDataMax, sDataMin;
 
+    std::vector<double> oLevels;
     if (pimpl_->templateCS) {
-        soVertical = makeArrayDims(dataReader_->getCDM(), oConverter);
+        soVertical = makeArrayDims(adaptSliceBuilder(rcdm, oConverter, sb));
     } else {
-        soVertical.add(pimpl_->vAxis /* or dim name? */, pimpl_->level1.size());
+        size_t oStart, oSize;
+        sb.getStartAndSize(pimpl_->vAxis, oStart, oSize);
+        oLevels.assign(pimpl_->level1.begin() + oStart, pimpl_->level1.begin() + oStart + oSize);
+        soVertical.add(pimpl_->vAxis /* or dim name? */, oLevels.size());
     }
     set_not_shared(geoZi, siData, siVertical);
     set_not_shared(geoZo, soData, soVertical);
-    forceUnLimDimLength1(getCDM(), siData, siVertical, soData, soVertical);
-
-    enum { IN, IN_VERTICAL, OUT, OUT_VERTICAL };
-    ArrayGroup group = ArrayGroup().add(siData).add(siVertical).add(soData).add(soVertical);
-    group.minimizeShared(0); // we have to treat each value separately
-
-    shared_array<double> valueMin, valueMax;
-    size_t VALID_MIN = 0, VALID_MAX = 0;
-    if (pimpl_->templateCS) {
-        if (!pimpl_->ignoreValidityMax) {
-            const std::vector<std::string> oValidMaxShape = oConverter->getValidityMaxShape();
-            LOG4FIMEX(logger, Logger::DEBUG, "o valid max shape: " << join(oValidMaxShape.begin(), oValidMaxShape.end()));
-            const SliceBuilder sbValidMax = createSliceBuilder(dataReader_->getCDM(), oValidMaxShape);
-            if (DataPtr oValuesMax = oConverter->getValidityMax(sbValidMax)) {
-                sDataMax = makeArrayDims(getCDM(), oValidMaxShape);
-                forceUnLimDimLength1(getCDM(), sDataMax);
-                VALID_MAX = group.arrayCount();
-                group.add(sDataMax);
-                valueMax = oValuesMax->asDouble();
-            }
-        }
-        if (!pimpl_->ignoreValidityMin) {
-            const std::vector<std::string> oValidMinShape = oConverter->getValidityMinShape();
-            LOG4FIMEX(logger, Logger::DEBUG, "o valid min shape: " << join(oValidMinShape.begin(), oValidMinShape.end()));
-            const SliceBuilder sbValidMin = createSliceBuilder(dataReader_->getCDM(), oValidMinShape);
-            if (DataPtr oValuesMin = oConverter->getValidityMin(sbValidMin)) {
-                sDataMin = makeArrayDims(getCDM(), oValidMinShape);
-                forceUnLimDimLength1(getCDM(), sDataMin);
-                VALID_MIN = group.arrayCount();
-                group.add(sDataMin);
-                valueMin = oValuesMin->asDouble();
-            }
-        }
-    }
-    if (VALID_MIN == 0 && VALID_MAX == 0) {
-        if (!pimpl_->ignoreValidityMax) {
-            const std::vector<std::string> iValidMaxShape = iConverter->getValidityMaxShape();
-            LOG4FIMEX(logger, Logger::DEBUG, "i valid max shape: " << join(iValidMaxShape.begin(), iValidMaxShape.end()));
-            const SliceBuilder sbValidMax = createSliceBuilder(dataReader_->getCDM(), iValidMaxShape);
-            if (DataPtr iValuesMax = iConverter->getValidityMax(sbValidMax)) {
-                sDataMax = makeArrayDims(getCDM(), iValidMaxShape);
-                forceUnLimDimLength1(getCDM(), sDataMax);
-                VALID_MAX = group.arrayCount();
-                LOG4FIMEX(logger, Logger::DEBUG, "VALID_MAX=" << VALID_MAX);
-                group.add(sDataMax);
-                valueMax = iValuesMax->asDouble();
-            }
-        }
-        if (!pimpl_->ignoreValidityMin) {
-            const std::vector<std::string> iValidMinShape = iConverter->getValidityMinShape();
-            LOG4FIMEX(logger, Logger::DEBUG, "i valid min shape: " << join(iValidMinShape.begin(), iValidMinShape.end()));
-            const SliceBuilder sbValidMin = createSliceBuilder(dataReader_->getCDM(), iValidMinShape);
-            if (DataPtr iValuesMin = iConverter->getValidityMin(sbValidMin)) {
-                sDataMin = makeArrayDims(getCDM(), iValidMinShape);
-                forceUnLimDimLength1(getCDM(), sDataMin);
-                VALID_MIN = group.arrayCount();
-                LOG4FIMEX(logger, Logger::DEBUG, "VALID_MIN=" << VALID_MIN);
-                group.add(sDataMin);
-                valueMin = iValuesMin->asDouble();
-            }
-        }
-    }
 
     const size_t nzi = siData.length(geoZi);
     const size_t nzo = soData.length(geoZo);
@@ -429,69 +468,146 @@ DataPtr CDMVerticalInterpolator::getLevelDataSlice(CoordinateSystem_cp csI, cons
     const size_t odataZdelta = soData.delta(geoZo);
     const size_t overticalZdelta = pimpl_->templateCS ? soVertical.delta(geoZo) : 1;
 
-    DataPtr data = dataReader_->getDataSlice(varName, unLimDimPos);
-    const double badValue = cdm_->getFillValue(varName);
-    shared_array<float> iData = data2InterpolationArray(data, badValue);
-    const size_t oSize = soData.volume();
-    shared_array<float> oData(new float[oSize]);
-    shared_array<float> iVerticalValues = iVerticalData->asFloat();
-    shared_array<float> oVerticalValues;
-    if (pimpl_->templateCS)
-        oVerticalValues = oVerticalData->asFloat();
-
-#ifdef _OPENMP
-#pragma omp parallel for default(shared)
-#endif
-    for (size_t k = 0; k < nzo; k++) {
-        LOG4FIMEX(logger, Logger::DEBUG, "k=" << k);
-        size_t loopi = 0;
-        Loop loop(group);
-        do { // sharedVolume() == 1 because we called minimizeShared before
-            LOG4FIMEX(logger, Logger::DEBUG, "loopi=" << loopi++);
-            const size_t verticalOutIdx = loop[OUT_VERTICAL] + k * overticalZdelta;
-            const double verticalOut = pimpl_->templateCS ? oVerticalValues[verticalOutIdx] : pimpl_->level1[verticalOutIdx];
-            float* interpolated = &oData[loop[OUT] + k*odataZdelta];
-
-            bool range = true;
-            if (valueMin && valueMax) {
-                range = (verticalOut >= valueMin[loop[VALID_MIN]]) && (verticalOut <= valueMax[loop[VALID_MAX]]);
-                LOG4FIMEX(logger, Logger::DEBUG, "verticalOut= " << verticalOut
-                          << " min[" << loop[VALID_MIN] << "]=" << valueMin[loop[VALID_MIN]]
-                          << " max[" << loop[VALID_MAX] << "]=" << valueMax[loop[VALID_MAX]]
-                          << " range=" << range);
-            } else if (valueMin) {
-                range = (verticalOut >= valueMin[loop[VALID_MIN]]);
-                LOG4FIMEX(logger, Logger::DEBUG, "verticalOut= " << verticalOut
-                          << " min[" << loop[VALID_MIN] << "]=" << valueMin[loop[VALID_MIN]]
-                          << " range=" << range);
-            } else if (valueMax) {
-                range = (verticalOut <= valueMax[loop[VALID_MAX]]);
-                LOG4FIMEX(logger, Logger::DEBUG, "verticalOut= " << verticalOut
-                          << " max[" << loop[VALID_MAX] << "]=" << valueMax[loop[VALID_MAX]]
-                          << " range=" << range);
+    // the plan depends on the vertical coordinates and the array layout, not on the data
+    std::ostringstream planKey;
+    planKey << csI->id() << '|' << pimpl_->ignoreValidityMin << pimpl_->ignoreValidityMax;
+    for (const SliceBuilder* s : {&sbiData, &sb}) {
+        planKey << '|';
+        const std::vector<std::string> names = s->getDimensionNames();
+        for (size_t i = 0; i < names.size(); i++)
+            planKey << names[i] << ':' << s->getDimensionStartPositions()[i] << ':' << s->getDimensionSizes()[i] << ',';
+    }
+    VerticalInterpolationPlan_cp plan = pimpl_->findPlan(planKey.str());
+    if (!plan) {
+        ArrayDims sDataMax, sDataMin;
+        enum { IN, IN_VERTICAL, OUT, OUT_VERTICAL };
+        ArrayGroup group = ArrayGroup().add(siData).add(siVertical).add(soData).add(soVertical);
+        group.minimizeShared(0); // we have to treat each value separately
+
+        shared_array<double> valueMin, valueMax;
+        size_t VALID_MIN = 0, VALID_MAX = 0;
+        if (pimpl_->templateCS) {
+            if (!pimpl_->ignoreValidityMax) {
+                const std::vector<std::string> oValidMaxShape = oConverter->getValidityMaxShape();
+                LOG4FIMEX(logger, Logger::DEBUG, "o valid max shape: " << join(oValidMaxShape.begin(), oValidMaxShape.end()));
+                const SliceBuilder sbValidMax = adaptSliceBuilder(rcdm, oValidMaxShape, sb);
+                if (DataPtr oValuesMax = oConverter->getValidityMax(sbValidMax)) {
+                    sDataMax = makeArrayDims(sbValidMax);
+                    VALID_MAX = group.arrayCount();
+                    group.add(sDataMax);
+                    valueMax = oValuesMax->asDouble();
+                }
             }
-
-            if (range) {
-                const leap_iterator<const float*> ivertical0(&iVerticalValues[loop[IN_VERTICAL]], iverticalZdelta);
-                const leap_iterator<const float*> ivertical1 = ivertical0 + nzi;
-                const pair<size_t, size_t> pos = find_closest_neighbor_distinct_elements(ivertical0, ivertical1, verticalOut);
-                if (pos.first != pos.second) {
-                    const size_t idataZ0  = loop[IN] + idataZdelta * pos.first;
-                    const size_t idataZ1  = loop[IN] + idataZdelta * pos.second;
-                    const float valueI0 = iData[idataZ0], valueI1 = iData[idataZ1];
-                    const float verticalI0 = *(ivertical0 + pos.first), verticalI1 = *(ivertical0 + pos.second);
-                    intFunc(&valueI0, &valueI1, interpolated, 1, verticalI0, verticalI1, verticalOut);
-                } else {
-                    // find_closest_neighbor_distinct_elements failed
-                    *interpolated = MIFI_UNDEFINED_F;
+            if (!pimpl_->ignoreValidityMin) {
+                const std::vector<std::string> oValidMinShape = oConverter->getValidityMinShape();
+                LOG4FIMEX(logger, Logger::DEBUG, "o valid min shape: " << join(oValidMinShape.begin(), oValidMinShape.end()));
+                const SliceBuilder sbValidMin = adaptSliceBuilder(rcdm, oValidMinShape, sb);
+                if (DataPtr oValuesMin = oConverter->getValidityMin(sbValidMin)) {
+                    sDataMin = makeArrayDims(sbValidMin);
+                    VALID_MIN = group.arrayCount();
+                    group.add(sDataMin);
+                    valueMin = oValuesMin->asDouble();
+                }
+            }
+        }
+        if (VALID_MIN == 0 && VALID_MAX == 0) {
+            if (!pimpl_->ignoreValidityMax) {
+                const std::vector<std::string> iValidMaxShape = iConverter->getValidityMaxShape();
+                LOG4FIMEX(logger, Logger::DEBUG, "i valid max shape: " << join(iValidMaxShape.begin(), iValidMaxShape.end()));
+                const SliceBuilder sbValidMax = adaptSliceBuilder(rcdm, iValidMaxShape, sb);
+                if (DataPtr iValuesMax = iConverter->getValidityMax(sbValidMax)) {
+                    sDataMax = makeArrayDims(sbValidMax);
+                    VALID_MAX = group.arrayCount();
+                    LOG4FIMEX(logger, Logger::DEBUG, "VALID_MAX=" << VALID_MAX);
+                    group.add(sDataMax);
+                    valueMax = iValuesMax->asDouble();
+                }
+            }
+            if (!pimpl_->ignoreValidityMin) {
+                const std::vector<std::string> iValidMinShape = iConverter->getValidityMinShape();
+                LOG4FIMEX(logger, Logger::DEBUG, "i valid min shape: " << join(iValidMinShape.begin(), iValidMinShape.end()));
+                const SliceBuilder sbValidMin = adaptSliceBuilder(rcdm, iValidMinShape, sb);
+                if (DataPtr iValuesMin = iConverter->getValidityMin(sbValidMin)) {
+                    sDataMin = makeArrayDims(sbValidMin);
+                    VALID_MIN = group.arrayCount();
+                    LOG4FIMEX(logger, Logger::DEBUG, "VALID_MIN=" << VALID_MIN);
+                    group.add(sDataMin);
+                    valueMin = iValuesMin->asDouble();
                 }
-            } else {
-                // not a valid z
-                *interpolated = MIFI_UNDEFINED_F;
             }
+        }
+
+        // collect the start positions of all columns
+        std::vector<size_t> colIn, colInVertical, colOut, colOutVertical, colValidMin, colValidMax;
+        Loop loop(group);
+        do { // sharedVolume() == 1 because we called minimizeShared before
+            colIn.push_back(loop[IN]);
+            colInVertical.push_back(loop[IN_VERTICAL]);
+            colOut.push_back(loop[OUT]);
+            colOutVertical.push_back(loop[OUT_VERTICAL]);
+            colValidMin.push_back(loop[VALID_MIN]);
+            colValidMax.push_back(loop[VALID_MAX]);
         } while (loop.next());
+        const size_t columns = colIn.size();
+        LOG4FIMEX(logger, Logger::DEBUG, "creating vertical interpolation plan for " << columns << " columns");
+
+        VerticalInterpolationPlan_p newPlan = std::make_shared<VerticalInterpolationPlan>(columns, nzo, idataZdelta, odataZdelta);
+        shared_array<float> iVerticalValues = iConverter->getDataSlice(sbiVertical)->asFloat();
+        shared_array<float> oVerticalValues;
+        if (pimpl_->templateCS)
+            oVerticalValues = oConverter->getDataSlice(adaptSliceBuilder(rcdm, oConverter, sb))->asFloat();
+        const mifi_vertical_interpol_method method = pimpl_->verticalInterpolationMethod;
+
+        parallelForRange(
+            columns, 256,
+            [&](size_t begin, size_t end) {
+                std::vector<float> profile(nzi);
+                for (size_t c = begin; c < end; c++) {
+                    newPlan->setColumn(c, colIn[c], colOut[c]);
+                    for (size_t z = 0; z < nzi; z++)
+                        profile[z] = iVerticalValues[colInVertical[c] + z * iverticalZdelta];
+                    const int order = verticalProfileOrder(&profile[0], nzi);
+
+                    for (size_t k = 0; k < nzo; k++) {
+                        const size_t verticalOutIdx = colOutVertical[c] + k * overticalZdelta;
+                        const double verticalOut = pimpl_->templateCS ? oVerticalValues[verticalOutIdx] : oLevels[verticalOutIdx];
+
+                        bool range = true;
+                        if (valueMin)
+                            range = (verticalOut >= valueMin[colValidMin[c]]);
+                        if (range && valueMax)
+                            range = (verticalOut <= valueMax[colValidMax[c]]);
+
+                        if (range) {
+                            const pair<size_t, size_t> pos = findVerticalNeighbors(&profile[0], nzi, order, verticalOut);
+                            if (pos.first != pos.second) {
+                                const float weight = verticalInterpolationWeight(method, profile[pos.first], profile[pos.second], verticalOut);
+                                newPlan->setLevel(c, k, pos.first, pos.second, weight);
+                            } else {
+                                // findVerticalNeighbors failed
+                                newPlan->setUndefined(c, k);
+                            }
+                        } else {
+                            // not a valid z
+                            newPlan->setUndefined(c, k);
+                        }
+                    }
+                }
+            },
+            TASK_STAGE_INTERPOLATE);
+        plan = newPlan;
+        pimpl_->addPlan(planKey.str(), plan);
     }
 
+    DataPtr data = dataReader_->getDataSlice(varName, sbiData);
+    if (data->size() == 0)
+        return data;
+    const double badValue = cdm_->getFillValue(varName);
+    shared_array<float> iData = data2InterpolationArray(data, badValue);
+    const size_t oSize = soData.volume();
+    shared_array<float> oData = make_pooled_array<float>(oSize);
+    plan->apply(iData.get(), oData.get());
+
     // correct data going out of bounds
     const double valid_min = cdm_->getValidMin(varName);
     const double valid_max = cdm_->getValidMax(varName);
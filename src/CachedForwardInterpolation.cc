@@ -26,6 +26,8 @@
 
 #include "CachedForwardInterpolation.h"
 
+#include "BufferPool.h"
+
 #include "fimex/CDMException.h"
 #include "fimex/Logger.h"
 #include "fimex/MathUtils.h"
@@ -76,20 +78,6 @@ struct AggSimple : Aggregator
     }
 };
 
-struct AggSum : AggSimple
-{
-    void push(float f) override
-    {
-        count += 1;
-        val += f;
-    }
-};
-
-struct AggMean : AggSum
-{
-    float get_and_reset() override { return reset(count > 0 ? val / count : 0); }
-};
-
 struct AggMin : AggSimple
 {
     void push(float f) override
@@ -179,12 +167,14 @@ CachedForwardInterpolation::CachedForwardInterpolation(const std::string& xDimNa
     }
 
     undefAggr = false;
+    // sum and mean are linear, and use a sparse matrix instead of an aggregator
+    int sparseFlags = -1;
     // clang-format off
     switch (funcType) {
-    case MIFI_INTERPOL_FORWARD_UNDEF_SUM: undefAggr = true; // fallthrough
-    case MIFI_INTERPOL_FORWARD_SUM: agg.reset(new AggSum()); break;
-    case MIFI_INTERPOL_FORWARD_UNDEF_MEAN: undefAggr = true; // fallthrough
-    case MIFI_INTERPOL_FORWARD_MEAN: agg.reset(new AggMean()); break;
+    case MIFI_INTERPOL_FORWARD_UNDEF_SUM: sparseFlags = 0; break;
+    case MIFI_INTERPOL_FORWARD_SUM: sparseFlags = SparseInterpolationMatrix::SKIP_MISSING; break;
+    case MIFI_INTERPOL_FORWARD_UNDEF_MEAN: sparseFlags = SparseInterpolationMatrix::NORMALIZE; break;
+    case MIFI_INTERPOL_FORWARD_MEAN: sparseFlags = SparseInterpolationMatrix::SKIP_MISSING | SparseInterpolationMatrix::NORMALIZE; break;
     case MIFI_INTERPOL_FORWARD_UNDEF_MEDIAN: undefAggr = true; // fallthrough
     case MIFI_INTERPOL_FORWARD_MEDIAN: agg.reset(new AggMedian(maxPointsInIn)); break;
     case MIFI_INTERPOL_FORWARD_UNDEF_MAX: undefAggr = true; // fallthrough
@@ -194,6 +184,17 @@ CachedForwardInterpolation::CachedForwardInterpolation(const std::string& xDimNa
     default: throw CDMException("unknown forward interpolation method: " + type2string(funcType));
     }
     // clang-format on
+
+    if (sparseFlags >= 0) {
+        std::shared_ptr<SparseInterpolationMatrix> matrix = std::make_shared<SparseInterpolationMatrix>(inX * inY, sparseFlags);
+        for (size_t o = 0; o < outLayerSize; ++o) {
+            for (size_t i : pointsInIn[o])
+                matrix->addWeight(i, 1);
+            matrix->endRow();
+        }
+        matrix_ = matrix;
+        pointsInIn = shared_array<vector<size_t>>();
+    }
 }
 
 CachedForwardInterpolation::~CachedForwardInterpolation() {}
@@ -204,12 +205,17 @@ shared_array<float> CachedForwardInterpolation::interpolateValues(shared_array<f
     size_t inLayerSize = inX * inY;
     size_t inZ = size / inLayerSize;
     newSize = outLayerSize*inZ;
-    shared_array<float> outData(new float[newSize]);
+    shared_array<float> outData = make_pooled_array<float>(newSize);
+    if (matrix_) {
+        matrix_->apply(inData.get(), inZ, outData.get());
+        return outData;
+    }
     for (size_t z = 0; z < inZ; ++z) {
+        const float* inDataZ = &inData[z * inLayerSize];
         float* outDataIt = &outData[z*outLayerSize];
         for (size_t i = 0; i < outLayerSize; i++) {
             for (size_t ii : pointsInIn[i]) {
-                const float val = inData[ii];
+                const float val = inDataZ[ii];
                 if (undefAggr || !mifi_isnan(val))
                     agg->push(val);
             }
@@ -219,4 +225,9 @@ shared_array<float> CachedForwardInterpolation::interpolateValues(shared_array<f
     return outData;
 }
 
+SparseInterpolationMatrix_cp CachedForwardInterpolation::sparseMatrix() const
+{
+    return matrix_;
+}
+
 } // namespace MetNoFimex
@@ -40,12 +40,15 @@ private:
     size_t maxPointsInIn;
     std::unique_ptr<Aggregator> agg;
     bool undefAggr;
+    //! sum and mean as sparse matrix, 0 for the other aggregations
+    SparseInterpolationMatrix_cp matrix_;
 
 public:
     CachedForwardInterpolation(const std::string& xDimName, const std::string& yDimName, int funcType, shared_array<double> pointsOnXAxis,
                                shared_array<double> pointsOnYAxis, size_t inX, size_t inY, size_t outX, size_t outY);
     ~CachedForwardInterpolation();
     shared_array<float> interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const override;
+    SparseInterpolationMatrix_cp sparseMatrix() const override;
 };
 
 } // namespace MetNoFimex
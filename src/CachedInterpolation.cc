@@ -35,9 +35,15 @@
 
 #include "fimex/Logger.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include "BufferPool.h"
+#include "InterpolationKernels.h"
+#include "TaskScheduler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
 
 namespace MetNoFimex
 {
@@ -65,6 +71,202 @@ CachedInterpolationInterface::CachedInterpolationInterface(const std::string& xD
 
 CachedInterpolationInterface::~CachedInterpolationInterface() {}
 
+namespace {
+
+// binary format of serialized interpolations, see CachedInterpolationInterface::write
+const char SERIAL_MAGIC[8] = {'F', 'I', 'M', 'E', 'X', 'C', 'I', 'W'};
+const uint32_t SERIAL_VERSION = 1;
+const uint32_t SERIAL_BYTE_ORDER = 0x01020304;
+
+enum SerializationType { SERIAL_NONE = 0, SERIAL_BILINEAR_BICUBIC = 1, SERIAL_NEAREST_NEIGHBOR = 2, SERIAL_SPARSE_MATRIX = 3 };
+
+template <typename T>
+void writeValue(std::ostream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::ostream& out, const std::string& value)
+{
+    writeValue<uint64_t>(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+template <typename T>
+void writeVector(std::ostream& out, const std::vector<T>& values)
+{
+    writeValue<uint64_t>(out, values.size());
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+class SerialReader
+{
+public:
+    SerialReader(const char* data, size_t size)
+        : pos_(data)
+        , end_(data + size)
+    {
+    }
+
+    template <typename T>
+    T value()
+    {
+        T v;
+        read(&v, sizeof(T));
+        return v;
+    }
+
+    std::string string()
+    {
+        const uint64_t n = value<uint64_t>();
+        check(n);
+        std::string s(pos_, n);
+        pos_ += n;
+        return s;
+    }
+
+    template <typename T>
+    std::vector<T> vector()
+    {
+        const uint64_t n = value<uint64_t>();
+        check(n * sizeof(T));
+        std::vector<T> v(n);
+        read(v.data(), n * sizeof(T));
+        return v;
+    }
+
+    void read(void* dest, size_t n)
+    {
+        check(n);
+        std::memcpy(dest, pos_, n);
+        pos_ += n;
+    }
+
+private:
+    void check(uint64_t n) const
+    {
+        if (n > static_cast<uint64_t>(end_ - pos_))
+            throw CDMException("truncated serialized interpolation");
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+} // namespace
+
+SparseInterpolationMatrix_cp CachedInterpolationInterface::sparseMatrix() const
+{
+    return SparseInterpolationMatrix_cp();
+}
+
+int CachedInterpolationInterface::serializationType() const
+{
+    return sparseMatrix() ? SERIAL_SPARSE_MATRIX : SERIAL_NONE;
+}
+
+void CachedInterpolationInterface::writeWeights(std::ostream& out) const
+{
+    if (SparseInterpolationMatrix_cp matrix = sparseMatrix()) {
+        writeValue<int32_t>(out, matrix->flags());
+        writeVector(out, matrix->rowStart());
+        writeVector(out, matrix->columns());
+        writeVector(out, matrix->weights());
+    }
+}
+
+void CachedInterpolationInterface::write(std::ostream& out) const
+{
+    const int type = serializationType();
+    if (type == SERIAL_NONE)
+        throw CDMException("interpolation cannot be serialized");
+
+    out.write(SERIAL_MAGIC, sizeof(SERIAL_MAGIC));
+    writeValue<uint32_t>(out, SERIAL_VERSION);
+    writeValue<uint32_t>(out, SERIAL_BYTE_ORDER);
+    writeValue<int32_t>(out, type);
+    writeString(out, _xDimName);
+    writeString(out, _yDimName);
+    writeValue<uint64_t>(out, inX);
+    writeValue<uint64_t>(out, inY);
+    writeValue<uint64_t>(out, outX);
+    writeValue<uint64_t>(out, outY);
+    writeValue<uint8_t>(out, reducedDomain_ ? 1 : 0);
+    if (reducedDomain_) {
+        writeString(out, reducedDomain_->xDim);
+        writeString(out, reducedDomain_->yDim);
+        writeValue<uint64_t>(out, reducedDomain_->xMin);
+        writeValue<uint64_t>(out, reducedDomain_->yMin);
+    }
+    writeWeights(out);
+    if (!out)
+        throw CDMException("error writing serialized interpolation");
+}
+
+CachedInterpolationInterface_p readCachedInterpolation(const char* data, size_t size)
+{
+    SerialReader in(data, size);
+    char magic[sizeof(SERIAL_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (std::memcmp(magic, SERIAL_MAGIC, sizeof(magic)) != 0)
+        throw CDMException("not a serialized interpolation");
+    const uint32_t version = in.value<uint32_t>();
+    if (version != SERIAL_VERSION)
+        throw CDMException("unsupported serialized interpolation version " + type2string(version));
+    if (in.value<uint32_t>() != SERIAL_BYTE_ORDER)
+        throw CDMException("serialized interpolation has a different byte-order");
+
+    const int32_t type = in.value<int32_t>();
+    const std::string xDimName = in.string();
+    const std::string yDimName = in.string();
+    const size_t inX = in.value<uint64_t>();
+    const size_t inY = in.value<uint64_t>();
+    const size_t outX = in.value<uint64_t>();
+    const size_t outY = in.value<uint64_t>();
+    ReducedInterpolationDomain_p reducedDomain;
+    if (in.value<uint8_t>()) {
+        const std::string rxDim = in.string();
+        const std::string ryDim = in.string();
+        const size_t xMin = in.value<uint64_t>();
+        const size_t yMin = in.value<uint64_t>();
+        reducedDomain = std::make_shared<ReducedInterpolationDomain>(rxDim, ryDim, xMin, yMin);
+    }
+
+    const size_t outLayerSize = outX * outY;
+    switch (type) {
+    case SERIAL_BILINEAR_BICUBIC: {
+        const int funcType = in.value<int32_t>();
+        const std::vector<double> pointsOnXAxis = in.vector<double>();
+        const std::vector<double> pointsOnYAxis = in.vector<double>();
+        if (pointsOnXAxis.size() != outLayerSize || pointsOnYAxis.size() != outLayerSize)
+            throw CDMException("serialized interpolation has inconsistent size");
+        return std::make_shared<CachedInterpolation>(xDimName, yDimName, funcType, pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY, reducedDomain);
+    }
+    case SERIAL_NEAREST_NEIGHBOR: {
+        const std::vector<uint64_t> points = in.vector<uint64_t>();
+        if (points.size() != outLayerSize)
+            throw CDMException("serialized interpolation has inconsistent size");
+        const std::vector<size_t> pointsInIn(points.begin(), points.end());
+        const size_t invalid = ~0u;
+        for (size_t i : pointsInIn) {
+            if (i != invalid && i >= inX * inY)
+                throw CDMException("serialized interpolation has inconsistent size");
+        }
+        return std::make_shared<CachedNNInterpolation>(xDimName, yDimName, pointsInIn, inX, inY, outX, outY, reducedDomain);
+    }
+    case SERIAL_SPARSE_MATRIX: {
+        const int flags = in.value<int32_t>();
+        const std::vector<uint64_t> rowStart = in.vector<uint64_t>();
+        const std::vector<uint32_t> columns = in.vector<uint32_t>();
+        const std::vector<float> weights = in.vector<float>();
+        SparseInterpolationMatrix_cp matrix = std::make_shared<SparseInterpolationMatrix>(inX * inY, flags, rowStart, columns, weights);
+        return std::make_shared<CachedSparseInterpolation>(xDimName, yDimName, matrix, inX, inY, outX, outY, reducedDomain);
+    }
+    default:
+        throw CDMException("unknown serialized interpolation type " + type2string(type));
+    }
+}
+
 DataPtr CachedInterpolationInterface::getInputDataSlice(CDMReader_p reader, const std::string& varName, size_t unLimDimPos) const
 {
     DataPtr data;
@@ -90,9 +292,13 @@ DataPtr CachedInterpolationInterface::getInputDataSlice(CDMReader_p reader, cons
 
 DataPtr CachedInterpolationInterface::getInputDataSlice(CDMReader_p reader, const std::string& varName, const SliceBuilder& sb) const
 {
-    DataPtr data;
-    LOG4FIMEX(logger, Logger::DEBUG, "creating a slicebuilder for '"<< varName << "'" );
-    SliceBuilder rsb(reader->getCDM(), varName);
+    return reader->getDataSlice(varName, getInputSliceBuilder(reader->getCDM(), varName, sb));
+}
+
+SliceBuilder CachedInterpolationInterface::getInputSliceBuilder(const CDM& inputCdm, const std::string& varName, const SliceBuilder& sb) const
+{
+    LOG4FIMEX(logger, Logger::DEBUG, "creating a slicebuilder for '" << varName << "'");
+    SliceBuilder rsb(inputCdm, varName);
     const std::vector<std::string> dims = rsb.getDimensionNames();
     for (size_t i = 0; i < dims.size(); i++) {
         const std::string& dn = dims[i];
@@ -110,8 +316,7 @@ DataPtr CachedInterpolationInterface::getInputDataSlice(CDMReader_p reader, cons
         }
         rsb.setStartAndSize(dn, start, size);
     }
-    data = reader->getDataSlice(varName, rsb);
-    return data;
+    return rsb;
 }
 
 DataPtr CachedInterpolationInterface::getOutputDataSlice(DataPtr data, const SliceBuilder& sb) const
@@ -133,6 +338,15 @@ DataPtr CachedInterpolationInterface::getOutputDataSlice(DataPtr data, const Sli
     return data->slice(maxDims, startPos, dimSizes);
 }
 
+CachedInterpolationInterface_p createSparseInterpolation(const CachedInterpolationInterface& ci)
+{
+    SparseInterpolationMatrix_cp matrix = ci.sparseMatrix();
+    if (!matrix)
+        throw CDMException("interpolation cannot be expressed as sparse matrix");
+    return std::make_shared<CachedSparseInterpolation>(ci.getXDimName(), ci.getYDimName(), matrix, ci.getInX(), ci.getInY(), ci.getOutX(), ci.getOutY(),
+                                                       ci.reducedDomain());
+}
+
 CachedInterpolationInterface_p createCachedInterpolation(const std::string& xDimName, const std::string& yDimName, int method,
                                                          const std::vector<double>& pointsOnXAxis, const std::vector<double>& pointsOnYAxis, size_t inX,
                                                          size_t inY, size_t outX, size_t outY)
@@ -155,54 +369,227 @@ CachedInterpolation::CachedInterpolation(const std::string& xDimName, const std:
     : CachedInterpolationInterface(xDimName, yDimName, inx, iny, outx, outy)
     , pointsOnXAxis(pointsOnXAxis)
     , pointsOnYAxis(pointsOnYAxis)
+    , funcType(funcType)
 {
     // we do not round pointsOnXYAxis values here:
-    // * mifi_get_values_bilinear_f and mifi_get_values_bicubic_f use floor/fraction
+    // * bilinear and bicubic weights use floor/fraction
+
+    createReducedDomain(xDimName, yDimName);
+    initWeights();
+}
+
+CachedInterpolation::CachedInterpolation(const std::string& xDimName, const std::string& yDimName, int funcType, const std::vector<double>& pointsOnXAxis,
+                                         const std::vector<double>& pointsOnYAxis, size_t inx, size_t iny, size_t outx, size_t outy,
+                                         ReducedInterpolationDomain_p reducedDomain)
+    : CachedInterpolationInterface(xDimName, yDimName, inx, iny, outx, outy)
+    , pointsOnXAxis(pointsOnXAxis)
+    , pointsOnYAxis(pointsOnYAxis)
+    , funcType(funcType)
+{
+    reducedDomain_ = reducedDomain;
+    initWeights();
+}
+
+namespace {
+
+// output points interpolated at once for all z-levels, offsets and weights of a tile stay in cache
+const size_t INTERPOLATION_TILE_SIZE = 1024;
+
+enum AxisMode { AXIS_UNDEFINED, AXIS_LINEAR, AXIS_NEAREST };
+
+/**
+ * Position and fraction of v on an axis of size n, as in mifi_get_values_bilinear_f:
+ * linear between pos and pos+1 if possible, otherwise the nearest neighbor
+ */
+AxisMode bilinearAxis(double v, size_t n, size_t& pos, float& frac)
+{
+    if (!(v >= -1 && v <= n)) // also nan
+        return AXIS_UNDEFINED;
+    const double p0 = std::floor(v);
+    if (p0 >= 0 && p0 + 1 < n) {
+        pos = static_cast<size_t>(p0);
+        frac = v - p0;
+        return AXIS_LINEAR;
+    }
+    const double p = std::round(v);
+    if (p >= 0 && p < n) {
+        pos = static_cast<size_t>(p);
+        frac = 0;
+        return AXIS_NEAREST;
+    }
+    return AXIS_UNDEFINED;
+}
+
+/**
+ * Position and the 4 weights of v on an axis of size n, as in mifi_get_values_bicubic_f,
+ * i.e. the product of (1, f, f^2, f^3) and the convolution matrix for a = -0.5
+ */
+bool bicubicAxis(double v, size_t n, size_t& pos, double w[4])
+{
+    if (!(v >= 1 && v < n)) // also nan
+        return false;
+    const double p0 = std::floor(v);
+    if (p0 + 2 >= n)
+        return false;
+    pos = static_cast<size_t>(p0) - 1;
+
+    static const double M[4][4] = {{0, 1, 0, 0}, {-.5, 0, .5, 0}, {1, -2.5, 2, -.5}, {-.5, 1.5, -1.5, .5}};
+    const double f = v - p0;
+    const double F[4] = {1, f, f * f, f * f * f};
+    for (int i = 0; i < 4; i++) {
+        w[i] = 0;
+        for (int j = 0; j < 4; j++)
+            w[i] += F[j] * M[j][i];
+    }
+    return true;
+}
+
+} // namespace
+
+void CachedInterpolation::initWeights()
+{
+    if (static_cast<double>(inX) * inY > std::numeric_limits<int32_t>::max())
+        throw CDMException("CachedInterpolation input too large: " + type2string(inX) + "x" + type2string(inY));
 
     switch (funcType) {
-    case MIFI_INTERPOL_BILINEAR: this->func = mifi_get_values_bilinear_f; break;
-    case MIFI_INTERPOL_BICUBIC:  this->func = mifi_get_values_bicubic_f; break;
-#if 0
-    case MIFI_INTERPOL_NEAREST_NEIGHBOR:
-    case MIFI_INTERPOL_COORD_NN:
-    case MIFI_INTERPOL_COORD_NN_KD: this->func = mifi_get_values_f; break;
-#endif
+    case MIFI_INTERPOL_BILINEAR: initBilinearWeights(); break;
+    case MIFI_INTERPOL_BICUBIC: initBicubicWeights(); break;
     default:
         throw CDMException("CachedInterpolation supports only bilinear and bicubic, not: " + type2string(funcType));
     }
+}
 
-    createReducedDomain(xDimName, yDimName);
+void CachedInterpolation::initBilinearWeights()
+{
+    const size_t outLayerSize = outX * outY;
+    offsets_.assign(outLayerSize, 0);
+    steps_.assign(outLayerSize, 0);
+    weights_.assign(2 * outLayerSize, 0);
+    float* wx = &weights_[0];
+    float* wy = wx + outLayerSize;
+
+    bool defined = false;
+    for (size_t xy = 0; xy < outLayerSize; ++xy) {
+        size_t px, py;
+        const AxisMode xMode = bilinearAxis(pointsOnXAxis[xy], inX, px, wx[xy]);
+        const AxisMode yMode = bilinearAxis(pointsOnYAxis[xy], inY, py, wy[xy]);
+        if (xMode == AXIS_UNDEFINED || yMode == AXIS_UNDEFINED) {
+            // nan propagates to the output
+            wx[xy] = MIFI_UNDEFINED_F;
+            continue;
+        }
+        offsets_[xy] = py * inX + px;
+        steps_[xy] = (xMode == AXIS_LINEAR ? BILINEAR_STEP_X : 0) | (yMode == AXIS_LINEAR ? BILINEAR_STEP_Y : 0);
+        defined = true;
+    }
+    if (!defined)
+        offsets_.clear();
 }
 
-shared_array<float> CachedInterpolation::interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const
+void CachedInterpolation::initBicubicWeights()
 {
     const size_t outLayerSize = outX * outY;
-    const size_t inZ = size / (inX*inY);
-    newSize = outLayerSize*inZ;
-    shared_array<float> outfield(new float[newSize]);
+    offsets_.assign(outLayerSize, 0);
+    steps_.clear();
+    weights_.assign(8 * outLayerSize, 0);
 
-#ifdef _OPENMP
-#pragma omp parallel default(shared)
-    {
-#endif
-        std::unique_ptr<float[]> zValues(new float[inZ]);
-#ifdef _OPENMP
-#pragma omp for
-#endif
+    bool defined = false;
     for (size_t xy = 0; xy < outLayerSize; ++xy) {
-        float* outPos = &outfield[xy];
-        if (func(inData.get(), zValues.get(), pointsOnXAxis[xy], pointsOnYAxis[xy], inX, inY, inZ) != MIFI_ERROR) {
-            for (size_t z = 0; z < inZ; ++z) {
-                *outPos = zValues[z];
-                outPos += outLayerSize;
+        size_t px, py;
+        double xm[4], my[4];
+        if (bicubicAxis(pointsOnXAxis[xy], inX, px, xm) && bicubicAxis(pointsOnYAxis[xy], inY, py, my)) {
+            offsets_[xy] = py * inX + px;
+            for (int i = 0; i < 4; i++) {
+                weights_[i * outLayerSize + xy] = static_cast<float>(xm[i]);
+                weights_[(4 + i) * outLayerSize + xy] = static_cast<float>(my[i]);
             }
+            defined = true;
         } else {
-            throw CDMException("error during interpolation");
+            // nan propagates to the output
+            for (int i = 0; i < 8; i++)
+                weights_[i * outLayerSize + xy] = MIFI_UNDEFINED_F;
         }
     }
-#ifdef _OPENMP
+    // undefined points read the 4x4 neighbourhood at offset 0, which might not exist
+    if (!defined)
+        offsets_.clear();
+}
+
+int CachedInterpolation::serializationType() const
+{
+    return SERIAL_BILINEAR_BICUBIC;
+}
+
+void CachedInterpolation::writeWeights(std::ostream& out) const
+{
+    writeValue<int32_t>(out, funcType);
+    writeVector(out, pointsOnXAxis);
+    writeVector(out, pointsOnYAxis);
+}
+
+SparseInterpolationMatrix_cp CachedInterpolation::sparseMatrix() const
+{
+    // undefined input values propagate, also with zero weight, as in interpolateValues
+    const size_t outLayerSize = outX * outY;
+    std::shared_ptr<SparseInterpolationMatrix> matrix = std::make_shared<SparseInterpolationMatrix>(inX * inY);
+    for (size_t xy = 0; xy < outLayerSize; ++xy) {
+        if (offsets_.empty()) {
+            matrix->endRow();
+            continue;
+        }
+        const size_t offset = offsets_[xy];
+        if (funcType == MIFI_INTERPOL_BILINEAR) {
+            const float wx = weights_[xy], wy = weights_[outLayerSize + xy];
+            if (!mifi_isnan(wx)) {
+                const size_t nx = (steps_[xy] & BILINEAR_STEP_X) ? 2 : 1;
+                const size_t ny = (steps_[xy] & BILINEAR_STEP_Y) ? 2 : 1;
+                for (size_t j = 0; j < ny; ++j)
+                    for (size_t i = 0; i < nx; ++i)
+                        matrix->addWeight(offset + j * inX + i, (j ? wy : 1.f - wy) * (i ? wx : 1.f - wx));
+            }
+        } else if (!mifi_isnan(weights_[xy])) {
+            for (size_t j = 0; j < 4; ++j)
+                for (size_t i = 0; i < 4; ++i)
+                    matrix->addWeight(offset + j * inX + i, weights_[(4 + j) * outLayerSize + xy] * weights_[i * outLayerSize + xy]);
+        }
+        matrix->endRow();
+    }
+    return matrix;
+}
+
+shared_array<float> CachedInterpolation::interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const
+{
+    const size_t outLayerSize = outX * outY;
+    const size_t inLayerSize = inX * inY;
+    const size_t inZ = size / inLayerSize;
+    newSize = outLayerSize*inZ;
+    shared_array<float> outfield = make_pooled_array<float>(newSize);
+    if (offsets_.empty()) {
+        std::fill(outfield.get(), outfield.get() + newSize, MIFI_UNDEFINED_F);
+        return outfield;
     }
-#endif
+
+    const float* in = inData.get();
+    float* out = outfield.get();
+    parallelForRange(
+        outLayerSize, INTERPOLATION_TILE_SIZE,
+        [&](size_t begin, size_t end) {
+            const size_t n = end - begin;
+            const uint32_t* offsets = &offsets_[begin];
+            if (funcType == MIFI_INTERPOL_BILINEAR) {
+                const float* wx = &weights_[begin];
+                const float* wy = wx + outLayerSize;
+                for (size_t z = 0; z < inZ; ++z)
+                    bilinearKernel(in + z * inLayerSize, inX, offsets, &steps_[begin], wx, wy, out + z * outLayerSize + begin, n);
+            } else {
+                const float* w = &weights_[begin];
+                const float* const xm[4] = {w, w + outLayerSize, w + 2 * outLayerSize, w + 3 * outLayerSize};
+                const float* const my[4] = {w + 4 * outLayerSize, w + 5 * outLayerSize, w + 6 * outLayerSize, w + 7 * outLayerSize};
+                for (size_t z = 0; z < inZ; ++z)
+                    bicubicKernel(in + z * inLayerSize, inX, offsets, xm, my, out + z * outLayerSize + begin, n);
+            }
+        },
+        TASK_STAGE_INTERPOLATE);
 
     return outfield;
 }
@@ -312,6 +699,35 @@ CachedNNInterpolation::CachedNNInterpolation(const std::string& xDimName, const
     }
 }
 
+CachedNNInterpolation::CachedNNInterpolation(const std::string& xDimName, const std::string& yDimName, const std::vector<size_t>& pointsInIn, size_t inx,
+                                             size_t iny, size_t outx, size_t outy, ReducedInterpolationDomain_p reducedDomain)
+    : CachedInterpolationInterface(xDimName, yDimName, inx, iny, outx, outy)
+    , pointsInIn(pointsInIn)
+{
+    reducedDomain_ = reducedDomain;
+}
+
+int CachedNNInterpolation::serializationType() const
+{
+    return SERIAL_NEAREST_NEIGHBOR;
+}
+
+void CachedNNInterpolation::writeWeights(std::ostream& out) const
+{
+    writeVector(out, std::vector<uint64_t>(pointsInIn.begin(), pointsInIn.end()));
+}
+
+SparseInterpolationMatrix_cp CachedNNInterpolation::sparseMatrix() const
+{
+    std::shared_ptr<SparseInterpolationMatrix> matrix = std::make_shared<SparseInterpolationMatrix>(inX * inY);
+    for (size_t i : pointsInIn) {
+        if (i != INVALID)
+            matrix->addWeight(i, 1);
+        matrix->endRow();
+    }
+    return matrix;
+}
+
 shared_array<float> CachedNNInterpolation::interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const
 {
     const size_t outLayerSize = outX * outY;
@@ -319,7 +735,7 @@ shared_array<float> CachedNNInterpolation::interpolateValues(shared_array<float>
     const size_t inZ = size / inLayerSize;
     newSize = outLayerSize * inZ;
 
-    shared_array<float> outData(new float[newSize]);
+    shared_array<float> outData = make_pooled_array<float>(newSize);
     std::fill(outData.get(), outData.get() + newSize, MIFI_UNDEFINED_F);
 
     for (size_t z = 0; z < inZ; ++z) {
@@ -334,4 +750,29 @@ shared_array<float> CachedNNInterpolation::interpolateValues(shared_array<float>
     return outData;
 }
 
+CachedSparseInterpolation::CachedSparseInterpolation(const std::string& xDimName, const std::string& yDimName, SparseInterpolationMatrix_cp matrix,
+                                                     size_t inx, size_t iny, size_t outx, size_t outy, ReducedInterpolationDomain_p reducedDomain)
+    : CachedInterpolationInterface(xDimName, yDimName, inx, iny, outx, outy)
+    , matrix_(matrix)
+{
+    if (!matrix_ || matrix_->inSize() != inX * inY || matrix_->rows() != outX * outY)
+        throw CDMException("sparse interpolation matrix does not match " + type2string(inX) + "x" + type2string(inY) + " => " + type2string(outX) + "x" +
+                           type2string(outY));
+    reducedDomain_ = reducedDomain;
+}
+
+SparseInterpolationMatrix_cp CachedSparseInterpolation::sparseMatrix() const
+{
+    return matrix_;
+}
+
+shared_array<float> CachedSparseInterpolation::interpolateValues(shared_array<float> inData, size_t size, size_t& newSize) const
+{
+    const size_t inZ = size / (inX * inY);
+    newSize = outX * outY * inZ;
+    shared_array<float> outData = make_pooled_array<float>(newSize);
+    matrix_->apply(inData.get(), inZ, outData.get());
+    return outData;
+}
+
 } // namespace MetNoFimex
@@ -0,0 +1,317 @@
+/*
+ * Fimex, ConservativeRemapping.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "ConservativeRemapping.h"
+
+#include "fimex/CDMException.h"
+#include "fimex/Logger.h"
+#include "fimex/Type2String.h"
+#include "fimex/mifi_constants.h"
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MetNoFimex {
+
+namespace {
+
+Logger_p logger = getLogger("fimex.ConservativeRemapping");
+
+// input rows handled by one task
+const size_t ROWS_PER_TASK = 8;
+// clipping an input cell (4 corners) to an output cell adds at most this many vertices
+const size_t MAX_POLYGON = 64;
+
+struct Point
+{
+    double x, y;
+};
+
+struct Overlap
+{
+    size_t out;   // position in output layer
+    size_t in;    // position in input layer
+    float weight; // overlap area / output cell area
+};
+
+//! sine of the latitude, the y-coordinate of an equal-area projection of longitude/latitude
+inline double sinLatitude(double lat)
+{
+    return std::sin(std::max(-MIFI_PI / 2, std::min(MIFI_PI / 2, lat)));
+}
+
+/**
+ * Bounds of the cells around the values of a monotonic axis, in ascending order.
+ */
+class AxisBounds
+{
+public:
+    /**
+     * @param axis cell centres
+     * @param isLatitude use sinLatitude of the bounds of the latitude axis in radian
+     */
+    AxisBounds(const std::vector<double>& axis, bool isLatitude)
+        : n_(axis.size())
+        , descending_(false)
+    {
+        if (n_ < 2)
+            throw CDMException("conservative remapping needs at least 2 output cells per axis");
+        bounds_.reserve(n_ + 1);
+        bounds_.push_back(axis[0] - (axis[1] - axis[0]) / 2);
+        for (size_t i = 1; i < n_; ++i)
+            bounds_.push_back((axis[i - 1] + axis[i]) / 2);
+        bounds_.push_back(axis[n_ - 1] + (axis[n_ - 1] - axis[n_ - 2]) / 2);
+        if (isLatitude)
+            std::transform(bounds_.begin(), bounds_.end(), bounds_.begin(), sinLatitude);
+        if (axis[1] < axis[0]) {
+            descending_ = true;
+            std::reverse(bounds_.begin(), bounds_.end());
+        }
+        for (size_t i = 1; i <= n_; ++i) {
+            if (!(bounds_[i - 1] < bounds_[i]))
+                throw CDMException("conservative remapping needs strictly monotonic output axes");
+        }
+    }
+
+    //! @return lower bound of ascending cell k
+    double lower(size_t k) const { return bounds_[k]; }
+    //! @return upper bound of ascending cell k
+    double upper(size_t k) const { return bounds_[k + 1]; }
+    //! @return position on the axis of ascending cell k
+    size_t index(size_t k) const { return descending_ ? n_ - 1 - k : k; }
+
+    //! find the ascending cells [begin, end) overlapping [lo, hi]
+    void range(double lo, double hi, size_t& begin, size_t& end) const
+    {
+        begin = std::upper_bound(bounds_.begin(), bounds_.end(), lo) - bounds_.begin();
+        begin = (begin > 0) ? begin - 1 : 0;
+        end = std::min(n_, static_cast<size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), hi) - bounds_.begin()));
+    }
+
+private:
+    size_t n_;
+    bool descending_;
+    std::vector<double> bounds_;
+};
+
+//! x shifted by a multiple of 2pi to be closest to ref
+inline double unwrapLongitude(double x, double ref)
+{
+    return ref + std::remainder(x - ref, 2 * MIFI_PI);
+}
+
+/**
+ * Corners of the input cells, (inX+1)*(inY+1), bilinear interpolated from the
+ * cell centres, and extrapolated at the borders. With xIsLongitude, the
+ * y-coordinate of the corners is sinLatitude, so that areas are proportional
+ * to the area on the sphere.
+ */
+std::vector<Point> cellCorners(const double* px, const double* py, size_t inX, size_t inY, bool xIsLongitude)
+{
+    std::vector<Point> corners((inX + 1) * (inY + 1));
+    for (size_t cy = 0; cy <= inY; ++cy) {
+        const size_t y0 = std::min(cy > 0 ? cy - 1 : 0, inY - 2);
+        const double u = cy - 0.5 - y0;
+        for (size_t cx = 0; cx <= inX; ++cx) {
+            const size_t x0 = std::min(cx > 0 ? cx - 1 : 0, inX - 2);
+            const double t = cx - 0.5 - x0;
+            const size_t p00 = y0 * inX + x0, p01 = p00 + 1, p10 = p00 + inX, p11 = p10 + 1;
+            double x00 = px[p00], x01 = px[p01], x10 = px[p10], x11 = px[p11];
+            if (xIsLongitude) {
+                x01 = unwrapLongitude(x01, x00);
+                x10 = unwrapLongitude(x10, x00);
+                x11 = unwrapLongitude(x11, x00);
+            }
+            Point& c = corners[cy * (inX + 1) + cx];
+            c.x = (1 - u) * ((1 - t) * x00 + t * x01) + u * ((1 - t) * x10 + t * x11);
+            c.y = (1 - u) * ((1 - t) * py[p00] + t * py[p01]) + u * ((1 - t) * py[p10] + t * py[p11]);
+            if (xIsLongitude)
+                c.y = sinLatitude(c.y);
+        }
+    }
+    return corners;
+}
+
+/**
+ * Clip a polygon to the half-plane of points with coordinate (x if axis == 0, else y)
+ * above (keepAbove) or below bound, Sutherland-Hodgman.
+ *
+ * @return number of points in out
+ */
+size_t clipPolygon(const Point* in, size_t n, Point* out, int axis, double bound, bool keepAbove)
+{
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Point& a = in[i];
+        const Point& b = in[(i + 1) % n];
+        const double va = axis ? a.y : a.x;
+        const double vb = axis ? b.y : b.x;
+        const bool insideA = keepAbove ? (va >= bound) : (va <= bound);
+        const bool insideB = keepAbove ? (vb >= bound) : (vb <= bound);
+        if (insideA)
+            out[m++] = a;
+        if (insideA != insideB) {
+            const double f = (bound - va) / (vb - va);
+            out[m++] = Point{a.x + f * (b.x - a.x), a.y + f * (b.y - a.y)};
+        }
+    }
+    return m;
+}
+
+double polygonArea(const Point* p, size_t n)
+{
+    double area = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Point& a = p[i];
+        const Point& b = p[(i + 1) % n];
+        area += a.x * b.y - b.x * a.y;
+    }
+    return std::fabs(area) / 2;
+}
+
+//! area of the cell inside the rectangle [x0, x1] x [y0, y1]
+double overlapArea(const Point* cell, double x0, double x1, double y0, double y1)
+{
+    Point a[MAX_POLYGON], b[MAX_POLYGON];
+    size_t n = clipPolygon(cell, 4, a, 0, x0, true);
+    n = clipPolygon(a, n, b, 0, x1, false);
+    n = clipPolygon(b, n, a, 1, y0, true);
+    n = clipPolygon(a, n, b, 1, y1, false);
+    return (n < 3) ? 0 : polygonArea(b, n);
+}
+
+void addCellOverlaps(const std::vector<Point>& corners, const double* px, size_t inX, size_t ix, size_t iy, const AxisBounds& xBounds,
+                     const AxisBounds& yBounds, size_t outX, bool xIsLongitude, std::vector<Overlap>& overlaps)
+{
+    const size_t c00 = iy * (inX + 1) + ix;
+    Point cell[4] = {corners[c00], corners[c00 + 1], corners[c00 + inX + 2], corners[c00 + inX + 1]};
+    const double centreX = px[iy * inX + ix];
+    if (xIsLongitude) {
+        for (Point& c : cell)
+            c.x = unwrapLongitude(c.x, centreX);
+    }
+    double xMin = cell[0].x, xMax = cell[0].x, yMin = cell[0].y, yMax = cell[0].y;
+    for (const Point& c : cell) {
+        if (!std::isfinite(c.x) || !std::isfinite(c.y))
+            return;
+        xMin = std::min(xMin, c.x);
+        xMax = std::max(xMax, c.x);
+        yMin = std::min(yMin, c.y);
+        yMax = std::max(yMax, c.y);
+    }
+    // cells around a pole are not representable in longitude/latitude
+    if (xIsLongitude && xMax - xMin > MIFI_PI)
+        return;
+
+    size_t yBegin, yEnd;
+    yBounds.range(yMin, yMax, yBegin, yEnd);
+    const int shifts = xIsLongitude ? 1 : 0;
+    for (int s = -shifts; s <= shifts; ++s) {
+        const double shift = s * 2 * MIFI_PI;
+        size_t xBegin, xEnd;
+        xBounds.range(xMin + shift, xMax + shift, xBegin, xEnd);
+        for (size_t ky = yBegin; ky < yEnd; ++ky) {
+            const double y0 = yBounds.lower(ky), y1 = yBounds.upper(ky);
+            for (size_t kx = xBegin; kx < xEnd; ++kx) {
+                const double x0 = xBounds.lower(kx), x1 = xBounds.upper(kx);
+                const double area = overlapArea(cell, x0 - shift, x1 - shift, y0, y1);
+                if (area > 0) {
+                    const Overlap o = {yBounds.index(ky) * outX + xBounds.index(kx), iy * inX + ix, static_cast<float>(area / ((x1 - x0) * (y1 - y0)))};
+                    overlaps.push_back(o);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+CachedInterpolationInterface_p createConservativeInterpolation(const std::string& xDimName, const std::string& yDimName, const double* pointsOnXAxis,
+                                                               const double* pointsOnYAxis, size_t inX, size_t inY, const std::vector<double>& outXAxis,
+                                                               const std::vector<double>& outYAxis, bool xIsLongitude)
+{
+    if (inX < 2 || inY < 2)
+        throw CDMException("conservative remapping needs at least 2x2 input cells, got " + type2string(inX) + "x" + type2string(inY));
+    const AxisBounds xBounds(outXAxis, false), yBounds(outYAxis, xIsLongitude);
+    const size_t outX = outXAxis.size(), outY = outYAxis.size();
+    const std::vector<Point> corners = cellCorners(pointsOnXAxis, pointsOnYAxis, inX, inY, xIsLongitude);
+
+    // overlaps of blocks of input rows, in order of the input
+    std::vector<std::vector<Overlap>> overlaps((inY + ROWS_PER_TASK - 1) / ROWS_PER_TASK);
+    parallelForRange(
+        inY, ROWS_PER_TASK,
+        [&](size_t begin, size_t end) {
+            std::vector<Overlap>& blockOverlaps = overlaps[begin / ROWS_PER_TASK];
+            for (size_t iy = begin; iy < end; ++iy) {
+                for (size_t ix = 0; ix < inX; ++ix)
+                    addCellOverlaps(corners, pointsOnXAxis, inX, ix, iy, xBounds, yBounds, outX, xIsLongitude, blockOverlaps);
+            }
+        },
+        TASK_STAGE_INTERPOLATE);
+
+    // sort by output point, i.e. matrix row, and find the used input domain
+    std::vector<uint64_t> rowStart(outX * outY + 1, 0);
+    size_t minInX = inX, maxInX = 0, minInY = inY, maxInY = 0;
+    for (const std::vector<Overlap>& block : overlaps) {
+        for (const Overlap& o : block) {
+            rowStart[o.out + 1] += 1;
+            minInX = std::min(minInX, o.in % inX);
+            maxInX = std::max(maxInX, o.in % inX);
+            minInY = std::min(minInY, o.in / inX);
+            maxInY = std::max(maxInY, o.in / inX);
+        }
+    }
+    for (size_t r = 0; r < outX * outY; ++r)
+        rowStart[r + 1] += rowStart[r];
+    const size_t nonZeros = rowStart.back();
+    LOG4FIMEX(logger, Logger::DEBUG, "conservative remapping " << inX << "x" << inY << " => " << outX << "x" << outY << " with " << nonZeros << " overlaps");
+
+    ReducedInterpolationDomain_p reducedDomain;
+    size_t redInX = inX, redInY = inY;
+    if (nonZeros > 0 && (minInX > 0 || minInY > 0 || maxInX < inX - 1 || maxInY < inY - 1)) {
+        redInX = maxInX - minInX + 1;
+        redInY = maxInY - minInY + 1;
+        reducedDomain = std::make_shared<ReducedInterpolationDomain>(xDimName, yDimName, minInX, minInY);
+    } else {
+        minInX = minInY = 0;
+    }
+
+    std::vector<uint32_t> columns(nonZeros);
+    std::vector<float> weights(nonZeros);
+    std::vector<uint64_t> next(rowStart.begin(), rowStart.end() - 1);
+    for (const std::vector<Overlap>& block : overlaps) {
+        for (const Overlap& o : block) {
+            const uint64_t k = next[o.out]++;
+            columns[k] = (o.in / inX - minInY) * redInX + (o.in % inX - minInX);
+            weights[k] = o.weight;
+        }
+    }
+
+    SparseInterpolationMatrix_cp matrix = std::make_shared<SparseInterpolationMatrix>(
+        redInX * redInY, SparseInterpolationMatrix::SKIP_MISSING | SparseInterpolationMatrix::NORMALIZE, rowStart, columns, weights);
+    return std::make_shared<CachedSparseInterpolation>(xDimName, yDimName, matrix, redInX, redInY, outX, outY, reducedDomain);
+}
+
+} // namespace MetNoFimex
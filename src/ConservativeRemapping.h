@@ -0,0 +1,68 @@
+/*
+ * Fimex, ConservativeRemapping.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef CONSERVATIVEREMAPPING_H_
+#define CONSERVATIVEREMAPPING_H_
+
+#include "fimex/CachedInterpolation.h"
+
+#include <string>
+#include <vector>
+
+namespace MetNoFimex {
+
+/**
+ * Create a first-order conservative remapping from a curvilinear input grid
+ * to a rectilinear output grid.
+ *
+ * The corners of the input cells are interpolated (at the borders
+ * extrapolated) from the cell centres, the output cells are bounded by the
+ * midpoints between the output axis values. The weight of an input cell for
+ * an output cell is the overlap area divided by the area of the output cell,
+ * with areas measured in the plane of the output projection. Each input cell
+ * is only intersected with the output cells within its bounding box, found by
+ * binary search on the output cell bounds.
+ *
+ * Undefined input values are skipped, and the output is normalized by the
+ * overlap of the defined input cells, i.e. the output is the area-weighted
+ * mean of the input, and partially covered output cells keep their mean.
+ *
+ * @param xDimName x-dimension of the input
+ * @param yDimName y-dimension of the input
+ * @param pointsOnXAxis x-coordinates of the input cell centres in the output projection, size inX*inY
+ * @param pointsOnYAxis y-coordinates of the input cell centres in the output projection, size inX*inY
+ * @param inX x-size of the input
+ * @param inY y-size of the input
+ * @param outXAxis x-coordinates of the output cell centres, monotonic
+ * @param outYAxis y-coordinates of the output cell centres, monotonic
+ * @param xIsLongitude true if the x- and y-coordinates are longitudes and latitudes in radian, handling the wrap-around
+ *        at the date line and measuring areas on the sphere
+ * @throw CDMException if a grid has less than 2 cells in x or y direction
+ */
+CachedInterpolationInterface_p createConservativeInterpolation(const std::string& xDimName, const std::string& yDimName, const double* pointsOnXAxis,
+                                                               const double* pointsOnYAxis, size_t inX, size_t inY, const std::vector<double>& outXAxis,
+                                                               const std::vector<double>& outYAxis, bool xIsLongitude);
+
+} // namespace MetNoFimex
+
+#endif /* CONSERVATIVEREMAPPING_H_ */
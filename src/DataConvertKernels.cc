@@ -0,0 +1,199 @@
+/*
+ * Fimex, DataConvertKernels.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "DataConvertKernels.h"
+
+#include "fimex/DataUtils.h"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FIMEX_HAVE_AVX2_KERNELS 1
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include <limits>
+#define FIMEX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace MetNoFimex {
+
+#ifdef FIMEX_HAVE_AVX2_KERNELS
+namespace {
+
+bool cpuHasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+// load 4 values as double, isFill is set to all bits for fill-values and nan
+
+FIMEX_TARGET_AVX2 inline __m256d maskFromInt32(__m128i eq)
+{
+    return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(eq));
+}
+
+FIMEX_TARGET_AVX2 inline __m256d load4(const short* in, short fill, __m256d& isFill)
+{
+    const __m128i v = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)));
+    isFill = maskFromInt32(_mm_cmpeq_epi32(v, _mm_set1_epi32(fill)));
+    return _mm256_cvtepi32_pd(v);
+}
+
+FIMEX_TARGET_AVX2 inline __m256d load4(const unsigned short* in, unsigned short fill, __m256d& isFill)
+{
+    const __m128i v = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)));
+    isFill = maskFromInt32(_mm_cmpeq_epi32(v, _mm_set1_epi32(fill)));
+    return _mm256_cvtepi32_pd(v);
+}
+
+FIMEX_TARGET_AVX2 inline __m256d load4(const unsigned char* in, unsigned char fill, __m256d& isFill)
+{
+    int32_t bytes;
+    std::memcpy(&bytes, in, sizeof(bytes));
+    const __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+    isFill = maskFromInt32(_mm_cmpeq_epi32(v, _mm_set1_epi32(fill)));
+    return _mm256_cvtepi32_pd(v);
+}
+
+FIMEX_TARGET_AVX2 inline __m256d load4(const double* in, double fill, __m256d& isFill)
+{
+    const __m256d v = _mm256_loadu_pd(in);
+    isFill = _mm256_or_pd(_mm256_cmp_pd(v, _mm256_set1_pd(fill), _CMP_EQ_OQ), _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+    return v;
+}
+
+FIMEX_TARGET_AVX2 inline __m256d load4(const float* in, float fill, __m256d& isFill)
+{
+    const __m256d v = _mm256_cvtps_pd(_mm_loadu_ps(in));
+    // the float fill-value is exact in double
+    isFill = _mm256_or_pd(_mm256_cmp_pd(v, _mm256_set1_pd(fill), _CMP_EQ_OQ), _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+    return v;
+}
+
+// store 4 doubles, converted like data_caster
+
+FIMEX_TARGET_AVX2 inline void store4(double* out, __m256d v)
+{
+    _mm256_storeu_pd(out, v);
+}
+
+FIMEX_TARGET_AVX2 inline void store4(float* out, __m256d v)
+{
+    _mm_storeu_ps(out, _mm256_cvtpd_ps(v));
+}
+
+FIMEX_TARGET_AVX2 inline void store4(short* out, __m256d v)
+{
+    // v is integral, see roundHalfAway; static_cast<short> keeps the lower 16bit of the int32
+    const __m128i i32 = _mm_and_si128(_mm256_cvttpd_epi32(v), _mm_set1_epi32(0xFFFF));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi32(i32, i32));
+}
+
+//! same as round(), i.e. half-way cases away from zero
+FIMEX_TARGET_AVX2 inline __m256d roundHalfAway(__m256d v)
+{
+    const __m256d signBit = _mm256_set1_pd(-0.);
+    const __m256d truncated = _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256d absDiff = _mm256_andnot_pd(signBit, _mm256_sub_pd(v, truncated));
+    const __m256d up = _mm256_cmp_pd(absDiff, _mm256_set1_pd(.5), _CMP_GE_OQ);
+    const __m256d one = _mm256_or_pd(_mm256_and_pd(v, signBit), _mm256_set1_pd(1.));
+    return _mm256_add_pd(truncated, _mm256_and_pd(up, one));
+}
+
+template <typename IN, typename OUT>
+FIMEX_TARGET_AVX2 void scaleValuesAvx2(const IN* in, OUT* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale,
+                                       double newOffset)
+{
+    const double scale = oldScale / newScale;
+    const double offset = (oldOffset - newOffset) / newScale;
+    const IN inFill = static_cast<IN>(oldFill);
+    const OUT outFill = static_cast<OUT>(newFill);
+    const __m256d vScale = _mm256_set1_pd(scale);
+    const __m256d vOffset = _mm256_set1_pd(offset);
+    const __m256d vOutFill = _mm256_set1_pd(outFill);
+    const __m256d vIntMin = _mm256_set1_pd(std::numeric_limits<int32_t>::min());
+    const __m256d vIntMax = _mm256_set1_pd(std::numeric_limits<int32_t>::max());
+    const ScaleValue<IN, OUT> scaleValue(oldFill, oldScale, oldOffset, newFill, newScale, newOffset);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d isFill;
+        const __m256d v = load4(in + i, inFill, isFill);
+        // no fma, to get the same results as ScaleValue
+        __m256d r = _mm256_add_pd(_mm256_mul_pd(v, vScale), vOffset);
+        if (std::numeric_limits<OUT>::is_integer) {
+            r = roundHalfAway(r);
+            // the int32 conversion in store4 saturates, values outside int32 are converted by ScaleValue
+            const __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(r, vIntMin, _CMP_GE_OQ), _mm256_cmp_pd(r, vIntMax, _CMP_LE_OQ));
+            if (_mm256_movemask_pd(_mm256_or_pd(inRange, isFill)) != 0xF) {
+                std::transform(in + i, in + i + 4, out + i, scaleValue);
+                continue;
+            }
+        }
+        store4(out + i, _mm256_blendv_pd(r, vOutFill, isFill));
+    }
+    std::transform(in + i, in + n, out + i, scaleValue);
+}
+
+template <typename IN, typename OUT>
+bool scaleValuesDispatch(const IN* in, OUT* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale,
+                         double newOffset)
+{
+    if (!cpuHasAvx2())
+        return false;
+    scaleValuesAvx2(in, out, n, oldFill, oldScale, oldOffset, newFill, newScale, newOffset);
+    return true;
+}
+
+} // namespace
+
+#define FIMEX_SCALEVALUESKERNEL(IN, OUT)                                                                                                                       \
+    template <>                                                                                                                                                \
+    bool scaleValuesKernel(const IN* in, OUT* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale,                \
+                           double newOffset)                                                                                                                   \
+    {                                                                                                                                                          \
+        return scaleValuesDispatch(in, out, n, oldFill, oldScale, oldOffset, newFill, newScale, newOffset);                                                    \
+    }
+
+#else // no kernels for this cpu/compiler
+
+#define FIMEX_SCALEVALUESKERNEL(IN, OUT)                                                                                                                       \
+    template <>                                                                                                                                                \
+    bool scaleValuesKernel(const IN*, OUT*, size_t, double, double, double, double, double, double)                                                           \
+    {                                                                                                                                                          \
+        return false;                                                                                                                                          \
+    }
+
+#endif
+
+FIMEX_SCALEVALUESKERNEL(short, float)
+FIMEX_SCALEVALUESKERNEL(unsigned short, float)
+FIMEX_SCALEVALUESKERNEL(unsigned char, float)
+FIMEX_SCALEVALUESKERNEL(short, double)
+FIMEX_SCALEVALUESKERNEL(float, short)
+FIMEX_SCALEVALUESKERNEL(float, double)
+FIMEX_SCALEVALUESKERNEL(double, float)
+
+} // namespace MetNoFimex
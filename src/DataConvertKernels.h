@@ -0,0 +1,61 @@
+/*
+ * Fimex, DataConvertKernels.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef DATACONVERTKERNELS_H_
+#define DATACONVERTKERNELS_H_
+
+#include <cstddef>
+
+namespace MetNoFimex {
+
+/**
+ * Vectorized version of std::transform with ScaleValue<IN, OUT>, i.e.
+ *
+ *   out[i] = (in[i] == oldFill || isnan(in[i])) ? newFill : (oldScale*in[i] + oldOffset - newOffset) / newScale
+ *
+ * with rounding for integer output. The results are identical to ScaleValue.
+ *
+ * Kernels exist only for the common packing/unpacking type pairs, and only
+ * if the cpu supports them (checked at runtime).
+ *
+ * @return false if no kernel is available, and nothing has been done
+ */
+template <typename IN, typename OUT>
+inline bool scaleValuesKernel(const IN*, OUT*, size_t, double, double, double, double, double, double)
+{
+    return false;
+}
+
+// clang-format off
+template <> bool scaleValuesKernel(const short* in, float* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+template <> bool scaleValuesKernel(const unsigned short* in, float* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+template <> bool scaleValuesKernel(const unsigned char* in, float* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+template <> bool scaleValuesKernel(const short* in, double* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+template <> bool scaleValuesKernel(const float* in, short* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+template <> bool scaleValuesKernel(const float* in, double* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+template <> bool scaleValuesKernel(const double* in, float* out, size_t n, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset);
+// clang-format on
+
+} // namespace MetNoFimex
+
+#endif /* DATACONVERTKERNELS_H_ */
@@ -24,20 +24,26 @@
 #ifndef DATAIMPL_H_
 #define DATAIMPL_H_
 
+#include "BufferPool.h"
+#include "DataConvertKernels.h"
 #include "fimex/CDMDataType.h"
 #include "fimex/CDMException.h"
 #include "fimex/Data.h"
 #include "fimex/DataUtils.h"
 #include "fimex/MathUtils.h"
 #include "fimex/Type2String.h"
+#include "fimex/mifi_constants.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iterator>
 #include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace MetNoFimex {
 
@@ -84,34 +90,48 @@ class DataImpl : public Data
 public:
     /// constructor where the array will be automatically allocated
     explicit DataImpl(long length)
-        : length(length), theData(new C[length]) {}
+        : length(length)
+        , theData(new C[length])
+        , isView(false)
+        , hasViews(false)
+    {
+    }
     explicit DataImpl(shared_array<C> array, long length)
         : length(length)
         , theData(array)
+        , isView(false)
+        , hasViews(false)
     {
     }
     ~DataImpl() {}
 
     size_t size() const override {return length;}
     int bytes_for_one() const override {return sizeof(C);}
-    void* getDataPtr() override {return &theData[0];}
+    void* getDataPtr() override
+    {
+        makeUnique();
+        return &theData[0];
+    }
     void toStream(std::ostream& os, const std::string& separator = "") const override;
 
     /**
          *  @brief get the datapointer of the data
          */
-    virtual const shared_array<C> asBase() const { return theData; }
+    virtual const shared_array<C> asBase() const { return isShared() ? copyOfData() : theData; }
     /**
          * general conversion function, not in base since template methods not allowed
          */
     template <typename T>
     const shared_array<T> as() const
     {
-        return ArrayTypeConverter<T, C>(theData, length)();
+        // memory shared between views and the original data must not be handed out
+        return ArrayTypeConverter<T, C>((isShared() && std::is_same<T, C>::value) ? copyOfData() : theData, length)();
     }
     template <typename T>
     shared_array<T> as()
     {
+        if (std::is_same<T, C>::value)
+            makeUnique();
         return ArrayTypeConverter<T, C>(theData, length)();
     }
     // conversion function
@@ -130,9 +150,17 @@ public:
 
     double getDouble(size_t pos) override {return data_caster<double, C>()(theData[pos]);}
     long long getLongLong(size_t pos) override {return data_caster<long long, C>()(theData[pos]);}
-    void setValue(size_t pos, double val) override {theData[pos] = data_caster<C, double>()(val);}
+    void setValue(size_t pos, double val) override
+    {
+        makeUnique();
+        theData[pos] = data_caster<C, double>()(val);
+    }
     void setValues(size_t startPos, const Data& data, size_t first = 0, size_t last = -1) override;
-    void setAllValues(double val) override {std::fill(&theData[0], (&theData[0])+length, data_caster<C, double>()(val));}
+    void setAllValues(double val) override
+    {
+        makeUnique();
+        std::fill(&theData[0], (&theData[0]) + length, data_caster<C, double>()(val));
+    }
     DataPtr clone() const override;
     DataPtr slice(const std::vector<size_t>& orgDimSize, const std::vector<size_t>& startDims, const std::vector<size_t>& outputDimSize) override;
     DataPtr convertDataType(double oldFill, double oldScale, double oldOffset, CDMDataType newType, double newFill, double newScale, double newOffset) override;
@@ -150,9 +178,18 @@ public:
 private:
     size_t length;
     shared_array<C> theData;
+    //! theData points into the memory of another DataImpl, copy-on-write
+    bool isView;
+    //! views to theData have been created, copy-on-write
+    std::atomic<bool> hasViews;
     DataImpl(const DataImpl<C>& rhs);
     DataImpl<C>& operator=(const DataImpl<C> & rhs);
     void copyData(size_t startPos, const shared_array<C>& otherData, size_t otherSize, size_t otherStart, size_t otherEnd);
+    shared_array<C> copyOfData() const;
+    //! theData is, or might be, shared between a view and its original data
+    bool isShared() const { return isView || (hasViews && !theData.unique()); }
+    //! make sure that theData is not shared with views before modification
+    void makeUnique();
 };
 
 
@@ -160,20 +197,41 @@ private:
 // (template definitions should be in header files (depending on compiler))
 template<typename C>
 DataImpl<C>::DataImpl(const DataImpl<C>& rhs)
-    : length(rhs.length), theData(new C[rhs.length])
+    : length(rhs.length)
+    , theData(rhs.copyOfData())
+    , isView(false)
+    , hasViews(false)
 {
-    std::copy(&rhs.theData[0], &rhs.theData[0] + rhs.length, &theData[0]);
 }
 
 template<typename C>
 DataImpl<C>& DataImpl<C>::operator=(const DataImpl<C>& rhs)
 {
     length = rhs.length;
-    theData = shared_array<C>(new C[rhs.length]);
-    std::copy(&rhs.theData[0], &rhs.theData[0] + rhs.length, &theData[0]);
+    theData = rhs.copyOfData();
+    isView = false;
+    hasViews = false;
     return *this;
 }
 
+template <typename C>
+shared_array<C> DataImpl<C>::copyOfData() const
+{
+    shared_array<C> copy = make_pooled_array<C>(length);
+    std::copy(&theData[0], &theData[0] + length, &copy[0]);
+    return copy;
+}
+
+template <typename C>
+void DataImpl<C>::makeUnique()
+{
+    if ((isView || hasViews) && !theData.unique()) {
+        theData = copyOfData();
+    }
+    isView = false;
+    hasViews = false;
+}
+
 template <typename C>
 void DataImpl<C>::toStream(std::ostream& os, const std::string& separator) const
 {
@@ -202,6 +260,7 @@ void DataImpl<C>::copyData(size_t startPos, const shared_array<C>& otherData, si
     otherLast = std::min(otherLast, otherSize);
     otherLast = std::min(size()-startPos+otherFirst, otherLast);
     if (otherLast > otherFirst) {
+        makeUnique();
         std::copy(&otherData[otherFirst], &otherData[otherLast], &theData[startPos]);
     }
 }
@@ -263,6 +322,24 @@ void recursiveCopyMultiDimData(C** orgData, C** newData, const std::vector<size_
     (*orgData) += (orgDimSize[currentDim] - (newStart[currentDim] + newSize[currentDim])) * orgSliceSize[currentDim];
 }
 
+/**
+ * check if a slice is a contiguous part of the original data, i.e. all dimensions
+ * faster than the first partially used dimension are used completely, and all slower
+ * dimensions have size 1 (fortran order, as in recursiveCopyMultiDimData)
+ */
+inline bool isContiguousSlice(const std::vector<size_t>& orgDimSize, const std::vector<size_t>& newStart, const std::vector<size_t>& newSize)
+{
+    size_t dim = 0;
+    while (dim < orgDimSize.size() && newStart[dim] == 0 && newSize[dim] == orgDimSize[dim])
+        dim++;
+    // dim is the first partially used dimension, all slower dimensions must have size 1
+    for (dim++; dim < orgDimSize.size(); dim++) {
+        if (newSize[dim] != 1)
+            return false;
+    }
+    return true;
+}
+
 template<typename C>
 DataPtr DataImpl<C>::slice(const std::vector<size_t>& orgDimSize, const std::vector<size_t>& startDims, const std::vector<size_t>& outputDimSize) {
     // handle scalar data
@@ -279,17 +356,29 @@ DataPtr DataImpl<C>::slice(const std::vector<size_t>& orgDimSize, const std::vec
     }
     if (orgSize != size()) throw CDMException("dimension-mismatch: " + type2string(size()) + "!=" + type2string(orgSize));
 
-    // get the old and new datacontainer
-    std::shared_ptr<DataImpl<C>> output(new DataImpl<C>(outputSize));
-    C* newData = output->theData.get();
-    C* oldData = theData.get();
-
     // pre-calculation of the slice-size of the different dimensions
     std::vector<size_t> orgSliceSize(orgDimSize.size(), 0);
     orgSliceSize[0] = 1;
     for (size_t dim = 1; dim < orgDimSize.size(); dim++) {
         orgSliceSize[dim] = orgSliceSize[dim-1] * orgDimSize[dim-1];
     }
+
+    // a contiguous block of memory is shared, with copy-on-write
+    if (outputSize > 0 && isContiguousSlice(orgDimSize, startDims, outputDimSize)) {
+        size_t offset = 0;
+        for (size_t dim = 0; dim < orgDimSize.size(); dim++)
+            offset += startDims[dim] * orgSliceSize[dim];
+        std::shared_ptr<DataImpl<C>> view(new DataImpl<C>(shared_array<C>(theData, theData.get() + offset), outputSize));
+        view->isView = true;
+        hasViews = true;
+        return view;
+    }
+
+    // get the old and new datacontainer
+    std::shared_ptr<DataImpl<C>> output(new DataImpl<C>(outputSize));
+    C* newData = output->theData.get();
+    C* oldData = theData.get();
+
     // slice the data
     recursiveCopyMultiDimData(&oldData, &newData, orgDimSize, orgSliceSize, startDims, outputDimSize, orgDimSize.size() - 1);
 
@@ -302,6 +391,7 @@ void DataImpl<C>::setValues(InputIterator begin, InputIterator end, size_t dataS
     size_t dist = std::distance(begin, end);
     if ((dist + dataStartPos) > length)
         throw CDMException("dataPos " + type2string(dist+dataStartPos) + " >= dataLength " + type2string(length));
+    makeUnique();
     std::transform(begin, end, &theData[dataStartPos], data_caster<C, typename InputIterator::value_type>());
 }
 
@@ -309,13 +399,33 @@ template <typename OUT, typename IN>
 shared_array<OUT> convertArrayType(const shared_array<IN>& inData, size_t length, double oldFill, double oldScale, double oldOffset,
                                    UnitsConverter_p unitsConverter, double newFill, double newScale, double newOffset)
 {
-    shared_array<OUT> outData(new OUT[length]);
+    shared_array<OUT> outData = make_pooled_array<OUT>(length);
+    if (unitsConverter && unitsConverter->isLinear()) {
+        // merge the units-conversion into scale and offset
+        double unitScale, unitOffset;
+        unitsConverter->getScaleOffset(unitScale, unitOffset);
+        oldOffset = unitScale * oldOffset + unitOffset;
+        oldScale *= unitScale;
+        unitsConverter.reset();
+    }
     if (!unitsConverter) {
-        ScaleValue<IN, OUT> sv(oldFill, oldScale, oldOffset, newFill, newScale, newOffset);
-        std::transform(&inData[0], &inData[length], &outData[0], sv);
+        if (!scaleValuesKernel(&inData[0], &outData[0], length, oldFill, oldScale, oldOffset, newFill, newScale, newOffset)) {
+            ScaleValue<IN, OUT> sv(oldFill, oldScale, oldOffset, newFill, newScale, newOffset);
+            std::transform(&inData[0], &inData[length], &outData[0], sv);
+        }
     } else {
-        ScaleValueUnits<IN, OUT> sv(oldFill, oldScale, oldOffset, unitsConverter, newFill, newScale, newOffset);
-        std::transform(&inData[0], &inData[length], &outData[0], sv);
+        // scale to double with nan as fill, convert units block-wise, scale to output
+        const double nan = MIFI_UNDEFINED_D;
+        ScaleValue<IN, double> svIn(oldFill, oldScale, oldOffset, nan, 1, 0);
+        ScaleValue<double, OUT> svOut(nan, 1, 0, newFill, newScale, newOffset);
+        const size_t blockSize = 4096;
+        std::vector<double> buffer(std::min(length, blockSize));
+        for (size_t start = 0; start < length; start += blockSize) {
+            const size_t n = std::min(length - start, blockSize);
+            std::transform(&inData[start], &inData[start + n], &buffer[0], svIn);
+            unitsConverter->convert(&buffer[0], &buffer[0], n, nan);
+            std::transform(&buffer[0], &buffer[n], &outData[start], svOut);
+        }
     }
     return outData;
 }
@@ -363,7 +473,7 @@ DataPtr DataImpl<std::string>::convertDataType(double, double, double, UnitsConv
 template <typename T1, typename T2>
 shared_array<T1> ArrayTypeConverter<T1, T2>::operator()()
 {
-    shared_array<T1> outData(new T1[length]);
+    shared_array<T1> outData = make_pooled_array<T1>(length);
     std::transform(&inData[0], &inData[length], &outData[0], data_caster<T1, T2>());
     return outData;
 }
@@ -172,6 +172,7 @@ void FeltCDMReader2::readAdditionalAxisVariablesFromXPath(const XMLDoc& doc, con
 
 FeltCDMReader2::FeltCDMReader2(string filename, string configFilename)
 : filename(filename)
+, mutex_("FeltCDMReader2")
 {
     try {
         XMLInputFile config(configFilename);
@@ -183,6 +184,7 @@ FeltCDMReader2::FeltCDMReader2(string filename, string configFilename)
 
 FeltCDMReader2::FeltCDMReader2(string filename, const XMLInput& configInput)
 : filename(filename)
+, mutex_("FeltCDMReader2")
 {
     try {
         init(configInput);
@@ -774,7 +776,7 @@ DataPtr FeltCDMReader2::getDataSlice(const string& varName, size_t unLimDimPos)
                 DataPtr levelData;
                 // level-data might be undefined, create a undefined slice then
                 try {
-                    OmpScopedLock lock(mutex_);
+                    ExclusiveLock lock(mutex_);
                     levelData = feltfile_->getScaledDataSlice(fa, t, *lit);
                 } catch (NoSuchField_Felt_File_Error nsfe) {
                     levelData = createData(variable.getDataType(), xDim * yDim, cdm_->getFillValue(varName));
@@ -34,6 +34,8 @@
 #include "fimex/TokenizeDotted.h"
 #include "fimex/XMLDoc.h"
 
+#include "TaskScheduler.h"
+
 #include <algorithm>
 #include <map>
 #include <set>
@@ -151,23 +153,18 @@ FillWriter::FillWriter(CDMReader_p in, CDMReaderWriter_p io, std::string configF
 
     // process variables
     CDM::VarVec iVars = iCdm.getVariables();
-    int varVecSize = iVars.size();
-#ifdef _OPENMP
-#pragma omp parallel for default(shared)
-#endif
-    for (int iVar = 0; iVar < varVecSize; iVar++) {
-    //for (CDM::VarVec::iterator iv = iVars.begin(); iv != iVars.end(); ++iv) {
+    parallelFor(iVars.size(), [&](size_t iVar) {
         CDMVariable* iv = &iVars.at(iVar);
         LOG4FIMEX(logger, Logger::DEBUG, "processing variable  '" << iv->getName()<< "'");
         if (!oCdm.hasVariable(iv->getName())) {
             LOG4FIMEX(logger, Logger::WARN, "new variable '" << iv->getName() << "': omitting");
-            continue;
+            return;
         }
         const vector<string>& iShape = iv->getShape();
         string badDim = findFirstUnusableDimension(unusableIDims, iShape);
         if (badDim != "") {
             LOG4FIMEX(logger, Logger::ERROR, "Cannot fill-write '" << iv->getName() << "' due to bad dimension: '" << badDim << "'");
-            continue;
+            return;
         }
         const CDMVariable& oVar = oCdm.getVariable(iv->getName());
         const vector<string>& oShape = oVar.getShape();
@@ -182,7 +179,7 @@ FillWriter::FillWriter(CDMReader_p in, CDMReaderWriter_p io, std::string configF
         // simple test of equal shapes (omitting translated dims
         if (!equal(iTestShape.begin(), iTestShape.end(), oTestShape.begin())) {
             LOG4FIMEX(logger, Logger::WARN, "variable '" << iv->getName() << "' has different shape: omitting");
-            continue;
+            return;
         }
 
         typedef vector<pair<SliceBuilder, SliceBuilder> > SlicePairs;
@@ -238,7 +235,7 @@ FillWriter::FillWriter(CDMReader_p in, CDMReaderWriter_p io, std::string configF
             DataPtr inData = in->getDataSlice(iv->getName(), sliceIt->first);
             io->putDataSlice(iv->getName(), sliceIt->second, inData);
         }
-    }
+    }, TASK_STAGE_WRITE);
     if (unusableIDims.size() > 0) throw CDMException("FillWriter finished with errors in dimension-mapping");
 }
 
@@ -73,12 +73,19 @@ struct ProjectionInfo {
 
 struct GribCDMReader::Impl
 {
+    Impl()
+        : mutex("GribCDMReader")
+    {
+    }
+
     string configId;
     vector<GribFileMessage> indices;
+    // files of indices, kept open while reading
+    GribFileCache files;
     XMLDoc_p doc;
     map<int, vector<xmlNodePtr> > nodeIdx1;
     map<int, vector<xmlNodePtr> > nodeIdx2;
-    OmpMutex mutex;
+    SharedMutex mutex;
     map<GridDefinition, ProjectionInfo> gridProjection;
     string timeDimName;
     string ensembleDimName;
@@ -1188,6 +1195,109 @@ DataPtr roundData(shared_array<T> array, size_t n, double scale, double initialM
     return createData(n, array);
 }
 
+// read a complete xy-layer, double is decoded in place
+size_t readLayer(const GribFileMessage& gfm, GribFileCache& files, double missingValue, vector<double>&, double* out, size_t n)
+{
+    return gfm.readData(out, n, missingValue, files);
+}
+
+template <typename T>
+size_t readLayer(const GribFileMessage& gfm, GribFileCache& files, double missingValue, vector<double>& gridData, T* out, size_t n)
+{
+    gridData.resize(n);
+    const size_t dataRead = gfm.readData(&gridData[0], n, missingValue, files);
+    copy(gridData.begin(), gridData.begin() + dataRead, out);
+    return dataRead;
+}
+
+/**
+ * Read all messages in slices to out, each message to a complete xy-slice of the requested size. The
+ * messages are read in file order, in parallel if the grib-library is thread-safe. Invalid messages
+ * and missing parts of messages are set to missingValue.
+ */
+template <typename T>
+void readSlices(const string& varName, const vector<GribFileMessage>& slices, GribFileCache& files, SharedMutex& mutex, double missingValue,
+                const vector<size_t>& maxSizes, const vector<size_t>& dimStart, const vector<size_t>& dimSizes, T* out)
+{
+    const size_t maxXySize = maxSizes.at(0) * maxSizes.at(1);
+    const size_t xySliceSize = dimSizes.at(0) * dimSizes.at(1);
+    const T missing = static_cast<T>(missingValue);
+
+    vector<size_t> readOrder;
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (slices[i].isValid()) {
+            readOrder.push_back(i);
+        } else {
+            LOG4FIMEX(logger, Logger::DEBUG, "skipping variable " << varName << ", 1 level at " << (i * xySliceSize));
+            fill(out + i * xySliceSize, out + (i + 1) * xySliceSize, missing);
+        }
+    }
+    sort(readOrder.begin(), readOrder.end(), [&slices](size_t a, size_t b) {
+        const GribFileMessage& ma = slices[a];
+        const GribFileMessage& mb = slices[b];
+        if (ma.getFileURL() != mb.getFileURL())
+            return ma.getFileURL() < mb.getFileURL();
+        if (ma.getFilePosition() != mb.getFilePosition())
+            return ma.getFilePosition() < mb.getFilePosition();
+        return ma.getMessageNumber() < mb.getMessageNumber();
+    });
+
+    std::string readError;
+#if defined(_OPENMP) && defined(HAVE_GRIB_API_THREADSAFE)
+#pragma omp parallel default(shared)
+#endif
+    {
+        // storage for one layer
+        vector<double> gridData;
+#if defined(_OPENMP) && defined(HAVE_GRIB_API_THREADSAFE)
+#pragma omp for schedule(dynamic)
+#endif
+        for (long r = 0; r < static_cast<long>(readOrder.size()); ++r) {
+            const GribFileMessage& gfm = slices[readOrder[r]];
+            T* outLayer = out + readOrder[r] * xySliceSize;
+            try {
+                size_t dataRead;
+                if (maxXySize == xySliceSize) {
+                    {
+#ifndef HAVE_GRIB_API_THREADSAFE
+                        ExclusiveLock lock(mutex);
+#endif
+                        dataRead = readLayer(gfm, files, missingValue, gridData, outLayer, xySliceSize);
+                    }
+                    fill(outLayer + dataRead, outLayer + xySliceSize, missing);
+                } else {
+                    gridData.resize(maxXySize);
+                    {
+#ifndef HAVE_GRIB_API_THREADSAFE
+                        ExclusiveLock lock(mutex);
+#endif
+                        dataRead = gfm.readData(&gridData[0], maxXySize, missingValue, files);
+                    }
+                    fill(gridData.begin() + dataRead, gridData.end(), missingValue);
+                    // strided copy of the xy-subset
+                    for (size_t y = 0; y < dimSizes.at(1); ++y) {
+                        const double* row = &gridData[(dimStart.at(1) + y) * maxSizes.at(0) + dimStart.at(0)];
+                        copy(row, row + dimSizes.at(0), outLayer + y * dimSizes.at(0));
+                    }
+                }
+                LOG4FIMEX(logger, Logger::DEBUG,
+                          "reading variable " << gfm.getShortName() << ", level " << gfm.getLevelNumber() << " size " << dataRead << " starting at "
+                                              << (readOrder[r] * xySliceSize));
+            } catch (std::exception& ex) {
+                // exceptions must not leave an openmp region
+#if defined(_OPENMP) && defined(HAVE_GRIB_API_THREADSAFE)
+#pragma omp critical(GribCDMReaderReadError)
+#endif
+                {
+                    if (readError.empty())
+                        readError = ex.what();
+                }
+            }
+        }
+    }
+    if (!readError.empty())
+        throw CDMException("error reading grib-data for variable '" + varName + "': " + readError);
+}
 
 vector<size_t> createVector(size_t id, const vector<size_t>& dimStart, const vector<size_t>& dimSizes)
 {
@@ -1213,7 +1323,54 @@ DataPtr GribCDMReader::getDataSlice(const string& varName, const SliceBuilder& s
     if (variable.hasData()) {
         return variable.getData()->slice(sb.getMaxDimensionSizes(), sb.getDimensionStartPositions(), sb.getDimensionSizes());
     }
+    return readSliceMessages(varName, sb, findSliceMessages(varName, sb));
+}
+
+std::vector<DataPtr> GribCDMReader::getDataSlices(const DataSliceRequest_v& requests)
+{
+    std::vector<DataPtr> results(requests.size());
+    std::vector<vector<GribFileMessage>> messages(requests.size());
+    vector<size_t> readOrder;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const DataSliceRequest& r = requests[i];
+        const CDMVariable& variable = cdm_->getVariable(r.varName);
+        if (variable.getDataType() == CDM_NAT || variable.hasData()) {
+            results[i] = getDataSlice(r.varName, r.sb);
+        } else {
+            messages[i] = findSliceMessages(r.varName, r.sb);
+            readOrder.push_back(i);
+        }
+    }
 
+    // read the requests in the order of their first message in the files, requests
+    // without messages first
+    std::vector<const GribFileMessage*> firstMessage(requests.size(), 0);
+    for (size_t i : readOrder) {
+        for (const GribFileMessage& gfm : messages[i]) {
+            if (gfm.isValid()) {
+                firstMessage[i] = &gfm;
+                break;
+            }
+        }
+    }
+    std::stable_sort(readOrder.begin(), readOrder.end(), [&firstMessage](size_t a, size_t b) {
+        const GribFileMessage* ma = firstMessage[a];
+        const GribFileMessage* mb = firstMessage[b];
+        if (!ma || !mb)
+            return ma == 0 && mb != 0;
+        if (ma->getFileURL() != mb->getFileURL())
+            return ma->getFileURL() < mb->getFileURL();
+        return ma->getFilePosition() < mb->getFilePosition();
+    });
+    for (size_t i : readOrder) {
+        results[i] = readSliceMessages(requests[i].varName, requests[i].sb, messages[i]);
+        messages[i].clear();
+    }
+    return results;
+}
+
+vector<GribFileMessage> GribCDMReader::findSliceMessages(const string& varName, const SliceBuilder& sb) const
+{
     //map<string, map<size_t, map<long, map<size_t, size_t> > > > varTimeLevelEnsembleGFIBox;
     map<string, map<size_t, map<long, map<size_t, size_t> > > >::const_iterator gmIt = p_->varTimeLevelEnsembleGFIBox.find(varName);
     if (gmIt == p_->varTimeLevelEnsembleGFIBox.end()) {
@@ -1226,7 +1383,6 @@ DataPtr GribCDMReader::getDataSlice(const string& varName, const SliceBuilder& s
     assert(dimNames.at(0) != p_->timeDimName);
     const vector<size_t>& dimSizes = sb.getDimensionSizes();
     const vector<size_t>& dimStart = sb.getDimensionStartPositions();
-    const vector<size_t>& maxSizes = sb.getMaxDimensionSizes();
 
     // x/y = dimNames/Size 0,1
     const size_t xySliceSize = dimSizes.at(0) * dimSizes.at(1);
@@ -1289,59 +1445,38 @@ DataPtr GribCDMReader::getDataSlice(const string& varName, const SliceBuilder& s
         }
     }
 
+    return slices;
+}
+
+DataPtr GribCDMReader::readSliceMessages(const string& varName, const SliceBuilder& sb, const vector<GribFileMessage>& slices)
+{
+    const CDMVariable& variable = cdm_->getVariable(varName);
     // read data from file
     if (slices.size() == 0) return createData(variable.getDataType(), 0);
 
-    size_t maxXySize = maxSizes.at(0) * maxSizes.at(1);
-
-    // storage for complete data
-    shared_array<double> doubleArray(new double[sliceSize]);
-    // prefill with missing values
+    const vector<size_t>& dimSizes = sb.getDimensionSizes();
+    const vector<size_t>& dimStart = sb.getDimensionStartPositions();
+    const vector<size_t>& maxSizes = sb.getMaxDimensionSizes();
+    size_t sliceSize = 1;
+    for (size_t i = 0; i < dimSizes.size(); ++i)
+        sliceSize *= dimSizes.at(i);
 
     double missingValue = cdm_->getFillValue(varName);
     if (p_->varPrecision.find(varName) != p_->varPrecision.end()) {
         // varPrecision used, use default missing
         missingValue = MIFI_FILL_DOUBLE;
     }
-    fill(&doubleArray[0], &doubleArray[sliceSize], missingValue);
-    DataPtr data = createData(sliceSize, doubleArray);
-    // storage for one layer
-    vector<double> gridData;
-    size_t dataCurrentPos = 0;
-    for (vector<GribFileMessage>::iterator gfmIt = slices.begin(); gfmIt != slices.end(); ++gfmIt) {
-        // join the data of the different levels
-        if (gfmIt->isValid()) {
-            DataPtr data;
-            size_t dataRead;
-            gridData.resize(maxXySize); // make sure the gridData is always large enough
-            {
-#ifndef HAVE_GRIB_API_THREADSAFE
-                OmpScopedLock lock(p_->mutex);
-#endif
-                dataRead = gfmIt->readData(gridData, missingValue);
-            }
-            LOG4FIMEX(logger, Logger::DEBUG, "reading variable " << gfmIt->getShortName() << ", level "<< gfmIt->getLevelNumber() << " size " << dataRead << " starting at " << dataCurrentPos);
-            if (maxXySize != xySliceSize) {
-                // slicing on xy-data
-                DataPtr tempData = createData(CDM_DOUBLE, gridData.begin(), gridData.end());
-                vector<size_t> orgSizes, newStart, newSizes;
-                orgSizes.push_back(maxSizes.at(0));
-                orgSizes.push_back(maxSizes.at(1));
-                newStart.push_back(dimStart.at(0));
-                newStart.push_back(dimStart.at(1));
-                newSizes.push_back(dimSizes.at(0));
-                newSizes.push_back(dimSizes.at(1));
-                tempData = tempData->slice(orgSizes, newStart, newSizes);
-                shared_array<double> da = tempData->asDouble();
-                copy(da.get(), da.get()+tempData->size(), &doubleArray[dataCurrentPos]);
-            } else {
-                // copy complete vector
-                copy(gridData.begin(), gridData.end(), &doubleArray[dataCurrentPos]);
-            }
-        } else {
-            LOG4FIMEX(logger, Logger::DEBUG, "skipping variable " << varName << ", 1 level, " << " size " << gridData.size());
-        }
-        dataCurrentPos += xySliceSize; // always forward a complete slice
+
+    // storage for complete data, float variables are read without double intermediate
+    DataPtr data;
+    if (variable.getDataType() == CDM_FLOAT) {
+        shared_array<float> floatArray(new float[sliceSize]);
+        readSlices(varName, slices, p_->files, p_->mutex, missingValue, maxSizes, dimStart, dimSizes, floatArray.get());
+        data = createData(sliceSize, floatArray);
+    } else {
+        shared_array<double> doubleArray(new double[sliceSize]);
+        readSlices(varName, slices, p_->files, p_->mutex, missingValue, maxSizes, dimStart, dimSizes, doubleArray.get());
+        data = createData(sliceSize, doubleArray);
     }
     std::map<string, std::pair<double, double>>::const_iterator it = p_->varPrecision.find(varName);
     if (it != p_->varPrecision.end()) {
@@ -37,6 +37,8 @@
 #include "fimex/Type2String.h"
 #include "fimex/XMLUtils.h"
 
+#include "MutexLock.h"
+
 #include <date/date.h>
 
 #include <algorithm>
@@ -49,6 +51,11 @@
 #include <libxml/xmlwriter.h>
 #include <libxml/xpath.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "grib_api.h"
 
 #ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
@@ -1122,22 +1129,125 @@ string GribFileMessage::toString() const
     return string(reinterpret_cast<const char*> (buffer->content));
 }
 
-size_t GribFileMessage::readData(std::vector<double>& data, double missingValue) const
+struct GribFileCache::Impl
+{
+    Impl()
+        : mutex("GribFileCache")
+        , mapMutex("GribFileCache map", 8)
+    {
+    }
+    struct MappedFile
+    {
+        const char* data;
+        size_t size;
+    };
+    SharedMutex mutex;     // protects files and retired
+    ShardedMutex mapMutex; // serializes mapping of the same file
+    std::map<std::string, MappedFile> files;
+    std::vector<MappedFile> retired; // outdated mappings, possibly still in use by other threads
+
+    bool find(const std::string& fileName, MappedFile& mf)
+    {
+        SharedLock lock(mutex);
+        std::map<std::string, MappedFile>::const_iterator it = files.find(fileName);
+        if (it == files.end())
+            return false;
+        mf = it->second;
+        return true;
+    }
+};
+
+GribFileCache::GribFileCache()
+    : p_(new Impl())
+{
+}
+
+GribFileCache::~GribFileCache()
+{
+    for (const auto& f : p_->files)
+        munmap(const_cast<char*>(f.second.data), f.second.size);
+    for (const auto& mf : p_->retired)
+        munmap(const_cast<char*>(mf.data), mf.size);
+}
+
+const char* GribFileCache::map(const std::string& fileName, size_t minSize, size_t& size)
+{
+    // files are mapped once and read by many threads, so look up under a shared lock,
+    // and map new files without blocking lookups of other files
+    Impl::MappedFile mf = {0, 0};
+    if (!p_->find(fileName, mf) || mf.size < minSize) {
+        ExclusiveLock mapLock(p_->mapMutex.get(fileName));
+        const bool found = p_->find(fileName, mf);
+        if (!found || mf.size < minSize) {
+            // new file, or a read beyond the mapping: map the file with its current size
+            Impl::MappedFile current = {0, 0};
+            const int fd = open(fileName.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                struct stat st;
+                if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && static_cast<size_t>(st.st_size) != mf.size) {
+                    void* m = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                    if (m != MAP_FAILED) {
+                        current.data = static_cast<const char*>(m);
+                        current.size = st.st_size;
+                    }
+                }
+                close(fd);
+            }
+            if (current.data == 0) {
+                // unchanged or not mappable, failures are not cached
+                size = mf.size;
+                return mf.data;
+            }
+            LOG4FIMEX(loggerGFM, Logger::DEBUG, "mapping file: " << fileName << " size: " << current.size);
+            ExclusiveLock lock(p_->mutex);
+            if (found) {
+                // other threads may still read the old mapping, keep it until the cache is destroyed
+                p_->retired.push_back(mf);
+            }
+            p_->files[fileName] = current;
+            mf = current;
+        }
+    }
+    size = mf.size;
+    return mf.data;
+}
+
+std::shared_ptr<grib_handle> GribFileMessage::openHandle(GribFileCache* cache) const
 {
-    if (!isValid()) return 0;
     string url = getFileURL();
     // remove the 'file:' prefix, needs to be improved when streams are allowed
     url = url.substr(5);
-    FILE* fileh = fopen(url.c_str(), "rb");
-    if (fileh == 0) {
-        throw runtime_error("cannot open file: " + getFileURL());
-    }
-    std::shared_ptr<FILE> fh(fileh, fclose);
-    fseeko(fh.get(), getFilePosition(), SEEK_SET);
 
     // enable multi-messages
     grib_multi_support_on(0);
 
+    std::shared_ptr<FILE> fh;
+    if (cache) {
+        size_t fileSize = 0;
+        const char* fileData = (getFilePosition() >= 0) ? cache->map(url, getFilePosition() + 1, fileSize) : 0;
+        if (fileData && getFilePosition() >= 0 && static_cast<size_t>(getFilePosition()) < fileSize) {
+            const char* msgData = fileData + getFilePosition();
+            const size_t msgSize = fileSize - getFilePosition();
+            if (getMessageNumber() == 0) {
+                // decode directly from the mapped file, no copy
+                std::shared_ptr<grib_handle> gh(grib_handle_new_from_message(0, msgData, msgSize), grib_handle_delete);
+                if (gh.get() == 0)
+                    throw CDMException("cannot find grib-handle at file: " + url + " pos: " + type2string(getFilePosition()));
+                return gh;
+            }
+            // multi-message, read it like from a file
+            fh = std::shared_ptr<FILE>(fmemopen(const_cast<char*>(msgData), msgSize, "rb"), fclose);
+        }
+    }
+    if (!fh) {
+        FILE* fileh = fopen(url.c_str(), "rb");
+        if (fileh == 0) {
+            throw runtime_error("cannot open file: " + getFileURL());
+        }
+        fh = std::shared_ptr<FILE>(fileh, fclose);
+        fseeko(fh.get(), getFilePosition(), SEEK_SET);
+    }
+
     int err = 0;
     for (size_t i = 0; i < getMessageNumber(); i++) {
         // forward to correct multimessage
@@ -1145,18 +1255,41 @@ size_t GribFileMessage::readData(std::vector<double>& data, double missingValue)
     }
     // read the message of interest
     std::shared_ptr<grib_handle> gh(grib_handle_new_from_file(0, fh.get(), &err), grib_handle_delete);
+    if (gh.get() == 0)
+        throw CDMException("cannot find grib-handle at file: " + url + " pos: " + type2string(getFilePosition()) + " msg: " + type2string(getMessageNumber()));
+    if (err != GRIB_SUCCESS)
+        GRIB_CHECK(err, 0);
+    return gh;
+}
+
+size_t GribFileMessage::readData(std::vector<double>& data, double missingValue) const
+{
+    return readData(&data[0], data.size(), missingValue, 0);
+}
+
+size_t GribFileMessage::readData(std::vector<double>& data, double missingValue, GribFileCache& cache) const
+{
+    return readData(&data[0], data.size(), missingValue, &cache);
+}
+
+size_t GribFileMessage::readData(double* data, size_t size, double missingValue, GribFileCache& cache) const
+{
+    return readData(data, size, missingValue, &cache);
+}
+
+size_t GribFileMessage::readData(double* data, size_t maxSize, double missingValue, GribFileCache* cache) const
+{
+    if (!isValid()) return 0;
+    std::shared_ptr<grib_handle> gh = openHandle(cache);
     size_t size = 0;
-    if (gh.get() != 0) {
-        if (err != GRIB_SUCCESS) GRIB_CHECK(err,0);
+    {
         double oldMissing;
         MIFI_GRIB_CHECK(grib_get_double(gh.get(), "missingValue", &oldMissing), 0);
         MIFI_GRIB_CHECK(grib_set_double(gh.get(), "missingValue", missingValue), 0);
         MIFI_GRIB_CHECK(grib_get_size(gh.get(), "values", &size), 0);
-        if (size > data.size()) size = data.size();
-        MIFI_GRIB_CHECK(grib_get_double_array(gh.get(), "values", &data[0], &size), 0);
+        if (size > maxSize) size = maxSize;
+        MIFI_GRIB_CHECK(grib_get_double_array(gh.get(), "values", data, &size), 0);
         MIFI_GRIB_CHECK(grib_set_double(gh.get(), "missingValue", oldMissing), 0);
-    } else {
-        throw CDMException("cannot find grib-handle at file: " + url + " pos: " + type2string(getFilePosition()) + " msg: " + type2string(getMessageNumber()));
     }
     return size;
 }
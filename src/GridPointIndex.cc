@@ -0,0 +1,329 @@
+/*
+ * Fimex, GridPointIndex.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "GridPointIndex.h"
+
+#include "TaskScheduler.h"
+
+#include "nanoflann/nanoflann.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace MetNoFimex {
+
+namespace {
+
+// kd-trees are built in parallel for tiles of at most BLOCK_SIZE x BLOCK_SIZE grid points
+const size_t BLOCK_SIZE = 512;
+// queries per task of the batched search
+const size_t QUERY_BATCH = 1024;
+// coordinate of undefined points, far away from all points on the unit sphere
+const double UNDEFINED_COORD = 1e10;
+
+// internal setup for nanoflann kd-tree
+struct PointCloud
+{
+    struct Point
+    {
+        double x, y, z;
+    };
+
+    std::vector<Point> pts;
+
+    // Must return the number of data points
+    inline size_t kdtree_get_point_count() const { return pts.size(); }
+
+    // Returns the distance between the vector "p1[0:size-1]" and the data point with index "idx_p2" stored in the class:
+    inline double kdtree_distance(const double* p1, const size_t idx_p2, size_t) const
+    {
+        const double d0 = p1[0] - pts[idx_p2].x;
+        const double d1 = p1[1] - pts[idx_p2].y;
+        const double d2 = p1[2] - pts[idx_p2].z;
+        return d0 * d0 + d1 * d1 + d2 * d2;
+    }
+
+    // Returns the dim'th component of the idx'th point in the class
+    inline double kdtree_get_pt(const size_t idx, int dim) const
+    {
+        if (dim == 0)
+            return pts[idx].x;
+        else if (dim == 1)
+            return pts[idx].y;
+        else
+            return pts[idx].z;
+    }
+
+    // use the standard bounding-box computation
+    template <class BBOX>
+    bool kdtree_get_bbox(BBOX&) const
+    {
+        return false;
+    }
+};
+
+typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<double, PointCloud>, PointCloud, 3 /* dim */> KDTree;
+
+/**
+ * nanoflann result set keeping the closest point below a distance bound,
+ * or at the bound if inclusive
+ */
+class ClosestResultSet
+{
+public:
+    ClosestResultSet(double bound, bool inclusive)
+        : dist_(bound)
+        , index_(GridPointIndex::npos)
+        , inclusive_(inclusive)
+    {
+    }
+    size_t size() const { return (index_ == GridPointIndex::npos) ? 0 : 1; }
+    bool full() const { return true; }
+    void addPoint(double dist, size_t index)
+    {
+        if (dist < dist_ || (inclusive_ && index_ == GridPointIndex::npos && dist == dist_)) {
+            dist_ = dist;
+            index_ = index;
+        }
+    }
+    double worstDist() const
+    {
+        // nanoflann only adds points closer than worstDist
+        return (inclusive_ && index_ == GridPointIndex::npos) ? std::nextafter(dist_, std::numeric_limits<double>::max()) : dist_;
+    }
+    size_t index() const { return index_; }
+
+private:
+    double dist_;
+    size_t index_;
+    bool inclusive_;
+};
+
+/**
+ * kd-tree of the points of a tile of the grid, with bounding box of the valid points
+ *
+ * The cloud contains all points of the tile, x fastest, so that grid positions
+ * follow from the tile layout. Undefined points are at UNDEFINED_COORD and are
+ * never the closest point of a tile with valid points.
+ */
+struct Block
+{
+    size_t x0, y0, width;
+    PointCloud cloud;
+    std::unique_ptr<KDTree> index; // only if the tile has valid points
+    double lower[3], upper[3];
+
+    //! grid position of point i of the cloud
+    size_t gridPos(size_t i, size_t nx) const { return (y0 + i / width) * nx + x0 + i % width; }
+
+    //! squared distance of q to the bounding box
+    double boxDistance(const double q[3]) const
+    {
+        double d = 0;
+        for (int i = 0; i < 3; ++i) {
+            const double di = std::max(std::max(lower[i] - q[i], q[i] - upper[i]), 0.);
+            d += di * di;
+        }
+        return d;
+    }
+};
+
+typedef std::vector<std::pair<double, size_t>> BlockOrder;
+
+} // namespace
+
+struct GridPointIndex::Impl
+{
+    size_t nx, ny;
+    size_t blocksX;            // tiles in x direction
+    std::vector<Block> blocks; // trees refer to the clouds, must not be moved after building
+
+    void buildBlock(Block& block, const double* lonVals, const double* latVals, size_t x0, size_t x1, size_t y0, size_t y1) const;
+    size_t findClosest(const double q[3], double maxDist, BlockOrder& order) const;
+    const PointCloud::Point& point(size_t ix, size_t iy) const;
+};
+
+void GridPointIndex::Impl::buildBlock(Block& block, const double* lonVals, const double* latVals, size_t x0, size_t x1, size_t y0, size_t y1) const
+{
+    block.x0 = x0;
+    block.y0 = y0;
+    block.width = x1 - x0;
+    std::fill(block.lower, block.lower + 3, std::numeric_limits<double>::max());
+    std::fill(block.upper, block.upper + 3, -std::numeric_limits<double>::max());
+    block.cloud.pts.reserve((x1 - x0) * (y1 - y0));
+    bool hasValid = false;
+    for (size_t y = y0; y < y1; ++y) {
+        for (size_t pos = y * nx + x0; pos < y * nx + x1; ++pos) {
+            double xyz[3];
+            if (std::isnan(lonVals[pos]) || std::isnan(latVals[pos])) {
+                std::fill(xyz, xyz + 3, UNDEFINED_COORD);
+            } else {
+                lonLat2Sphere(lonVals[pos], latVals[pos], xyz);
+                hasValid = true;
+                for (int i = 0; i < 3; ++i) {
+                    block.lower[i] = std::min(block.lower[i], xyz[i]);
+                    block.upper[i] = std::max(block.upper[i], xyz[i]);
+                }
+            }
+            block.cloud.pts.push_back(PointCloud::Point{xyz[0], xyz[1], xyz[2]});
+        }
+    }
+    if (hasValid) {
+        block.index.reset(new KDTree(3 /*dim*/, block.cloud, nanoflann::KDTreeSingleIndexAdaptorParams(12 /* max leaf */)));
+        block.index->buildIndex();
+    }
+}
+
+/**
+ * Search the blocks in order of their distance to q, each bounded by the
+ * closest point found so far, until the remaining blocks cannot contain a
+ * closer point. The result does not depend on the number of threads.
+ */
+size_t GridPointIndex::Impl::findClosest(const double q[3], double maxDist, BlockOrder& order) const
+{
+    double bestDist = (maxDist > 0) ? maxDist * maxDist : std::numeric_limits<double>::max();
+    size_t bestPos = npos;
+
+    order.clear();
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (!blocks[b].index)
+            continue; // no valid points
+        const double d = blocks[b].boxDistance(q);
+        if (d <= bestDist)
+            order.push_back(std::make_pair(d, b));
+    }
+    std::sort(order.begin(), order.end());
+    for (const std::pair<double, size_t>& o : order) {
+        if (o.first > bestDist)
+            break;
+        const Block& block = blocks[o.second];
+        // points exactly at maxDist are found, ties between blocks keep the first point
+        ClosestResultSet result(bestDist, bestPos == npos);
+        block.index->findNeighbors(result, q, nanoflann::SearchParams());
+        if (result.size()) {
+            bestDist = result.worstDist();
+            bestPos = block.gridPos(result.index(), nx);
+        }
+    }
+    return bestPos;
+}
+
+const PointCloud::Point& GridPointIndex::Impl::point(size_t ix, size_t iy) const
+{
+    const Block& block = blocks[(iy / BLOCK_SIZE) * blocksX + ix / BLOCK_SIZE];
+    return block.cloud.pts[(iy - block.y0) * block.width + (ix - block.x0)];
+}
+
+const size_t GridPointIndex::npos;
+
+GridPointIndex::GridPointIndex(const double* lonVals, const double* latVals, size_t nx, size_t ny)
+    : p_(new Impl())
+{
+    p_->nx = nx;
+    p_->ny = ny;
+
+    // square tiles are spatially compact, so queries usually search few trees
+    const size_t blocksX = (nx + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const size_t blocksY = (ny + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    p_->blocksX = blocksX;
+    p_->blocks.resize(blocksX * blocksY);
+    parallelFor(p_->blocks.size(), [&](size_t b) {
+        const size_t x0 = (b % blocksX) * BLOCK_SIZE, y0 = (b / blocksX) * BLOCK_SIZE;
+        p_->buildBlock(p_->blocks[b], lonVals, latVals, x0, std::min(nx, x0 + BLOCK_SIZE), y0, std::min(ny, y0 + BLOCK_SIZE));
+    });
+}
+
+GridPointIndex::~GridPointIndex() {}
+
+size_t GridPointIndex::nx() const
+{
+    return p_->nx;
+}
+
+size_t GridPointIndex::ny() const
+{
+    return p_->ny;
+}
+
+void GridPointIndex::lonLat2Sphere(double lon, double lat, double xyz[3])
+{
+    const double cosLat = std::cos(lat);
+    xyz[0] = cosLat * std::cos(lon);
+    xyz[1] = cosLat * std::sin(lon);
+    xyz[2] = std::sin(lat);
+}
+
+bool GridPointIndex::findClosest(double lon, double lat, double maxDist, size_t& ix, size_t& iy) const
+{
+    if (std::isnan(lon) || std::isnan(lat))
+        return false;
+    double query[3];
+    lonLat2Sphere(lon, lat, query);
+    BlockOrder order;
+    const size_t pos = p_->findClosest(query, maxDist, order);
+    if (pos == npos)
+        return false;
+    ix = pos % p_->nx;
+    iy = pos / p_->nx;
+    return true;
+}
+
+void GridPointIndex::findClosest(const double* lonVals, const double* latVals, size_t n, double maxDist, size_t* positions) const
+{
+    parallelForRange(
+        n, QUERY_BATCH,
+        [&](size_t begin, size_t end) {
+            BlockOrder order; // reused within the batch
+            for (size_t i = begin; i < end; ++i) {
+                if (std::isnan(lonVals[i]) || std::isnan(latVals[i])) {
+                    positions[i] = npos;
+                } else {
+                    double query[3];
+                    lonLat2Sphere(lonVals[i], latVals[i], query);
+                    positions[i] = p_->findClosest(query, maxDist, order);
+                }
+            }
+        },
+        TASK_STAGE_INTERPOLATE);
+}
+
+bool GridPointIndex::isValid(size_t ix, size_t iy) const
+{
+    return p_->point(ix, iy).x != UNDEFINED_COORD;
+}
+
+void GridPointIndex::point(size_t ix, size_t iy, double xyz[3]) const
+{
+    if (!isValid(ix, iy)) {
+        std::fill(xyz, xyz + 3, std::nan(""));
+        return;
+    }
+    const PointCloud::Point& pt = p_->point(ix, iy);
+    xyz[0] = pt.x;
+    xyz[1] = pt.y;
+    xyz[2] = pt.z;
+}
+
+} // namespace MetNoFimex
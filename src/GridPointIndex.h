@@ -0,0 +1,105 @@
+/*
+ * Fimex, GridPointIndex.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef FIMEX_GRIDPOINTINDEX_H_
+#define FIMEX_GRIDPOINTINDEX_H_
+
+#include <cstddef>
+#include <memory>
+
+namespace MetNoFimex {
+
+/**
+ * Spatial index (kd-tree) of the points of a 2d longitude/latitude grid,
+ * e.g. of a curvilinear model grid. Points are compared by their distance
+ * on the unit sphere, thus without special cases at the date line or the poles.
+ *
+ * Large grids are indexed by one kd-tree per tile of 512x512 grid points,
+ * built in parallel. Queries are thread-safe.
+ */
+class GridPointIndex
+{
+public:
+    //! position returned if no point was found
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * @param lonVals longitudes in radian, size nx*ny, x varying fastest
+     * @param latVals latitudes in radian, size nx*ny; points with nan lon or lat are never found
+     */
+    GridPointIndex(const double* lonVals, const double* latVals, size_t nx, size_t ny);
+    ~GridPointIndex();
+
+    GridPointIndex(const GridPointIndex&) = delete;
+    GridPointIndex& operator=(const GridPointIndex&) = delete;
+
+    size_t nx() const;
+    size_t ny() const;
+
+    /**
+     * Find the grid point closest to lon/lat.
+     *
+     * @param lon longitude in radian
+     * @param lat latitude in radian
+     * @param maxDist maximum distance on the unit sphere, points at maxDist are found, <= 0 for unlimited
+     * @param ix output, x-index of the closest point
+     * @param iy output, y-index of the closest point
+     * @return false if no point was found
+     */
+    bool findClosest(double lon, double lat, double maxDist, size_t& ix, size_t& iy) const;
+
+    /**
+     * Find the grid points closest to n positions, searching batches of
+     * positions in parallel.
+     *
+     * @param lonVals longitudes in radian, size n
+     * @param latVals latitudes in radian, size n
+     * @param n number of positions
+     * @param maxDist maximum distance on the unit sphere, points at maxDist are found, <= 0 for unlimited
+     * @param positions output, size n, grid position ix + iy*nx of the closest point, or npos if no point was found
+     */
+    void findClosest(const double* lonVals, const double* latVals, size_t n, double maxDist, size_t* positions) const;
+
+    /**
+     * @return false if the grid point has undefined coordinates
+     */
+    bool isValid(size_t ix, size_t iy) const;
+
+    /**
+     * Position of grid point ix,iy on the unit sphere.
+     */
+    void point(size_t ix, size_t iy, double xyz[3]) const;
+
+    /**
+     * Position of lon/lat (radian) on the unit sphere.
+     */
+    static void lonLat2Sphere(double lon, double lat, double xyz[3]);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> p_;
+};
+
+} // namespace MetNoFimex
+
+#endif /* FIMEX_GRIDPOINTINDEX_H_ */
@@ -0,0 +1,170 @@
+/*
+ * Fimex, InterpolationKernels.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+
+#include "InterpolationKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FIMEX_HAVE_AVX2_KERNELS 1
+#include <immintrin.h>
+#define FIMEX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace MetNoFimex {
+
+namespace {
+
+// scalar versions, the vectorized versions below use the same operations in the same order
+
+inline float bilinearValue(const float* in, size_t inX, uint32_t offset, uint8_t steps, float wx, float wy)
+{
+    const size_t dx = (steps & BILINEAR_STEP_X) ? 1 : 0;
+    const size_t dy = (steps & BILINEAR_STEP_Y) ? inX : 0;
+    const float* s = in + offset;
+    const float wx1 = 1.f - wx;
+    return (1.f - wy) * (wx1 * s[0] + wx * s[dx]) + wy * (wx1 * s[dy] + wx * s[dy + dx]);
+}
+
+void bilinearScalar(const float* in, size_t inX, const uint32_t* offsets, const uint8_t* steps, const float* wx, const float* wy, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = bilinearValue(in, inX, offsets[i], steps[i], wx[i], wy[i]);
+}
+
+void bicubicScalar(const float* in, size_t inX, const uint32_t* offsets, const float* const xm[4], const float* const my[4], float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const float* row = in + offsets[i];
+        float value = 0;
+        for (int j = 0; j < 4; ++j) {
+            const float xs = xm[0][i] * row[0] + xm[1][i] * row[1] + xm[2][i] * row[2] + xm[3][i] * row[3];
+            value = value + xs * my[j][i];
+            row += inX;
+        }
+        out[i] = value;
+    }
+}
+
+#ifdef FIMEX_HAVE_AVX2_KERNELS
+
+bool cpuHasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+// no fma in the avx2 versions, to get the same results as the scalar versions
+
+FIMEX_TARGET_AVX2 void bilinearAvx2(const float* in, size_t inX, const uint32_t* offsets, const uint8_t* steps, const float* wx, const float* wy, float* out,
+                                    size_t n)
+{
+    const __m256i vOne = _mm256_set1_epi32(1);
+    const __m256i vInX = _mm256_set1_epi32(static_cast<int>(inX));
+    const __m256 fOne = _mm256_set1_ps(1.f);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i o00 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + i));
+        const __m256i s = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(steps + i)));
+        const __m256i dx = _mm256_and_si256(s, vOne);
+        const __m256i dy = _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(s, 1), vOne), vInX);
+        const __m256i o01 = _mm256_add_epi32(o00, dx);
+        const __m256i o10 = _mm256_add_epi32(o00, dy);
+        const __m256i o11 = _mm256_add_epi32(o10, dx);
+
+        const __m256 s00 = _mm256_i32gather_ps(in, o00, 4);
+        const __m256 s01 = _mm256_i32gather_ps(in, o01, 4);
+        const __m256 s10 = _mm256_i32gather_ps(in, o10, 4);
+        const __m256 s11 = _mm256_i32gather_ps(in, o11, 4);
+
+        const __m256 vwx = _mm256_loadu_ps(wx + i);
+        const __m256 vwy = _mm256_loadu_ps(wy + i);
+        const __m256 vwx1 = _mm256_sub_ps(fOne, vwx);
+        const __m256 lower = _mm256_add_ps(_mm256_mul_ps(vwx1, s00), _mm256_mul_ps(vwx, s01));
+        const __m256 upper = _mm256_add_ps(_mm256_mul_ps(vwx1, s10), _mm256_mul_ps(vwx, s11));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(fOne, vwy), lower), _mm256_mul_ps(vwy, upper)));
+    }
+    bilinearScalar(in, inX, offsets + i, steps + i, wx + i, wy + i, out + i, n - i);
+}
+
+FIMEX_TARGET_AVX2 void bicubicAvx2(const float* in, size_t inX, const uint32_t* offsets, const float* const xm[4], const float* const my[4], float* out,
+                                   size_t n)
+{
+    const __m256i vInX = _mm256_set1_epi32(static_cast<int>(inX));
+    const __m256i v1 = _mm256_set1_epi32(1);
+    const __m256i v2 = _mm256_set1_epi32(2);
+    const __m256i v3 = _mm256_set1_epi32(3);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + i));
+        const __m256 xm0 = _mm256_loadu_ps(xm[0] + i);
+        const __m256 xm1 = _mm256_loadu_ps(xm[1] + i);
+        const __m256 xm2 = _mm256_loadu_ps(xm[2] + i);
+        const __m256 xm3 = _mm256_loadu_ps(xm[3] + i);
+        __m256 value = _mm256_setzero_ps();
+        for (int j = 0; j < 4; ++j) {
+            const __m256 r0 = _mm256_i32gather_ps(in, row, 4);
+            const __m256 r1 = _mm256_i32gather_ps(in, _mm256_add_epi32(row, v1), 4);
+            const __m256 r2 = _mm256_i32gather_ps(in, _mm256_add_epi32(row, v2), 4);
+            const __m256 r3 = _mm256_i32gather_ps(in, _mm256_add_epi32(row, v3), 4);
+            __m256 xs = _mm256_add_ps(_mm256_mul_ps(xm0, r0), _mm256_mul_ps(xm1, r1));
+            xs = _mm256_add_ps(xs, _mm256_mul_ps(xm2, r2));
+            xs = _mm256_add_ps(xs, _mm256_mul_ps(xm3, r3));
+            value = _mm256_add_ps(value, _mm256_mul_ps(xs, _mm256_loadu_ps(my[j] + i)));
+            row = _mm256_add_epi32(row, vInX);
+        }
+        _mm256_storeu_ps(out + i, value);
+    }
+    const float* const xmTail[4] = {xm[0] + i, xm[1] + i, xm[2] + i, xm[3] + i};
+    const float* const myTail[4] = {my[0] + i, my[1] + i, my[2] + i, my[3] + i};
+    bicubicScalar(in, inX, offsets + i, xmTail, myTail, out + i, n - i);
+}
+
+#endif // FIMEX_HAVE_AVX2_KERNELS
+
+} // namespace
+
+void bilinearKernel(const float* in, size_t inX, const uint32_t* offsets, const uint8_t* steps, const float* wx, const float* wy, float* out, size_t n)
+{
+#ifdef FIMEX_HAVE_AVX2_KERNELS
+    if (cpuHasAvx2()) {
+        bilinearAvx2(in, inX, offsets, steps, wx, wy, out, n);
+        return;
+    }
+#endif
+    bilinearScalar(in, inX, offsets, steps, wx, wy, out, n);
+}
+
+void bicubicKernel(const float* in, size_t inX, const uint32_t* offsets, const float* const xm[4], const float* const my[4], float* out, size_t n)
+{
+#ifdef FIMEX_HAVE_AVX2_KERNELS
+    if (cpuHasAvx2()) {
+        bicubicAvx2(in, inX, offsets, xm, my, out, n);
+        return;
+    }
+#endif
+    bicubicScalar(in, inX, offsets, xm, my, out, n);
+}
+
+} // namespace MetNoFimex
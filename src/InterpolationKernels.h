@@ -0,0 +1,73 @@
+/*
+ * Fimex, InterpolationKernels.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef INTERPOLATIONKERNELS_H_
+#define INTERPOLATIONKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MetNoFimex {
+
+//! bit in the bilinear steps, set if the right neighbour (offset+1) is used
+const uint8_t BILINEAR_STEP_X = 1;
+//! bit in the bilinear steps, set if the upper neighbour (offset+inX) is used
+const uint8_t BILINEAR_STEP_Y = 2;
+
+/**
+ * Bilinear interpolation of n output points from one input layer with precomputed offsets and weights:
+ *
+ *   out[i] = (1-wy[i])*((1-wx[i])*in[o] + wx[i]*in[o+dx]) + wy[i]*((1-wx[i])*in[o+dy] + wx[i]*in[o+dy+dx])
+ *
+ * with o = offsets[i], dx = 1 and dy = inX if the respective bit in steps[i] is set, 0 otherwise.
+ * Gathers are vectorized if the cpu supports it (checked at runtime), the results do not depend on this.
+ *
+ * @param in the input layer, all offsets must be valid positions in the layer
+ * @param inX x-size of the input layer
+ * @param offsets position of the lower-left input point
+ * @param steps combination of BILINEAR_STEP_X and BILINEAR_STEP_Y
+ * @param wx weight in x direction, NaN for undefined output points
+ * @param wy weight in y direction
+ * @param out the n output values
+ */
+void bilinearKernel(const float* in, size_t inX, const uint32_t* offsets, const uint8_t* steps, const float* wx, const float* wy, float* out, size_t n);
+
+/**
+ * Bicubic interpolation of n output points from one input layer with precomputed offsets and separable weights:
+ *
+ *   out[i] = sum_j my[j][i] * sum_k xm[k][i] * in[offsets[i] + j*inX + k],   j,k = 0..3
+ *
+ * Gathers are vectorized if the cpu supports it (checked at runtime), the results do not depend on this.
+ *
+ * @param in the input layer, all 4x4 neighbourhoods must be inside the layer
+ * @param inX x-size of the input layer
+ * @param offsets position of the lower-left input point of the 4x4 neighbourhood
+ * @param xm weights in x direction, NaN for undefined output points
+ * @param my weights in y direction
+ * @param out the n output values
+ */
+void bicubicKernel(const float* in, size_t inX, const uint32_t* offsets, const float* const xm[4], const float* const my[4], float* out, size_t n);
+
+} // namespace MetNoFimex
+
+#endif /* INTERPOLATIONKERNELS_H_ */
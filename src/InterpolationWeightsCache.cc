@@ -0,0 +1,186 @@
+/*
+ * Fimex, InterpolationWeightsCache.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "InterpolationWeightsCache.h"
+
+#include "fimex/CDMException.h"
+#include "fimex/Logger.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MetNoFimex {
+
+static Logger_p logger = getLogger("fimex.InterpolationWeightsCache");
+
+namespace {
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+//! read-only memory mapping of a complete file
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& fileName)
+        : data_(nullptr)
+        , size_(0)
+    {
+        const int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* m = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                data_ = static_cast<const char*>(m);
+                size_ = st.st_size;
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedFile()
+    {
+        if (data_)
+            ::munmap(const_cast<char*>(data_), size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+} // namespace
+
+InterpolationWeightsKey::InterpolationWeightsKey()
+    : hash_(FNV_OFFSET)
+{
+}
+
+void InterpolationWeightsKey::addBytes(const void* data, size_t n)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+        hash_ ^= bytes[i];
+        hash_ *= FNV_PRIME;
+    }
+}
+
+InterpolationWeightsKey& InterpolationWeightsKey::add(const std::string& value)
+{
+    // include the length to separate "ab","c" from "a","bc"
+    add(static_cast<long long>(value.size()));
+    addBytes(value.data(), value.size());
+    return *this;
+}
+
+InterpolationWeightsKey& InterpolationWeightsKey::add(long long value)
+{
+    addBytes(&value, sizeof(value));
+    return *this;
+}
+
+InterpolationWeightsKey& InterpolationWeightsKey::add(const double* values, size_t n)
+{
+    add(static_cast<long long>(n));
+    addBytes(values, n * sizeof(double));
+    return *this;
+}
+
+std::string InterpolationWeightsKey::str() const
+{
+    std::ostringstream s;
+    s << std::hex << std::setw(16) << std::setfill('0') << hash_;
+    return s.str();
+}
+
+InterpolationWeightsCache::InterpolationWeightsCache(const std::string& directory)
+    : directory_(directory)
+{
+    struct stat st;
+    if (::stat(directory_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+        throw CDMException("interpolation weights cache directory does not exist: " + directory_);
+}
+
+std::string InterpolationWeightsCache::fileName(const InterpolationWeightsKey& key) const
+{
+    return directory_ + "/fimex-weights-" + key.str() + ".bin";
+}
+
+CachedInterpolationInterface_p InterpolationWeightsCache::get(const InterpolationWeightsKey& key) const
+{
+    const std::string file = fileName(key);
+    MappedFile mapped(file);
+    if (!mapped.data()) {
+        LOG4FIMEX(logger, Logger::DEBUG, "no cached interpolation weights in " << file);
+        return CachedInterpolationInterface_p();
+    }
+    try {
+        CachedInterpolationInterface_p ci = readCachedInterpolation(mapped.data(), mapped.size());
+        LOG4FIMEX(logger, Logger::INFO, "using cached interpolation weights from " << file);
+        return ci;
+    } catch (CDMException& ex) {
+        LOG4FIMEX(logger, Logger::WARN, "ignoring cached interpolation weights in " << file << ": " << ex.what());
+        return CachedInterpolationInterface_p();
+    }
+}
+
+void InterpolationWeightsCache::put(const InterpolationWeightsKey& key, const CachedInterpolationInterface& ci) const
+{
+    if (!ci.isSerializable())
+        return;
+
+    const std::string file = fileName(key);
+    std::ostringstream tmp;
+    tmp << file << ".tmp." << ::getpid();
+    const std::string tmpFile = tmp.str();
+    try {
+        {
+            std::ofstream out(tmpFile.c_str(), std::ios::binary | std::ios::trunc);
+            if (!out)
+                throw CDMException("cannot open " + tmpFile);
+            ci.write(out);
+            out.close();
+            if (!out)
+                throw CDMException("error writing " + tmpFile);
+        }
+        if (std::rename(tmpFile.c_str(), file.c_str()) != 0)
+            throw CDMException("cannot rename " + tmpFile + " to " + file);
+        LOG4FIMEX(logger, Logger::DEBUG, "stored interpolation weights in " << file);
+    } catch (CDMException& ex) {
+        std::remove(tmpFile.c_str());
+        LOG4FIMEX(logger, Logger::WARN, "cannot store interpolation weights: " << ex.what());
+    }
+}
+
+} // namespace MetNoFimex
@@ -0,0 +1,95 @@
+/*
+ * Fimex, InterpolationWeightsCache.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef INTERPOLATIONWEIGHTSCACHE_H_
+#define INTERPOLATIONWEIGHTSCACHE_H_
+
+#include "fimex/CachedInterpolation.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MetNoFimex {
+
+/**
+ * Fingerprint of all inputs defining an interpolation, i.e. source and target grids,
+ * projections and interpolation method. Uses 64bit FNV-1a hashing.
+ */
+class InterpolationWeightsKey
+{
+public:
+    InterpolationWeightsKey();
+
+    InterpolationWeightsKey& add(const std::string& value);
+    InterpolationWeightsKey& add(long long value);
+    InterpolationWeightsKey& add(const double* values, size_t n);
+    InterpolationWeightsKey& add(const std::vector<double>& values) { return add(values.data(), values.size()); }
+
+    /** @return the hash as 16 hexadecimal characters */
+    std::string str() const;
+
+private:
+    void addBytes(const void* data, size_t n);
+    uint64_t hash_;
+};
+
+/**
+ * Persistent cache of CachedInterpolationInterface objects in a directory, usually
+ * shared between many runs with the same source and target grids.
+ *
+ * Files are written atomically (write to temporary file, then rename), so
+ * concurrent processes may share the directory. Unreadable or outdated files
+ * are ignored and recomputed.
+ */
+class InterpolationWeightsCache
+{
+public:
+    explicit InterpolationWeightsCache(const std::string& directory);
+
+    /**
+     * Load an interpolation from the cache.
+     *
+     * @return the interpolation, or null if not found or not readable
+     */
+    CachedInterpolationInterface_p get(const InterpolationWeightsKey& key) const;
+
+    /**
+     * Store an interpolation in the cache. Failures are logged and otherwise ignored,
+     * as are interpolations which cannot be serialized.
+     */
+    void put(const InterpolationWeightsKey& key, const CachedInterpolationInterface& ci) const;
+
+    const std::string& directory() const { return directory_; }
+
+private:
+    std::string fileName(const InterpolationWeightsKey& key) const;
+    std::string directory_;
+};
+
+typedef std::shared_ptr<InterpolationWeightsCache> InterpolationWeightsCache_p;
+
+} // namespace MetNoFimex
+
+#endif /* INTERPOLATIONWEIGHTSCACHE_H_ */
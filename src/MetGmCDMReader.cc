@@ -33,7 +33,7 @@
 
 namespace MetNoFimex {
 
-static OmpMutex mutex;
+static SharedMutex mutex("MetGmCDMReader");
 
 MetGmCDMReader::MetGmCDMReader(const std::string& metgmsource, const XMLInput& configXML)
 {
@@ -48,7 +48,7 @@ MetGmCDMReader::MetGmCDMReader(const std::string& metgmsource, const XMLInput& c
 
     DataPtr MetGmCDMReader::getDataSlice(const std::string& varName, size_t unLimDimPos)
     {
-        OmpScopedLock lock(mutex);
+        ExclusiveLock lock(mutex);
         return d_ptr->getDataSlice(varName, unLimDimPos);
     }
 
@@ -0,0 +1,245 @@
+/*
+ * Fimex, MutexLock.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "MutexLock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+
+namespace MetNoFimex {
+
+struct LockSiteCounters
+{
+    LockSiteCounters()
+        : exclusive(0)
+        , shared(0)
+        , contended(0)
+        , waitNanoseconds(0)
+    {
+    }
+    std::atomic<size_t> exclusive;
+    std::atomic<size_t> shared;
+    std::atomic<size_t> contended;
+    std::atomic<unsigned long long> waitNanoseconds;
+};
+
+namespace {
+
+void printLockStatistics()
+{
+    for (const LockStatistics& s : getLockStatistics()) {
+        if (s.exclusive == 0 && s.shared == 0)
+            continue;
+        fprintf(stderr, "fimex lock '%s': %zu exclusive, %zu shared, %zu contended, %.6fs waiting\n", s.site.c_str(), s.exclusive, s.shared, s.contended,
+                s.waitSeconds);
+    }
+}
+
+bool statisticsFromEnvironment()
+{
+    if (getenv("FIMEX_LOCK_STATISTICS") == 0)
+        return false;
+    atexit(&printLockStatistics);
+    return true;
+}
+
+std::atomic<bool>& statisticsEnabled()
+{
+    static std::atomic<bool> enabled(statisticsFromEnvironment());
+    return enabled;
+}
+
+struct LockSites
+{
+    std::mutex mutex;
+    // counters are never deleted, locks keep pointers to them
+    std::map<std::string, LockSiteCounters*> sites;
+
+    LockSiteCounters* get(const std::string& site)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        LockSiteCounters*& c = sites[site];
+        if (!c)
+            c = new LockSiteCounters;
+        return c;
+    }
+};
+
+LockSites& lockSites()
+{
+    // never destroyed, locks might be used during static destruction
+    static LockSites* sites = new LockSites;
+    return *sites;
+}
+
+} // namespace
+
+void setLockStatisticsEnabled(bool enabled)
+{
+    statisticsEnabled() = enabled;
+}
+
+bool isLockStatisticsEnabled()
+{
+    return statisticsEnabled();
+}
+
+std::vector<LockStatistics> getLockStatistics()
+{
+    std::vector<LockStatistics> stats;
+    LockSites& ls = lockSites();
+    std::lock_guard<std::mutex> lock(ls.mutex);
+    for (const auto& site : ls.sites) {
+        LockStatistics s;
+        s.site = site.first;
+        s.exclusive = site.second->exclusive;
+        s.shared = site.second->shared;
+        s.contended = site.second->contended;
+        s.waitSeconds = site.second->waitNanoseconds * 1e-9;
+        stats.push_back(s);
+    }
+    std::sort(stats.begin(), stats.end(), [](const LockStatistics& a, const LockStatistics& b) { return a.waitSeconds > b.waitSeconds; });
+    return stats;
+}
+
+void resetLockStatistics()
+{
+    LockSites& ls = lockSites();
+    std::lock_guard<std::mutex> lock(ls.mutex);
+    for (const auto& site : ls.sites) {
+        site.second->exclusive = 0;
+        site.second->shared = 0;
+        site.second->contended = 0;
+        site.second->waitNanoseconds = 0;
+    }
+}
+
+SharedMutex::SharedMutex(const char* site)
+    : readers_(0)
+    , waitingWriters_(0)
+    , writer_(false)
+    , counters_(lockSites().get(site))
+{
+}
+
+bool SharedMutex::tryLock(bool exclusive)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (writer_ || (exclusive ? readers_ > 0 : waitingWriters_ > 0))
+        return false;
+    if (exclusive)
+        writer_ = true;
+    else
+        readers_ += 1;
+    return true;
+}
+
+void SharedMutex::wait(bool exclusive)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (exclusive) {
+        waitingWriters_ += 1;
+        cond_.wait(lock, [this]() { return !writer_ && readers_ == 0; });
+        waitingWriters_ -= 1;
+        writer_ = true;
+    } else {
+        cond_.wait(lock, [this]() { return !writer_ && waitingWriters_ == 0; });
+        readers_ += 1;
+    }
+}
+
+void SharedMutex::lock()
+{
+    if (tryLock(true)) {
+        if (statisticsEnabled())
+            counters_->exclusive += 1;
+        return;
+    }
+    if (!statisticsEnabled()) {
+        wait(true);
+        return;
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    wait(true);
+    counters_->waitNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    counters_->contended += 1;
+    counters_->exclusive += 1;
+}
+
+void SharedMutex::unlock()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writer_ = false;
+    }
+    cond_.notify_all();
+}
+
+void SharedMutex::lock_shared()
+{
+    if (tryLock(false)) {
+        if (statisticsEnabled())
+            counters_->shared += 1;
+        return;
+    }
+    if (!statisticsEnabled()) {
+        wait(false);
+        return;
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    wait(false);
+    counters_->waitNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    counters_->contended += 1;
+    counters_->shared += 1;
+}
+
+void SharedMutex::unlock_shared()
+{
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readers_ -= 1;
+        last = (readers_ == 0);
+    }
+    if (last)
+        cond_.notify_all();
+}
+
+ShardedMutex::ShardedMutex(const char* site, size_t shards)
+{
+    shards_.reserve(shards);
+    for (size_t i = 0; i < shards; ++i)
+        shards_.push_back(std::unique_ptr<SharedMutex>(new SharedMutex(site)));
+}
+
+SharedMutex& ShardedMutex::get(const std::string& key)
+{
+    return *shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+} // namespace MetNoFimex
@@ -31,6 +31,13 @@
 #include <omp.h>
 #endif
 
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 namespace MetNoFimex {
 
 class OmpMutex
@@ -111,6 +118,133 @@ private:
     OmpMutex& mut;
 };
 
+/* wait statistics of all locks with the same site name */
+struct LockStatistics
+{
+    std::string site;
+    size_t exclusive;   //!< exclusive acquisitions
+    size_t shared;      //!< shared acquisitions
+    size_t contended;   //!< acquisitions which had to wait
+    double waitSeconds; //!< total time waited
+};
+
+struct LockSiteCounters;
+
+/**
+ * Enable or disable measuring the wait time of SharedMutex locks. Measuring
+ * is also enabled by setting the environment variable FIMEX_LOCK_STATISTICS,
+ * which prints the statistics to stderr at program exit.
+ */
+void setLockStatisticsEnabled(bool enabled);
+bool isLockStatisticsEnabled();
+
+//! statistics of all lock sites used so far, sorted by wait time
+std::vector<LockStatistics> getLockStatistics();
+
+void resetLockStatistics();
+
+/*
+ * A reader-writer lock, usable with and without OpenMP. Many threads may hold
+ * a shared lock, e.g. for metadata lookups, while an exclusive lock blocks
+ * all others. Waiting writers block new readers.
+ *
+ * The site names the place where the lock is used, e.g. "netcdf", and
+ * groups the statistics of several locks.
+ */
+class SharedMutex
+{
+public:
+    explicit SharedMutex(const char* site = "unnamed");
+
+    SharedMutex(const SharedMutex&) = delete;
+    SharedMutex& operator=(const SharedMutex&) = delete;
+
+    void lock();
+    void unlock();
+    void lock_shared();
+    void unlock_shared();
+
+private:
+    bool tryLock(bool exclusive);
+    void wait(bool exclusive);
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    size_t readers_;
+    size_t waitingWriters_;
+    bool writer_;
+    LockSiteCounters* counters_;
+};
+
+/* Scoped exclusive lock of a SharedMutex. */
+class ExclusiveLock
+{
+public:
+    explicit ExclusiveLock(SharedMutex& m)
+        : mut(m)
+    {
+        mut.lock();
+    }
+    ~ExclusiveLock() { mut.unlock(); }
+
+    ExclusiveLock(const ExclusiveLock&) = delete;
+    ExclusiveLock& operator=(const ExclusiveLock&) = delete;
+
+private:
+    SharedMutex& mut;
+};
+
+/* Scoped unlock of an exclusively locked SharedMutex. */
+class ExclusiveUnlock
+{
+public:
+    explicit ExclusiveUnlock(SharedMutex& m)
+        : mut(m)
+    {
+        mut.unlock();
+    }
+    ~ExclusiveUnlock() { mut.lock(); }
+
+    ExclusiveUnlock(const ExclusiveUnlock&) = delete;
+    ExclusiveUnlock& operator=(const ExclusiveUnlock&) = delete;
+
+private:
+    SharedMutex& mut;
+};
+
+/* Scoped shared lock of a SharedMutex. */
+class SharedLock
+{
+public:
+    explicit SharedLock(SharedMutex& m)
+        : mut(m)
+    {
+        mut.lock_shared();
+    }
+    ~SharedLock() { mut.unlock_shared(); }
+
+    SharedLock(const SharedLock&) = delete;
+    SharedLock& operator=(const SharedLock&) = delete;
+
+private:
+    SharedMutex& mut;
+};
+
+/*
+ * A fixed number of SharedMutex, selected by a key, e.g. a filename, so that
+ * unrelated keys rarely contend.
+ */
+class ShardedMutex
+{
+public:
+    explicit ShardedMutex(const char* site, size_t shards = 16);
+
+    SharedMutex& get(const std::string& key);
+
+private:
+    std::vector<std::unique_ptr<SharedMutex>> shards_;
+};
+
 } // namespace MetNoFimex
 
 #endif /* MUTEXLOCK_H_ */
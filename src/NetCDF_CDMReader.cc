@@ -33,9 +33,12 @@
 #include "fimex/StringUtils.h"
 
 #include "NetCDF_Utils.h"
+#include "TaskScheduler.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <map>
 
 namespace MetNoFimex {
 
@@ -54,12 +57,13 @@ NetCDF_CDMReader::NetCDF_CDMReader(const std::string& filename, bool writeable)
         cacheSize /= fimexSlots;
         LOG4FIMEX(logger, Logger::DEBUG, "setting chunk cache to "<< fimexSlots << " slots of size " << (long)(cacheSize/1024/1024) << "MB");
 
-        OmpScopedLock lock(Nc::getMutex());
+        ExclusiveLock lock(Nc::getMutex());
         nc_set_chunk_cache(cacheSize, fimexSlots, 0.75);
     }
     ncFile->filename = filename;
+    ncFile->writeable = writeable;
 
-    OmpScopedLock lock(Nc::getMutex());
+    ExclusiveLock lock(Nc::getMutex());
     ncCheck(nc_open(ncFile->filename.c_str(), writeable ? NC_WRITE : NC_NOWRITE, &ncFile->ncId), "opening "+ncFile->filename);
     ncFile->isOpen = true;
 
@@ -76,7 +80,7 @@ NetCDF_CDMReader::NetCDF_CDMReader(const std::string& filename, bool writeable)
             size_t dimlen;
             ncCheck(nc_inq_dimname (ncFile->ncId, i, ncName));
             ncCheck(nc_inq_dimlen(ncFile->ncId, i, &dimlen));
-            OmpScopedUnlock unlock(Nc::getMutex());
+            ExclusiveUnlock unlock(Nc::getMutex());
             CDMDimension d(string(ncName), dimlen);
             d.setUnlimited(recid == i);
             cdm_->addDimension(d);
@@ -103,7 +107,7 @@ NetCDF_CDMReader::NetCDF_CDMReader(const std::string& filename, bool writeable)
                 shape.push_back(dimName);
             }
             {
-                OmpScopedUnlock unlock(Nc::getMutex());
+                ExclusiveUnlock unlock(Nc::getMutex());
                 CDMDataType type = ncType2cdmDataType(dtype);
                 cdm_->addVariable(CDMVariable(ncName, type, shape));
             }
@@ -135,90 +139,205 @@ NetCDF_CDMReader::~NetCDF_CDMReader()
 DataPtr NetCDF_CDMReader::getDataSlice(const std::string& varName, size_t unLimDimPos)
 {
     const CDMVariable& var = cdm_->getVariable(varName);
-    if (var.hasData()) {
-        return getDataSliceFromMemory(var, unLimDimPos);
+    {
+        SharedLock dataLock(ncFile->dataMutex);
+        if (var.hasData()) {
+            return getDataSliceFromMemory(var, unLimDimPos);
+        }
     }
 
-    OmpScopedLock lock(Nc::getMutex());
-    ncFile->reopen_if_forked();
+    NcReadLock lock(*ncFile);
+    const int ncId = lock.ncId();
     int varid;
-    ncCheck(nc_inq_varid(ncFile->ncId, var.getName().c_str(), &varid));
+    ncCheck(nc_inq_varid(ncId, var.getName().c_str(), &varid));
     nc_type dtype;
-    ncCheck(nc_inq_vartype(ncFile->ncId, varid, &dtype));
+    ncCheck(nc_inq_vartype(ncId, varid, &dtype));
     int dimLen;
-    ncCheck(nc_inq_varndims(ncFile->ncId, varid, &dimLen));
+    ncCheck(nc_inq_varndims(ncId, varid, &dimLen));
     int dimIds[dimLen];
-    ncCheck(nc_inq_vardimid(ncFile->ncId, varid, &dimIds[0]));
+    ncCheck(nc_inq_vardimid(ncId, varid, &dimIds[0]));
     size_t count[dimLen];
     size_t start[dimLen];
     for (int i = 0; i < dimLen; ++i) {
         start[i] = 0;
-        ncCheck(nc_inq_dimlen(ncFile->ncId, dimIds[i], &count[i]));
+        ncCheck(nc_inq_dimlen(ncId, dimIds[i], &count[i]));
     }
     if (cdm_->hasUnlimitedDim(var)) {
         // unlimited dim always at 0
         start[0] = unLimDimPos;
         count[0] = 1;
     }
-    {
-        OmpScopedUnlock unlock(Nc::getMutex());
-        LOG4FIMEX(logger, Logger::DEBUG,
-                  "ncGetValues for " << varName << ": (" << join(start, start + dimLen) << ") size (" << join(count, count + dimLen) << ")");
-    }
-    return ncGetValues(ncFile->ncId, varid, dtype, static_cast<size_t>(dimLen), start, count);
+    LOG4FIMEX(logger, Logger::DEBUG,
+              "ncGetValues for " << varName << ": (" << join(start, start + dimLen) << ") size (" << join(count, count + dimLen) << ")");
+    ncFile->readPlanner.prepareRead(ncId, varid, start, count);
+    return ncGetValues(ncId, varid, dtype, static_cast<size_t>(dimLen), start, count);
 }
 
 DataPtr NetCDF_CDMReader::getDataSlice(const std::string& varName, const SliceBuilder& sb)
 {
     const CDMVariable& var = cdm_->getVariable(varName);
-    if (var.hasData()) {
-        return var.getData()->slice(sb.getMaxDimensionSizes(),
-                                    sb.getDimensionStartPositions(),
-                                    sb.getDimensionSizes());
+    {
+        SharedLock dataLock(ncFile->dataMutex);
+        if (var.hasData()) {
+            return var.getData()->slice(sb.getMaxDimensionSizes(), sb.getDimensionStartPositions(), sb.getDimensionSizes());
+        }
     }
 
-    ncFile->reopen_if_forked();
+    const vector<size_t> start(sb.getDimensionStartPositions().rbegin(), sb.getDimensionStartPositions().rend());
+    const vector<size_t> count(sb.getDimensionSizes().rbegin(), sb.getDimensionSizes().rend());
+    LOG4FIMEX(logger, Logger::DEBUG, "ncGetValues SB for " << varName << ": (" << join(start.begin(), start.end()) <<") size (" << join(count.begin(), count.end()) << ")");
 
+    NcReadLock lock(*ncFile);
+    const int ncId = lock.ncId();
     int varid, dimLen;
     nc_type dtype;
-    {
-        OmpScopedLock lock(Nc::getMutex());
-        ncCheck(nc_inq_varid(ncFile->ncId, var.getName().c_str(), &varid));
-        ncCheck(nc_inq_vartype(ncFile->ncId, varid, &dtype));
-        ncCheck(nc_inq_varndims(ncFile->ncId, varid, &dimLen));
+    ncCheck(nc_inq_varid(ncId, var.getName().c_str(), &varid));
+    ncCheck(nc_inq_vartype(ncId, varid, &dtype));
+    ncCheck(nc_inq_varndims(ncId, varid, &dimLen));
+    assert(start.size() == static_cast<size_t>(dimLen));
+    assert(count.size() == static_cast<size_t>(dimLen));
+
+    ncFile->readPlanner.prepareRead(ncId, varid, &start[0], &count[0]);
+    return ncGetValues(ncId, varid, dtype, static_cast<size_t>(dimLen), &start[0], &count[0]);
+}
+
+namespace {
+
+//! hyperslab of a request, in netcdf order
+struct NcSlab
+{
+    size_t request;
+    vector<size_t> start;
+    vector<size_t> count;
+};
+
+bool operator<(const NcSlab& a, const NcSlab& b)
+{
+    if (a.start != b.start)
+        return a.start < b.start;
+    return a.count < b.count;
+}
+
+/**
+ * Check if slab can be appended to the hyperslab (start, count) along the
+ * slowest dimension, without leaving the chunk of the first value.
+ *
+ * Text (NC_CHAR) is never coalesced, as string data cannot be split with slice().
+ */
+bool isCoalescable(const NcChunkLayout& layout, nc_type dtype, const vector<size_t>& start, const vector<size_t>& count, const NcSlab& slab)
+{
+    if (dtype == NC_CHAR || !layout.isChunked() || layout.chunks[0] <= 1 || slab.count[0] == 0)
+        return false;
+    if (slab.start[0] != start[0] + count[0])
+        return false;
+    for (size_t i = 1; i < start.size(); ++i) {
+        if (slab.start[i] != start[i] || slab.count[i] != count[i])
+            return false;
     }
+    return (slab.start[0] + slab.count[0] - 1) / layout.chunks[0] == start[0] / layout.chunks[0];
+}
 
-    const vector<size_t> start(sb.getDimensionStartPositions().rbegin(), sb.getDimensionStartPositions().rend());
-    assert(start.size() == static_cast<size_t>(dimLen));
+/**
+ * Read the requests of a single variable in the order of the file, with
+ * requests following each other in the same chunk coalesced into a single read.
+ */
+void readSlabs(Nc& nc, const string& varName, vector<NcSlab>& slabs, vector<DataPtr>& results)
+{
+    std::sort(slabs.begin(), slabs.end());
 
-    const vector<size_t> count(sb.getDimensionSizes().rbegin(), sb.getDimensionSizes().rend());
-    assert(count.size() == static_cast<size_t>(dimLen));
+    NcReadLock lock(nc);
+    const int ncId = lock.ncId();
+    int varid, dimLen;
+    nc_type dtype;
+    ncCheck(nc_inq_varid(ncId, varName.c_str(), &varid));
+    ncCheck(nc_inq_vartype(ncId, varid, &dtype));
+    ncCheck(nc_inq_varndims(ncId, varid, &dimLen));
+    const NcChunkLayout layout = nc.readPlanner.layout(ncId, varid);
+
+    for (size_t i = 0; i < slabs.size();) {
+        vector<size_t> start = slabs[i].start, count = slabs[i].count;
+        size_t end = i + 1;
+        while (end < slabs.size() && isCoalescable(layout, dtype, start, count, slabs[end])) {
+            count[0] += slabs[end].count[0];
+            end += 1;
+        }
 
-    LOG4FIMEX(logger, Logger::DEBUG, "ncGetValues SB for " << varName << ": (" << join(start.begin(), start.end()) <<") size (" << join(count.begin(), count.end()) << ")");
+        LOG4FIMEX(logger, Logger::DEBUG,
+                  "ncGetValues for " << end - i << " requests of " << varName << ": (" << join(start.begin(), start.end()) << ") size ("
+                                     << join(count.begin(), count.end()) << ")");
+        const size_t* startPtr = start.empty() ? 0 : &start[0];
+        const size_t* countPtr = count.empty() ? 0 : &count[0];
+        nc.readPlanner.prepareRead(ncId, varid, startPtr, countPtr);
+        DataPtr data = ncGetValues(ncId, varid, dtype, static_cast<size_t>(dimLen), startPtr, countPtr);
+        if (end == i + 1) {
+            results[slabs[i].request] = data;
+        } else {
+            // split along the slowest netcdf dimension, i.e. the last fimex dimension
+            const vector<size_t> orgDimSize(count.rbegin(), count.rend());
+            for (size_t j = i; j < end; ++j) {
+                vector<size_t> sliceStart(dimLen, 0);
+                sliceStart[dimLen - 1] = slabs[j].start[0] - start[0];
+                const vector<size_t> sliceSize(slabs[j].count.rbegin(), slabs[j].count.rend());
+                results[slabs[j].request] = data->slice(orgDimSize, sliceStart, sliceSize);
+            }
+        }
+        i = end;
+    }
+}
 
-    OmpScopedLock lock(Nc::getMutex());
-    return ncGetValues(ncFile->ncId, varid, dtype, static_cast<size_t>(dimLen), &start[0], &count[0]);
+} // namespace
+
+std::vector<DataPtr> NetCDF_CDMReader::getDataSlices(const DataSliceRequest_v& requests)
+{
+    std::vector<DataPtr> results(requests.size());
+    std::map<std::string, vector<NcSlab>> varSlabs;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const DataSliceRequest& r = requests[i];
+        const CDMVariable& var = cdm_->getVariable(r.varName);
+        bool inMemory;
+        {
+            SharedLock dataLock(ncFile->dataMutex);
+            inMemory = var.hasData();
+        }
+        if (inMemory) {
+            results[i] = getDataSlice(r.varName, r.sb);
+        } else {
+            NcSlab slab;
+            slab.request = i;
+            slab.start.assign(r.sb.getDimensionStartPositions().rbegin(), r.sb.getDimensionStartPositions().rend());
+            slab.count.assign(r.sb.getDimensionSizes().rbegin(), r.sb.getDimensionSizes().rend());
+            varSlabs[var.getName()].push_back(slab);
+        }
+    }
+
+    std::vector<std::pair<const std::string, vector<NcSlab>>*> groups;
+    for (auto& vs : varSlabs)
+        groups.push_back(&vs);
+    parallelFor(groups.size(), [&](size_t g) { readSlabs(*ncFile, groups[g]->first, groups[g]->second, results); }, TASK_STAGE_READ);
+    return results;
 }
 
 void NetCDF_CDMReader::sync()
 {
-    OmpScopedLock lock(Nc::getMutex());
+    ExclusiveLock lock(Nc::getMutex());
     ncCheck(nc_sync(ncFile->ncId));
 }
 
 void NetCDF_CDMReader::putDataSlice(const std::string& varName, size_t unLimDimPos, const DataPtr data)
 {
     CDMVariable& var = cdm_->getVariable(varName);
-
-    OmpScopedLock lock(Nc::getMutex()); // FIXME abusing ncMutex as a little bit of protection for "var.setData"
-    if (var.hasData()) {
-        var.setData(DataPtr());
+    {
+        ExclusiveLock dataLock(ncFile->dataMutex);
+        if (var.hasData()) {
+            var.setData(DataPtr());
+        }
     }
 
     // no data, no write
     if (!data || data->size() == 0)
         return;
 
+    ExclusiveLock lock(Nc::getMutex());
     int varid, dimLen;
     nc_type dtype;
     ncCheck(nc_inq_varid(ncFile->ncId, var.getName().c_str(), &varid));
@@ -233,7 +352,7 @@ void NetCDF_CDMReader::putDataSlice(const std::string& varName, size_t unLimDimP
         ncCheck(nc_inq_dimlen(ncFile->ncId, dimIds[i], &count[i]));
     }
     {
-        OmpScopedUnlock unlock(Nc::getMutex());
+        ExclusiveUnlock unlock(Nc::getMutex());
         if (cdm_->hasUnlimitedDim(var)) {
             // unlimited dim always at 0
             start[0] = unLimDimPos;
@@ -248,8 +367,11 @@ void NetCDF_CDMReader::putDataSlice(const std::string& varName, size_t unLimDimP
 void NetCDF_CDMReader::putDataSlice(const std::string& varName, const SliceBuilder& sb, const DataPtr data)
 {
     CDMVariable& var = cdm_->getVariable(varName);
-    if (var.hasData()) {
-        var.setData(DataPtr());
+    {
+        ExclusiveLock dataLock(ncFile->dataMutex);
+        if (var.hasData()) {
+            var.setData(DataPtr());
+        }
     }
 
     // no data, no write
@@ -259,7 +381,7 @@ void NetCDF_CDMReader::putDataSlice(const std::string& varName, const SliceBuild
     int varid, dimLen;
     nc_type dtype;
     {
-        OmpScopedLock lock(Nc::getMutex());
+        ExclusiveLock lock(Nc::getMutex());
         ncCheck(nc_inq_varid(ncFile->ncId, var.getName().c_str(), &varid));
         ncCheck(nc_inq_vartype(ncFile->ncId, varid, &dtype));
         ncCheck(nc_inq_varndims(ncFile->ncId, varid, &dimLen));
@@ -275,7 +397,7 @@ void NetCDF_CDMReader::putDataSlice(const std::string& varName, const SliceBuild
 
     LOG4FIMEX(logger, Logger::DEBUG, "ncPutValues SB for " << varName << ": (" << join(start.begin(), start.end()) <<") size (" << join(count.begin(), count.end()) << ")");
 
-    OmpScopedLock lock(Nc::getMutex());
+    ExclusiveLock lock(Nc::getMutex());
     return ncPutValues(data, ncFile->ncId, varid, dtype, static_cast<size_t>(dimLen), &start[0], &count[0]);
 }
 
@@ -285,7 +407,7 @@ void NetCDF_CDMReader::addAttribute(const std::string& varName, int varid, const
     ncCheck(nc_inq_atttype(ncFile->ncId, varid, attName.c_str(), &dtype));
     DataPtr attrData = ncGetAttValues(ncFile->ncId, varid, attName, dtype);
 
-    OmpScopedUnlock unlock(Nc::getMutex());
+    ExclusiveUnlock unlock(Nc::getMutex());
     cdm_->addAttribute(varName, CDMAttribute(attName, attrData));
 }
 
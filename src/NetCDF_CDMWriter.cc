@@ -37,9 +37,14 @@
 #include "fimex/mifi_constants.h"
 
 #include "NetCDF_Utils.h"
+#include "TaskScheduler.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
 
 #include <libxml/tree.h>
@@ -51,6 +56,25 @@ namespace {
 
 Logger_p logger = getLogger("fimex.NetCDF_CDMWriter");
 
+//! maximum size of the slices requested with CDMReader::getDataSlices, summed over all parallel steps
+const size_t maxBatchBytes = 256 * 1024 * 1024;
+
+//! size of one value of type in memory, 8 for unknown types
+size_t dataTypeBytes(CDMDataType type)
+{
+    switch (type) {
+    case CDM_CHAR:
+    case CDM_UCHAR:
+    case CDM_STRING: return 1;
+    case CDM_SHORT:
+    case CDM_USHORT: return 2;
+    case CDM_INT:
+    case CDM_UINT:
+    case CDM_FLOAT: return 4;
+    default: return 8;
+    }
+}
+
 int getNcVersion(int version, std::unique_ptr<XMLDoc>& doc)
 {
     int retVal = NC_CLOBBER;
@@ -110,6 +134,7 @@ void checkDoc(std::unique_ptr<XMLDoc>& doc, const std::string& filename)
 NetCDF_CDMWriter::NetCDF_CDMWriter(CDMReader_p reader, const std::string& outputFile, std::string configFile, int version)
     : CDMWriter(reader, outputFile)
     , ncFile(new Nc())
+    , readAheadBytes(0)
 {
     std::unique_ptr<XMLDoc> doc;
     if (!configFile.empty()) {
@@ -154,6 +179,14 @@ NetCDF_CDMWriter::NetCDF_CDMWriter(CDMReader_p reader, const std::string& output
     initFillRenameVariable(doc);
     initFillRenameDimension(doc);
     initFillRenameAttribute(doc);
+    if (doc) {
+        // read slices ahead while writing, up to readAheadMB
+        xmlXPathObject_p xpathObj = doc->getXPathObject("/cdm_ncwriter_config/default[@readAheadMB]");
+        xmlNodeSetPtr nodes = xpathObj->nodesetval;
+        if (nodes && nodes->nodeNr) {
+            readAheadBytes = static_cast<size_t>(string2type<double>(getXmlProp(nodes->nodeTab[0], "readAheadMB")) * 1024 * 1024);
+        }
+    }
 
     init();
 }
@@ -501,7 +534,7 @@ NetCDF_CDMWriter::NcVarIdMap NetCDF_CDMWriter::defineVariables(const NcDimIdMap&
 
 void NetCDF_CDMWriter::writeAttributes(const NcVarIdMap& ncVarMap)
 {
-    OmpScopedLock lock(Nc::getMutex());
+    ExclusiveLock lock(Nc::getMutex());
     for (const auto& nmsp_att : cdm.getAttributes()) {
         int varId;
         if (nmsp_att.first == CDM::globalAttributeNS()) {
@@ -613,6 +646,166 @@ DataPtr NetCDF_CDMWriter::convertData(const CDMVariable& var, DataPtr data)
     return data;
 }
 
+//! a slice of a variable to be written, unLimDimPos = -1 for variables without unlimited dimension
+struct NetCDF_CDMWriter::SliceTask
+{
+    const CDMVariable* var;
+    int varId;
+    long long unLimDimPos;
+    bool withUnlim;
+    int unLimDimIdx;
+    std::vector<size_t> start;
+    std::vector<size_t> count;
+};
+
+bool NetCDF_CDMWriter::initSliceTask(SliceTask& task, const CDMVariable& cdmVar, int varId, long long unLimDimPos, int unLimDimId)
+{
+    task.var = &cdmVar;
+    task.varId = varId;
+    task.unLimDimPos = unLimDimPos;
+    task.unLimDimIdx = -1;
+
+    int n_dims;
+    std::vector<int> dim_ids;
+    {
+        ExclusiveLock ncLock(Nc::getMutex());
+
+        ncCheck(nc_inq_varndims(ncFile->ncId, varId, &n_dims));
+
+        dim_ids.resize(n_dims);
+        ncCheck(nc_inq_vardimid(ncFile->ncId, varId, dim_ids.data()));
+
+        task.start.resize(n_dims);
+        task.count.resize(n_dims);
+        for (int i = 0; i < n_dims; ++i) {
+            if (dim_ids[i] == unLimDimId)
+                task.unLimDimIdx = i;
+
+            size_t dim_len;
+            ncCheck(nc_inq_dimlen(ncFile->ncId, dim_ids[i], &dim_len));
+            task.start[i] = 0;
+            task.count[i] = dim_len;
+        }
+    }
+    LOG4FIMEX(logger, Logger::DEBUG, "dimids of " << cdmVar.getName() << ": " << join(dim_ids.begin(), dim_ids.end()));
+
+    const bool no_unlim = (unLimDimPos == -1 && task.unLimDimIdx == -1 && !cdm.hasUnlimitedDim(cdmVar));
+    task.withUnlim = (unLimDimPos != -1 && task.unLimDimIdx >= 0 && cdm.hasUnlimitedDim(cdmVar));
+    if (task.withUnlim) {
+        task.count[task.unLimDimIdx] = 1; // just one slice
+        task.start[task.unLimDimIdx] = unLimDimPos;
+    }
+    return no_unlim || task.withUnlim;
+}
+
+DataPtr NetCDF_CDMWriter::readSlice(const SliceTask& task)
+{
+    const CDMVariable& cdmVar = *task.var;
+    const std::string& varName = cdmVar.getName();
+    DataPtr data;
+    if (task.withUnlim) {
+        data = cdmReader->getDataSlice(varName, task.unLimDimPos);
+    } else {
+        data = cdmReader->getData(varName);
+    }
+    return prepareSlice(task, data);
+}
+
+DataPtr NetCDF_CDMWriter::prepareSlice(const SliceTask& task, DataPtr data)
+{
+    const CDMVariable& cdmVar = *task.var;
+    data = convertData(cdmVar, data);
+
+    if (data->size() == 0 && ncFile->format < 3) {
+        // need to write data with _FillValue,
+        // since we are using NC_NOFILL for nc3 format files = NC_FORMAT_CLASSIC(1) NC_FORMAT_64BIT(2))
+        const size_t size = std::accumulate(task.count.begin(), task.count.end(), size_t(1), std::multiplies<size_t>());
+        data = createData(cdmVar.getDataType(), size, cdm.getFillValue(cdmVar.getName()));
+    }
+    return data;
+}
+
+struct NetCDF_CDMWriter::BatchBudget
+{
+    //! bytes of the slices currently read in batches, limited by maxBatchBytes
+    std::atomic<size_t> bytes;
+
+    BatchBudget()
+        : bytes(0)
+    {
+    }
+
+    //! account for n bytes, fails if this exceeds maxBatchBytes unless force is set
+    bool reserve(size_t n, bool force)
+    {
+        size_t current = bytes;
+        do {
+            if (!force && current + n > maxBatchBytes)
+                return false;
+        } while (!bytes.compare_exchange_weak(current, current + n));
+        return true;
+    }
+};
+
+void NetCDF_CDMWriter::readAndWriteSlices(const std::vector<SliceTask>& tasks, BatchBudget& budget)
+{
+    if (tasks.empty())
+        return;
+    const CDM& readerCdm = cdmReader->getCDM();
+    const std::string& unLimDimName = readerCdm.getUnlimitedDim()->getName();
+    size_t begin = 0;
+    while (begin < tasks.size()) {
+        // batches of parallel steps share the budget, a step which gets no budget
+        // reads one slice at a time
+        DataSliceRequest_v requests;
+        size_t bytes = 0, end = begin;
+        do {
+            const SliceTask& task = tasks[end];
+            const std::string& varName = task.var->getName();
+            const size_t taskBytes = dataTypeBytes(readerCdm.getVariable(varName).getDataType())
+                                     * std::accumulate(task.count.begin(), task.count.end(), size_t(1), std::multiplies<size_t>());
+            if (!budget.reserve(taskBytes, end == begin))
+                break;
+            requests.push_back(DataSliceRequest(varName, SliceBuilder(readerCdm, varName)));
+            requests.back().sb.setStartAndSize(unLimDimName, task.unLimDimPos, 1);
+            bytes += taskBytes;
+            end += 1;
+        } while (end < tasks.size());
+
+        try {
+            std::vector<DataPtr> data = cdmReader->getDataSlices(requests);
+            for (size_t i = begin; i < end; ++i) {
+                writeSlice(tasks[i], prepareSlice(tasks[i], data[i - begin]));
+                data[i - begin].reset();
+            }
+        } catch (...) {
+            budget.bytes -= bytes;
+            throw;
+        }
+        budget.bytes -= bytes;
+        begin = end;
+    }
+}
+
+void NetCDF_CDMWriter::writeSlice(const SliceTask& task, DataPtr data)
+{
+    if (data->size() == 0)
+        return;
+
+    const CDMVariable& cdmVar = *task.var;
+    const std::string& varName = cdmVar.getName();
+    const int n_dims = task.start.size();
+    LOG4FIMEX(logger, Logger::DEBUG,
+              "dimLen= " << n_dims << " start=" << join(task.start.begin(), task.start.end()) << " count=" << join(task.count.begin(), task.count.end()));
+    try {
+        LOG4FIMEX(logger, Logger::DEBUG, "writing variable " << varName);
+        ExclusiveLock ncLock(Nc::getMutex());
+        ncPutValues(data, ncFile->ncId, task.varId, cdmDataType2ncType(cdmVar.getDataType()), n_dims, task.start.data(), task.count.data());
+    } catch (CDMException& ex) {
+        throw CDMException(ex.what() + std::string(" while writing var ") + varName);
+    }
+}
+
 void NetCDF_CDMWriter::writeData(const NcVarIdMap& ncVarMap)
 {
     const CDMDimension* unLimDim = cdm.getUnlimitedDim();
@@ -623,31 +816,34 @@ void NetCDF_CDMWriter::writeData(const NcVarIdMap& ncVarMap)
 #ifdef HAVE_MPI
     const bool sliceAlongUnlimited = (maxUnLim > 3);
     const bool using_mp = (mifi_mpi_initialized() && mifi_mpi_size > 1);
+#else
+    if (readAheadBytes > 0) {
+        writeDataPipelined(ncVarMap);
+        return;
+    }
 #endif
 
     // read data along unLimDim and then variables, otherwise netcdf3 reading might get very slow
     // see http://www.unidata.ucar.edu/support/help/MailArchives/netcdf/msg10905.html
     // use unLimDimPos = -1 for variables without unlimited dimension
 
-#if !defined(__INTEL_COMPILER) || (__INTEL_COMPILER >= 1800)
-#ifdef _OPENMP
-#pragma omp parallel for default(none) shared(logger, cdmVars, ncVarMap)
-#endif
-#endif //__INTEL_COMPILER
-    for (long long unLimDimPos = -1; unLimDimPos < maxUnLim; ++unLimDimPos) {
+    BatchBudget budget;
+    parallelFor(maxUnLim + 1, [&](size_t i) {
+        const long long unLimDimPos = static_cast<long long>(i) - 1;
 #ifdef HAVE_MPI
         if (using_mpi) {
             if (sliceAlongUnlimited) { // MPI-slices along unlimited dimension
                 // only work on variables which belong to this mpi-process (modulo-base)
                 if ((unLimDimPos % mifi_mpi_size) != mifi_mpi_rank) {
                     LOG4FIMEX(logger, Logger::DEBUG, "processor " << mifi_mpi_rank << " skipping unLimDimPos " << unLimDimPos);
-                    continue;
+                    return;
                 } else {
                     LOG4FIMEX(logger, Logger::DEBUG, "processor " << mifi_mpi_rank << " working on unLimDimPos " << unLimDimPos);
                 }
             }
         }
 #endif
+        std::vector<SliceTask> batch;
         for (size_t vi = 0; vi < cdmVars.size(); ++vi) {
             const CDMVariable& cdmVar = cdmVars[vi];
             const std::string& varName = cdmVar.getName();
@@ -666,75 +862,101 @@ void NetCDF_CDMWriter::writeData(const NcVarIdMap& ncVarMap)
                 }
             }
 #endif
-            int n_dims;
-            std::unique_ptr<int[]> dim_ids;
-            std::unique_ptr<size_t[]> count;
-            std::unique_ptr<size_t[]> start;
-            int unLimDimIdx = -1;
-            {
-                OmpScopedLock ncLock(Nc::getMutex());
-
-                ncCheck(nc_inq_varndims(ncFile->ncId, varId, &n_dims));
-
-                dim_ids.reset(new int[n_dims]);
-                ncCheck(nc_inq_vardimid(ncFile->ncId, varId, dim_ids.get()));
-
-                start.reset(new size_t[n_dims]);
-                count.reset(new size_t[n_dims]);
-                for (int i = 0; i < n_dims; ++i) {
-                    if (dim_ids[i] == unLimDimId)
-                        unLimDimIdx = i;
-
-                    size_t dim_len;
-                    ncCheck(nc_inq_dimlen(ncFile->ncId, dim_ids[i], &dim_len));
-                    start[i] = 0;
-                    count[i] = dim_len;
-                }
-            }
-            LOG4FIMEX(logger, Logger::DEBUG, "dimids of " << varName << ": " << join(&dim_ids[0], &dim_ids[0] + n_dims));
-
-            const bool no_unlim = (unLimDimPos == -1 && unLimDimIdx == -1 && !cdm.hasUnlimitedDim(cdmVar));
-            const bool with_unlim = (unLimDimPos != -1 && unLimDimIdx >= 0 && cdm.hasUnlimitedDim(cdmVar));
-            DataPtr data;
-            if (no_unlim) {
-                data = cdmReader->getData(varName);
-            } else if (with_unlim) {
-                data = cdmReader->getDataSlice(varName, unLimDimPos);
-            } else {
+            SliceTask task;
+            if (!initSliceTask(task, cdmVar, varId, unLimDimPos, unLimDimId))
                 continue; // FIXME
+            if (!task.withUnlim) {
+                writeSlice(task, readSlice(task));
+                continue;
             }
-            data = convertData(cdmVar, data);
-
-            if (data->size() == 0 && ncFile->format < 3) {
-                // need to write data with _FillValue,
-                // since we are using NC_NOFILL for nc3 format files = NC_FORMAT_CLASSIC(1) NC_FORMAT_64BIT(2))
-                if (with_unlim)
-                    count[unLimDimIdx] = 1; // just one slice
-                size_t size = (n_dims > 0) ? std::accumulate(count.get(), count.get() + n_dims, 1, std::multiplies<size_t>()) : 1;
-                data = createData(cdmVar.getDataType(), size, cdm.getFillValue(varName));
-            }
-            if (data->size() > 0) {
-                if (with_unlim) {
-                    count[unLimDimIdx] = 1;
-                    start[unLimDimIdx] = unLimDimPos;
-                }
-                LOG4FIMEX(logger, Logger::DEBUG,
-                          "dimLen= " << n_dims << " start=" << join(&start[0], &start[0] + n_dims) << " count=" << join(&count[0], &count[0] + n_dims));
-                try {
-                    LOG4FIMEX(logger, Logger::DEBUG, "writing variable " << varName);
-                    class OmpScopedLock ncLock(Nc::getMutex());
-                    ncPutValues(data, ncFile->ncId, varId, cdmDataType2ncType(cdmVar.getDataType()), n_dims, start.get(), count.get());
-                } catch (CDMException& ex) {
-                    throw CDMException(ex.what() + std::string(" while writing var ") + varName);
-                }
-            }
+            // slices along the unlimited dimension are requested together, allowing
+            // the reader to share work between the variables
+            batch.push_back(task);
         }
+        readAndWriteSlices(batch, budget);
 #ifndef HAVE_MPI
         if (unLimDimPos >= 0) {
             NCMUTEX_LOCKED(ncCheck(nc_sync(ncFile->ncId))); // sync every 'time/unlimited' step (does not work with MPI)
         }
 #endif
+    }, TASK_STAGE_WRITE);
+}
+
+void NetCDF_CDMWriter::writeDataPipelined(const NcVarIdMap& ncVarMap)
+{
+    const CDMDimension* unLimDim = cdm.getUnlimitedDim();
+    const int unLimDimId = ncDimId(ncFile->ncId, unLimDim);
+    const long long maxUnLim = (unLimDim == 0) ? 0 : unLimDim->getLength();
+    const CDM::VarVec& cdmVars = cdm.getVariables();
+
+    // all slices in the order of writing, along unLimDim and then variables
+    std::vector<SliceTask> tasks;
+    for (long long unLimDimPos = -1; unLimDimPos < maxUnLim; ++unLimDimPos) {
+        for (const CDMVariable& cdmVar : cdmVars) {
+            SliceTask task;
+            if (initSliceTask(task, cdmVar, ncVarMap.find(cdmVar.getName())->second, unLimDimPos, unLimDimId))
+                tasks.push_back(task);
+        }
+    }
+    LOG4FIMEX(logger, Logger::DEBUG, "pipelined writing of " << tasks.size() << " slices with " << readAheadBytes << " bytes read-ahead");
+
+    // All threads read slices in order, as long as the read-ahead memory is not exhausted.
+    // Completed slices are written strictly in order, by one thread at a time. The next slice
+    // to write is always read, so the queue cannot block.
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::map<size_t, DataPtr> readSlices;
+    size_t nextRead = 0, nextWrite = 0, queuedBytes = 0;
+    bool writing = false;
+    std::string error;
+
+#ifdef _OPENMP
+#pragma omp parallel default(shared)
+#endif
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (error.empty() && nextWrite < tasks.size()) {
+            try {
+                std::map<size_t, DataPtr>::iterator ready = readSlices.find(nextWrite);
+                if (!writing && ready != readSlices.end()) {
+                    const size_t t = nextWrite;
+                    DataPtr data = ready->second;
+                    readSlices.erase(ready);
+                    writing = true;
+                    lock.unlock();
+                    writeSlice(tasks[t], data);
+                    const bool syncUnLim = tasks[t].unLimDimPos >= 0 && (t + 1 == tasks.size() || tasks[t + 1].unLimDimPos != tasks[t].unLimDimPos);
+                    if (syncUnLim) {
+                        NCMUTEX_LOCKED(ncCheck(nc_sync(ncFile->ncId))); // sync every 'time/unlimited' step
+                    }
+                    lock.lock();
+                    queuedBytes -= data->size() * data->bytes_for_one();
+                    writing = false;
+                    nextWrite += 1;
+                    queueChanged.notify_all();
+                } else if (nextRead < tasks.size() && (queuedBytes < readAheadBytes || nextRead == nextWrite)) {
+                    const size_t t = nextRead++;
+                    lock.unlock();
+                    DataPtr data = readSlice(tasks[t]);
+                    lock.lock();
+                    readSlices[t] = data;
+                    queuedBytes += data->size() * data->bytes_for_one();
+                    queueChanged.notify_all();
+                } else {
+                    queueChanged.wait(lock);
+                }
+            } catch (std::exception& ex) {
+                // exceptions must not leave an openmp region
+                if (!lock.owns_lock())
+                    lock.lock();
+                if (error.empty())
+                    error = ex.what();
+                queueChanged.notify_all();
+            }
+        }
     }
+    if (!error.empty())
+        throw CDMException(error);
 }
 
 void NetCDF_CDMWriter::init()
@@ -28,8 +28,13 @@
 #include "fimex/Logger.h"
 #include "MutexLock.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
+#include <list>
+#include <map>
 #include <numeric>
+#include <unordered_map>
 
 extern "C" {
 #include "netcdf.h"
@@ -43,7 +48,7 @@ namespace MetNoFimex {
 
 static Logger_p logger = getLogger("fimex.NetCDF_Utils");
 // hdf5 lib is usually not thread-safe, so reading from one file and writing to another fails
-static OmpMutex ncMutex;
+static SharedMutex ncMutex("netcdf");
 
 namespace {
 
@@ -82,13 +87,18 @@ void ncCheck(int status, const std::string& msg)
 
 Nc::Nc()
     : isOpen(false)
+    , writeable(true)
     , pid(getpid())
+    , dataMutex("netcdf data")
+    , readIdsMutex("netcdf read ids")
 {
 }
 
 Nc::~Nc()
 {
+    closeReadIds();
     if (isOpen) {
+        readPlanner.logStatistics(filename);
         int status;
         NCMUTEX_LOCKED(status = nc_close(ncId));
         if (status != NC_NOERR) {
@@ -106,18 +116,342 @@ void Nc::reopen_if_forked()
         pid = this_pid;
         LOG4FIMEX(logger, Logger::DEBUG, "reopening file " << filename << " after fork to " << pid << " '" << ncId << "' ");
 
-        OmpScopedLock lock(ncMutex);
+        closeReadIds();
+        ExclusiveLock lock(ncMutex);
         // reopen file so file descriptions (e.g. offset) are not shared
         ncCheck(nc_close(ncId), "closing parent filehandle");
         ncCheck(nc_open(filename.c_str(), NC_NOWRITE, &ncId), "re-opening '"+filename+"' after fork");
     }
 }
 
-OmpMutex& Nc::getMutex()
+SharedMutex& Nc::getMutex()
 {
     return ncMutex;
 }
 
+int Nc::acquireReadId()
+{
+    ExclusiveLock lock(readIdsMutex);
+    if (!idleReadIds.empty()) {
+        const int id = idleReadIds.back();
+        idleReadIds.pop_back();
+        return id;
+    }
+    int id;
+    ncCheck(nc_open(filename.c_str(), NC_NOWRITE, &id), "re-opening '" + filename + "' for concurrent reading");
+    readIds.push_back(id);
+    LOG4FIMEX(logger, Logger::DEBUG, "opened read handle " << readIds.size() << " for NetCDF file '" << filename << "'");
+    return id;
+}
+
+void Nc::releaseReadId(int id)
+{
+    ExclusiveLock lock(readIdsMutex);
+    idleReadIds.push_back(id);
+}
+
+void Nc::closeReadIds()
+{
+    ExclusiveLock lock(readIdsMutex);
+    for (int id : readIds) {
+        const int status = nc_close(id);
+        if (status != NC_NOERR)
+            LOG4FIMEX(logger, Logger::ERROR, "error while closing read handle of NetCDF file '" << filename << "': " << nc_strerror(status));
+    }
+    readIds.clear();
+    idleReadIds.clear();
+}
+
+NcReadLock::NcReadLock(Nc& nc)
+    : nc_(nc)
+    , ncId_(nc.ncId)
+    , pooled_(false)
+{
+    nc_.reopen_if_forked();
+#ifdef HAVE_NETCDF_THREADSAFE
+    if (!nc_.writeable) {
+        ncId_ = nc_.acquireReadId();
+        pooled_ = true;
+        return;
+    }
+#endif
+    Nc::getMutex().lock();
+}
+
+NcReadLock::~NcReadLock()
+{
+    if (pooled_)
+        nc_.releaseReadId(ncId_);
+    else
+        Nc::getMutex().unlock();
+}
+
+size_t NcChunkLayout::chunkBytes() const
+{
+    return std::accumulate(chunks.begin(), chunks.end(), valueSize, std::multiplies<size_t>());
+}
+
+size_t NcChunkLayout::chunksTouched(const size_t* start, const size_t* count) const
+{
+    size_t n = 1;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (count[i] == 0)
+            return 0;
+        n *= (start[i] + count[i] - 1) / chunks[i] - start[i] / chunks[i] + 1;
+    }
+    return n;
+}
+
+namespace {
+
+// upper limit for enlarging the chunk cache of a single variable
+const size_t MAX_PLANNED_CHUNK_CACHE = 256 * 1024 * 1024;
+// upper limit for the enlarged chunk caches of all variables and netcdf-ids of a file,
+// hdf5 keeps them until the file is closed
+const size_t MAX_PLANNED_CHUNK_CACHE_TOTAL = 512 * 1024 * 1024;
+// reads touching more chunks are not modelled chunk by chunk
+const size_t MAX_MODELLED_CHUNKS = 65536;
+
+size_t nextPrime(size_t n)
+{
+    for (;; ++n) {
+        bool prime = (n > 1);
+        for (size_t d = 2; prime && d * d <= n; ++d)
+            prime = (n % d != 0);
+        if (prime)
+            return n;
+    }
+}
+
+//! least-recently-used model of the chunks kept in the chunk cache of a variable
+struct NcChunkCacheModel
+{
+    NcChunkCacheModel()
+        : bytes(0)
+        , capacity(0)
+        , enlarged(false)
+    {
+    }
+
+    size_t bytes;    // size of the chunk cache
+    size_t capacity; // number of chunks fitting into the chunk cache
+    bool enlarged;   // size set by the planner, counted in the planned bytes
+    std::list<size_t> chunks; // most recently used first
+    std::unordered_map<size_t, std::list<size_t>::iterator> positions;
+
+    /// @return true if the chunk was not in the cache, i.e. has to be decompressed
+    bool access(size_t chunk);
+    /// @return number of chunks decompressed when reading a hyperslab
+    size_t read(const NcChunkLayout& layout, const size_t* start, const size_t* count);
+};
+
+bool NcChunkCacheModel::access(size_t chunk)
+{
+    const auto it = positions.find(chunk);
+    if (it != positions.end()) {
+        chunks.splice(chunks.begin(), chunks, it->second);
+        return false;
+    }
+    if (capacity == 0)
+        return true;
+    if (chunks.size() >= capacity) {
+        positions.erase(chunks.back());
+        chunks.pop_back();
+    }
+    chunks.push_front(chunk);
+    positions[chunk] = chunks.begin();
+    return true;
+}
+
+size_t NcChunkCacheModel::read(const NcChunkLayout& layout, const size_t* start, const size_t* count)
+{
+    const size_t n = layout.chunks.size();
+    std::vector<size_t> first(n), last(n), strides(n);
+    size_t stride = 1;
+    for (size_t i = n; i-- > 0;) {
+        first[i] = start[i] / layout.chunks[i];
+        last[i] = (start[i] + count[i] - 1) / layout.chunks[i];
+        strides[i] = stride;
+        stride *= std::max<size_t>(1, (layout.dimLen[i] + layout.chunks[i] - 1) / layout.chunks[i]);
+    }
+
+    size_t decompressed = 0;
+    std::vector<size_t> pos = first;
+    while (true) {
+        size_t chunk = 0;
+        for (size_t i = 0; i < n; ++i)
+            chunk += pos[i] * strides[i];
+        if (access(chunk))
+            decompressed += 1;
+
+        size_t i = n;
+        while (i > 0 && pos[i - 1] == last[i - 1]) {
+            pos[i - 1] = first[i - 1];
+            i -= 1;
+        }
+        if (i == 0)
+            break;
+        pos[i - 1] += 1;
+    }
+    return decompressed;
+}
+
+struct NcVarReadStatistics
+{
+    NcVarReadStatistics()
+        : reads(0)
+        , requestedBytes(0)
+        , decompressedBytes(0)
+    {
+    }
+    size_t reads;
+    size_t requestedBytes;
+    size_t decompressedBytes;
+};
+
+} // namespace
+
+struct NcReadPlanner::Impl
+{
+    Impl()
+        : mutex("netcdf read planner")
+        , fixedCache(getenv("FIMEX_CHUNK_CACHE_SIZE") != 0)
+        , plannedBytes(0)
+    {
+    }
+
+    SharedMutex mutex;
+    bool fixedCache; // chunk cache configured by the user, do not change
+    size_t plannedBytes; // sum of the enlarged chunk caches
+    std::map<int, NcChunkLayout> layouts;                      // by varId
+    std::map<std::pair<int, int>, NcChunkCacheModel> caches; // by ncId, varId
+    std::map<int, NcVarReadStatistics> statistics;             // by varId
+
+    const NcChunkLayout& layout(int ncId, int varId);
+    NcChunkCacheModel& cache(int ncId, int varId, const NcChunkLayout& layout);
+};
+
+const NcChunkLayout& NcReadPlanner::Impl::layout(int ncId, int varId)
+{
+    const auto it = layouts.find(varId);
+    if (it != layouts.end())
+        return it->second;
+
+    NcChunkLayout l;
+    char varName[NC_MAX_NAME + 1];
+    nc_type dtype;
+    int ndims;
+    int dimIds[NC_MAX_VAR_DIMS];
+    ncCheck(nc_inq_var(ncId, varId, varName, &dtype, &ndims, dimIds, 0));
+    l.varName = varName;
+    l.dimLen.resize(ndims);
+    for (int i = 0; i < ndims; ++i)
+        ncCheck(nc_inq_dimlen(ncId, dimIds[i], &l.dimLen[i]));
+    if (nc_inq_type(ncId, dtype, 0, &l.valueSize) != NC_NOERR)
+        l.valueSize = 0;
+#ifdef NC_NETCDF4
+    if (ndims > 0 && l.valueSize > 0) {
+        int storage;
+        std::vector<size_t> chunks(ndims);
+        // fails for netcdf-3 files, which are not chunked
+        if (nc_inq_var_chunking(ncId, varId, &storage, &chunks[0]) == NC_NOERR && storage == NC_CHUNKED)
+            l.chunks.swap(chunks);
+    }
+#endif
+    return layouts[varId] = l;
+}
+
+NcChunkCacheModel& NcReadPlanner::Impl::cache(int ncId, int varId, const NcChunkLayout& layout)
+{
+    const std::pair<int, int> key(ncId, varId);
+    const auto it = caches.find(key);
+    if (it != caches.end())
+        return it->second;
+
+    NcChunkCacheModel& c = caches[key];
+#ifdef NC_NETCDF4
+    size_t size, nelems;
+    float preemption;
+    if (nc_get_var_chunk_cache(ncId, varId, &size, &nelems, &preemption) == NC_NOERR) {
+        c.bytes = size;
+        c.capacity = size / layout.chunkBytes();
+    }
+#endif
+    return c;
+}
+
+NcReadPlanner::NcReadPlanner()
+    : p_(new Impl)
+{
+}
+
+NcReadPlanner::~NcReadPlanner()
+{
+}
+
+NcChunkLayout NcReadPlanner::layout(int ncId, int varId)
+{
+    ExclusiveLock lock(p_->mutex);
+    return p_->layout(ncId, varId);
+}
+
+void NcReadPlanner::prepareRead(int ncId, int varId, const size_t* start, const size_t* count)
+{
+    ExclusiveLock lock(p_->mutex);
+    const NcChunkLayout& l = p_->layout(ncId, varId);
+    if (!l.isChunked())
+        return;
+
+    const size_t chunkBytes = l.chunkBytes();
+    const size_t touched = l.chunksTouched(start, count);
+    NcChunkCacheModel& cache = p_->cache(ncId, varId, l);
+#ifdef NC_NETCDF4
+    const size_t needed = touched * chunkBytes;
+    const size_t plannedOthers = p_->plannedBytes - (cache.enlarged ? cache.bytes : 0);
+    if (!p_->fixedCache && needed > cache.bytes && needed <= MAX_PLANNED_CHUNK_CACHE && plannedOthers + needed <= MAX_PLANNED_CHUNK_CACHE_TOTAL) {
+        // many more hash-slots than chunks, as recommended for hdf5
+        const size_t nelems = nextPrime(std::max<size_t>(1009, 10 * touched));
+        if (nc_set_var_chunk_cache(ncId, varId, needed, nelems, 0.75) == NC_NOERR) {
+            LOG4FIMEX(logger, Logger::DEBUG,
+                      "chunk cache of '" << l.varName << "' set to " << needed / 1024 << "kB in " << nelems << " slots for " << touched << " chunks");
+            cache.bytes = needed;
+            cache.capacity = touched;
+            cache.enlarged = true;
+            p_->plannedBytes = plannedOthers + needed;
+        }
+    }
+#endif
+
+    const size_t requested = std::accumulate(count, count + l.chunks.size(), l.valueSize, std::multiplies<size_t>());
+    size_t decompressed = 0;
+    if (touched > MAX_MODELLED_CHUNKS)
+        decompressed = touched;
+    else if (touched > 0)
+        decompressed = cache.read(l, start, count);
+    decompressed *= chunkBytes;
+
+    NcVarReadStatistics& stats = p_->statistics[varId];
+    stats.reads += 1;
+    stats.requestedBytes += requested;
+    stats.decompressedBytes += decompressed;
+    LOG4FIMEX(logger, Logger::DEBUG,
+              "reading '" << l.varName << "': " << requested << " bytes requested, " << decompressed << " bytes decompressed from " << touched << " chunks");
+}
+
+void NcReadPlanner::logStatistics(const std::string& filename) const
+{
+    ExclusiveLock lock(p_->mutex);
+    for (const auto& s : p_->statistics) {
+        const NcVarReadStatistics& stats = s.second;
+        if (stats.requestedBytes == 0)
+            continue;
+        LOG4FIMEX(logger, Logger::INFO,
+                  "chunked variable '" << p_->layouts[s.first].varName << "' of '" << filename << "': " << stats.reads << " reads, "
+                                       << stats.requestedBytes / 1048576. << "MB requested, " << stats.decompressedBytes / 1048576.
+                                       << "MB decompressed, amplification " << static_cast<double>(stats.decompressedBytes) / stats.requestedBytes);
+    }
+}
+
 nc_type cdmDataType2ncType(CDMDataType dt) {
     switch (dt) {
     case CDM_CHAR: return NC_BYTE;
@@ -30,6 +30,7 @@
 #include "MutexLock.h"
 
 #include <memory>
+#include <vector>
 
 #include "fimex_config.h"
 #ifndef HAVE_NETCDF_HDF5_LIB
@@ -50,26 +51,123 @@ extern "C" {
 
 #define NCMUTEX_LOCKED(x)                                                                                                                                      \
     do {                                                                                                                                                       \
-        OmpScopedLock lock(Nc::getMutex());                                                                                                                    \
+        ExclusiveLock lock(Nc::getMutex());                                                                                                                    \
         x;                                                                                                                                                     \
     } while (0)
 
 namespace MetNoFimex {
 
+/**
+ * Storage layout of a netcdf variable, in netcdf dimension order.
+ */
+struct NcChunkLayout
+{
+    NcChunkLayout()
+        : valueSize(0)
+    {
+    }
+    std::string varName;
+    std::vector<size_t> dimLen;
+    std::vector<size_t> chunks; ///< chunk sizes, empty for contiguous storage
+    size_t valueSize;
+
+    bool isChunked() const { return !chunks.empty(); }
+    /// size of a (decompressed) chunk in bytes
+    size_t chunkBytes() const;
+    /// number of chunks touched by a hyperslab
+    size_t chunksTouched(const size_t* start, const size_t* count) const;
+};
+
+/**
+ * Planning of reads from chunked (netcdf4/hdf5) variables.
+ *
+ * hdf5 decompresses complete chunks, and a chunk cache too small for the
+ * chunks touched by one hyperslab makes later reads decompress the same
+ * chunks again. The planner enlarges the per-variable chunk cache of a
+ * netcdf-id to the chunks of the largest hyperslab read, within a budget
+ * shared by all variables and netcdf-ids of the file, and estimates the
+ * amount of decompressed data from a model of the cache.
+ */
+class NcReadPlanner
+{
+public:
+    NcReadPlanner();
+    ~NcReadPlanner();
+
+    /// layout of a variable, to be called while holding the netcdf-id, e.g. with NcReadLock
+    NcChunkLayout layout(int ncId, int varId);
+    /// prepare reading a hyperslab, to be called while holding the netcdf-id, e.g. with NcReadLock
+    void prepareRead(int ncId, int varId, const size_t* start, const size_t* count);
+    /// log requested and decompressed bytes of all chunked variables read
+    void logStatistics(const std::string& filename) const;
+
+    NcReadPlanner(const NcReadPlanner&) = delete;
+    NcReadPlanner& operator=(const NcReadPlanner&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> p_;
+};
+
 /// storage class for netcdf-file pointer
 class Nc {
 public:
     Nc();
     ~Nc();
-    static OmpMutex& getMutex(); // lock against common reading/writing in nc4
+    static SharedMutex& getMutex(); // lock against common reading/writing in nc4
     std::string filename;
     int ncId;
     int format;
     bool isOpen;
+    bool writeable;
     pid_t pid;
     void reopen_if_forked();
     bool supports_nc_string() const
       { return format == NC_FORMAT_NETCDF4; }
+
+    /// lock for in-memory data of the variables read from this file, shared by readers
+    SharedMutex dataMutex;
+
+    /// chunk-cache sizing and read statistics of the variables of this file
+    NcReadPlanner readPlanner;
+
+    /**
+     * Get a read-only netcdf-id of this file for exclusive use by the caller,
+     * opening an additional handle if all handles are busy. Only useful with
+     * a thread-safe netcdf/hdf5 library.
+     */
+    int acquireReadId();
+    /// give back a netcdf-id received from acquireReadId
+    void releaseReadId(int id);
+
+private:
+    void closeReadIds();
+
+    SharedMutex readIdsMutex;
+    std::vector<int> readIds;     // all additional read-only handles
+    std::vector<int> idleReadIds; // additional read-only handles currently not in use
+};
+
+/**
+ * Scoped access to a netcdf-id for reading. Usually, this holds the global
+ * Nc::getMutex(). If HAVE_NETCDF_THREADSAFE is defined and the file is not
+ * opened for writing, it uses a handle from a pool of re-opened read-only
+ * handles instead, so that different files and different threads
+ * on the same file are read (and decompressed) concurrently.
+ */
+class NcReadLock {
+public:
+    explicit NcReadLock(Nc& nc);
+    ~NcReadLock();
+    int ncId() const { return ncId_; }
+
+    NcReadLock(const NcReadLock&) = delete;
+    NcReadLock& operator=(const NcReadLock&) = delete;
+
+private:
+    Nc& nc_;
+    int ncId_;
+    bool pooled_;
 };
 
 
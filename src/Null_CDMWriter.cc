@@ -32,6 +32,7 @@
 #include "fimex/Type2String.h"
 
 #include "MutexLock.h"
+#include "TaskScheduler.h"
 
 #include "fimex_config.h"
 #ifdef HAVE_MPI
@@ -114,16 +115,15 @@ Null_CDMWriter::Null_CDMWriter(const CDMReader_p cdmReader, const std::string& o
     // write data
     const CDMDimension* unLimDim = cdm.getUnlimitedDim();
     const long long maxUnLim = (unLimDim ? unLimDim->getLength() : 0);
-#ifdef _OPENMP
-#pragma omp parallel for default(shared)
-#endif
-    for (long long unLimDimPos = -1; unLimDimPos < maxUnLim; ++unLimDimPos) {
+    // unLimDimPos = -1 for variables without unlimited dimension
+    parallelFor(maxUnLim + 1, [&](size_t i) {
+        const long long unLimDimPos = static_cast<long long>(i) - 1;
 #ifdef HAVE_MPI
         if (mifi_mpi_initialized()) {
             // only work on variables which belong to this mpi-process (modulo-base)
             if ((unLimDimPos % mifi_mpi_size) != mifi_mpi_rank) {
                 LOG4FIMEX(logger, Logger::DEBUG, "processor " << mifi_mpi_rank << " skipping on unLimDimPos " << unLimDimPos);
-                continue;
+                return;
             } else {
                 LOG4FIMEX(logger, Logger::DEBUG, "processor " << mifi_mpi_rank << " working on unLimDimPos " << unLimDimPos);
             }
@@ -143,7 +143,7 @@ Null_CDMWriter::Null_CDMWriter(const CDMReader_p cdmReader, const std::string& o
                 throw CDMException("problems writing data to var " + cdmVar.getName() + ": " + ", datalength: " + type2string(data->size()));
             }
         }
-    }
+    }, TASK_STAGE_WRITE);
 }
 
 Null_CDMWriter::~Null_CDMWriter()
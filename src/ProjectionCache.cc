@@ -0,0 +1,279 @@
+/*
+ * Fimex, ProjectionCache.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "ProjectionCache.h"
+
+#include "fimex/Logger.h"
+#include "fimex/mifi_constants.h"
+
+#include "TaskScheduler.h"
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace MetNoFimex {
+
+static Logger_p logger = getLogger("fimex.ProjectionCache");
+
+namespace {
+
+// number of values transformed at once, small enough to stay in cache
+const size_t PROJECT_BLOCK_SIZE = 4096;
+// idle projections kept per proj4-string, about one per thread
+const size_t MAX_IDLE_PER_PROJECTION = 16;
+// proj4-strings kept in the cache
+const size_t MAX_CACHED_PROJECTIONS = 64;
+
+/**
+ * Normalize a proj4-string by removing leading, trailing and repeated
+ * whitespace. The order of the parameters is kept, as it is significant
+ * e.g. for repeated parameters or pipelines.
+ */
+std::string normalizeProjString(const std::string& projString)
+{
+    std::istringstream in(projString);
+    std::string normalized, param;
+    while (in >> param) {
+        if (!normalized.empty())
+            normalized += ' ';
+        normalized += param;
+    }
+    return normalized;
+}
+
+/**
+ * Initialize a projection with its own proj context. Cached projections are
+ * used by several threads (one at a time), which is not safe with the shared
+ * default context.
+ */
+projPJ initProjection(const char* projString)
+{
+    projCtx ctx = pj_ctx_alloc();
+    if (!ctx)
+        return 0;
+    projPJ pj = pj_init_plus_ctx(ctx, projString);
+    if (!pj) {
+        const int err = pj_ctx_get_errno(ctx);
+        fprintf(stderr, "Proj error:%d %s", err, pj_strerrno(err));
+        pj_ctx_free(ctx);
+    }
+    return pj;
+}
+
+//! free a projection from initProjection together with its context
+void freeProjection(projPJ pj)
+{
+    projCtx ctx = pj_get_ctx(pj);
+    pj_free(pj);
+    pj_ctx_free(ctx);
+}
+
+struct ProjectionEntry
+{
+    ProjectionEntry()
+        : used(0)
+    {
+    }
+    std::vector<projPJ> idle;
+    size_t used; // projections acquired and not yet released
+};
+
+class ProjectionCache
+{
+public:
+    projPJ acquire(const char* projString);
+    void release(projPJ pj);
+    void clear();
+
+private:
+    void evictUnused();
+
+    std::mutex mutex_;
+    std::map<std::string, ProjectionEntry> entries_;
+    std::map<projPJ, std::string> acquired_; // key of acquired projections
+};
+
+projPJ ProjectionCache::acquire(const char* projString)
+{
+    const std::string key = normalizeProjString(projString);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, ProjectionEntry>::iterator it = entries_.find(key);
+        if (it != entries_.end() && !it->second.idle.empty()) {
+            projPJ pj = it->second.idle.back();
+            it->second.idle.pop_back();
+            it->second.used += 1;
+            acquired_[pj] = key;
+            return pj;
+        }
+    }
+
+    // initialize outside the lock, this is the expensive part
+    projPJ pj = initProjection(projString);
+    if (!pj)
+        return 0;
+    LOG4FIMEX(logger, Logger::DEBUG, "initialized projection '" << key << "'");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.find(key) == entries_.end() && entries_.size() >= MAX_CACHED_PROJECTIONS)
+        evictUnused();
+    entries_[key].used += 1;
+    acquired_[pj] = key;
+    return pj;
+}
+
+void ProjectionCache::release(projPJ pj)
+{
+    if (!pj)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<projPJ, std::string>::iterator a = acquired_.find(pj);
+    if (a == acquired_.end()) {
+        freeProjection(pj);
+        return;
+    }
+    ProjectionEntry& entry = entries_[a->second];
+    acquired_.erase(a);
+    entry.used -= 1;
+    if (entry.idle.size() < MAX_IDLE_PER_PROJECTION)
+        entry.idle.push_back(pj);
+    else
+        freeProjection(pj);
+}
+
+void ProjectionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    evictUnused();
+}
+
+void ProjectionCache::evictUnused()
+{
+    for (std::map<std::string, ProjectionEntry>::iterator it = entries_.begin(); it != entries_.end();) {
+        for (projPJ pj : it->second.idle)
+            freeProjection(pj);
+        it->second.idle.clear();
+        if (it->second.used == 0)
+            entries_.erase(it++);
+        else
+            ++it;
+    }
+}
+
+ProjectionCache& projectionCache()
+{
+    // never destroyed, projections might be used during static destruction
+    static ProjectionCache* cache = new ProjectionCache;
+    return *cache;
+}
+
+//! projection acquired from the cache for the lifetime of this object
+class ScopedProjection
+{
+public:
+    explicit ScopedProjection(const char* projString)
+        : pj_(projectionCache().acquire(projString))
+    {
+    }
+    ~ScopedProjection() { projectionCache().release(pj_); }
+    projPJ get() const { return pj_; }
+
+    ScopedProjection(const ScopedProjection&) = delete;
+    ScopedProjection& operator=(const ScopedProjection&) = delete;
+
+private:
+    projPJ pj_;
+};
+
+void scaleValues(double* x, double* y, size_t n, double scale)
+{
+    if (scale == 1)
+        return;
+    for (size_t i = 0; i < n; ++i) {
+        x[i] *= scale;
+        y[i] *= scale;
+    }
+}
+
+} // namespace
+
+} // namespace MetNoFimex
+
+using namespace MetNoFimex;
+
+projPJ mifi_proj_acquire(const char* proj_string)
+{
+    return projectionCache().acquire(proj_string);
+}
+
+void mifi_proj_release(projPJ pj)
+{
+    projectionCache().release(pj);
+}
+
+void mifi_proj_cache_clear(void)
+{
+    projectionCache().clear();
+}
+
+int mifi_project_values_scaled(const char* proj_input, const char* proj_output, double* in_out_x_vals, double* in_out_y_vals, size_t num,
+                               double in_scale, double out_scale)
+{
+    if (num == 0)
+        return MIFI_OK;
+    if (normalizeProjString(proj_input) == normalizeProjString(proj_output)) {
+        scaleValues(in_out_x_vals, in_out_y_vals, num, in_scale * out_scale);
+        return MIFI_OK;
+    }
+
+    std::atomic<int> status(MIFI_OK);
+    parallelForRange(num, PROJECT_BLOCK_SIZE, [&](size_t begin, size_t end) {
+        if (status != MIFI_OK)
+            return;
+        ScopedProjection inputPJ(proj_input), outputPJ(proj_output);
+        if (!inputPJ.get() || !outputPJ.get()) {
+            status = MIFI_ERROR;
+            return;
+        }
+
+        const size_t n = end - begin;
+        double* x = in_out_x_vals + begin;
+        double* y = in_out_y_vals + begin;
+        scaleValues(x, y, n, in_scale);
+        // z currently of no interest, no height attached to values
+        std::vector<double> z(n, 0.);
+        const int err = pj_transform(inputPJ.get(), outputPJ.get(), static_cast<long>(n), 0, x, y, &z[0]);
+        if (err != 0) {
+            fprintf(stderr, "Proj error:%d %s", err, pj_strerrno(err));
+            status = MIFI_ERROR;
+            return;
+        }
+        scaleValues(x, y, n, out_scale);
+    });
+    return status;
+}
@@ -0,0 +1,85 @@
+/*
+ * Fimex, ProjectionCache.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef PROJECTIONCACHE_H_
+#define PROJECTIONCACHE_H_
+
+#ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
+#define ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
+#endif
+
+#include "proj_api.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Get an initialized projection for a proj4-string. Projections are kept in a
+ * thread-safe cache, keyed by the proj4-string with normalized whitespace, so
+ * that proj4 initializes each projection only once per thread. Each projection
+ * has its own proj context, so different projections can be used concurrently.
+ *
+ * A projection is used exclusively by the caller until it is given back with
+ * mifi_proj_release, and must not be freed with pj_free.
+ *
+ * @param proj_string proj4-string
+ * @return the projection, or NULL if proj4 cannot initialize it
+ */
+extern projPJ mifi_proj_acquire(const char* proj_string);
+
+/**
+ * Give back a projection received from mifi_proj_acquire.
+ */
+extern void mifi_proj_release(projPJ pj);
+
+/**
+ * Remove all unused projections from the cache.
+ */
+extern void mifi_proj_cache_clear(void);
+
+/**
+ * @brief transform values between two projections, with unit conversion
+ *
+ * The values are multiplied by in_scale before, and by out_scale after the
+ * projection, e.g. for conversion between degree and radian, in the same pass
+ * over blocks of the arrays. Large arrays are transformed in parallel.
+ *
+ * @param proj_input input projection proj string
+ * @param proj_output output projection proj string
+ * @param in_out_x_vals x-values, will be input and output
+ * @param in_out_y_vals y-values, will be input and output
+ * @param num size of arrays
+ * @param in_scale factor applied to the input values
+ * @param out_scale factor applied to the output values
+ * @return error-code
+ */
+extern int mifi_project_values_scaled(const char* proj_input, const char* proj_output, double* in_out_x_vals, double* in_out_y_vals, size_t num,
+                                      double in_scale, double out_scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROJECTIONCACHE_H_ */
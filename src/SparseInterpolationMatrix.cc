@@ -0,0 +1,132 @@
+/*
+ * Fimex, SparseInterpolationMatrix.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "fimex/SparseInterpolationMatrix.h"
+
+#include "fimex/CDMException.h"
+#include "fimex/MathUtils.h"
+#include "fimex/Type2String.h"
+#include "fimex/mifi_constants.h"
+
+#include "TaskScheduler.h"
+
+#include <limits>
+
+namespace MetNoFimex {
+
+namespace {
+
+// output points calculated at once for all z-levels, the weights of a tile stay in cache
+const size_t SPARSE_TILE_SIZE = 1024;
+
+template <bool SKIP_MISSING, bool NORMALIZE>
+void applyRows(const uint64_t* rowStart, const uint32_t* columns, const float* weights, const float* in, float* out, size_t begin, size_t end)
+{
+    for (size_t r = begin; r < end; ++r) {
+        float value = 0, weightSum = 0;
+        bool used = false;
+        for (uint64_t e = rowStart[r]; e < rowStart[r + 1]; ++e) {
+            const float v = in[columns[e]];
+            if (SKIP_MISSING && mifi_isnan(v))
+                continue;
+            value += weights[e] * v;
+            if (NORMALIZE)
+                weightSum += weights[e];
+            used = true;
+        }
+        if (!used)
+            out[r] = MIFI_UNDEFINED_F;
+        else if (NORMALIZE)
+            out[r] = value / weightSum;
+        else
+            out[r] = value;
+    }
+}
+
+} // namespace
+
+SparseInterpolationMatrix::SparseInterpolationMatrix(size_t inSize, int flags)
+    : inSize_(inSize)
+    , flags_(flags)
+    , rowStart_(1, 0)
+{
+    if (inSize_ > std::numeric_limits<uint32_t>::max())
+        throw CDMException("sparse interpolation matrix input too large: " + type2string(inSize_));
+}
+
+SparseInterpolationMatrix::SparseInterpolationMatrix(size_t inSize, int flags, const std::vector<uint64_t>& rowStart, const std::vector<uint32_t>& columns,
+                                                     const std::vector<float>& weights)
+    : inSize_(inSize)
+    , flags_(flags)
+    , rowStart_(rowStart)
+    , columns_(columns)
+    , weights_(weights)
+{
+    if (inSize_ > std::numeric_limits<uint32_t>::max())
+        throw CDMException("sparse interpolation matrix input too large: " + type2string(inSize_));
+    if (rowStart_.empty() || rowStart_.front() != 0 || rowStart_.back() != columns_.size() || columns_.size() != weights_.size())
+        throw CDMException("sparse interpolation matrix has inconsistent size");
+    for (size_t r = 1; r < rowStart_.size(); ++r) {
+        if (rowStart_[r] < rowStart_[r - 1])
+            throw CDMException("sparse interpolation matrix has decreasing row start");
+    }
+    for (uint32_t c : columns_) {
+        if (c >= inSize_)
+            throw CDMException("sparse interpolation matrix has input position out of range: " + type2string(c));
+    }
+}
+
+void SparseInterpolationMatrix::addWeight(size_t in, float weight)
+{
+    if (in >= inSize_)
+        throw CDMException("sparse interpolation matrix input position out of range: " + type2string(in));
+    columns_.push_back(static_cast<uint32_t>(in));
+    weights_.push_back(weight);
+}
+
+void SparseInterpolationMatrix::endRow()
+{
+    rowStart_.push_back(columns_.size());
+}
+
+void SparseInterpolationMatrix::apply(const float* in, size_t inZ, float* out) const
+{
+    const size_t outSize = rows();
+    void (*applyFunc)(const uint64_t*, const uint32_t*, const float*, const float*, float*, size_t, size_t);
+    switch (flags_ & (SKIP_MISSING | NORMALIZE)) {
+    case SKIP_MISSING | NORMALIZE: applyFunc = applyRows<true, true>; break;
+    case SKIP_MISSING: applyFunc = applyRows<true, false>; break;
+    case NORMALIZE: applyFunc = applyRows<false, true>; break;
+    default: applyFunc = applyRows<false, false>; break;
+    }
+
+    parallelForRange(
+        outSize, SPARSE_TILE_SIZE,
+        [&](size_t begin, size_t end) {
+            for (size_t z = 0; z < inZ; ++z)
+                applyFunc(&rowStart_[0], columns_.data(), weights_.data(), in + z * inSize_, out + z * outSize, begin, end);
+        },
+        TASK_STAGE_INTERPOLATE);
+}
+
+} // namespace MetNoFimex
@@ -0,0 +1,219 @@
+/*
+ * Fimex, TaskScheduler.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "TaskScheduler.h"
+
+#include "fimex/ThreadPool.h"
+#include "fimex/mifi_constants.h"
+
+#include "MutexLock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace MetNoFimex {
+
+namespace {
+
+std::atomic<size_t> stageThreads[TASK_STAGE_COUNT];
+
+//! chunks of a loop, taken by the workers in order
+class ChunkQueue
+{
+public:
+    ChunkQueue(size_t n, size_t grain, const std::function<void(size_t, size_t)>& func)
+        : n_(n)
+        , grain_(grain)
+        , chunks_((n + grain - 1) / grain)
+        , func_(func)
+        , next_(0)
+        , failed_(false)
+    {
+    }
+
+    size_t chunks() const { return chunks_; }
+
+    //! process chunks until none are left
+    void work()
+    {
+        for (size_t c = next_++; c < chunks_ && !failed_; c = next_++) {
+            try {
+                func_(c * grain_, std::min(n_, (c + 1) * grain_));
+            } catch (...) {
+                // exceptions must not leave an openmp task
+                OmpScopedLock lock(errorMutex_);
+                if (!error_)
+                    error_ = std::current_exception();
+                failed_ = true;
+            }
+        }
+    }
+
+    void rethrow()
+    {
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+private:
+    const size_t n_;
+    const size_t grain_;
+    const size_t chunks_;
+    const std::function<void(size_t, size_t)>& func_;
+    std::atomic<size_t> next_;
+    std::atomic<bool> failed_;
+    OmpMutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+//! run queue.work() in parallel by up to workers threads, including the calling thread
+void runWorkers(ChunkQueue& queue, size_t workers)
+{
+#ifdef _OPENMP
+    if (omp_in_parallel()) {
+        // nested, the idle threads of the current team take the tasks
+        for (size_t w = 1; w < workers; ++w) {
+#pragma omp task default(shared)
+            queue.work();
+        }
+        queue.work();
+#pragma omp taskwait
+    } else {
+#pragma omp parallel num_threads(static_cast<int>(workers)) default(shared)
+#pragma omp single
+        {
+            for (size_t w = 1; w < workers; ++w) {
+#pragma omp task default(shared)
+                queue.work();
+            }
+            queue.work();
+#pragma omp taskwait
+        }
+    }
+#else
+    (void)workers;
+    queue.work();
+#endif
+}
+
+} // namespace
+
+void setTaskStageThreads(TaskStage stage, size_t n)
+{
+    stageThreads[stage] = n;
+}
+
+size_t getTaskStageThreads(TaskStage stage)
+{
+    return stageThreads[stage];
+}
+
+size_t taskThreads(TaskStage stage)
+{
+#ifdef _OPENMP
+    // inside a parallel region, work can only be shared within the current team
+    size_t threads = omp_in_parallel() ? omp_get_num_threads() : omp_get_max_threads();
+#else
+    size_t threads = 1;
+#endif
+    const size_t limit = stageThreads[stage];
+    if (limit > 0)
+        threads = std::min(threads, limit);
+    return std::max(threads, size_t(1));
+}
+
+void parallelForRange(size_t n, size_t grain, const std::function<void(size_t, size_t)>& func, TaskStage stage)
+{
+    if (n == 0)
+        return;
+    ChunkQueue queue(n, std::max(grain, size_t(1)), func);
+    const size_t workers = std::min(queue.chunks(), taskThreads(stage));
+    if (workers <= 1)
+        queue.work();
+    else
+        runWorkers(queue, workers);
+    queue.rethrow();
+}
+
+void parallelFor(size_t n, const std::function<void(size_t)>& func, TaskStage stage)
+{
+    parallelForRange(
+        n, 1,
+        [&func](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                func(i);
+        },
+        stage);
+}
+
+TaskGroup::TaskGroup(TaskStage stage)
+    : stage_(stage)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::run(const std::function<void()>& task)
+{
+    tasks_.push_back(task);
+}
+
+void TaskGroup::wait()
+{
+    std::vector<std::function<void()>> tasks;
+    tasks.swap(tasks_);
+    parallelFor(tasks.size(), [&tasks](size_t i) { tasks[i](); }, stage_);
+}
+
+} // namespace MetNoFimex
+
+using namespace MetNoFimex;
+
+int mifi_setStageNumThreads(const char* stage, int n)
+{
+    if (stage == 0 || n < 0)
+        return MIFI_ERROR;
+    TaskStage s;
+    if (std::strcmp(stage, "read") == 0)
+        s = TASK_STAGE_READ;
+    else if (std::strcmp(stage, "interpolate") == 0)
+        s = TASK_STAGE_INTERPOLATE;
+    else if (std::strcmp(stage, "write") == 0)
+        s = TASK_STAGE_WRITE;
+    else
+        return MIFI_ERROR;
+    setTaskStageThreads(s, n);
+    return MIFI_OK;
+}
@@ -0,0 +1,113 @@
+/*
+ * Fimex, TaskScheduler.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef FIMEX_TASKSCHEDULER_H_
+#define FIMEX_TASKSCHEDULER_H_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace MetNoFimex {
+
+/*
+ * Library-wide parallel loops and task groups.
+ *
+ * All parallel work of the library runs in one team of OpenMP threads, limited
+ * by the global thread budget set with mifi_setNumThreads. The outermost
+ * parallelFor starts the team, nested calls (e.g. an interpolator called from a
+ * parallel writer) submit their work as tasks to the same team. Idle threads
+ * take these tasks, so nested parallelism neither oversubscribes the cores nor
+ * runs serially.
+ *
+ * The work of a loop is split into chunks, which are taken by at most
+ * getTaskStageThreads(stage) workers. Exceptions thrown by the loop body are
+ * rethrown in the calling thread after all workers have finished.
+ *
+ * Do not call these functions while holding a lock: the waiting thread
+ * may run other tasks, which might need the same mutex.
+ *
+ * Without OpenMP, all work runs in the calling thread.
+ */
+
+//! stages of the processing chain with separate thread limits
+enum TaskStage {
+    TASK_STAGE_DEFAULT,
+    TASK_STAGE_READ,        //!< reading and decoding input data
+    TASK_STAGE_INTERPOLATE, //!< horizontal, vertical and time interpolation
+    TASK_STAGE_WRITE,       //!< writing output, usually driving the other stages
+    TASK_STAGE_COUNT
+};
+
+/**
+ * Limit the number of threads working on one loop of a stage.
+ * @param n maximum number of threads, 0 for the global thread budget
+ */
+void setTaskStageThreads(TaskStage stage, size_t n);
+
+//! @return the thread limit of the stage, 0 for the global thread budget
+size_t getTaskStageThreads(TaskStage stage);
+
+//! @return the number of threads available for a loop of the stage in the current context
+size_t taskThreads(TaskStage stage = TASK_STAGE_DEFAULT);
+
+/**
+ * Call func(begin, end) for consecutive ranges of at most grain elements covering [0, n).
+ */
+void parallelForRange(size_t n, size_t grain, const std::function<void(size_t, size_t)>& func, TaskStage stage = TASK_STAGE_DEFAULT);
+
+/**
+ * Call func(i) for all i in [0, n), distributing single elements dynamically.
+ */
+void parallelFor(size_t n, const std::function<void(size_t)>& func, TaskStage stage = TASK_STAGE_DEFAULT);
+
+/**
+ * Group of independent tasks, run in parallel by wait().
+ *
+ * A task group must be used by one thread only. Tasks may use their own task
+ * groups and parallel loops.
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(TaskStage stage = TASK_STAGE_DEFAULT);
+    //! runs remaining tasks, but discards their exceptions
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    //! add a task
+    void run(const std::function<void()>& task);
+
+    //! run all tasks added since the last wait, rethrowing the first exception
+    void wait();
+
+private:
+    TaskStage stage_;
+    std::vector<std::function<void()>> tasks_;
+};
+
+} // namespace MetNoFimex
+
+#endif /* FIMEX_TASKSCHEDULER_H_ */
@@ -97,6 +97,36 @@ void handleUdUnitError(int unitErrCode, const std::string& message)
     }
 }
 
+namespace {
+template <typename T>
+void convertValues(UnitsConverter& conv, const T* from, T* to, size_t n, T fillValue)
+{
+    for (size_t i = 0; i < n; ++i) {
+        to[i] = (from[i] == fillValue || std::isnan(from[i])) ? from[i] : conv.convert(from[i]);
+    }
+}
+
+template <typename T>
+void convertLinear(double scale, double offset, const T* from, T* to, size_t n, T fillValue)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const T f = from[i];
+        // nan stays nan
+        to[i] = (f == fillValue) ? f : static_cast<T>(scale * f + offset);
+    }
+}
+} // namespace
+
+void UnitsConverter::convert(const double* from, double* to, size_t n, double fillValue)
+{
+    convertValues(*this, from, to, n, fillValue);
+}
+
+void UnitsConverter::convert(const float* from, float* to, size_t n, float fillValue)
+{
+    convertValues(*this, from, to, n, fillValue);
+}
+
 class LinearUnitsConverter : public UnitsConverter{
     double dscale_;
     double doffset_;
@@ -114,6 +144,8 @@ public:
     ~LinearUnitsConverter() {}
     double convert(double from) override { return dscale_ * from + doffset_; }
     float convert(float from) override { return fscale_ * from + foffset_; }
+    void convert(const double* from, double* to, size_t n, double fillValue) override { convertLinear(dscale_, doffset_, from, to, n, fillValue); }
+    void convert(const float* from, float* to, size_t n, float fillValue) override { convertLinear(fscale_, foffset_, from, to, n, fillValue); }
     bool isLinear() override { return true; }
     void getScaleOffset(double& scale, double& offset) override
     {
@@ -146,6 +178,20 @@ public:
         }
         return retval;
     }
+    void convert(const double* from, double* to, size_t n, double fillValue) override
+    {
+#pragma omp critical(cv_converter)
+        {
+            convertRuns(from, to, n, fillValue, &cv_convert_doubles);
+        }
+    }
+    void convert(const float* from, float* to, size_t n, float fillValue) override
+    {
+#pragma omp critical(cv_converter)
+        {
+            convertRuns(from, to, n, fillValue, &cv_convert_floats);
+        }
+    }
     bool isLinear() override
     {
         // check some points
@@ -185,6 +231,26 @@ public:
             }
         }
     }
+
+private:
+    //! convert all consecutive runs of defined values with one call each, skipping fill values and nan
+    template <typename T, typename F>
+    void convertRuns(const T* from, T* to, size_t n, T fillValue, F cvConvert)
+    {
+        size_t i = 0;
+        while (i < n) {
+            if (from[i] == fillValue || std::isnan(from[i])) {
+                to[i] = from[i];
+                ++i;
+                continue;
+            }
+            size_t end = i + 1;
+            while (end < n && !(from[end] == fillValue || std::isnan(from[end])))
+                ++end;
+            cvConvert(conv_, from + i, end - i, to + i);
+            i = end;
+        }
+    }
 };
 #endif
 
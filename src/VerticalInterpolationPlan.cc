@@ -0,0 +1,175 @@
+/*
+ * Fimex, VerticalInterpolationPlan.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "VerticalInterpolationPlan.h"
+
+#include "fimex/FindNeighborElements.h"
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace MetNoFimex {
+
+int verticalProfileOrder(const float* profile, size_t n)
+{
+    if (n < 2)
+        return 0;
+    size_t i = 1;
+    if (profile[0] < profile[1]) {
+        while (i < n && profile[i - 1] < profile[i])
+            i += 1;
+        return (i == n) ? 1 : 0;
+    } else {
+        while (i < n && profile[i - 1] > profile[i])
+            i += 1;
+        return (i == n) ? -1 : 0;
+    }
+}
+
+std::pair<size_t, size_t> findVerticalNeighbors(const float* profile, size_t n, int order, float x)
+{
+    if (order == 0 || !std::isfinite(x))
+        return find_closest_neighbor_distinct_elements(profile, profile + n, x);
+
+    // find_closest_neighbor_distinct_elements picks the first of several
+    // levels with the same (rounded) distance to x
+    size_t low, high;
+    if (order > 0) {
+        high = std::upper_bound(profile, profile + n, x) - profile;
+        if (high == 0 || high == n)
+            return find_closest_distinct_elements(profile, profile + n, x); // extrapolating
+        low = high - 1;
+        while (low > 0 && (x - profile[low - 1]) == (x - profile[low]))
+            low -= 1;
+    } else {
+        low = std::lower_bound(profile, profile + n, x, std::greater<float>()) - profile;
+        if (low == 0 || low == n)
+            return find_closest_distinct_elements(profile, profile + n, x); // extrapolating
+        high = low - 1;
+        while (high > 0 && (x - profile[high - 1]) == (x - profile[high]))
+            high -= 1;
+    }
+    return std::make_pair(low, high);
+}
+
+namespace {
+//! weight as in mifi_get_values_linear_f
+float linearWeight(double a, double b, double x)
+{
+    return (a == b) ? 0 : static_cast<float>((x - a) / (b - a));
+}
+
+//! weight as in mifi_get_values_linear_conf_extrapol_f
+float limitedLinearWeight(float leftLimit, float rightLimit, double a, double b, double x)
+{
+    const float f = linearWeight(a, b, x);
+    if (f == 0 || f == 1 || ((f >= leftLimit) && (f <= rightLimit)))
+        return f;
+    return MIFI_UNDEFINED_F;
+}
+} // namespace
+
+float verticalInterpolationWeight(mifi_vertical_interpol_method method, double a, double b, double x)
+{
+    switch (method) {
+    case MIFI_VINT_METHOD_NN:
+        return 0;
+    case MIFI_VINT_METHOD_LIN:
+        return linearWeight(a, b, x);
+    case MIFI_VINT_METHOD_LIN_WEAK_EXTRA:
+        return limitedLinearWeight(-1, 2, a, b, x);
+    case MIFI_VINT_METHOD_LIN_NO_EXTRA:
+        return limitedLinearWeight(0, 1, a, b, x);
+    case MIFI_VINT_METHOD_LIN_CONST_EXTRA: {
+        const float f = linearWeight(a, b, x);
+        if (f >= 1)
+            return 1;
+        if (f <= 0)
+            return 0;
+        return f;
+    }
+    case MIFI_VINT_METHOD_LOGLOG:
+        if (a <= 0 || b <= 0 || x <= 0)
+            return MIFI_UNDEFINED_F;
+        // add M_E to make sure that the log remains positive
+        a = std::log(a + M_E);
+        b = std::log(b + M_E);
+        x = std::log(x + M_E);
+        // fall through
+    case MIFI_VINT_METHOD_LOG:
+        if (a <= 0 || b <= 0 || x <= 0)
+            return MIFI_UNDEFINED_F;
+        return linearWeight(std::log(a), std::log(b), std::log(x));
+    }
+    return MIFI_UNDEFINED_F;
+}
+
+VerticalInterpolationPlan::VerticalInterpolationPlan(size_t columns, size_t nzo, size_t idataZdelta, size_t odataZdelta)
+    : nzo_(nzo)
+    , idataZdelta_(idataZdelta)
+    , odataZdelta_(odataZdelta)
+    , inBase_(columns)
+    , outBase_(columns)
+    , level0_(columns * nzo)
+    , level1_(columns * nzo)
+    , weight_(columns * nzo)
+{
+}
+
+void VerticalInterpolationPlan::setUndefined(size_t column, size_t k)
+{
+    // any valid level, nan-weight gives nan
+    setLevel(column, k, 0, 0, MIFI_UNDEFINED_F);
+}
+
+void VerticalInterpolationPlan::apply(const float* in, float* out) const
+{
+    const size_t nc = columns();
+    if (nc == 0)
+        return;
+    parallelFor(
+        nzo_,
+        [&](size_t k) {
+            const unsigned int* l0 = &level0_[k * nc];
+            const unsigned int* l1 = &level1_[k * nc];
+            const float* w = &weight_[k * nc];
+            const size_t ok = k * odataZdelta_;
+            for (size_t c = 0; c < nc; c++) {
+                const float a = in[inBase_[c] + l0[c] * idataZdelta_];
+                const float b = in[inBase_[c] + l1[c] * idataZdelta_];
+                // same as mifi_get_values_linear_f, no side-effects of nan for w == 0 or w == 1
+                out[outBase_[c] + ok] = (w[c] == 0) ? a : ((w[c] == 1) ? b : a + w[c] * (b - a));
+            }
+        },
+        TASK_STAGE_INTERPOLATE);
+}
+
+size_t VerticalInterpolationPlan::bytes() const
+{
+    return inBase_.size() * 2 * sizeof(size_t) + weight_.size() * (2 * sizeof(unsigned int) + sizeof(float));
+}
+
+} // namespace MetNoFimex
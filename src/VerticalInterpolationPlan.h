@@ -0,0 +1,123 @@
+/*
+ * Fimex, VerticalInterpolationPlan.h
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef FIMEX_VERTICALINTERPOLATIONPLAN_H_
+#define FIMEX_VERTICALINTERPOLATIONPLAN_H_
+
+#include "fimex/mifi_constants.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace MetNoFimex {
+
+/**
+ * @return 1 if the profile is strictly increasing, -1 if strictly decreasing, 0 otherwise
+ */
+int verticalProfileOrder(const float* profile, size_t n);
+
+/**
+ * Find the levels next to x, with the same result as
+ * find_closest_neighbor_distinct_elements(profile, profile+n, x), but
+ * using binary search for strictly monotonic profiles.
+ *
+ * @param order result of verticalProfileOrder(profile, n)
+ */
+std::pair<size_t, size_t> findVerticalNeighbors(const float* profile, size_t n, int order, float x);
+
+/**
+ * Weight w for interpolating values A at level a and B at level b to level x
+ * as A + w * (B - A), with the same result as the mifi_get_values_*_f function
+ * of the method. w is 0 or 1 when A or B should be used unchanged, and
+ * nan if the value is undefined.
+ */
+float verticalInterpolationWeight(mifi_vertical_interpol_method method, double a, double b, double x);
+
+/**
+ * Vertical interpolation of all columns of a data-slice, prepared from the
+ * vertical coordinates only. A plan can be applied to all variables with the
+ * same vertical coordinates and the same array layout.
+ */
+class VerticalInterpolationPlan
+{
+public:
+    /**
+     * @param columns number of columns in the slice
+     * @param nzo number of output levels
+     * @param idataZdelta distance between levels in the input data
+     * @param odataZdelta distance between levels in the output data
+     */
+    VerticalInterpolationPlan(size_t columns, size_t nzo, size_t idataZdelta, size_t odataZdelta);
+
+    size_t columns() const { return inBase_.size(); }
+    size_t levels() const { return nzo_; }
+
+    //! set position of level 0 of a column in the input and output data
+    void setColumn(size_t column, size_t inBase, size_t outBase)
+    {
+        inBase_[column] = inBase;
+        outBase_[column] = outBase;
+    }
+
+    //! interpolate output level k of a column from the input levels level0 and level1
+    void setLevel(size_t column, size_t k, size_t level0, size_t level1, float weight)
+    {
+        const size_t i = k * columns() + column;
+        level0_[i] = static_cast<unsigned int>(level0);
+        level1_[i] = static_cast<unsigned int>(level1);
+        weight_[i] = weight;
+    }
+
+    //! output level k of a column is undefined
+    void setUndefined(size_t column, size_t k);
+
+    /**
+     * Interpolate the input data.
+     * @param in input data, with nan as undefined
+     * @param out output data
+     */
+    void apply(const float* in, float* out) const;
+
+    //! memory used by the plan
+    size_t bytes() const;
+
+private:
+    size_t nzo_;
+    size_t idataZdelta_;
+    size_t odataZdelta_;
+    std::vector<size_t> inBase_;
+    std::vector<size_t> outBase_;
+    // indexed by k * columns + column
+    std::vector<unsigned int> level0_;
+    std::vector<unsigned int> level1_;
+    std::vector<float> weight_;
+};
+
+typedef std::shared_ptr<VerticalInterpolationPlan> VerticalInterpolationPlan_p;
+typedef std::shared_ptr<const VerticalInterpolationPlan> VerticalInterpolationPlan_cp;
+
+} // namespace MetNoFimex
+
+#endif /* FIMEX_VERTICALINTERPOLATIONPLAN_H_ */
@@ -22,6 +22,7 @@
  */
 
 #include "fimex/CDM.h"
+#include "fimex/CDMCachingReader.h"
 #include "fimex/CDMException.h"
 #include "fimex/CDMExtractor.h"
 #include "fimex/CDMFileReaderFactory.h"
@@ -91,6 +92,7 @@ const po::option op_input_optional = po::option("input.optional", "additional op
 const po::option op_input_printNcML = po::option("input.printNcML", "print NcML description of input").set_implicit_value("-");
 const po::option op_input_printCS = po::option("input.printCS", "print CoordinateSystems of input file").set_narg(0);
 const po::option op_input_printSize = po::option("input.printSize", "print size estimate").set_narg(0);
+const po::option op_cache_size = po::option("cache.size", "keep up to this many MB of recently read input slices in memory");
 const po::option op_output_file = po::option("output.file", "output file");
 const po::option op_output_fillFile = po::option("output.fillFile", "existing output file to be filled");
 const po::option op_output_type = po::option("output.type", "filetype of output file, e.g. nc, nc4, grib1, grib2");
@@ -154,7 +156,7 @@ const po::option op_qualityExtract_printNcML = po::option("qualityExtract.printN
 const po::option op_qualityExtract_printCS = po::option("qualityExtract.printCS", "print CoordinateSystems of extractor").set_narg(0);
 const po::option op_qualityExtract_printSize = po::option("qualityExtract.printSize", "print size estimate").set_narg(0);
 const po::option op_interpolate_projString = po::option("interpolate.projString", "proj4 input string describing the new projection");
-const po::option op_interpolate_method = po::option("interpolate.method", "interpolation method, one of nearestneighbor, bilinear, bicubic, coord_nearestneighbor, coord_kdtree, forward_max, forward_min, forward_mean, forward_median, forward_sum or forward_undef_*");
+const po::option op_interpolate_method = po::option("interpolate.method", "interpolation method, one of nearestneighbor, bilinear, bicubic, coord_nearestneighbor, coord_kdtree, forward_max, forward_min, forward_mean, forward_median, forward_sum, forward_undef_* or conservative");
 const po::option op_interpolate_xAxisValues = po::option("interpolate.xAxisValues", "string with values on x-Axis, use ... to continue, i.e. 10.5,11,...,29.5, see Fimex::SpatialAxisSpec for full definition");
 const po::option op_interpolate_yAxisValues = po::option("interpolate.yAxisValues", "string with values on x-Axis, use ... to continue, i.e. 10.5,11,...,29.5, see Fimex::SpatialAxisSpec for full definition");
 const po::option op_interpolate_xAxisUnit = po::option("interpolate.xAxisUnit", "unit of x-Axis given as udunits string, i.e. m or degrees_east");
@@ -175,6 +177,7 @@ const po::option op_interpolate_longitudeValues = po::option("interpolate.longit
 const po::option op_interpolate_vcrossNames = po::option("interpolate.vcrossNames", "string with comma-separated names for vertical cross sections");
 const po::option op_interpolate_vcrossNoPoints = po::option("interpolate.vcrossNoPoints", "string with comma-separated number of lat/lon values for each vertical cross sections");
 const po::option op_interpolate_template = po::option("interpolate.template", "netcdf file containing lat/lon list used in interpolation");
+const po::option op_interpolate_weightsCache = po::option("interpolate.weightsCache", "existing directory to persistently cache interpolation weights between runs");
 const po::option op_interpolate_printNcML = po::option("interpolate.printNcML", "print NcML description of extractor").set_implicit_value("-");
 const po::option op_interpolate_printCS = po::option("interpolate.printCS", "print CoordinateSystems of interpolator").set_narg(0);
 const po::option op_interpolate_printSize = po::option("interpolate.printSize", "print size estimate").set_narg(0);
@@ -187,7 +190,7 @@ const po::option op_merge_smoothing = po::option("merge.smoothing", "smoothing f
 const po::option op_merge_keepOuterVariables =
     po::option("merge.keepOuterVariables", "keep all outer variables, default: only keep variables existing in inner and outer").set_narg(0);
 const po::option op_merge_method = po::option("merge.method", "interpolation method for grid conversions, one of nearestneighbor, bilinear, bicubic,"
-        " coord_nearestneighbor, coord_kdtree, forward_max, forward_min, forward_mean, forward_median, forward_sum or forward_undef_* (*=max,min,mean,median,sum");
+        " coord_nearestneighbor, coord_kdtree, forward_max, forward_min, forward_mean, forward_median, forward_sum, forward_undef_* (*=max,min,mean,median,sum) or conservative");
 const po::option op_merge_projString = po::option("merge.projString", "proj4 input string describing the new projection, default: use inner projection extended to outer grid");
 const po::option op_merge_xAxisValues = po::option("merge.xAxisValues", "string with values on x-Axis, use ... to continue, i.e. 10.5,11,...,29.5, see Fimex::SpatialAxisSpec for full definition");
 const po::option op_merge_yAxisValues = po::option("merge.yAxisValues", "string with values on x-Axis, use ... to continue, i.e. 10.5,11,...,29.5, see Fimex::SpatialAxisSpec for full definition");
@@ -211,6 +214,7 @@ const po::option op_verticalInterpolate_printNcML = po::option("verticalInterpol
 const po::option op_verticalInterpolate_printCS = po::option("verticalInterpolate.printCS", "print CoordinateSystems of vertical interpolator").set_narg(0);
 const po::option op_verticalInterpolate_printSize = po::option("verticalInterpolate.printSize", "print size estimate").set_narg(0);
 const po::option op_timeInterpolate_timeSpec = po::option("timeInterpolate.timeSpec", "specification of times to interpolate to, see MetNoFimex::TimeSpec for a full definition");
+const po::option op_timeInterpolate_batch = po::option("timeInterpolate.batch", "interpolate all time-steps between two input times at once").set_narg(0);
 const po::option op_timeInterpolate_printNcML = po::option("timeInterpolate.printNcML", "print NcML description of extractor").set_implicit_value("-");
 const po::option op_timeInterpolate_printCS = po::option("timeInterpolate.printCS", "print CoordinateSystems of timeInterpolator").set_narg(0);
 const po::option op_timeInterpolate_printSize = po::option("timeInterpolate.printSize", "print size estimate").set_narg(0);
@@ -235,6 +239,7 @@ void writeUsage(ostream& out, const po::option_set& config)
     out << "             [--input.config CFGFILENAME] [--output.config CFGFILENAME]" << endl;
     out << "             [--input.optional OPT1 --input.optional OPT2 ...]" << endl;
     out << "             [--num_threads ...]" << endl;
+    out << "             [--cache.size MB]" << endl;
     out << "             [--process....]" << endl;
     out << "             [--qualityExtract....]" << endl;
     out << "             [--extract....]" << endl;
@@ -430,6 +435,15 @@ int getInterpolationMethod(const po::value_set& vm, const po::option& opt)
     return method;
 }
 
+CDMReader_p getCDMCachingReader(const po::value_set& vm, CDMReader_p dataReader)
+{
+    if (!vm.is_set(op_cache_size))
+        return dataReader;
+    const double sizeMB = string2type<double>(vm.value(op_cache_size));
+    LOG4FIMEX(logger, Logger::DEBUG, "cache.size found: " << sizeMB << "MB");
+    return std::make_shared<CDMCachingReader>(dataReader, static_cast<size_t>(sizeMB * 1024 * 1024));
+}
+
 CDMReader_p getCDMProcessor(const po::value_set& vm, CDMReader_p dataReader)
 {
     if (!(vm.is_set(op_process_accumulateVariable) || vm.is_set(op_process_deaccumulateVariable) || vm.is_set(op_process_rotateVector_direction) ||
@@ -608,6 +622,7 @@ CDMReader_p getCDMTimeInterpolator(const po::value_set& vm, CDMReader_p dataRead
     LOG4FIMEX(logger, Logger::DEBUG, "timeInterpolate.timeSpec found with spec: " << timeSpec);
     std::shared_ptr<CDMTimeInterpolator> timeInterpolator(new CDMTimeInterpolator(dataReader));
     timeInterpolator->changeTimeAxis(timeSpec);
+    timeInterpolator->setBatchMode(vm.is_set(op_timeInterpolate_batch));
     printReaderStatements("timeInterpolate", vm, timeInterpolator);
 
     return timeInterpolator;
@@ -704,6 +719,9 @@ CDMInterpolator_p createCDMInterpolator(const po::value_set& vm, CDMReader_p dat
     if (getOption(op_interpolate_postprocess, vm, value)) {
         interpolator->addPostprocess(parseProcess(value, "postprocess"));
     }
+    if (getOption(op_interpolate_weightsCache, vm, value)) {
+        interpolator->setWeightsCacheDirectory(value);
+    }
     return interpolator;
 }
 
@@ -851,6 +869,7 @@ CDMReader_p getCDMMerger(const po::value_set& vm, CDMReader_p dataReader)
 
 CDMReader_p applyFimexStreamTasks(const po::value_set& vm, CDMReader_p dataReader)
 {
+    dataReader = getCDMCachingReader(vm, dataReader);
     dataReader = getCDMProcessor(vm, dataReader);
     dataReader = getCDMQualityExtractor("", vm, dataReader);
     dataReader = getCDMExtractor(vm, dataReader);
@@ -907,6 +926,7 @@ int run(int argc, char* args[])
         << op_input_printNcML
         << op_input_printCS
         << op_input_printSize
+        << op_cache_size
         << op_output_file
         << op_output_fillFile
         << op_output_type
@@ -972,6 +992,7 @@ int run(int argc, char* args[])
         << op_interpolate_vcrossNames
         << op_interpolate_vcrossNoPoints
         << op_interpolate_template
+        << op_interpolate_weightsCache
         << op_interpolate_printNcML
         << op_interpolate_printCS
         << op_interpolate_printSize
@@ -1006,6 +1027,7 @@ int run(int argc, char* args[])
         << op_verticalInterpolate_printCS
         << op_verticalInterpolate_printSize
         << op_timeInterpolate_timeSpec
+        << op_timeInterpolate_batch
         << op_timeInterpolate_printNcML
         << op_timeInterpolate_printCS
         << op_timeInterpolate_printSize
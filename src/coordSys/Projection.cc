@@ -30,6 +30,7 @@
 #include <regex>
 
 #include "fimex/interpolation.h"
+#include "ProjectionCache.h"
 
 // list over supported projections
 #include "fimex/CDMException.h"
@@ -83,73 +84,28 @@ void Projection::convertToLonLat(std::vector<double>& xVals, std::vector<double>
     if (xVals.size() == 0) return;
     if (xVals.size() != yVals.size()) throw CDMException("convertToLonLat: xVals.size() != yVals.size()");
 
-    // convert to radian if required
-    if (isDegree()) {
-        std::transform(xVals.begin(),
-                       xVals.end(),
-                       xVals.begin(),
-                       std::bind1st(std::multiplies<double>(), DEG_TO_RAD));
-        std::transform(yVals.begin(),
-                       yVals.end(),
-                       yVals.begin(),
-                       std::bind1st(std::multiplies<double>(), DEG_TO_RAD));
-    }
-
-    // run projection
-    std::string fromProj = getProj4String();
-    std::string toProj = "+proj=latlong " + getProj4EarthString();
-    if (fromProj == toProj) return;
-    if (MIFI_OK != mifi_project_values(fromProj.c_str(), toProj.c_str(), &xVals[0], &yVals[0], static_cast<int>(xVals.size()))) {
+    // run projection, converting to radian if required and back to degree in the same pass
+    const std::string fromProj = getProj4String();
+    const std::string toProj = "+proj=latlong " + getProj4EarthString();
+    const double inScale = isDegree() ? DEG_TO_RAD : 1;
+    if (MIFI_OK != mifi_project_values_scaled(fromProj.c_str(), toProj.c_str(), &xVals[0], &yVals[0], xVals.size(), inScale, RAD_TO_DEG)) {
         throw CDMException("convertToLonLat: unable to convert from '" +fromProj + "' to '"+toProj+"'");
     }
-
-    // convert to degree
-    std::transform(xVals.begin(),
-                   xVals.end(),
-                   xVals.begin(),
-                   std::bind1st(std::multiplies<double>(), RAD_TO_DEG));
-    std::transform(yVals.begin(),
-                   yVals.end(),
-                   yVals.begin(),
-                   std::bind1st(std::multiplies<double>(), RAD_TO_DEG));
-
 }
+
 void Projection::convertFromLonLat(std::vector<double>& xVals, std::vector<double>& yVals) const
 {
     // check input
     if (xVals.size() == 0) return;
     if (xVals.size() != yVals.size()) throw CDMException("convertToLonLat: xVals.size() != yVals.size()");
 
-    // convert to radian
-    std::transform(xVals.begin(),
-                   xVals.end(),
-                   xVals.begin(),
-                   std::bind1st(std::multiplies<double>(), DEG_TO_RAD));
-    std::transform(yVals.begin(),
-                   yVals.end(),
-                   yVals.begin(),
-                   std::bind1st(std::multiplies<double>(), DEG_TO_RAD));
-
-    // run projection
-    std::string fromProj = "+proj=latlong " + getProj4EarthString();
-    std::string toProj = getProj4String();
-    if (fromProj == toProj) return;
-    if (MIFI_OK != mifi_project_values(fromProj.c_str(), toProj.c_str(), &xVals[0], &yVals[0], static_cast<int>(xVals.size()))) {
+    // run projection, converting to radian and back to degree if required in the same pass
+    const std::string fromProj = "+proj=latlong " + getProj4EarthString();
+    const std::string toProj = getProj4String();
+    const double outScale = isDegree() ? RAD_TO_DEG : 1;
+    if (MIFI_OK != mifi_project_values_scaled(fromProj.c_str(), toProj.c_str(), &xVals[0], &yVals[0], xVals.size(), DEG_TO_RAD, outScale)) {
         throw CDMException("convertFromLonLat: unable to convert from '" +fromProj + "' to '"+toProj+"'");
     }
-
-    // convert to degree if required
-    if (isDegree()) {
-        std::transform(xVals.begin(),
-                       xVals.end(),
-                       xVals.begin(),
-                       std::bind1st(std::multiplies<double>(), RAD_TO_DEG));
-        std::transform(yVals.begin(),
-                       yVals.end(),
-                       yVals.begin(),
-                       std::bind1st(std::multiplies<double>(), RAD_TO_DEG));
-    }
-
 }
 
 Projection_p Projection::create(std::vector<CDMAttribute> attrs)
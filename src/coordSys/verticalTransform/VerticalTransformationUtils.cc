@@ -250,12 +250,16 @@ SliceBuilder adaptSliceBuilder(const CDM& cdm, const std::string& varName, const
     return sbVar;
 }
 
+SliceBuilder adaptSliceBuilder(const CDM& cdm, const std::vector<std::string>& shape, const SliceBuilder& sb)
+{
+    SliceBuilder sbShape(shape, getDimSizes(cdm, shape));
+    copySliceBuilder(sbShape, sb);
+    return sbShape;
+}
+
 SliceBuilder adaptSliceBuilder(const CDM& cdm, VerticalConverter_p converter, const SliceBuilder& sb)
 {
-    const string_v& conShape= converter->getShape();
-    SliceBuilder sbCon(conShape, getDimSizes(cdm, conShape));
-    copySliceBuilder(sbCon, sb);
-    return sbCon;
+    return adaptSliceBuilder(cdm, converter->getShape(), sb);
 }
 
 DataPtr getSliceData(CDMReader_p reader, const SliceBuilder& sbOrig, const std::string& varName, const std::string& unit)
@@ -28,6 +28,7 @@
 #endif
 
 #include "proj_api.h"
+#include "ProjectionCache.h"
 #include <string.h>
 #include <stdio.h>
 #ifdef _OPENMP
@@ -101,6 +102,8 @@ int mifi_string_to_interpolation_method(const char* mString)
         method = MIFI_INTERPOL_FORWARD_UNDEF_MAX;
     } else if (mifi_string_equal("forward_undef_min", mString)) {
         method = MIFI_INTERPOL_FORWARD_MIN;
+    } else if (mifi_string_equal("conservative", mString)) {
+        method = MIFI_INTERPOL_CONSERVATIVE;
     }
     return method;
 }
@@ -641,13 +644,11 @@ int mifi_get_vector_reproject_matrix_points(const char* proj_input,
         fprintf(stderr, "output proj: %s\n", proj_output);
     }
 
-    if (!(inputPJ = pj_init_plus(proj_input))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
+    if (!(inputPJ = mifi_proj_acquire(proj_input))) {
         return MIFI_ERROR;
     }
-    if (!(outputPJ = pj_init_plus(proj_output))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        pj_free(inputPJ);
+    if (!(outputPJ = mifi_proj_acquire(proj_output))) {
+        mifi_proj_release(inputPJ);
         return MIFI_ERROR;
     }
 
@@ -677,7 +678,8 @@ int mifi_get_vector_reproject_matrix_points(const char* proj_input,
                 matrix); // 4*on
     }
 
-
+    mifi_proj_release(inputPJ);
+    mifi_proj_release(outputPJ);
     free(in_x_points);
     free(in_y_points);
     free(pointsZ);
@@ -699,13 +701,11 @@ int mifi_get_vector_reproject_matrix_field(const char* proj_input,
         fprintf(stderr, "output proj: %s\n", proj_output);
     }
 
-    if (!(inputPJ = pj_init_plus(proj_input))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
+    if (!(inputPJ = mifi_proj_acquire(proj_input))) {
         return MIFI_ERROR;
     }
-    if (!(outputPJ = pj_init_plus(proj_output))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        pj_free(inputPJ);
+    if (!(outputPJ = mifi_proj_acquire(proj_output))) {
+        mifi_proj_release(inputPJ);
         return MIFI_ERROR;
     }
     double* out_x_field = (double*) malloc(ox*oy*sizeof(double));
@@ -729,8 +729,8 @@ int mifi_get_vector_reproject_matrix_field(const char* proj_input,
         retVal = mifi_get_vector_reproject_matrix_proj(inputPJ, outputPJ, in_x_field, in_y_field, out_x_field, out_y_field, pointsZ, ox, oy, matrix);
 //        fprintf(stderr, "matrix: %e %e %e %e\n", matrix[0], matrix[1], matrix[2], matrix[3]);
     }
-    pj_free(inputPJ);
-    pj_free(outputPJ);
+    mifi_proj_release(inputPJ);
+    mifi_proj_release(outputPJ);
     free(out_x_field);
     free(out_y_field);
     free(pointsZ);
@@ -752,13 +752,11 @@ int mifi_get_vector_reproject_matrix(const char* proj_input,
         fprintf(stderr, "output proj: %s\n", proj_output);
     }
 
-    if (!(inputPJ = pj_init_plus(proj_input))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
+    if (!(inputPJ = mifi_proj_acquire(proj_input))) {
         return MIFI_ERROR;
     }
-    if (!(outputPJ = pj_init_plus(proj_output))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        pj_free(inputPJ);
+    if (!(outputPJ = mifi_proj_acquire(proj_output))) {
+        mifi_proj_release(inputPJ);
         return MIFI_ERROR;
     }
 
@@ -798,8 +796,8 @@ int mifi_get_vector_reproject_matrix(const char* proj_input,
         // start real calc
         retVal = mifi_get_vector_reproject_matrix_proj(inputPJ, outputPJ, in_xproj_axis, in_yproj_axis, out_xproj_axis, out_yproj_axis, pointsZ, ox, oy, matrix);
     }
-    pj_free(inputPJ);
-    pj_free(outputPJ);
+    mifi_proj_release(inputPJ);
+    mifi_proj_release(outputPJ);
     free(in_yproj_axis);
     free(in_xproj_axis);
     free(out_yproj_axis);
@@ -1174,92 +1172,27 @@ int mifi_get_values_log_log_f(const float* infieldA, const float* infieldB, floa
 
 int mifi_project_values(const char* proj_input, const char* proj_output, double* in_out_x_vals, double* in_out_y_vals, const int num)
 {
-    // init projections
-    projPJ inputPJ;
-    projPJ outputPJ;
     if (MIFI_DEBUG > 0) {
         fprintf(stderr, "input proj: %s\n", proj_input);
         fprintf(stderr, "output proj: %s\n", proj_output);
     }
-
-    if (!(inputPJ = pj_init_plus(proj_input))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        return MIFI_ERROR;
-    }
-    if (!(outputPJ = pj_init_plus(proj_output))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        pj_free(inputPJ);
-        return MIFI_ERROR;
-    }
-    // z currently of no interest, no height attached to values
-    double* pointsZ= (double*) calloc(num, sizeof(double));
-    if (pointsZ == NULL) {
-        fprintf(stderr, "memory allocation error");
-        pj_free(inputPJ);
-        pj_free(outputPJ);
-        return MIFI_ERROR;
-    }
-    if (pj_transform(inputPJ, outputPJ, num, 0, in_out_x_vals, in_out_y_vals, pointsZ) != 0) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        pj_free(inputPJ);
-        pj_free(outputPJ);
-        free(pointsZ);
-        return MIFI_ERROR;
-    }
-    pj_free(inputPJ);
-    pj_free(outputPJ);
-    free(pointsZ);
-    return MIFI_OK;
-
+    return mifi_project_values_scaled(proj_input, proj_output, in_out_x_vals, in_out_y_vals, num, 1., 1.);
 }
 
 int mifi_project_axes(const char* proj_input, const char* proj_output, const double* in_x_axis, const double* in_y_axis, const int ix, const int iy,
                       double* out_xproj_axis, double* out_yproj_axis)
 {
-    // init projections
-    projPJ inputPJ;
-    projPJ outputPJ;
     if (MIFI_DEBUG > 0) {
         fprintf(stderr, "input proj: %s\n", proj_input);
         fprintf(stderr, "output proj: %s\n", proj_output);
     }
-
-    if (!(inputPJ = pj_init_plus(proj_input))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        return MIFI_ERROR;
-    }
-    if (!(outputPJ = pj_init_plus(proj_output))) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        pj_free(inputPJ);
-        return MIFI_ERROR;
-    }
-    // z currently of no interest, no height attached to values
-    double* pointsZ= (double*) calloc(ix*iy, sizeof(double));
-    if (pointsZ == NULL) {
-        fprintf(stderr, "memory allocation error");
-        pj_free(inputPJ);
-        pj_free(outputPJ);
-        return MIFI_ERROR;
-    }
     for (int y = 0; y < iy; ++y) {
         for (int x = 0; x < ix; ++x) {
             out_xproj_axis[y*ix +x] = in_x_axis[x];
             out_yproj_axis[y*ix +x] = in_y_axis[y];
         }
     }
-
-    // transforming
-    if (pj_transform(inputPJ, outputPJ, ix*iy, 0, out_xproj_axis, out_yproj_axis, pointsZ) != 0) {
-        fprintf(stderr, "Proj error:%d %s", pj_errno, pj_strerrno(pj_errno));
-        free(pointsZ);
-        pj_free(inputPJ);
-        pj_free(outputPJ);
-        return MIFI_ERROR;
-    }
-    free(pointsZ);
-    pj_free(inputPJ);
-    pj_free(outputPJ);
-    return MIFI_OK;
+    return mifi_project_values_scaled(proj_input, proj_output, out_xproj_axis, out_yproj_axis, (size_t)ix * iy, 1., 1.);
 }
 
 int mifi_fill2d_f(size_t nx, size_t ny, float* field, float relaxCrit, float corrEff, size_t maxLoop, size_t* nChanged) {
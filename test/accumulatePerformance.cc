@@ -0,0 +1,156 @@
+/*
+  Fimex, test/accumulatePerformance.cc
+
+  (C) Copyright 2026, met.no
+
+  Project Info:  https://wiki.met.no/fimex/start
+
+  This library is free software; you can redistribute it and/or modify it
+  under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 2.1 of the License, or
+  (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+  USA.
+*/
+
+/**
+ * Accumulate and de-accumulate variables with CDMProcessor in the order of
+ * the netcdf-writer (time outer, variables inner), and report the number of
+ * slices read from the input and the time used for increasing numbers of
+ * time steps. Both should grow linearly with the number of time steps.
+ *
+ * usage: accumulatePerformance [netcdf-file variable...]
+ *
+ * Without arguments, a generated input with 67 time steps and two variables
+ * of 500x500 values is used.
+ */
+
+#include "fimex/CDM.h"
+#include "fimex/CDMFileReaderFactory.h"
+#include "fimex/CDMProcessor.h"
+#include "fimex/Data.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+//! generated input, v(x,y,time) = time
+class GeneratedReader : public CDMReader
+{
+public:
+    GeneratedReader(const vector<string>& varNames, size_t nx, size_t ny, size_t nt)
+    {
+        cdm_->addDimension(CDMDimension("x", nx));
+        cdm_->addDimension(CDMDimension("y", ny));
+        CDMDimension time("time", nt);
+        time.setUnlimited(true);
+        cdm_->addDimension(time);
+        vector<string> shape;
+        shape.push_back("x");
+        shape.push_back("y");
+        shape.push_back("time");
+        for (const string& v : varNames)
+            cdm_->addVariable(CDMVariable(v, CDM_FLOAT, shape));
+    }
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string&, size_t unLimDimPos) override
+    {
+        const size_t n = cdm_->getDimension("x").getLength() * cdm_->getDimension("y").getLength();
+        shared_array<float> values(new float[n]);
+        for (size_t i = 0; i < n; ++i)
+            values[i] = unLimDimPos;
+        return createData(n, values);
+    }
+};
+
+//! pass-through reader counting the slices read
+class CountingReader : public CDMReader
+{
+public:
+    CountingReader(CDMReader_p dataReader)
+        : reads(0)
+        , dataReader_(dataReader)
+    {
+        *cdm_ = dataReader->getCDM();
+    }
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string& varName, size_t unLimDimPos) override
+    {
+        reads += 1;
+        return dataReader_->getDataSlice(varName, unLimDimPos);
+    }
+    size_t reads;
+
+private:
+    CDMReader_p dataReader_;
+};
+
+void run(CDMReader_p input, const vector<string>& varNames, size_t steps, bool accumulate)
+{
+    std::shared_ptr<CountingReader> counter = std::make_shared<CountingReader>(input);
+    std::shared_ptr<CDMProcessor> proc = std::make_shared<CDMProcessor>(counter);
+    for (const string& v : varNames) {
+        if (accumulate)
+            proc->accumulate(v);
+        else
+            proc->deAccumulate(v);
+    }
+
+    const double start = now();
+    for (size_t t = 0; t < steps; ++t) {
+        for (const string& v : varNames)
+            proc->getDataSlice(v, t);
+    }
+    const double used = now() - start;
+    cout << (accumulate ? "accumulate" : "deaccumulate") << "\t" << steps << "\t" << counter->reads << "\t" << used << endl;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    CDMReader_p input;
+    vector<string> varNames;
+    if (argc > 2) {
+        input = CDMFileReaderFactory::create("netcdf", argv[1]);
+        for (int i = 2; i < argc; ++i)
+            varNames.push_back(argv[i]);
+    } else {
+        varNames.push_back("precipitation_amount_acc");
+        varNames.push_back("integral_of_surface_net_downward_shortwave_flux_wrt_time");
+        input = std::make_shared<GeneratedReader>(varNames, 500, 500, 67);
+    }
+    const CDMDimension* unLimDim = input->getCDM().getUnlimitedDim();
+    if (!unLimDim) {
+        cerr << "input has no unlimited dimension" << endl;
+        return 1;
+    }
+    const size_t nt = unLimDim->getLength();
+
+    cout << "mode\t\tsteps\treads\tseconds" << endl;
+    for (size_t steps = (nt + 3) / 4; steps <= nt; steps *= 2)
+        run(input, varNames, steps, true);
+    run(input, varNames, nt, true);
+    run(input, varNames, nt, false);
+    return 0;
+}
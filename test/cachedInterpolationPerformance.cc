@@ -0,0 +1,123 @@
+/*
+  Fimex, test/cachedInterpolationPerformance.cc
+
+  (C) Copyright 2026, met.no
+
+  Project Info:  https://wiki.met.no/fimex/start
+
+  This library is free software; you can redistribute it and/or modify it
+  under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 2.1 of the License, or
+  (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+  USA.
+*/
+
+/**
+ * Compare CachedInterpolation::interpolateValues, with precomputed offsets and
+ * weights, with the former per-point interpolation through
+ * mifi_get_values_bilinear_f/mifi_get_values_bicubic_f and strided writes of
+ * all z-levels, both for bilinear and bicubic interpolation.
+ *
+ * usage: cachedInterpolationPerformance [outX outY inZ]
+ */
+
+#include "fimex/CachedInterpolation.h"
+#include "fimex/interpolation.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sys/time.h>
+#include <vector>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+typedef int (*InterpolationFunc)(const float* infield, float* outvalues, const double x, const double y, const int ix, const int iy, const int iz);
+
+//! the interpolation loop of CachedInterpolation before the precomputed weights
+void interpolatePerPoint(InterpolationFunc func, const float* inData, float* outData, const vector<double>& pointsOnXAxis,
+                         const vector<double>& pointsOnYAxis, size_t inX, size_t inY, size_t inZ)
+{
+    const size_t outLayerSize = pointsOnXAxis.size();
+    vector<float> zValues(inZ);
+    for (size_t xy = 0; xy < outLayerSize; ++xy) {
+        func(inData, &zValues[0], pointsOnXAxis[xy], pointsOnYAxis[xy], inX, inY, inZ);
+        float* outPos = outData + xy;
+        for (size_t z = 0; z < inZ; ++z) {
+            *outPos = zValues[z];
+            outPos += outLayerSize;
+        }
+    }
+}
+
+void benchmark(const char* name, int method, InterpolationFunc func, size_t outX, size_t outY, size_t inZ)
+{
+    // a rotated and stretched output grid inside a larger input grid
+    const size_t inX = outX + outX / 2, inY = outY + outY / 2;
+    vector<double> pointsOnXAxis, pointsOnYAxis;
+    for (size_t y = 0; y < outY; ++y) {
+        for (size_t x = 0; x < outX; ++x) {
+            pointsOnXAxis.push_back(2.3 + 1.1 * x + 0.2 * y);
+            pointsOnYAxis.push_back(2.7 + 0.1 * x + 1.05 * y);
+        }
+    }
+    const size_t inSize = inX * inY * inZ;
+    shared_array<float> inData(new float[inSize]);
+    for (size_t i = 0; i < inSize; ++i)
+        inData[i] = 100 * sin(0.001 * i);
+    vector<float> outData(outX * outY * inZ);
+    const int repeat = 5;
+
+    double start = now();
+    for (int r = 0; r < repeat; ++r)
+        interpolatePerPoint(func, inData.get(), &outData[0], pointsOnXAxis, pointsOnYAxis, inX, inY, inZ);
+    const double perPointTime = (now() - start) / repeat;
+
+    start = now();
+    const CachedInterpolation ci("x", "y", method, pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY, ReducedInterpolationDomain_p());
+    const double setupTime = now() - start;
+
+    start = now();
+    size_t outSize = 0;
+    for (int r = 0; r < repeat; ++r)
+        ci.interpolateValues(inData, inSize, outSize);
+    const double cachedTime = (now() - start) / repeat;
+
+    const size_t values = outX * outY * inZ;
+    cout << name << "\t" << (values / perPointTime / 1e6) << "\t\t" << (values / cachedTime / 1e6) << "\t\t" << setupTime << "\t"
+         << (perPointTime / cachedTime) << endl;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t outX = 1000, outY = 800, inZ = 20;
+    if (argc > 3) {
+        outX = atol(argv[1]);
+        outY = atol(argv[2]);
+        inZ = atol(argv[3]);
+    }
+
+    cout << "method\t\tper-point Mvalues/s\tcached Mvalues/s\tsetup s\tspeedup" << endl;
+    benchmark("bilinear", MIFI_INTERPOL_BILINEAR, mifi_get_values_bilinear_f, outX, outY, inZ);
+    benchmark("bicubic\t", MIFI_INTERPOL_BICUBIC, mifi_get_values_bicubic_f, outX, outY, inZ);
+    return 0;
+}
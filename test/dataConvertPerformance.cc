@@ -0,0 +1,95 @@
+/*
+  Fimex, test/dataConvertPerformance.cc
+
+  (C) Copyright 2026, met.no
+
+  Project Info:  https://wiki.met.no/fimex/start
+
+  This library is free software; you can redistribute it and/or modify it
+  under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 2.1 of the License, or
+  (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+  USA.
+*/
+
+/**
+ * Compare the vectorized scale/offset/fill kernels used by
+ * Data::convertDataType with the plain ScaleValue transform, for all type
+ * pairs with a kernel.
+ *
+ * usage: dataConvertPerformance [size]
+ */
+
+#include "../src/DataConvertKernels.h"
+#include "fimex/DataUtils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sys/time.h>
+#include <vector>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <typename IN, typename OUT>
+void benchmark(const char* name, size_t size, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset)
+{
+    vector<IN> in(size);
+    for (size_t i = 0; i < size; ++i)
+        in[i] = static_cast<IN>((i % 101 == 0) ? oldFill : (i % 200));
+    vector<OUT> out(size);
+    const int repeat = 20;
+
+    double start = now();
+    for (int r = 0; r < repeat; ++r)
+        std::transform(in.begin(), in.end(), out.begin(), ScaleValue<IN, OUT>(oldFill, oldScale, oldOffset, newFill, newScale, newOffset));
+    const double transformTime = (now() - start) / repeat;
+
+    start = now();
+    bool haveKernel = true;
+    for (int r = 0; r < repeat; ++r)
+        haveKernel = scaleValuesKernel(&in[0], &out[0], size, oldFill, oldScale, oldOffset, newFill, newScale, newOffset);
+    const double kernelTime = (now() - start) / repeat;
+
+    cout << name << "\t" << (size / transformTime / 1e6) << "\t";
+    if (haveKernel)
+        cout << (size / kernelTime / 1e6) << "\t" << (transformTime / kernelTime) << endl;
+    else
+        cout << "-\t-" << endl;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t size = 10 * 1000 * 1000;
+    if (argc > 1)
+        size = atol(argv[1]);
+
+    cout << "pair\t\ttransform Mvalues/s\tkernel Mvalues/s\tspeedup" << endl;
+    benchmark<short, float>("short->float\t", size, -32767, 0.01, 273.15, 9.96921e+36, 1, 0);
+    benchmark<unsigned short, float>("ushort->float\t", size, 65535, 0.01, 0, 9.96921e+36, 1, 0);
+    benchmark<unsigned char, float>("uchar->float\t", size, 255, 0.5, -10, 9.96921e+36, 1, 0);
+    benchmark<short, double>("short->double\t", size, -32767, 0.01, 273.15, 9.96921e+36, 1, 0);
+    benchmark<float, short>("float->short\t", size, 9.96921e+36, 1, 0, -32767, 0.01, 273.15);
+    benchmark<float, double>("float->double\t", size, 9.96921e+36, 1, 0, 9.96921e+36, 1, 0);
+    benchmark<double, float>("double->float\t", size, 9.96921e+36, 1, 0, 9.96921e+36, 1, 0);
+    return 0;
+}
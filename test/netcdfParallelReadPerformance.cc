@@ -0,0 +1,110 @@
+/*
+  Fimex, test/netcdfParallelReadPerformance.cc
+
+  (C) Copyright 2026, met.no
+
+  Project Info:  https://wiki.met.no/fimex/start
+
+  This library is free software; you can redistribute it and/or modify it
+  under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 2.1 of the License, or
+  (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+  License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+  USA.
+*/
+
+/**
+ * Measure the scaling of reading all unlimited-dimension slices of a
+ * variable from one or more NetCDF files with an increasing number of
+ * OpenMP threads.
+ *
+ * usage: netcdfParallelReadPerformance variable file.nc [file2.nc ...]
+ *
+ * Without HAVE_NETCDF_THREADSAFE, all reads are serialized and the speedup stays
+ * around 1. With a thread-safe netcdf/hdf5 and fimex configured with
+ * -DENABLE_NETCDF_THREADSAFE=ON, compressed netcdf4 input should scale with
+ * the number of cores.
+ */
+
+#include "fimex/CDM.h"
+#include "fimex/CDMFileReaderFactory.h"
+#include "fimex/CDMReader.h"
+#include "fimex/Data.h"
+
+#include <iostream>
+#include <sys/time.h>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " variable file.nc [file2.nc ...]" << endl;
+        return 1;
+    }
+    const string varName = argv[1];
+
+    // one task per file and unlimited position
+    vector<CDMReader_p> readers;
+    vector<pair<size_t, size_t>> tasks;
+    for (int i = 2; i < argc; ++i) {
+        CDMReader_p reader = CDMFileReaderFactory::create("netcdf", argv[i]);
+        const CDM& cdm = reader->getCDM();
+        size_t slices = 1;
+        if (cdm.hasUnlimitedDim(cdm.getVariable(varName)))
+            slices = cdm.getUnlimitedDim()->getLength();
+        for (size_t s = 0; s < slices; ++s)
+            tasks.push_back(make_pair(readers.size(), s));
+        readers.push_back(reader);
+    }
+
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    cout << "threads\tseconds\tMB/s\tspeedup" << endl;
+    double serialTime = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+#ifdef _OPENMP
+        omp_set_num_threads(threads);
+#endif
+        size_t bytes = 0;
+        const double start = now();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+ : bytes)
+#endif
+        for (long t = 0; t < static_cast<long>(tasks.size()); ++t) {
+            DataPtr data = readers[tasks[t].first]->getDataSlice(varName, tasks[t].second);
+            bytes += data->bytes_for_one() * data->size();
+        }
+        const double seconds = now() - start;
+        if (threads == 1)
+            serialTime = seconds;
+        cout << threads << "\t" << seconds << "\t" << (bytes / 1048576. / seconds) << "\t" << (serialTime / seconds) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Fimex, testBufferPool.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "../src/BufferPool.h"
+
+using namespace MetNoFimex;
+
+TEST4FIMEX_TEST_CASE(test_buffer_pool_reuse)
+{
+    const size_t size = 1000 * 1000;
+    const BufferPoolStatistics before = getBufferPoolStatistics();
+    float* first;
+    {
+        shared_array<float> a = make_pooled_array<float>(size);
+        first = a.get();
+        a[size - 1] = 1;
+    }
+    {
+        // slightly smaller, same size-class
+        shared_array<float> b = make_pooled_array<float>(size - 10);
+        TEST4FIMEX_CHECK_EQ(b.get(), first);
+        b[size - 11] = 2;
+    }
+    const BufferPoolStatistics after = getBufferPoolStatistics();
+    TEST4FIMEX_CHECK_EQ(after.allocations, before.allocations + 1);
+    TEST4FIMEX_CHECK_EQ(after.reuses, before.reuses + 1);
+
+    // small arrays are not pooled
+    make_pooled_array<double>(10);
+    TEST4FIMEX_CHECK_EQ(getBufferPoolStatistics().allocations, after.allocations);
+}
+
+TEST4FIMEX_TEST_CASE(test_buffer_pool_disabled)
+{
+    const size_t maxBytes = getBufferPoolMaxBytes();
+    setBufferPoolMaxBytes(0);
+    TEST4FIMEX_CHECK_EQ(getBufferPoolStatistics().cachedBytes, 0);
+    make_pooled_array<double>(1000 * 1000);
+    TEST4FIMEX_CHECK_EQ(getBufferPoolStatistics().cachedBytes, 0);
+    setBufferPoolMaxBytes(maxBytes);
+}
+
+TEST4FIMEX_TEST_CASE(test_buffer_pool_thread_cache)
+{
+    const size_t maxBytes = getBufferPoolMaxBytes();
+    setBufferPoolMaxBytes(0);
+    setBufferPoolMaxBytes(maxBytes);
+
+    // the buffer released to the thread cache counts as cached
+    make_pooled_array<float>(1000 * 1000);
+    const BufferPoolStatistics cached = getBufferPoolStatistics();
+    TEST4FIMEX_CHECK(cached.cachedBytes >= 1000 * 1000 * sizeof(float));
+
+    // and is freed when the limit is lowered
+    setBufferPoolMaxBytes(0);
+    TEST4FIMEX_CHECK_EQ(getBufferPoolStatistics().cachedBytes, 0);
+    make_pooled_array<float>(1000 * 1000);
+    TEST4FIMEX_CHECK_EQ(getBufferPoolStatistics().allocations, cached.allocations + 1);
+
+    // buffers exceeding the limit are not kept in the thread cache
+    setBufferPoolMaxBytes(1000 * 1000);
+    make_pooled_array<float>(1000 * 1000);
+    TEST4FIMEX_CHECK_EQ(getBufferPoolStatistics().cachedBytes, 0);
+
+    setBufferPoolMaxBytes(maxBytes);
+}
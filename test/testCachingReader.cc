@@ -0,0 +1,143 @@
+/*
+ * Fimex, testCachingReader.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "fimex/CDM.h"
+#include "fimex/CDMCachingReader.h"
+#include "fimex/CDMException.h"
+#include "fimex/Data.h"
+#include "fimex/SliceBuilder.h"
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+//! reader with one float variable v(x,time), counting the number of reads
+class CountingReader : public CDMReader
+{
+public:
+    CountingReader()
+        : reads(0)
+    {
+        cdm_->addDimension(CDMDimension("x", 10));
+        CDMDimension time("time", 5);
+        time.setUnlimited(true);
+        cdm_->addDimension(time);
+        vector<string> shape;
+        shape.push_back("x");
+        shape.push_back("time");
+        cdm_->addVariable(CDMVariable("v", CDM_FLOAT, shape));
+    }
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string& varName, size_t unLimDimPos) override
+    {
+        reads += 1;
+        shared_array<float> values(new float[10]);
+        for (size_t i = 0; i < 10; ++i)
+            values[i] = unLimDimPos * 100 + i;
+        return createData(10, values);
+    }
+    int reads;
+};
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_caching_reader)
+{
+    std::shared_ptr<CountingReader> reader = std::make_shared<CountingReader>();
+    // room for 2 slices
+    CDMCachingReader_p cache = std::make_shared<CDMCachingReader>(reader, 2 * 10 * sizeof(float));
+
+    DataPtr d1 = cache->getDataSlice("v", 1);
+    TEST4FIMEX_CHECK_EQ(d1->getDouble(3), 103);
+    d1->setValue(3, -1); // must not modify cached data
+    cache->getDataSlice("v", 2);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 2);
+
+    DataPtr d1b = cache->getDataSlice("v", 1);
+    TEST4FIMEX_CHECK_EQ(d1b->getDouble(3), 103);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 2);
+
+    // evicts slice 2, the least recently used
+    cache->getDataSlice("v", 3);
+    cache->getDataSlice("v", 1);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 3);
+    cache->getDataSlice("v", 2);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 4);
+
+    CDMCachingReader::Statistics stats = cache->getStatistics();
+    TEST4FIMEX_CHECK_EQ(stats.hits, 2);
+    TEST4FIMEX_CHECK_EQ(stats.misses, 4);
+    TEST4FIMEX_CHECK_EQ(stats.evictions, 2);
+    TEST4FIMEX_CHECK_EQ(stats.bytes, 2 * 10 * sizeof(float));
+
+    // SliceBuilder requests are cached separately
+    SliceBuilder sb(cache->getCDM(), "v");
+    sb.setStartAndSize("time", 4, 1);
+    sb.setStartAndSize("x", 2, 3);
+    DataPtr d4 = cache->getDataSlice("v", sb);
+    TEST4FIMEX_CHECK_EQ(d4->size(), 3);
+    TEST4FIMEX_CHECK_EQ(d4->getDouble(0), 402);
+    cache->getDataSlice("v", sb);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 5);
+
+    cache->clear();
+    cache->getDataSlice("v", 1);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 6);
+}
+
+TEST4FIMEX_TEST_CASE(test_caching_reader_disabled)
+{
+    std::shared_ptr<CountingReader> reader = std::make_shared<CountingReader>();
+    CDMCachingReader_p cache = std::make_shared<CDMCachingReader>(reader, 0);
+    cache->getDataSlice("v", 1);
+    cache->getDataSlice("v", 1);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 2);
+}
+
+TEST4FIMEX_TEST_CASE(test_getDataSlices)
+{
+    std::shared_ptr<CountingReader> reader = std::make_shared<CountingReader>();
+
+    DataSliceRequest_v requests;
+    SliceBuilder sb(reader->getCDM(), "v");
+    sb.setStartAndSize("time", 1, 1);
+    requests.push_back(DataSliceRequest("v", sb)); // complete unlimited slice
+    sb.setStartAndSize("time", 3, 1);
+    sb.setStartAndSize("x", 2, 3);
+    requests.push_back(DataSliceRequest("v", sb));
+    requests.push_back(DataSliceRequest("v", SliceBuilder(reader->getCDM(), "v")));
+
+    const vector<DataPtr> data = reader->getDataSlices(requests);
+    TEST4FIMEX_REQUIRE_EQ(data.size(), 3);
+    TEST4FIMEX_CHECK_EQ(data[0]->size(), 10);
+    TEST4FIMEX_CHECK_EQ(data[0]->getDouble(3), 103);
+    TEST4FIMEX_CHECK_EQ(data[1]->size(), 3);
+    TEST4FIMEX_CHECK_EQ(data[1]->getDouble(0), 302);
+    TEST4FIMEX_CHECK_EQ(data[2]->size(), 50);
+    TEST4FIMEX_CHECK_EQ(data[2]->getDouble(42), 402);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 1 + 1 + 5);
+
+    requests.push_back(DataSliceRequest("unknown", sb));
+    TEST4FIMEX_CHECK_THROW(reader->getDataSlices(requests), CDMException);
+}
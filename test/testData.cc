@@ -204,6 +204,60 @@ TEST4FIMEX_TEST_CASE(test_slice_segfault)
     TEST4FIMEX_CHECK_EQ(slice->size(), newDimSize[0] * newDimSize[1] * newDimSize[2]);
 }
 
+TEST4FIMEX_TEST_CASE(test_slice_copy_on_write)
+{
+    DataPtr data = createData(CDM_FLOAT, 24);
+    for (size_t i = 0; i < 24; i++)
+        data->setValue(i, i);
+    // 4x3x2, the last slice in the slowest dimension is contiguous
+    const std::vector<size_t> orgDimSize = {4, 3, 2};
+    DataPtr view = data->slice(orgDimSize, {0, 1, 1}, {4, 2, 1});
+    TEST4FIMEX_REQUIRE_EQ(view->size(), 8);
+    TEST4FIMEX_CHECK_EQ(view->getDouble(0), 16);
+    TEST4FIMEX_CHECK_EQ(view->getDouble(7), 23);
+
+    // view of a view
+    DataPtr view2 = view->slice({8}, {4}, {4});
+    TEST4FIMEX_CHECK_EQ(view2->getDouble(0), 20);
+
+    // modifying the view does not modify the original data
+    view->setValue(0, -1);
+    TEST4FIMEX_CHECK_EQ(view->getDouble(0), -1);
+    TEST4FIMEX_CHECK_EQ(data->getDouble(16), 16);
+
+    // modifying the original does not modify the other views
+    data->setAllValues(0);
+    TEST4FIMEX_CHECK_EQ(view->getDouble(7), 23);
+    TEST4FIMEX_CHECK_EQ(view2->getDouble(3), 23);
+
+    // same-type arrays of a view are copies
+    shared_array<float> values = view2->asFloat();
+    values[0] = -2;
+    TEST4FIMEX_CHECK_EQ(view2->getDouble(0), 20);
+
+    // writing through the arrays or the pointer of the original does not modify its views
+    DataPtr parent = createData(CDM_FLOAT, 24);
+    for (size_t i = 0; i < 24; i++)
+        parent->setValue(i, i);
+    DataPtr parentView = parent->slice(orgDimSize, {0, 0, 1}, {4, 3, 1});
+    shared_array<float> parentValues = parent->asFloat();
+    parentValues[12] = -3;
+    TEST4FIMEX_CHECK_EQ(parentView->getDouble(0), 12);
+    static_cast<float*>(parent->getDataPtr())[13] = -4;
+    TEST4FIMEX_CHECK_EQ(parentView->getDouble(1), 13);
+    TEST4FIMEX_CHECK_EQ(parent->getDouble(13), -4);
+
+    // non-contiguous slices are copied
+    DataPtr copy = createData(CDM_FLOAT, 24);
+    for (size_t i = 0; i < 24; i++)
+        copy->setValue(i, i);
+    DataPtr sliced = copy->slice(orgDimSize, {1, 0, 0}, {2, 3, 2});
+    TEST4FIMEX_REQUIRE_EQ(sliced->size(), 12);
+    TEST4FIMEX_CHECK_EQ(sliced->getDouble(0), 1);
+    TEST4FIMEX_CHECK_EQ(sliced->getDouble(2), 5);
+    TEST4FIMEX_CHECK_EQ(sliced->getDouble(11), 22);
+}
+
 TEST4FIMEX_TEST_CASE(test_rounding)
 {
     DataPtr dataDouble(new DataImpl<double>(40));
@@ -233,3 +287,58 @@ TEST4FIMEX_TEST_CASE(test_rounding)
         TEST4FIMEX_CHECK_MESSAGE(asI[j] == expect, "int:   i=" << i << " have == " << asI[j] << " expected " << expect);
     }
 }
+
+namespace {
+template <typename IN, typename OUT>
+void checkConvertDataType(CDMDataType outType, const vector<double>& values, double oldFill, double oldScale, double oldOffset, double newFill, double newScale, double newOffset)
+{
+    const size_t n = values.size();
+    shared_array<IN> in(new IN[n]);
+    for (size_t i = 0; i < n; ++i)
+        in[i] = static_cast<IN>(values[i]);
+    DataPtr data = createData(n, in);
+    DataPtr converted = data->convertDataType(oldFill, oldScale, oldOffset, outType, newFill, newScale, newOffset);
+
+    vector<OUT> expected(n);
+    std::transform(&in[0], &in[n], expected.begin(), ScaleValue<IN, OUT>(oldFill, oldScale, oldOffset, newFill, newScale, newOffset));
+    const OUT* out = static_cast<const OUT*>(converted->getDataPtr());
+    TEST4FIMEX_REQUIRE_EQ(converted->size(), n);
+    for (size_t i = 0; i < n; ++i) {
+        TEST4FIMEX_CHECK_MESSAGE(out[i] == expected[i] || (std::isnan(static_cast<double>(out[i])) && std::isnan(static_cast<double>(expected[i]))),
+                                 "i=" << i << " have " << out[i] << " expected " << expected[i]);
+    }
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_convertDataType_kernels)
+{
+    // odd size to check the remainder, including fill-values, nan and rounding half-way cases
+    vector<double> values;
+    for (int i = 0; i < 203; i++)
+        values.push_back((i % 17 == 0) ? -99 : (i - 100) * 2.5);
+    vector<double> floats(values);
+    floats[5] = MIFI_UNDEFINED_D;
+    vector<double> positives;
+    for (int i = 0; i < 203; i++)
+        positives.push_back((i % 17 == 0) ? 5 : i);
+
+    checkConvertDataType<short, float>(CDM_FLOAT, values, -99, 0.01, 273.15, MIFI_UNDEFINED_D, 1, 0);
+    checkConvertDataType<unsigned short, float>(CDM_FLOAT, positives, 5, 0.5, -1, -1, 2, 0);
+    checkConvertDataType<unsigned char, float>(CDM_FLOAT, positives, 5, 0.5, -1, -1, 1, 0);
+    checkConvertDataType<short, double>(CDM_DOUBLE, values, -99, 0.01, 273.15, MIFI_UNDEFINED_D, 1, 0);
+    checkConvertDataType<float, short>(CDM_SHORT, floats, -99, 1, 0, -32767, 5, 0);
+    checkConvertDataType<float, short>(CDM_SHORT, floats, -99, 1, 0.3, -32767, 0.1, -20);
+    checkConvertDataType<float, double>(CDM_DOUBLE, floats, -99, 1.5, 2, -1e30, 1, 0);
+    checkConvertDataType<double, float>(CDM_FLOAT, floats, -99, 1, 0, MIFI_UNDEFINED_F, 3, 1);
+
+    // results outside the int32 range, single ones and whole vectors
+    vector<double> large(floats);
+    large[9] = 3e9;
+    for (size_t i = 20; i < 24; i++)
+        large[i] = -5e9 - i;
+    large[30] = 2147483647;
+    large[31] = -2147483648.;
+    large[40] = 1e12;
+    checkConvertDataType<float, short>(CDM_SHORT, large, -99, 1, 0, -32767, 1, 0);
+    checkConvertDataType<float, short>(CDM_SHORT, floats, -99, 1e8, 0, -32767, 1, 0);
+}
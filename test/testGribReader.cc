@@ -88,6 +88,25 @@ TEST4FIMEX_TEST_CASE(test_read_grb1)
     writeToFile(grbReader, "test_read_grb1.nc");
 }
 
+TEST4FIMEX_TEST_CASE(test_read_grb1_getDataSlices)
+{
+    if (!hasTestExtra())
+        return;
+    const string fileName = require("test.grb1"); // this is written by testGribWriter.cc
+
+    CDMReader_p grbReader = CDMFileReaderFactory::create("grib", fileName, XMLInputFile(pathTest("cdmGribReaderConfig_newEarth.xml")));
+    DataSliceRequest_v requests;
+    SliceBuilder sb(grbReader->getCDM(), "x_wind_10m");
+    sb.setStartAndSize("time", 0, 1);
+    requests.push_back(DataSliceRequest("x_wind_10m", sb));
+    sb.setStartAndSize("x", 4, 10);
+    sb.setStartAndSize("y", 2, 2);
+    requests.push_back(DataSliceRequest("x_wind_10m", sb));
+    requests.push_back(DataSliceRequest("x_wind_10m", SliceBuilder(grbReader->getCDM(), "x_wind_10m")));
+    requests.push_back(DataSliceRequest("x", SliceBuilder(grbReader->getCDM(), "x")));
+    TEST4FIMEX_CHECK_EQ(countDataSlicesDifferences(grbReader, requests), 0);
+}
+
 TEST4FIMEX_TEST_CASE(test_read_grb2)
 {
     if (!hasTestExtra())
@@ -0,0 +1,142 @@
+/*
+ * Fimex, testGridPointIndex.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "../src/GridPointIndex.h"
+
+#include "fimex/mifi_constants.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+//! closest valid grid point by brute force, lowest position of equal distances
+size_t bruteForceClosest(const vector<double>& lon, const vector<double>& lat, double qLon, double qLat, double maxDist)
+{
+    double q[3];
+    GridPointIndex::lonLat2Sphere(qLon, qLat, q);
+    double best = (maxDist > 0) ? maxDist * maxDist : 10;
+    size_t bestPos = GridPointIndex::npos;
+    for (size_t pos = 0; pos < lon.size(); ++pos) {
+        if (std::isnan(lon[pos]))
+            continue;
+        double p[3];
+        GridPointIndex::lonLat2Sphere(lon[pos], lat[pos], p);
+        const double d = (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]);
+        if (d < best || (d == best && pos < bestPos)) {
+            best = d;
+            bestPos = pos;
+        }
+    }
+    return bestPos;
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(grid_point_index_blocks)
+{
+    // skewed grid across the date line, large enough for several kd-trees
+    const size_t nx = 700, ny = 400;
+    vector<double> lon(nx * ny), lat(nx * ny);
+    for (size_t y = 0; y < ny; ++y) {
+        for (size_t x = 0; x < nx; ++x) {
+            const size_t pos = y * nx + x;
+            lon[pos] = std::remainder(3.0 + 0.0008 * x + 0.0002 * y, 2 * MIFI_PI);
+            lat[pos] = 1.0 + 0.0007 * y - 0.0001 * x;
+            if (pos % 997 == 0)
+                lon[pos] = MIFI_UNDEFINED_D;
+        }
+    }
+    const GridPointIndex index(&lon[0], &lat[0], nx, ny);
+    TEST4FIMEX_CHECK(!index.isValid(0, 0));
+    TEST4FIMEX_CHECK(index.isValid(1, 0));
+
+    vector<double> qLon, qLat;
+    unsigned int seed = 17;
+    for (size_t i = 0; i < 200; ++i) {
+        seed = seed * 1103515245 + 12345;
+        qLon.push_back(std::remainder(2.9 + 0.7 * ((seed >> 8) % 1000) / 1000., 2 * MIFI_PI));
+        seed = seed * 1103515245 + 12345;
+        qLat.push_back(0.9 + 0.35 * ((seed >> 8) % 1000) / 1000.);
+    }
+    qLon.push_back(0); // far away
+    qLat.push_back(0);
+    qLon.push_back(MIFI_UNDEFINED_D);
+    qLat.push_back(1.1);
+
+    const double maxDist = 0.05;
+    vector<size_t> positions(qLon.size());
+    index.findClosest(&qLon[0], &qLat[0], qLon.size(), maxDist, &positions[0]);
+    for (size_t i = 0; i < qLon.size(); ++i) {
+        const size_t expected = std::isnan(qLon[i]) ? GridPointIndex::npos : bruteForceClosest(lon, lat, qLon[i], qLat[i], maxDist);
+        TEST4FIMEX_CHECK_EQ(expected, positions[i]);
+        size_t ix = 0, iy = 0;
+        const bool found = index.findClosest(qLon[i], qLat[i], maxDist, ix, iy);
+        TEST4FIMEX_CHECK_EQ(expected != GridPointIndex::npos, found);
+        if (found)
+            TEST4FIMEX_CHECK_EQ(expected, iy * nx + ix);
+    }
+    TEST4FIMEX_CHECK_EQ(GridPointIndex::npos, positions[qLon.size() - 2]);
+
+    // unlimited distance finds the far away point, too
+    index.findClosest(&qLon[0], &qLat[0], qLon.size(), 0, &positions[0]);
+    TEST4FIMEX_CHECK_EQ(bruteForceClosest(lon, lat, 0, 0, 0), positions[qLon.size() - 2]);
+}
+
+TEST4FIMEX_TEST_CASE(grid_point_index_pole)
+{
+    // regular lon/lat grid around the north pole
+    const size_t nx = 36, ny = 5;
+    vector<double> lon(nx * ny), lat(nx * ny);
+    for (size_t y = 0; y < ny; ++y) {
+        for (size_t x = 0; x < nx; ++x) {
+            lon[y * nx + x] = (10. * x - 180) * MIFI_PI / 180;
+            lat[y * nx + x] = (85. + y) * MIFI_PI / 180;
+        }
+    }
+    const GridPointIndex index(&lon[0], &lat[0], nx, ny);
+    size_t ix, iy;
+    // across the pole
+    TEST4FIMEX_REQUIRE(index.findClosest(5 * MIFI_PI / 180, 89.9 * MIFI_PI / 180, 0, ix, iy));
+    TEST4FIMEX_CHECK_EQ(4, iy);
+    TEST4FIMEX_CHECK(ix == 18 || ix == 19);
+    TEST4FIMEX_REQUIRE(index.findClosest(-179 * MIFI_PI / 180, 86.1 * MIFI_PI / 180, 0, ix, iy));
+    TEST4FIMEX_CHECK_EQ(0, ix);
+    TEST4FIMEX_CHECK_EQ(1, iy);
+    TEST4FIMEX_REQUIRE(index.findClosest(179 * MIFI_PI / 180, 86.1 * MIFI_PI / 180, 0, ix, iy));
+    TEST4FIMEX_CHECK_EQ(0, ix);
+}
+
+TEST4FIMEX_TEST_CASE(grid_point_index_max_distance)
+{
+    // one valid point at (1, 0, 0), the query at (-1, 0, 0) has distance 2
+    const vector<double> lon{0, std::nan("")}, lat{0, 0};
+    const GridPointIndex index(&lon[0], &lat[0], 2, 1);
+    size_t ix, iy;
+    TEST4FIMEX_CHECK(index.findClosest(MIFI_PI, 0, 2, ix, iy));
+    TEST4FIMEX_CHECK_EQ(0, ix);
+    TEST4FIMEX_CHECK(!index.findClosest(MIFI_PI, 0, 1.99, ix, iy));
+}
@@ -24,11 +24,17 @@
 #include "testinghelpers.h"
 #include "fimex/interpolation.h"
 
+#include "../src/CachedForwardInterpolation.h"
+#include "../src/ConservativeRemapping.h"
+
 #include "fimex/CDMAttribute.h"
+#include "fimex/CDMException.h"
+#include "fimex/CachedInterpolation.h"
 #include "fimex/Data.h"
 
 #include <cmath>
 #include <fstream>
+#include <sstream>
 #include <string>
 
 // definitions from proj_api.h
@@ -697,3 +703,399 @@ TEST4FIMEX_TEST_CASE(binary_search)
     TEST4FIMEX_CHECK_EQ(3, bsearchDoubleIndex(7, values, N, ascendingDoubleComparator));
     TEST4FIMEX_CHECK_EQ(-5, bsearchDoubleIndex(8, values, N, ascendingDoubleComparator));
 }
+
+namespace {
+void checkCachedInterpolationRoundTrip(int method)
+{
+    using namespace MetNoFimex;
+    const size_t inX = 20, inY = 15, outX = 4, outY = 3;
+    std::vector<double> pointsOnXAxis, pointsOnYAxis;
+    for (size_t y = 0; y < outY; ++y) {
+        for (size_t x = 0; x < outX; ++x) {
+            pointsOnXAxis.push_back(8.3 + 1.7 * x);
+            pointsOnYAxis.push_back(5.1 + 1.2 * y);
+        }
+    }
+    CachedInterpolationInterface_p ci = createCachedInterpolation("x", "y", method, pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY);
+    TEST4FIMEX_REQUIRE(ci->reducedDomain());
+
+    std::ostringstream out;
+    ci->write(out);
+    const std::string serialized = out.str();
+    CachedInterpolationInterface_p restored = readCachedInterpolation(serialized.data(), serialized.size());
+    TEST4FIMEX_REQUIRE(restored);
+    TEST4FIMEX_REQUIRE(restored->reducedDomain());
+    TEST4FIMEX_CHECK_EQ(ci->reducedDomain()->xMin, restored->reducedDomain()->xMin);
+    TEST4FIMEX_CHECK_EQ(ci->reducedDomain()->yMin, restored->reducedDomain()->yMin);
+    TEST4FIMEX_CHECK_EQ(ci->getInX(), restored->getInX());
+    TEST4FIMEX_CHECK_EQ(ci->getInY(), restored->getInY());
+    TEST4FIMEX_CHECK_EQ(ci->getOutX(), restored->getOutX());
+    TEST4FIMEX_CHECK_EQ(ci->getOutY(), restored->getOutY());
+
+    const size_t inSize = 2 * ci->getInX() * ci->getInY();
+    shared_array<float> inData(new float[inSize]);
+    for (size_t i = 0; i < inSize; ++i)
+        inData[i] = 0.5f * i;
+    size_t ciSize = 0, restoredSize = 0;
+    shared_array<float> ciOut = ci->interpolateValues(inData, inSize, ciSize);
+    shared_array<float> restoredOut = restored->interpolateValues(inData, inSize, restoredSize);
+    TEST4FIMEX_REQUIRE_EQ(ciSize, restoredSize);
+    for (size_t i = 0; i < ciSize; ++i)
+        TEST4FIMEX_CHECK_EQ(ciOut[i], restoredOut[i]);
+
+    // truncated data must be rejected
+    TEST4FIMEX_CHECK_THROW(readCachedInterpolation(serialized.data(), serialized.size() - 1), CDMException);
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(cached_interpolation_serialize)
+{
+    checkCachedInterpolationRoundTrip(MIFI_INTERPOL_BILINEAR);
+    checkCachedInterpolationRoundTrip(MIFI_INTERPOL_BICUBIC);
+    checkCachedInterpolationRoundTrip(MIFI_INTERPOL_NEAREST_NEIGHBOR);
+}
+
+namespace {
+void checkCachedInterpolationValues(int method)
+{
+    using namespace MetNoFimex;
+    // more output points than one tile, including points at and outside the borders
+    const size_t inX = 30, inY = 20, inZ = 3, outX = 70, outY = 40;
+    std::vector<double> pointsOnXAxis, pointsOnYAxis;
+    for (size_t i = 0; i < outX * outY; ++i) {
+        pointsOnXAxis.push_back(-0.7 + (inX + 0.4) * std::fmod(i * 0.6180339887, 1.));
+        pointsOnYAxis.push_back(-0.7 + (inY + 0.1) * std::fmod(i * 0.4142135624, 1.));
+    }
+    pointsOnXAxis[17] = 4.;
+    pointsOnYAxis[17] = 3.;
+    pointsOnXAxis[18] = MIFI_UNDEFINED_D;
+
+    const size_t inSize = inX * inY * inZ;
+    shared_array<float> inData(new float[inSize]);
+    for (size_t i = 0; i < inSize; ++i)
+        inData[i] = 100 * std::sin(0.01f * i) + i % 7;
+    inData[5 * inX + 7] = MIFI_UNDEFINED_F;
+
+    const CachedInterpolation ci("x", "y", method, pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY, ReducedInterpolationDomain_p());
+    size_t outSize = 0;
+    shared_array<float> outData = ci.interpolateValues(inData, inSize, outSize);
+    TEST4FIMEX_REQUIRE_EQ(outX * outY * inZ, outSize);
+    TEST4FIMEX_CHECK_EQ(inData[3 * inX + 4], outData[17]);
+    TEST4FIMEX_CHECK(std::isnan(outData[18]));
+
+    std::vector<float> zValues(inZ);
+    size_t nan = 0;
+    for (size_t xy = 0; xy < outX * outY; ++xy) {
+        if (xy == 18)
+            continue; // undefined position, not handled by mifi_get_values_bilinear_f
+        if (method == MIFI_INTERPOL_BILINEAR)
+            mifi_get_values_bilinear_f(inData.get(), &zValues[0], pointsOnXAxis[xy], pointsOnYAxis[xy], inX, inY, inZ);
+        else
+            mifi_get_values_bicubic_f(inData.get(), &zValues[0], pointsOnXAxis[xy], pointsOnYAxis[xy], inX, inY, inZ);
+        for (size_t z = 0; z < inZ; ++z) {
+            const float expected = zValues[z], actual = outData[z * outX * outY + xy];
+            if (std::isnan(expected)) {
+                TEST4FIMEX_CHECK(std::isnan(actual));
+                nan += 1;
+            } else if (method == MIFI_INTERPOL_BILINEAR) {
+                TEST4FIMEX_CHECK_EQ(expected, actual);
+            } else {
+                TEST4FIMEX_CHECK(near(expected, actual, 1e-3));
+            }
+        }
+    }
+    // border and missing values are covered, but not everything is undefined
+    TEST4FIMEX_CHECK(nan > 0);
+    TEST4FIMEX_CHECK(nan < outSize / 2);
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(cached_interpolation_values)
+{
+    checkCachedInterpolationValues(MIFI_INTERPOL_BILINEAR);
+    checkCachedInterpolationValues(MIFI_INTERPOL_BICUBIC);
+}
+
+namespace {
+void checkSparseInterpolation(int method)
+{
+    using namespace MetNoFimex;
+    const size_t inX = 20, inY = 15, inZ = 2, outX = 6, outY = 5;
+    std::vector<double> pointsOnXAxis, pointsOnYAxis;
+    for (size_t y = 0; y < outY; ++y) {
+        for (size_t x = 0; x < outX; ++x) {
+            pointsOnXAxis.push_back(-1.2 + 3.9 * x);
+            pointsOnYAxis.push_back(0.6 + 3.3 * y);
+        }
+    }
+    CachedInterpolationInterface_p ci = createCachedInterpolation("x", "y", method, pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY);
+    CachedInterpolationInterface_p sparse = createSparseInterpolation(*ci);
+    TEST4FIMEX_REQUIRE(sparse->sparseMatrix());
+    TEST4FIMEX_CHECK_EQ(ci->getInX(), sparse->getInX());
+    TEST4FIMEX_CHECK_EQ(ci->getInY(), sparse->getInY());
+
+    const size_t inSize = inZ * ci->getInX() * ci->getInY();
+    shared_array<float> inData(new float[inSize]);
+    for (size_t i = 0; i < inSize; ++i)
+        inData[i] = 10 * std::cos(0.1f * i);
+    inData[ci->getInX() + 3] = MIFI_UNDEFINED_F;
+
+    size_t ciSize = 0, sparseSize = 0;
+    shared_array<float> ciOut = ci->interpolateValues(inData, inSize, ciSize);
+    shared_array<float> sparseOut = sparse->interpolateValues(inData, inSize, sparseSize);
+    TEST4FIMEX_REQUIRE_EQ(ciSize, sparseSize);
+    for (size_t i = 0; i < ciSize; ++i) {
+        if (std::isnan(ciOut[i]))
+            TEST4FIMEX_CHECK(std::isnan(sparseOut[i]));
+        else
+            TEST4FIMEX_CHECK(near(ciOut[i], sparseOut[i], 1e-4));
+    }
+
+    // the matrix is written as such, and restored as CachedSparseInterpolation
+    std::ostringstream out;
+    sparse->write(out);
+    const std::string serialized = out.str();
+    CachedInterpolationInterface_p restored = readCachedInterpolation(serialized.data(), serialized.size());
+    TEST4FIMEX_REQUIRE(std::dynamic_pointer_cast<CachedSparseInterpolation>(restored));
+    size_t restoredSize = 0;
+    shared_array<float> restoredOut = restored->interpolateValues(inData, inSize, restoredSize);
+    TEST4FIMEX_REQUIRE_EQ(sparseSize, restoredSize);
+    for (size_t i = 0; i < sparseSize; ++i) {
+        if (std::isnan(sparseOut[i]))
+            TEST4FIMEX_CHECK(std::isnan(restoredOut[i]));
+        else
+            TEST4FIMEX_CHECK_EQ(sparseOut[i], restoredOut[i]);
+    }
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(cached_interpolation_sparse)
+{
+    checkSparseInterpolation(MIFI_INTERPOL_BILINEAR);
+    checkSparseInterpolation(MIFI_INTERPOL_BICUBIC);
+    checkSparseInterpolation(MIFI_INTERPOL_NEAREST_NEIGHBOR);
+}
+
+TEST4FIMEX_TEST_CASE(sparse_matrix_missing)
+{
+    using namespace MetNoFimex;
+    const float nan = MIFI_UNDEFINED_F;
+    const float in[8] = {1, 2, nan, 4, 10, 20, 30, nan};
+    for (int flags = 0; flags < 4; ++flags) {
+        SparseInterpolationMatrix m(4, flags);
+        m.addWeight(0, 1);
+        m.addWeight(1, 3);
+        m.endRow();
+        m.addWeight(1, 1);
+        m.addWeight(2, 1);
+        m.endRow();
+        m.endRow();
+        TEST4FIMEX_REQUIRE_EQ(3, m.rows());
+        TEST4FIMEX_REQUIRE_EQ(4, m.nonZeros());
+
+        float out[6];
+        m.apply(in, 2, out);
+        const bool normalize = (flags & SparseInterpolationMatrix::NORMALIZE);
+        TEST4FIMEX_CHECK(near(out[0], normalize ? 7.f / 4 : 7.f, 1e-6));
+        TEST4FIMEX_CHECK(near(out[3], normalize ? 70.f / 4 : 70.f, 1e-6));
+        if (flags & SparseInterpolationMatrix::SKIP_MISSING) {
+            TEST4FIMEX_CHECK(near(out[1], 2, 1e-6));
+        } else {
+            TEST4FIMEX_CHECK(std::isnan(out[1]));
+        }
+        TEST4FIMEX_CHECK(near(out[4], normalize ? 25.f : 50.f, 1e-6));
+        TEST4FIMEX_CHECK(std::isnan(out[2]));
+        TEST4FIMEX_CHECK(std::isnan(out[5]));
+    }
+
+    const std::vector<uint64_t> rowStart = {0, 1, 2};
+    TEST4FIMEX_CHECK_THROW(SparseInterpolationMatrix(4, 0, rowStart, std::vector<uint32_t>{0, 4}, std::vector<float>{1, 1}), CDMException);
+    TEST4FIMEX_CHECK_THROW(SparseInterpolationMatrix(4, 0, rowStart, std::vector<uint32_t>{0}, std::vector<float>{1}), CDMException);
+}
+
+TEST4FIMEX_TEST_CASE(cached_forward_interpolation_sparse)
+{
+    using namespace MetNoFimex;
+    // 4x4 input points in 2x2 output cells, two levels
+    const size_t inX = 4, inY = 4, outX = 2, outY = 2;
+    shared_array<double> pointsOnXAxis(new double[inX * inY]), pointsOnYAxis(new double[inX * inY]);
+    for (size_t y = 0; y < inY; ++y) {
+        for (size_t x = 0; x < inX; ++x) {
+            pointsOnXAxis[y * inX + x] = 0.4 * x;
+            pointsOnYAxis[y * inX + x] = 0.4 * y;
+        }
+    }
+    shared_array<float> inData(new float[2 * inX * inY]);
+    for (size_t i = 0; i < 2 * inX * inY; ++i)
+        inData[i] = i;
+    inData[0] = MIFI_UNDEFINED_F;
+
+    // output cell 0 gets input 0, 1, 4, 5; cell 1 gets 2, 3, 6, 7
+    const int methods[4] = {MIFI_INTERPOL_FORWARD_SUM, MIFI_INTERPOL_FORWARD_MEAN, MIFI_INTERPOL_FORWARD_UNDEF_SUM, MIFI_INTERPOL_FORWARD_UNDEF_MEAN};
+    const float cell0[4] = {10, 10.f / 3, MIFI_UNDEFINED_F, MIFI_UNDEFINED_F};
+    const float cell1[4] = {18, 4.5, 18, 4.5};
+    for (int m = 0; m < 4; ++m) {
+        CachedForwardInterpolation ci("x", "y", methods[m], pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY);
+        TEST4FIMEX_REQUIRE(ci.sparseMatrix());
+        TEST4FIMEX_CHECK(ci.isSerializable());
+        size_t outSize = 0;
+        shared_array<float> outData = ci.interpolateValues(inData, 2 * inX * inY, outSize);
+        TEST4FIMEX_REQUIRE_EQ(8, outSize);
+        if (std::isnan(cell0[m]))
+            TEST4FIMEX_CHECK(std::isnan(outData[0]));
+        else
+            TEST4FIMEX_CHECK(near(cell0[m], outData[0], 1e-5));
+        TEST4FIMEX_CHECK(near(cell1[m], outData[1], 1e-5));
+        // second level, cell 1 gets 18, 19, 22, 23
+        TEST4FIMEX_CHECK(near(m % 2 ? 20.5f : 82.f, outData[5], 1e-5));
+    }
+
+    CachedForwardInterpolation median("x", "y", MIFI_INTERPOL_FORWARD_MEDIAN, pointsOnXAxis, pointsOnYAxis, inX, inY, outX, outY);
+    TEST4FIMEX_CHECK(!median.sparseMatrix());
+    TEST4FIMEX_CHECK(!median.isSerializable());
+}
+
+TEST4FIMEX_TEST_CASE(conservative_remapping_coarsen)
+{
+    using namespace MetNoFimex;
+    // 6x4 unit cells into 3x2 cells of 2x2, output y descending
+    const size_t inX = 6, inY = 4;
+    std::vector<double> pointsOnXAxis(inX * inY), pointsOnYAxis(inX * inY);
+    for (size_t y = 0; y < inY; ++y) {
+        for (size_t x = 0; x < inX; ++x) {
+            pointsOnXAxis[y * inX + x] = x + 0.5;
+            pointsOnYAxis[y * inX + x] = y + 0.5;
+        }
+    }
+    const std::vector<double> outXAxis{1, 3, 5}, outYAxis{3, 1};
+    CachedInterpolationInterface_p ci =
+        createConservativeInterpolation("x", "y", &pointsOnXAxis[0], &pointsOnYAxis[0], inX, inY, outXAxis, outYAxis, false);
+    TEST4FIMEX_REQUIRE(ci->sparseMatrix());
+    TEST4FIMEX_CHECK(!ci->reducedDomain());
+    TEST4FIMEX_CHECK_EQ(inX * inY, ci->sparseMatrix()->nonZeros());
+
+    shared_array<float> inData(new float[2 * inX * inY]);
+    for (size_t i = 0; i < 2 * inX * inY; ++i)
+        inData[i] = i;
+    inData[inX * inY + 0] = MIFI_UNDEFINED_F;
+    size_t outSize = 0;
+    shared_array<float> outData = ci->interpolateValues(inData, 2 * inX * inY, outSize);
+    TEST4FIMEX_REQUIRE_EQ(2 * 3 * 2, outSize);
+    // first output row is the upper half of the input
+    TEST4FIMEX_CHECK(near((12 + 13 + 18 + 19) / 4.f, outData[0], 1e-5));
+    TEST4FIMEX_CHECK(near((16 + 17 + 22 + 23) / 4.f, outData[2], 1e-5));
+    TEST4FIMEX_CHECK(near((0 + 1 + 6 + 7) / 4.f, outData[3], 1e-5));
+    // undefined input skipped in second level
+    TEST4FIMEX_CHECK(near((25 + 30 + 31) / 3.f, outData[6 + 3], 1e-5));
+
+    const std::vector<double> singleAxis{1};
+    TEST4FIMEX_CHECK_THROW(createConservativeInterpolation("x", "y", &pointsOnXAxis[0], &pointsOnYAxis[0], inX, inY, singleAxis, outYAxis, false),
+                           CDMException);
+}
+
+TEST4FIMEX_TEST_CASE(conservative_remapping_rotated)
+{
+    using namespace MetNoFimex;
+    // 20x20 unit cells rotated by 30 degree, output 0.5x0.5 cells in [-5.25,5.25]
+    const size_t inX = 20, inY = 20;
+    const double c = std::cos(MIFI_PI / 6), s = std::sin(MIFI_PI / 6);
+    std::vector<double> pointsOnXAxis(inX * inY), pointsOnYAxis(inX * inY);
+    for (size_t y = 0; y < inY; ++y) {
+        for (size_t x = 0; x < inX; ++x) {
+            const double i = x - 9.5, j = y - 9.5;
+            pointsOnXAxis[y * inX + x] = c * i - s * j;
+            pointsOnYAxis[y * inX + x] = s * i + c * j;
+        }
+    }
+    std::vector<double> outAxis;
+    for (int k = -10; k <= 10; ++k)
+        outAxis.push_back(0.5 * k);
+    CachedInterpolationInterface_p ci =
+        createConservativeInterpolation("x", "y", &pointsOnXAxis[0], &pointsOnYAxis[0], inX, inY, outAxis, outAxis, false);
+    SparseInterpolationMatrix_cp matrix = ci->sparseMatrix();
+    TEST4FIMEX_REQUIRE(matrix);
+    TEST4FIMEX_REQUIRE(ci->reducedDomain());
+    const size_t xMin = ci->reducedDomain()->xMin, yMin = ci->reducedDomain()->yMin;
+
+    // input cells inside the output domain are distributed completely
+    std::vector<double> covered(ci->getInX() * ci->getInY(), 0);
+    for (size_t r = 0; r < matrix->rows(); ++r) {
+        for (uint64_t k = matrix->rowStart()[r]; k < matrix->rowStart()[r + 1]; ++k)
+            covered[matrix->columns()[k]] += matrix->weights()[k] * 0.25;
+    }
+    size_t inside = 0;
+    for (size_t y = 0; y < inY; ++y) {
+        for (size_t x = 0; x < inX; ++x) {
+            const size_t p = y * inX + x;
+            if (std::fabs(pointsOnXAxis[p]) < 4 && std::fabs(pointsOnYAxis[p]) < 4) {
+                TEST4FIMEX_CHECK(near(1, covered[(y - yMin) * ci->getInX() + (x - xMin)], 1e-5));
+                inside += 1;
+            }
+        }
+    }
+    TEST4FIMEX_CHECK(inside > 30);
+
+    // constant fields stay constant
+    shared_array<float> inData(new float[ci->getInX() * ci->getInY()]);
+    std::fill(&inData[0], &inData[0] + ci->getInX() * ci->getInY(), 3.f);
+    size_t outSize = 0;
+    shared_array<float> outData = ci->interpolateValues(inData, ci->getInX() * ci->getInY(), outSize);
+    TEST4FIMEX_REQUIRE_EQ(outAxis.size() * outAxis.size(), outSize);
+    for (size_t i = 0; i < outSize; ++i)
+        TEST4FIMEX_CHECK(near(3, outData[i], 1e-5));
+}
+
+TEST4FIMEX_TEST_CASE(conservative_remapping_dateline)
+{
+    using namespace MetNoFimex;
+    // 4x2 input cells across the date line, output covering all longitudes
+    const size_t inX = 4, inY = 2, outX = 60;
+    const double d = 2 * MIFI_PI / outX;
+    std::vector<double> pointsOnXAxis(inX * inY), pointsOnYAxis(inX * inY);
+    for (size_t y = 0; y < inY; ++y) {
+        for (size_t x = 0; x < inX; ++x) {
+            pointsOnXAxis[y * inX + x] = std::remainder(MIFI_PI + (x - 1.5) * d, 2 * MIFI_PI);
+            pointsOnYAxis[y * inX + x] = 0.1 * y;
+        }
+    }
+    std::vector<double> outXAxis;
+    for (size_t k = 0; k < outX; ++k)
+        outXAxis.push_back(-MIFI_PI + (k + 0.5) * d);
+    const std::vector<double> outYAxis{0, 0.1};
+    CachedInterpolationInterface_p ci =
+        createConservativeInterpolation("x", "y", &pointsOnXAxis[0], &pointsOnYAxis[0], inX, inY, outXAxis, outYAxis, true);
+
+    shared_array<float> inData(new float[inX * inY]);
+    for (size_t i = 0; i < inX * inY; ++i)
+        inData[i] = i % inX;
+    size_t outSize = 0;
+    shared_array<float> outData = ci->interpolateValues(inData, inX * inY, outSize);
+    TEST4FIMEX_REQUIRE_EQ(outX * 2, outSize);
+    TEST4FIMEX_CHECK(near(0, outData[outX - 2], 1e-5));
+    TEST4FIMEX_CHECK(near(1, outData[outX - 1], 1e-5));
+    TEST4FIMEX_CHECK(near(2, outData[0], 1e-5));
+    TEST4FIMEX_CHECK(near(3, outData[1], 1e-5));
+    TEST4FIMEX_CHECK(std::isnan(outData[outX / 2]));
+}
+
+TEST4FIMEX_TEST_CASE(conservative_remapping_latitude_area)
+{
+    using namespace MetNoFimex;
+    // 2x2 input cells with latitude bounds 0, 0.5, 1, both rows inside the first output row
+    const size_t inX = 2, inY = 2;
+    const std::vector<double> pointsOnXAxis{0, 0.1, 0, 0.1}, pointsOnYAxis{0.25, 0.25, 0.75, 0.75};
+    const std::vector<double> outXAxis{0, 0.1}, outYAxis{0.5, 1.5};
+    CachedInterpolationInterface_p ci =
+        createConservativeInterpolation("x", "y", &pointsOnXAxis[0], &pointsOnYAxis[0], inX, inY, outXAxis, outYAxis, true);
+
+    shared_array<float> inData(new float[inX * inY]);
+    for (size_t i = 0; i < inX * inY; ++i)
+        inData[i] = i / inX;
+    size_t outSize = 0;
+    shared_array<float> outData = ci->interpolateValues(inData, inX * inY, outSize);
+    TEST4FIMEX_REQUIRE_EQ(4, outSize);
+    // weighted by the area on the sphere, not by the latitude range
+    const double expected = (std::sin(1.) - std::sin(0.5)) / std::sin(1.);
+    TEST4FIMEX_CHECK(near(expected, outData[0], 1e-5));
+    TEST4FIMEX_CHECK(near(expected, outData[1], 1e-5));
+}
@@ -225,6 +225,25 @@ TEST4FIMEX_TEST_CASE(interpolator_template)
     }
 }
 
+TEST4FIMEX_TEST_CASE(interpolator_getDataSlices)
+{
+    const string ncFileName(pathTest("erai.sfc.40N.0.75d.200301011200.nc"));
+    const string templateFileName(pathTest("template_noaa17.nc"));
+    CDMReader_p ncReader(CDMFileReaderFactory::create("netcdf", ncFileName));
+    CDMInterpolator_p interpolator = std::make_shared<CDMInterpolator>(ncReader);
+    interpolator->changeProjection(MIFI_INTERPOL_BILINEAR, templateFileName);
+
+    DataSliceRequest_v requests;
+    SliceBuilder sb(interpolator->getCDM(), "ga_skt");
+    requests.push_back(DataSliceRequest("ga_skt", sb));
+    sb.setStartAndSize("x", 2, 5);
+    sb.setStartAndSize("y", 3, 4);
+    requests.push_back(DataSliceRequest("ga_skt", sb));
+    requests.push_back(DataSliceRequest("longitude", SliceBuilder(interpolator->getCDM(), "longitude")));
+    requests.push_back(DataSliceRequest("x", SliceBuilder(interpolator->getCDM(), "x")));
+    TEST4FIMEX_CHECK_EQ(countDataSlicesDifferences(interpolator, requests), 0);
+}
+
 TEST4FIMEX_TEST_CASE(interpolator_latlon)
 {
     double lat[] = {59.109, 59.052, 58.994, 58.934, 58.874, 58.812, 58.749, 58.685, 58.62, 64.};
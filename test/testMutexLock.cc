@@ -0,0 +1,107 @@
+/*
+ * Fimex, testMutexLock.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "../src/MutexLock.h"
+#include "../src/TaskScheduler.h"
+
+#include <atomic>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+LockStatistics findStatistics(const string& site)
+{
+    for (const LockStatistics& s : getLockStatistics()) {
+        if (s.site == site)
+            return s;
+    }
+    LockStatistics empty = {site, 0, 0, 0, 0};
+    return empty;
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_SharedMutex_exclusion)
+{
+    SharedMutex mutex("testMutexLock exclusion");
+    std::atomic<int> readers(0), writers(0);
+    std::atomic<bool> overlap(false);
+    size_t counter = 0;
+    parallelFor(2000, [&](size_t i) {
+        if (i % 10 == 0) {
+            ExclusiveLock lock(mutex);
+            if (++writers != 1 || readers != 0)
+                overlap = true;
+            counter += 1;
+            --writers;
+        } else {
+            SharedLock lock(mutex);
+            ++readers;
+            if (writers != 0)
+                overlap = true;
+            --readers;
+        }
+    });
+    TEST4FIMEX_CHECK(!overlap);
+    TEST4FIMEX_CHECK_EQ(counter, 200);
+}
+
+TEST4FIMEX_TEST_CASE(test_SharedMutex_unlock)
+{
+    SharedMutex mutex("testMutexLock unlock");
+    ExclusiveLock lock(mutex);
+    {
+        ExclusiveUnlock unlock(mutex);
+        SharedLock shared(mutex);
+    }
+}
+
+TEST4FIMEX_TEST_CASE(test_LockStatistics)
+{
+    const bool enabled = isLockStatisticsEnabled();
+    setLockStatisticsEnabled(true);
+    resetLockStatistics();
+
+    SharedMutex mutex("testMutexLock statistics");
+    {
+        ExclusiveLock lock(mutex);
+    }
+    for (int i = 0; i < 3; ++i)
+        SharedLock lock(mutex);
+
+    // locks of one site share the statistics
+    ShardedMutex sharded("testMutexLock statistics", 4);
+    TEST4FIMEX_CHECK(&sharded.get("a.nc") == &sharded.get("a.nc"));
+    ExclusiveLock lock(sharded.get("b.nc"));
+
+    const LockStatistics s = findStatistics("testMutexLock statistics");
+    TEST4FIMEX_CHECK_EQ(s.exclusive, 2);
+    TEST4FIMEX_CHECK_EQ(s.shared, 3);
+    TEST4FIMEX_CHECK_EQ(s.contended, 0);
+
+    resetLockStatistics();
+    TEST4FIMEX_CHECK_EQ(findStatistics("testMutexLock statistics").exclusive, 0);
+    setLockStatisticsEnabled(enabled);
+}
@@ -27,12 +27,83 @@
 #include "testinghelpers.h"
 
 #include "fimex/CDMFileReaderFactory.h"
+#include "fimex/CDM.h"
 #include "fimex/CDMReaderWriter.h"
 #include "fimex/Data.h"
+#include "fimex/Logger.h"
+#include "fimex/NetCDF_CDMWriter.h"
+#include "fimex/SliceBuilder.h"
+
+#include <netcdf.h>
+
+#include <cstdlib>
+#include <mutex>
 
 using namespace std;
 using namespace MetNoFimex;
 
+namespace {
+
+//! logger class recording the messages of all levels, for checking internal decisions
+class RecordingLoggerClass : public LoggerClass
+{
+public:
+    struct Messages
+    {
+        std::mutex mutex;
+        vector<string> messages;
+    };
+
+    explicit RecordingLoggerClass(std::shared_ptr<Messages> messages)
+        : messages_(messages)
+    {
+    }
+
+    LoggerImpl* loggerFor(Logger* logger, const std::string&) override
+    {
+        remember(logger);
+        return new Recorder(messages_);
+    }
+
+private:
+    class Recorder : public LoggerImpl
+    {
+    public:
+        explicit Recorder(std::shared_ptr<Messages> messages)
+            : messages_(messages)
+        {
+        }
+        bool isEnabledFor(Logger::LogLevel) override { return true; }
+        void log(Logger::LogLevel, const std::string& message, const char*, unsigned int) override
+        {
+            std::lock_guard<std::mutex> lock(messages_->mutex);
+            messages_->messages.push_back(message);
+        }
+
+    private:
+        std::shared_ptr<Messages> messages_;
+    };
+
+    std::shared_ptr<Messages> messages_;
+};
+
+//! @return the largest number of requests of varName read at once, from the "ncGetValues for N requests of" debug messages
+size_t maxCoalescedRequests(const vector<string>& messages, const string& varName)
+{
+    const string prefix = "ncGetValues for ", suffix = " requests of " + varName + ":";
+    size_t maxRequests = 0;
+    for (const string& m : messages) {
+        if (m.compare(0, prefix.size(), prefix) != 0)
+            continue;
+        const size_t end = m.find(suffix, prefix.size());
+        if (end != string::npos)
+            maxRequests = std::max<size_t>(maxRequests, std::atoi(m.substr(prefix.size(), end - prefix.size()).c_str()));
+    }
+    return maxRequests;
+}
+
+} // namespace
+
 TEST4FIMEX_TEST_CASE(test_update)
 {
     const string fileName("test_update.nc");
@@ -112,3 +183,83 @@ TEST4FIMEX_TEST_CASE(test_scaled)
         }
     }
 }
+
+TEST4FIMEX_TEST_CASE(test_getDataSlices)
+{
+    const string fileName = pathTestOutput("test_getDataSlices.nc");
+    {
+        CDMReader_p r = CDMFileReaderFactory::create("netcdf", pathTest("test_merge_inner.nc"));
+        NetCDF_CDMWriter(r, fileName, pathTest("ncwriterChunked.xml"));
+    }
+
+    CDMReader_p r = CDMFileReaderFactory::create("netcdf", fileName);
+    TEST4FIMEX_REQUIRE(r);
+    const CDM& cdm = r->getCDM();
+
+    // consecutive parts of a chunk in reverse order, read as one, and a box
+    DataSliceRequest_v requests;
+    const size_t latStart[] = {25, 10, 0}, latSize[] = {16, 15, 10};
+    for (size_t i = 0; i < 3; ++i) {
+        SliceBuilder sb(cdm, "latitude");
+        sb.setStartAndSize("latitude", latStart[i], latSize[i]);
+        requests.push_back(DataSliceRequest("latitude", sb));
+    }
+    SliceBuilder box(cdm, "ga_2t_1");
+    box.setStartAndSize("time", 0, 1);
+    box.setStartAndSize("longitude", 1, 2);
+    box.setStartAndSize("latitude", 1, 2);
+    requests.push_back(DataSliceRequest("ga_2t_1", box));
+    requests.push_back(DataSliceRequest("time", SliceBuilder(cdm, "time")));
+
+    std::shared_ptr<RecordingLoggerClass::Messages> log = std::make_shared<RecordingLoggerClass::Messages>();
+    Logger::setClass(new RecordingLoggerClass(log));
+    const vector<DataPtr> slices = r->getDataSlices(requests);
+    Logger::setClass(Logger::LOG2STDERR);
+    TEST4FIMEX_CHECK(maxCoalescedRequests(log->messages, "latitude") > 1);
+
+    TEST4FIMEX_REQUIRE_EQ(slices.size(), requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        DataPtr expected = r->getDataSlice(requests[i].varName, requests[i].sb);
+        TEST4FIMEX_REQUIRE(slices[i]);
+        TEST4FIMEX_REQUIRE_EQ(slices[i]->size(), expected->size());
+        for (size_t j = 0; j < expected->size(); ++j)
+            TEST4FIMEX_CHECK_EQ(slices[i]->getDouble(j), expected->getDouble(j));
+    }
+}
+
+TEST4FIMEX_TEST_CASE(test_getDataSlices_char)
+{
+    // text in a single chunk, requests which would be coalesced for numbers
+    const string fileName = pathTestOutput("test_getDataSlices_char.nc");
+    {
+        int ncId, dimIds[2], varId;
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_create(fileName.c_str(), NC_CLOBBER | NC_NETCDF4, &ncId));
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_def_dim(ncId, "station", 4, &dimIds[0]));
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_def_dim(ncId, "name_length", 8, &dimIds[1]));
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_def_var(ncId, "name", NC_CHAR, 2, dimIds, &varId));
+        const size_t chunks[2] = {4, 8};
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_def_var_chunking(ncId, varId, NC_CHUNKED, chunks));
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_enddef(ncId));
+        const char names[4 * 8 + 1] = "oslo    bergen  tromso  alta    ";
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_put_var_text(ncId, varId, names));
+        TEST4FIMEX_REQUIRE_EQ(NC_NOERR, nc_close(ncId));
+    }
+
+    CDMReader_p r = CDMFileReaderFactory::create("netcdf", fileName);
+    TEST4FIMEX_REQUIRE(r);
+    DataSliceRequest_v requests;
+    for (size_t station = 0; station < 4; station += 2) {
+        SliceBuilder sb(r->getCDM(), "name");
+        sb.setStartAndSize("station", station, 2);
+        requests.push_back(DataSliceRequest("name", sb));
+    }
+
+    const vector<DataPtr> slices = r->getDataSlices(requests);
+    TEST4FIMEX_REQUIRE_EQ(slices.size(), requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        DataPtr expected = r->getDataSlice(requests[i].varName, requests[i].sb);
+        TEST4FIMEX_REQUIRE(slices[i]);
+        TEST4FIMEX_CHECK_EQ(expected->asString(), slices[i]->asString());
+    }
+    TEST4FIMEX_CHECK_EQ("oslo    bergen  ", slices[0]->asString());
+}
@@ -23,8 +23,11 @@
 
 #include "testinghelpers.h"
 
+#include "fimex/CDM.h"
 #include "fimex/CDMException.h"
 #include "fimex/CDMFileReaderFactory.h"
+#include "fimex/Data.h"
+#include "fimex/MathUtils.h"
 #include "fimex/NetCDF_CDMWriter.h"
 
 #include <memory>
@@ -63,3 +66,29 @@ TEST4FIMEX_TEST_CASE(test_feltNetcdfWriteConfig)
     TEST4FIMEX_CHECK_THROW(writer.getAttribute("surface_snow_thickness", "long_name"), CDMException);
     // "variable '" << var << "' has no attribute '" << att << "', expected exception");
 }
+
+TEST4FIMEX_TEST_CASE(test_netcdfWriteReadAhead)
+{
+    const string fileName = pathTest("coordTest.nc");
+    CDMReader_p reader = CDMFileReaderFactory::create("netcdf", fileName);
+    TEST4FIMEX_REQUIRE(reader);
+
+    const string outFile = "test_netcdfWriteReadAhead.nc";
+    NetCDF_CDMWriter(reader, outFile, pathTest("ncwriterReadAhead.xml"));
+
+    CDMReader_p written = CDMFileReaderFactory::create("netcdf", outFile);
+    for (const CDMVariable& var : reader->getCDM().getVariables()) {
+        const string& varName = var.getName();
+        TEST4FIMEX_REQUIRE(written->getCDM().hasVariable(varName));
+        DataPtr expected = reader->getData(varName);
+        DataPtr actual = written->getData(varName);
+        TEST4FIMEX_REQUIRE_EQ(actual->size(), expected->size());
+        for (size_t i = 0; i < expected->size(); ++i) {
+            const double e = expected->getDouble(i), a = actual->getDouble(i);
+            if (!(e == a || (mifi_isnan(e) && mifi_isnan(a)))) {
+                TEST4FIMEX_CHECK_MESSAGE(false, "variable " << varName << " differs at " << i << ": " << a << " != " << e);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,249 @@
+/*
+ * Fimex, testPointExtractor.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "fimex/CDM.h"
+#include "fimex/CDMPointExtractor.h"
+#include "fimex/Data.h"
+#include "fimex/SliceBuilder.h"
+#include "fimex/interpolation.h"
+
+#include <atomic>
+#include <cmath>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+const size_t NX = 200, NY = 100, NT = 3;
+
+//! lat/lon grid with v(lon,lat,time) = x + 10*y + 1000*time, counting the values read
+class GridReader : public CDMReader
+{
+public:
+    GridReader()
+        : valuesRead(0)
+    {
+        cdm_->addDimension(CDMDimension("lon", NX));
+        cdm_->addDimension(CDMDimension("lat", NY));
+        CDMDimension time("time", NT);
+        time.setUnlimited(true);
+        cdm_->addDimension(time);
+        cdm_->addAttribute(CDM::globalAttributeNS(), CDMAttribute("Conventions", "CF-1.6"));
+
+        addAxis("lon", "longitude", "degrees_east", 0, 0.1);
+        addAxis("lat", "latitude", "degrees_north", 50, 0.1);
+        addAxis("time", "time", "hours since 2026-01-01 00:00:00", 0, 1);
+
+        vector<string> shape;
+        shape.push_back("lon");
+        shape.push_back("lat");
+        shape.push_back("time");
+        cdm_->addVariable(CDMVariable("v", CDM_FLOAT, shape));
+    }
+
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string& varName, size_t unLimDimPos) override
+    {
+        const CDMVariable& var = cdm_->getVariable(varName);
+        if (var.hasData())
+            return getDataSliceFromMemory(var, unLimDimPos);
+        SliceBuilder sb(*cdm_, varName);
+        sb.setStartAndSize("time", unLimDimPos, 1);
+        return getDataSlice(varName, sb);
+    }
+
+    DataPtr getDataSlice(const string& varName, const SliceBuilder& sb) override
+    {
+        const CDMVariable& var = cdm_->getVariable(varName);
+        if (var.hasData())
+            return getDataSliceFromMemory(var, sb);
+        const vector<size_t>& start = sb.getDimensionStartPositions();
+        const vector<size_t>& size = sb.getDimensionSizes();
+        shared_array<float> values(new float[size[0] * size[1] * size[2]]);
+        size_t i = 0;
+        for (size_t t = start[2]; t < start[2] + size[2]; ++t)
+            for (size_t y = start[1]; y < start[1] + size[1]; ++y)
+                for (size_t x = start[0]; x < start[0] + size[0]; ++x)
+                    values[i++] = x + 10. * y + 1000. * t;
+        valuesRead += i;
+        return createData(i, values);
+    }
+
+    std::atomic<size_t> valuesRead;
+
+protected:
+    void addAxis(const string& name, const string& standardName, const string& units, double start, double step)
+    {
+        const size_t n = cdm_->getDimension(name).getLength();
+        CDMVariable var(name, CDM_DOUBLE, vector<string>(1, name));
+        shared_array<double> values(new double[n]);
+        for (size_t i = 0; i < n; ++i)
+            values[i] = start + i * step;
+        var.setData(createData(n, values));
+        cdm_->addVariable(var);
+        cdm_->addAttribute(name, CDMAttribute("standard_name", standardName));
+        cdm_->addAttribute(name, CDMAttribute("units", units));
+    }
+};
+
+//! curvilinear grid with 2d longitude and latitude and v(x,y,time) = x + 10*y + 1000*time
+class CurvilinearReader : public GridReader
+{
+public:
+    CurvilinearReader()
+    {
+        *cdm_ = CDM(); // replace the lat/lon grid
+        cdm_->addDimension(CDMDimension("x", NX));
+        cdm_->addDimension(CDMDimension("y", NY));
+        CDMDimension time("time", NT);
+        time.setUnlimited(true);
+        cdm_->addDimension(time);
+        cdm_->addAttribute(CDM::globalAttributeNS(), CDMAttribute("Conventions", "CF-1.6"));
+
+        addAxis("x", "projection_x_coordinate", "m", 0, 1000);
+        addAxis("y", "projection_y_coordinate", "m", 0, 1000);
+        addAxis("time", "time", "hours since 2026-01-01 00:00:00", 0, 1);
+
+        vector<string> shape;
+        shape.push_back("x");
+        shape.push_back("y");
+        shared_array<double> lon(new double[NX * NY]), lat(new double[NX * NY]);
+        for (size_t y = 0; y < NY; ++y) {
+            for (size_t x = 0; x < NX; ++x) {
+                lon[y * NX + x] = curvilinearLon(x, y);
+                lat[y * NX + x] = curvilinearLat(x, y);
+            }
+        }
+        addLonLat("longitude", "degrees_east", shape, createData(NX * NY, lon));
+        addLonLat("latitude", "degrees_north", shape, createData(NX * NY, lat));
+
+        shape.push_back("time");
+        cdm_->addVariable(CDMVariable("v", CDM_FLOAT, shape));
+        cdm_->addAttribute("v", CDMAttribute("coordinates", "longitude latitude"));
+    }
+
+    //! rotated and sheared grid
+    static double curvilinearLon(double x, double y) { return 10 + 0.1 * x + 0.03 * y; }
+    static double curvilinearLat(double x, double y) { return 50 + 0.1 * y - 0.02 * x; }
+
+private:
+    void addLonLat(const string& name, const string& units, const vector<string>& shape, DataPtr data)
+    {
+        CDMVariable var(name, CDM_DOUBLE, shape);
+        var.setData(data);
+        cdm_->addVariable(var);
+        cdm_->addAttribute(name, CDMAttribute("standard_name", name));
+        cdm_->addAttribute(name, CDMAttribute("units", units));
+    }
+};
+
+vector<double> pointLons()
+{
+    vector<double> lons;
+    lons.push_back(3.05); // x=30.5
+    lons.push_back(12.0); // x=120
+    lons.push_back(40.0); // outside
+    return lons;
+}
+
+vector<double> pointLats()
+{
+    vector<double> lats;
+    lats.push_back(52.05); // y=20.5
+    lats.push_back(55.0);  // y=50
+    lats.push_back(55.0);
+    return lats;
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_pointExtractor_cdm)
+{
+    std::shared_ptr<GridReader> grid = std::make_shared<GridReader>();
+    CDMPointExtractor_p points = std::make_shared<CDMPointExtractor>(grid, MIFI_INTERPOL_NEAREST_NEIGHBOR, pointLons(), pointLats());
+    const CDM& cdm = points->getCDM();
+    TEST4FIMEX_CHECK_EQ(cdm.getDimension("station").getLength(), 3);
+    TEST4FIMEX_CHECK(!cdm.hasDimension("lon"));
+    TEST4FIMEX_CHECK(!cdm.hasDimension("lat"));
+    const vector<string>& shape = cdm.getVariable("v").getShape();
+    TEST4FIMEX_REQUIRE_EQ(shape.size(), 2);
+    TEST4FIMEX_CHECK_EQ(shape[0], "station");
+    TEST4FIMEX_CHECK_EQ(shape[1], "time");
+    TEST4FIMEX_CHECK_EQ(points->getDataSlice("latitude")->getDouble(1), 55.0);
+    TEST4FIMEX_CHECK_EQ(points->getData("time")->size(), NT);
+}
+
+TEST4FIMEX_TEST_CASE(test_pointExtractor_values)
+{
+    std::shared_ptr<GridReader> grid = std::make_shared<GridReader>();
+    CDMPointExtractor_p nearest = std::make_shared<CDMPointExtractor>(grid, MIFI_INTERPOL_NEAREST_NEIGHBOR, pointLons(), pointLats());
+    DataPtr n = nearest->getDataSlice("v", 2);
+    TEST4FIMEX_REQUIRE_EQ(n->size(), 3);
+    TEST4FIMEX_CHECK_EQ(n->getDouble(1), 120 + 10 * 50 + 2000);
+    TEST4FIMEX_CHECK_EQ(n->getDouble(2), nearest->getCDM().getFillValue("v"));
+
+    CDMPointExtractor_p bilinear = std::make_shared<CDMPointExtractor>(grid, MIFI_INTERPOL_BILINEAR, pointLons(), pointLats());
+    grid->valuesRead = 0;
+    DataPtr b = bilinear->getDataSlice("v", 1);
+    TEST4FIMEX_REQUIRE_EQ(b->size(), 3);
+    TEST4FIMEX_CHECK(fabs(b->getDouble(0) - (30.5 + 10 * 20.5 + 1000)) < 0.05);
+    TEST4FIMEX_CHECK(fabs(b->getDouble(1) - (120 + 10 * 50 + 1000)) < 0.05);
+    TEST4FIMEX_CHECK_EQ(b->getDouble(2), bilinear->getCDM().getFillValue("v"));
+    // only the cells around the points are read
+    TEST4FIMEX_CHECK(grid->valuesRead.load() <= 8);
+
+    // all times, only the second station
+    SliceBuilder sb(bilinear->getCDM(), "v");
+    sb.setStartAndSize("station", 1, 1);
+    DataPtr s = bilinear->getDataSlice("v", sb);
+    TEST4FIMEX_REQUIRE_EQ(s->size(), NT);
+    for (size_t t = 0; t < NT; ++t)
+        TEST4FIMEX_CHECK(fabs(s->getDouble(t) - (120 + 10 * 50 + 1000. * t)) < 0.05);
+}
+
+TEST4FIMEX_TEST_CASE(test_pointExtractor_curvilinear)
+{
+    std::shared_ptr<CurvilinearReader> grid = std::make_shared<CurvilinearReader>();
+    vector<double> lons, lats;
+    lons.push_back(CurvilinearReader::curvilinearLon(30.5, 20.5));
+    lats.push_back(CurvilinearReader::curvilinearLat(30.5, 20.5));
+    lons.push_back(CurvilinearReader::curvilinearLon(120, 50));
+    lats.push_back(CurvilinearReader::curvilinearLat(120, 50));
+    lons.push_back(60); // outside
+    lats.push_back(55);
+
+    CDMPointExtractor_p nearest = std::make_shared<CDMPointExtractor>(grid, MIFI_INTERPOL_NEAREST_NEIGHBOR, lons, lats);
+    TEST4FIMEX_CHECK(!nearest->getCDM().hasDimension("x"));
+    DataPtr n = nearest->getDataSlice("v", 2);
+    TEST4FIMEX_REQUIRE_EQ(n->size(), 3);
+    TEST4FIMEX_CHECK_EQ(n->getDouble(1), 120 + 10 * 50 + 2000);
+    TEST4FIMEX_CHECK_EQ(n->getDouble(2), nearest->getCDM().getFillValue("v"));
+
+    CDMPointExtractor_p bilinear = std::make_shared<CDMPointExtractor>(grid, MIFI_INTERPOL_BILINEAR, lons, lats);
+    DataPtr b = bilinear->getDataSlice("v", 1);
+    TEST4FIMEX_REQUIRE_EQ(b->size(), 3);
+    TEST4FIMEX_CHECK(fabs(b->getDouble(0) - (30.5 + 10 * 20.5 + 1000)) < 0.1);
+    TEST4FIMEX_CHECK(fabs(b->getDouble(1) - (120 + 10 * 50 + 1000)) < 0.1);
+    TEST4FIMEX_CHECK_EQ(b->getDouble(2), bilinear->getCDM().getFillValue("v"));
+}
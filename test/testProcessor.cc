@@ -39,6 +39,89 @@
 using namespace std;
 using namespace MetNoFimex;
 
+namespace {
+//! reader with float variables a(x,time) = time+1 and b(x,time) = 2*(time+1), counting reads
+class StepReader : public CDMReader
+{
+public:
+    StepReader()
+        : reads(0)
+    {
+        cdm_->addDimension(CDMDimension("x", 3));
+        CDMDimension time("time", 10);
+        time.setUnlimited(true);
+        cdm_->addDimension(time);
+        vector<string> shape;
+        shape.push_back("x");
+        shape.push_back("time");
+        cdm_->addVariable(CDMVariable("a", CDM_FLOAT, shape));
+        cdm_->addVariable(CDMVariable("b", CDM_FLOAT, shape));
+    }
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string& varName, size_t unLimDimPos) override
+    {
+        reads += 1;
+        const float factor = (varName == "a") ? 1 : 2;
+        shared_array<float> values(new float[3]);
+        for (size_t i = 0; i < 3; ++i)
+            values[i] = factor * (unLimDimPos + 1);
+        return createData(3, values);
+    }
+    int reads;
+};
+
+//! StepReader returning the same slice objects on each read, like a cache
+class CachedStepReader : public StepReader
+{
+public:
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string& varName, size_t unLimDimPos) override
+    {
+        if (slices.empty()) {
+            for (size_t t = 0; t < 10; ++t)
+                slices.push_back(StepReader::getDataSlice(varName, t));
+        }
+        return slices.at(unLimDimPos);
+    }
+    vector<DataPtr> slices;
+};
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_accumulate_interleaved)
+{
+    std::shared_ptr<StepReader> reader = std::make_shared<StepReader>();
+    std::shared_ptr<CDMProcessor> proc = std::make_shared<CDMProcessor>(reader);
+    proc->accumulate("a");
+    proc->deAccumulate("b");
+
+    // time outer, variables inner, as in the netcdf-writer
+    for (size_t t = 0; t < 10; ++t) {
+        DataPtr a = proc->getDataSlice("a", t);
+        TEST4FIMEX_CHECK_EQ(a->asFloat()[1], (t + 1) * (t + 2) / 2);
+        a->setValue(1, -1); // must not modify the running sum
+        DataPtr b = proc->getDataSlice("b", t);
+        TEST4FIMEX_CHECK_EQ(b->asFloat()[2], 2); // b(0) = 2, b(t) - b(t-1) = 2
+    }
+    TEST4FIMEX_CHECK_EQ(reader->reads, 2 * 10);
+
+    // random access restarts from the first time step
+    TEST4FIMEX_CHECK_EQ(proc->getDataSlice("a", 3)->asFloat()[0], 10);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 2 * 10 + 4);
+}
+
+TEST4FIMEX_TEST_CASE(test_accumulate_cached_slices)
+{
+    std::shared_ptr<CachedStepReader> reader = std::make_shared<CachedStepReader>();
+    std::shared_ptr<CDMProcessor> proc = std::make_shared<CDMProcessor>(reader);
+    proc->accumulate("a");
+
+    for (size_t t = 0; t < 10; ++t)
+        TEST4FIMEX_CHECK_EQ(proc->getDataSlice("a", t)->asFloat()[0], (t + 1) * (t + 2) / 2);
+    // the slices of the reader are not modified
+    for (size_t t = 0; t < 10; ++t)
+        TEST4FIMEX_CHECK_EQ(reader->slices[t]->getDouble(0), t + 1);
+}
+
 #ifdef HAVE_NETCDF_H
 TEST4FIMEX_TEST_CASE(test_accumulate)
 {
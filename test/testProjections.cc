@@ -28,6 +28,8 @@
 #include "fimex/coordSys/Projection.h"
 #include "fimex/interpolation.h"
 
+#include "../src/ProjectionCache.h"
+
 #include <algorithm>
 
 #ifndef ACCEPT_USE_OF_DEPRECATED_PROJ_API_H
@@ -209,3 +211,49 @@ TEST4FIMEX_TEST_CASE(test_conversion_geostationary)
         TEST4FIMEX_CHECK(fabs(latValsConv_geos[i] - yVals[i]) < 1e-5);
     }
 }
+
+TEST4FIMEX_TEST_CASE(test_projection_cache)
+{
+    const string proj4stere = "+proj=stere +lat_0=90 +lon_0=-32 +lat_ts=60 +ellps=sphere +a=6371000 +e=0";
+
+    // projections are reused, also with different spacing
+    projPJ pj1 = mifi_proj_acquire(proj4stere.c_str());
+    TEST4FIMEX_REQUIRE(pj1 != 0);
+    mifi_proj_release(pj1);
+    projPJ pj2 = mifi_proj_acquire(" +proj=stere  +lat_0=90 +lon_0=-32 +lat_ts=60 +ellps=sphere +a=6371000 +e=0 ");
+    TEST4FIMEX_CHECK(pj1 == pj2);
+    // the parameter order is significant
+    projPJ pjOrder = mifi_proj_acquire("+lon_0=-32 +proj=stere +lat_0=90 +lat_ts=60 +ellps=sphere +a=6371000 +e=0");
+    TEST4FIMEX_CHECK(pjOrder != 0 && pjOrder != pj2);
+    mifi_proj_release(pjOrder);
+    // but not shared while in use
+    projPJ pj3 = mifi_proj_acquire(proj4stere.c_str());
+    TEST4FIMEX_CHECK(pj3 != 0 && pj3 != pj2);
+    mifi_proj_release(pj2);
+    mifi_proj_release(pj3);
+    mifi_proj_cache_clear();
+
+    TEST4FIMEX_CHECK(mifi_proj_acquire("+proj=no_such_projection") == 0);
+
+    // more values than in one block
+    const size_t n = 10000;
+    vector<double> xVals(n), yVals(n);
+    for (size_t i = 0; i < n; ++i) {
+        xVals[i] = (i % 100) * 50000.;
+        yVals[i] = (i / 100) * 50000.;
+    }
+    vector<double> lonVals(xVals), latVals(yVals);
+    TEST4FIMEX_REQUIRE_EQ(MIFI_OK, mifi_project_values(proj4stere.c_str(), projLonLat.c_str(), &lonVals[0], &latVals[0], n));
+    vector<double> lonValsDeg(xVals), latValsDeg(yVals);
+    TEST4FIMEX_REQUIRE_EQ(MIFI_OK, mifi_project_values_scaled(proj4stere.c_str(), projLonLat.c_str(), &lonValsDeg[0], &latValsDeg[0], n, 1, RAD_TO_DEG));
+    for (size_t i = 0; i < n; ++i) {
+        TEST4FIMEX_CHECK(fabs(lonValsDeg[i] - lonVals[i] * RAD_TO_DEG) < 1e-8);
+        TEST4FIMEX_CHECK(fabs(latValsDeg[i] - latVals[i] * RAD_TO_DEG) < 1e-8);
+    }
+
+    TEST4FIMEX_REQUIRE_EQ(MIFI_OK, mifi_project_values_scaled(projLonLat.c_str(), proj4stere.c_str(), &lonValsDeg[0], &latValsDeg[0], n, DEG_TO_RAD, 1));
+    for (size_t i = 0; i < n; ++i) {
+        TEST4FIMEX_CHECK(fabs(lonValsDeg[i] - xVals[i]) < 1e-3);
+        TEST4FIMEX_CHECK(fabs(latValsDeg[i] - yVals[i]) < 1e-3);
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * Fimex, testTaskScheduler.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "../src/TaskScheduler.h"
+#include "fimex/CDMException.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace std;
+using namespace MetNoFimex;
+
+namespace {
+//! counts the maximum number of concurrent calls
+struct ConcurrencyCounter
+{
+    ConcurrencyCounter()
+        : active(0)
+        , maxActive(0)
+    {
+    }
+    void enter()
+    {
+        const size_t a = ++active;
+        size_t m = maxActive;
+        while (a > m && !maxActive.compare_exchange_weak(m, a)) {
+        }
+    }
+    void leave() { --active; }
+    std::atomic<size_t> active;
+    std::atomic<size_t> maxActive;
+};
+
+void busy()
+{
+    volatile double x = 0;
+    for (int i = 0; i < 20000; ++i)
+        x = x + i;
+}
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_parallelFor)
+{
+    vector<int> visits(1000, 0);
+    parallelFor(visits.size(), [&visits](size_t i) { visits[i] += 1; });
+    for (size_t i = 0; i < visits.size(); ++i)
+        TEST4FIMEX_CHECK_EQ(visits[i], 1);
+
+    vector<int> ranges(1001, 0);
+    std::atomic<size_t> maxRange(0);
+    parallelForRange(ranges.size(), 64, [&](size_t begin, size_t end) {
+        if (end - begin > maxRange)
+            maxRange = end - begin;
+        for (size_t i = begin; i < end; ++i)
+            ranges[i] += 1;
+    });
+    for (size_t i = 0; i < ranges.size(); ++i)
+        TEST4FIMEX_CHECK_EQ(ranges[i], 1);
+    TEST4FIMEX_CHECK_EQ(maxRange.load(), 64);
+
+    parallelFor(0, [](size_t) { TEST4FIMEX_CHECK(false); });
+}
+
+TEST4FIMEX_TEST_CASE(test_parallelFor_nested)
+{
+    // nested loops share the threads of the outer loop
+    const size_t n = 16, m = 64;
+    std::atomic<size_t> sum(0);
+    ConcurrencyCounter counter;
+    parallelFor(n, [&](size_t i) {
+        parallelFor(m, [&](size_t j) {
+            counter.enter();
+            busy();
+            sum += i * m + j;
+            counter.leave();
+        });
+    });
+    TEST4FIMEX_CHECK_EQ(sum.load(), (n * m) * (n * m - 1) / 2);
+    TEST4FIMEX_CHECK(counter.maxActive.load() <= taskThreads());
+}
+
+TEST4FIMEX_TEST_CASE(test_parallelFor_exception)
+{
+    std::atomic<size_t> calls(0);
+    TEST4FIMEX_CHECK_THROW(parallelFor(100,
+                                       [&calls](size_t i) {
+                                           calls += 1;
+                                           if (i == 10)
+                                               throw CDMException("failed");
+                                       }),
+                           CDMException);
+    TEST4FIMEX_CHECK(calls.load() >= 11);
+}
+
+TEST4FIMEX_TEST_CASE(test_taskStageThreads)
+{
+    setTaskStageThreads(TASK_STAGE_READ, 1);
+    TEST4FIMEX_CHECK_EQ(getTaskStageThreads(TASK_STAGE_READ), 1);
+    TEST4FIMEX_CHECK_EQ(taskThreads(TASK_STAGE_READ), 1);
+
+    ConcurrencyCounter counter;
+    parallelFor(
+        32,
+        [&counter](size_t) {
+            counter.enter();
+            busy();
+            counter.leave();
+        },
+        TASK_STAGE_READ);
+    TEST4FIMEX_CHECK_EQ(counter.maxActive.load(), 1);
+
+    setTaskStageThreads(TASK_STAGE_READ, 0);
+    TEST4FIMEX_CHECK_EQ(taskThreads(TASK_STAGE_READ), taskThreads());
+}
+
+TEST4FIMEX_TEST_CASE(test_TaskGroup)
+{
+    vector<int> results(3, 0);
+    TaskGroup group;
+    for (size_t i = 0; i < results.size(); ++i)
+        group.run([&results, i]() { results[i] = static_cast<int>(i) + 1; });
+    group.wait();
+    TEST4FIMEX_CHECK_EQ(results[0], 1);
+    TEST4FIMEX_CHECK_EQ(results[2], 3);
+
+    group.run([]() { throw CDMException("failed"); });
+    TEST4FIMEX_CHECK_THROW(group.wait(), CDMException);
+
+    // tasks already run are not repeated
+    group.wait();
+}
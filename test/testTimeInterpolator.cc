@@ -31,10 +31,146 @@
 #include "fimex/CDMTimeInterpolator.h"
 #include "fimex/Data.h"
 #include "fimex/Logger.h"
+#include "fimex/SliceBuilder.h"
 
 using namespace std;
 using namespace MetNoFimex;
 
+namespace {
+//! reader with v(x,time) = 10*time + x, time is not the unlimited dimension
+class TimeSeriesReader : public CDMReader
+{
+public:
+    TimeSeriesReader()
+        : reads(0)
+    {
+        cdm_->addAttribute(cdm_->globalAttributeNS(), CDMAttribute("Conventions", "CF-1.6"));
+        cdm_->addDimension(CDMDimension("x", 4));
+        cdm_->addDimension(CDMDimension("time", 3));
+
+        cdm_->addVariable(CDMVariable("x", CDM_FLOAT, vector<string>(1, "x")));
+        cdm_->addAttribute("x", CDMAttribute("standard_name", "projection_x_coordinate"));
+        cdm_->addAttribute("x", CDMAttribute("units", "m"));
+        shared_array<float> xValues(new float[4]);
+        for (size_t i = 0; i < 4; ++i)
+            xValues[i] = i;
+        cdm_->getVariable("x").setData(createData(4, xValues));
+
+        cdm_->addVariable(CDMVariable("time", CDM_DOUBLE, vector<string>(1, "time")));
+        cdm_->addAttribute("time", CDMAttribute("units", "hours since 2000-01-01 00:00:00"));
+        shared_array<double> timeValues(new double[3]);
+        for (size_t i = 0; i < 3; ++i)
+            timeValues[i] = 3 * i;
+        cdm_->getVariable("time").setData(createData(3, timeValues));
+
+        vector<string> shape;
+        shape.push_back("x");
+        shape.push_back("time");
+        cdm_->addVariable(CDMVariable("v", CDM_FLOAT, shape));
+    }
+    using CDMReader::getDataSlice;
+    DataPtr getDataSlice(const string& varName, size_t unLimDimPos) override
+    {
+        const CDMVariable& variable = cdm_->getVariable(varName);
+        if (variable.hasData())
+            return getDataSliceFromMemory(variable, unLimDimPos);
+        shared_array<float> values(new float[4 * 3]);
+        for (size_t t = 0; t < 3; ++t)
+            for (size_t i = 0; i < 4; ++i)
+                values[t * 4 + i] = 10 * t + i;
+        return createData(4 * 3, values);
+    }
+    DataPtr getDataSlice(const string& varName, const SliceBuilder& sb) override
+    {
+        reads += 1;
+        return CDMReader::getDataSlice(varName, sb);
+    }
+    int reads;
+};
+} // namespace
+
+TEST4FIMEX_TEST_CASE(test_timeInterpolatorSliceBuilder)
+{
+    std::shared_ptr<TimeSeriesReader> reader = std::make_shared<TimeSeriesReader>();
+    std::shared_ptr<CDMTimeInterpolator> timeInterpol = std::make_shared<CDMTimeInterpolator>(reader);
+    timeInterpol->changeTimeAxis("0,1.5,...,6;unit=hours since 2000-01-01 00:00:00");
+    TEST4FIMEX_CHECK_EQ(timeInterpol->getCDM().getDimension("time").getLength(), 5);
+
+    // x = 1 and 2 at all times, each input time is read once
+    SliceBuilder sb(timeInterpol->getCDM(), "v");
+    sb.setStartAndSize("x", 1, 2);
+    DataPtr data = timeInterpol->getDataSlice("v", sb);
+    TEST4FIMEX_CHECK_EQ(reader->reads, 3);
+    TEST4FIMEX_REQUIRE_EQ(data->size(), 2 * 5);
+    const float expected[] = {1, 2, 6, 7, 11, 12, 16, 17, 21, 22};
+    shared_array<float> values = data->asFloat();
+    for (size_t i = 0; i < 10; ++i)
+        TEST4FIMEX_CHECK_EQ(values[i], expected[i]);
+
+    // single output time
+    sb.setStartAndSize("time", 3, 1);
+    DataPtr data3 = timeInterpol->getDataSlice("v", sb);
+    TEST4FIMEX_REQUIRE_EQ(data3->size(), 2);
+    TEST4FIMEX_CHECK_EQ(data3->asFloat()[1], 17);
+
+    // time is not the unlimited dimension, all times are returned
+    DataPtr all = timeInterpol->getDataSlice("v", 0);
+    TEST4FIMEX_REQUIRE_EQ(all->size(), 4 * 5);
+    TEST4FIMEX_CHECK_EQ(all->asFloat()[4 * 4 + 3], 23);
+}
+
+TEST4FIMEX_TEST_CASE(test_timeInterpolatorTimeWindow)
+{
+    for (int batch = 0; batch < 2; ++batch) {
+        std::shared_ptr<TimeSeriesReader> reader = std::make_shared<TimeSeriesReader>();
+        std::shared_ptr<CDMTimeInterpolator> timeInterpol = std::make_shared<CDMTimeInterpolator>(reader);
+        timeInterpol->changeTimeAxis("0,0.5,...,6;unit=hours since 2000-01-01 00:00:00");
+        timeInterpol->setBatchMode(batch);
+
+        // one output time-step per request, each input time is read once
+        SliceBuilder sb(timeInterpol->getCDM(), "v");
+        sb.setStartAndSize("x", 3, 1);
+        for (size_t t = 0; t < 13; ++t) {
+            sb.setStartAndSize("time", t, 1);
+            DataPtr data = timeInterpol->getDataSlice("v", sb);
+            TEST4FIMEX_REQUIRE_EQ(data->size(), 1);
+            TEST4FIMEX_CHECK_CLOSE(data->asFloat()[0], 3 + t * 10 / 6., 1e-4);
+        }
+        TEST4FIMEX_CHECK_EQ(reader->reads, 3);
+
+        // the window is dropped after the last time-step
+        timeInterpol->getDataSlice("v", sb);
+        TEST4FIMEX_CHECK_EQ(reader->reads, 5);
+    }
+
+    // cache too small for both input time-steps
+    {
+        std::shared_ptr<TimeSeriesReader> reader = std::make_shared<TimeSeriesReader>();
+        std::shared_ptr<CDMTimeInterpolator> timeInterpol = std::make_shared<CDMTimeInterpolator>(reader);
+        timeInterpol->changeTimeAxis("0,0.5,...,6;unit=hours since 2000-01-01 00:00:00");
+        timeInterpol->setTimeWindowCacheSize(sizeof(float));
+        SliceBuilder sb(timeInterpol->getCDM(), "v");
+        sb.setStartAndSize("x", 3, 1);
+        for (size_t t = 0; t < 13; ++t) {
+            sb.setStartAndSize("time", t, 1);
+            TEST4FIMEX_CHECK_CLOSE(timeInterpol->getDataSlice("v", sb)->asFloat()[0], 3 + t * 10 / 6., 1e-4);
+        }
+        TEST4FIMEX_CHECK(reader->reads > 3);
+    }
+
+    // without cache, two reads per output time-step
+    std::shared_ptr<TimeSeriesReader> reader = std::make_shared<TimeSeriesReader>();
+    std::shared_ptr<CDMTimeInterpolator> timeInterpol = std::make_shared<CDMTimeInterpolator>(reader);
+    timeInterpol->changeTimeAxis("0,0.5,...,6;unit=hours since 2000-01-01 00:00:00");
+    timeInterpol->setTimeWindowCacheSize(0);
+    SliceBuilder sb(timeInterpol->getCDM(), "v");
+    for (size_t t = 0; t < 13; ++t) {
+        sb.setStartAndSize("time", t, 1);
+        timeInterpol->getDataSlice("v", sb);
+    }
+    TEST4FIMEX_CHECK_EQ(reader->reads, 2 * 13);
+}
+
 #if defined(HAVE_FELT) && defined(HAVE_NETCDF_H)
 TEST4FIMEX_TEST_CASE(test_timeInterpolator)
 {
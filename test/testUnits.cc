@@ -31,6 +31,7 @@
 #include "testinghelpers.h"
 
 #include <cmath>
+#include <limits>
 
 using namespace std;
 using namespace MetNoFimex;
@@ -82,6 +83,37 @@ TEST4FIMEX_TEST_CASE(test_LogUnit)
     TEST4FIMEX_CHECK_CLOSE(conv->convert(1000.), 11.512925, 1e-5);
 }
 
+TEST4FIMEX_TEST_CASE(test_UnitsConvertArray)
+{
+    Units units;
+    const double fill = -999.;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double in[] = {273.15, fill, nan, 283.15};
+    double out[4];
+
+    UnitsConverter_p lin = units.getConverter("K", "Celsius");
+    lin->convert(in, out, 4, fill);
+    TEST4FIMEX_CHECK_CLOSE(out[0], 0, 1e-6);
+    TEST4FIMEX_CHECK_EQ(out[1], fill);
+    TEST4FIMEX_CHECK(std::isnan(out[2]));
+    TEST4FIMEX_CHECK_CLOSE(out[3], 10, 1e-6);
+
+    UnitsConverter_p log = units.getConverter("hPa", "ln(re 1Pa)");
+    const float fin[] = {1000.f, -1.f, 1000.f};
+    float fout[3];
+    log->convert(fin, fout, 3, -1.f);
+    TEST4FIMEX_CHECK_CLOSE(fout[0], 11.512925, 1e-4);
+    TEST4FIMEX_CHECK_EQ(fout[1], -1.f);
+    TEST4FIMEX_CHECK_CLOSE(fout[2], 11.512925, 1e-4);
+
+    // in-place
+    double inout[] = {1000., fill, 1000.};
+    log->convert(inout, inout, 3, fill);
+    TEST4FIMEX_CHECK_CLOSE(inout[0], 11.512925, 1e-5);
+    TEST4FIMEX_CHECK_EQ(inout[1], fill);
+    TEST4FIMEX_CHECK_CLOSE(inout[2], 11.512925, 1e-5);
+}
+
 TEST4FIMEX_TEST_CASE(test_TimeUnit)
 {
     TimeUnit tu("seconds since 1970-01-01 01:00:00");
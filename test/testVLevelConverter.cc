@@ -249,3 +249,44 @@ TEST4FIMEX_TEST_CASE(test_pressure_integrator_up)
     TEST4FIMEX_CHECK_CLOSE(5000, va[4], 1);
     TEST4FIMEX_CHECK_CLOSE(5000, va[5], 1);
 }
+
+TEST4FIMEX_TEST_CASE(test_vertical_interpolator_getDataSlices)
+{
+    CDMReader_p ncreader(CDMFileReaderFactory::create("netcdf", pathTest("testdata_arome_vc.nc")));
+    std::shared_ptr<CDMVerticalInterpolator> reader = std::make_shared<CDMVerticalInterpolator>(ncreader, "pressure", "log");
+    reader->interpolateToFixed(std::vector<double>{1000, 850, 500, 300});
+
+    DataSliceRequest_v requests;
+    SliceBuilder sb(reader->getCDM(), "air_temperature_ml");
+    sb.setStartAndSize("time", 0, 1);
+    requests.push_back(DataSliceRequest("air_temperature_ml", sb));
+    sb.setStartAndSize("x", 1, 2);
+    sb.setStartAndSize("pressure", 1, 2);
+    requests.push_back(DataSliceRequest("air_temperature_ml", sb));
+    requests.push_back(DataSliceRequest("pressure", SliceBuilder(reader->getCDM(), "pressure")));
+    requests.push_back(DataSliceRequest("x", SliceBuilder(reader->getCDM(), "x")));
+    TEST4FIMEX_CHECK_EQ(countDataSlicesDifferences(reader, requests), 0);
+}
+
+TEST4FIMEX_TEST_CASE(test_vertical_interpolator_slicebuilder)
+{
+    CDMReader_p ncreader(CDMFileReaderFactory::create("netcdf", pathTest("testdata_arome_vc.nc")));
+    std::shared_ptr<CDMVerticalInterpolator> reader = std::make_shared<CDMVerticalInterpolator>(ncreader, "pressure", "log");
+    reader->interpolateToFixed(std::vector<double>{1000, 850, 500, 300});
+
+    SliceBuilder sb(reader->getCDM(), "air_temperature_ml");
+    sb.setStartAndSize("x", 1, 2);
+    sb.setStartAndSize("y", 0, 1);
+    sb.setStartAndSize("pressure", 1, 2);
+    sb.setStartAndSize("time", 0, 1);
+    DataPtr data = reader->getDataSlice("air_temperature_ml", sb);
+    TEST4FIMEX_REQUIRE(data);
+
+    // complete variable, cut by the same slice-builder
+    DataPtr all = reader->getData("air_temperature_ml");
+    DataPtr expected = all->slice(sb.getMaxDimensionSizes(), sb.getDimensionStartPositions(), sb.getDimensionSizes());
+    TEST4FIMEX_REQUIRE_EQ(data->size(), expected->size());
+    shared_array<double> values = data->asDouble(), expectedValues = expected->asDouble();
+    for (size_t i = 0; i < data->size(); ++i)
+        TEST4FIMEX_CHECK_CLOSE(values[i], expectedValues[i], 1e-4);
+}
@@ -0,0 +1,104 @@
+/*
+ * Fimex, testVerticalInterpolationPlan.cc
+ *
+ * (C) Copyright 2026, met.no
+ *
+ * Project Info:  https://wiki.met.no/fimex/start
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "testinghelpers.h"
+
+#include "../src/VerticalInterpolationPlan.h"
+#include "fimex/FindNeighborElements.h"
+#include "fimex/interpolation.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+using namespace MetNoFimex;
+
+TEST4FIMEX_TEST_CASE(test_findVerticalNeighbors)
+{
+    const float increasing[] = {10, 20, 30, 50, 80, 100};
+    const float decreasing[] = {1000, 900, 850, 700, 500, 300, 100};
+    const float unordered[] = {500, 1000, 300, 700};
+    TEST4FIMEX_CHECK_EQ(verticalProfileOrder(increasing, 6), 1);
+    TEST4FIMEX_CHECK_EQ(verticalProfileOrder(decreasing, 7), -1);
+    TEST4FIMEX_CHECK_EQ(verticalProfileOrder(unordered, 4), 0);
+
+    const float xs[] = {0, 10, 15, 20, 49, 50, 99.5, 100, 120, 300, 600, 850, 999, 1000, 1200};
+    for (float x : xs) {
+        const pair<size_t, size_t> expI = find_closest_neighbor_distinct_elements(increasing, increasing + 6, x);
+        TEST4FIMEX_CHECK_MESSAGE(findVerticalNeighbors(increasing, 6, 1, x) == expI, "increasing x=" << x);
+        const pair<size_t, size_t> expD = find_closest_neighbor_distinct_elements(decreasing, decreasing + 7, x);
+        TEST4FIMEX_CHECK_MESSAGE(findVerticalNeighbors(decreasing, 7, -1, x) == expD, "decreasing x=" << x);
+    }
+
+    // x at the first level
+    const pair<size_t, size_t> first = findVerticalNeighbors(increasing, 6, 1, 10);
+    TEST4FIMEX_CHECK_EQ(first.first, 0);
+    TEST4FIMEX_CHECK_EQ(first.second, 1);
+}
+
+TEST4FIMEX_TEST_CASE(test_verticalInterpolationWeight)
+{
+    typedef int (*intFunc_t)(const float*, const float*, float*, const size_t, const double, const double, const double);
+    const mifi_vertical_interpol_method methods[] = {MIFI_VINT_METHOD_LIN,           MIFI_VINT_METHOD_LIN_WEAK_EXTRA, MIFI_VINT_METHOD_LIN_NO_EXTRA,
+                                                     MIFI_VINT_METHOD_LIN_CONST_EXTRA, MIFI_VINT_METHOD_LOG,           MIFI_VINT_METHOD_LOGLOG,
+                                                     MIFI_VINT_METHOD_NN};
+    const intFunc_t functions[] = {mifi_get_values_linear_f,
+                                   mifi_get_values_linear_weak_extrapol_f,
+                                   mifi_get_values_linear_no_extrapol_f,
+                                   mifi_get_values_linear_const_extrapol_f,
+                                   mifi_get_values_log_f,
+                                   mifi_get_values_log_log_f,
+                                   mifi_get_values_nearest_f};
+    const float valueA = 3, valueB = 7;
+    const double xs[] = {100, 200, 250, 300, 350, 500, 1000};
+    for (size_t m = 0; m < 7; m++) {
+        for (double x : xs) {
+            float expected;
+            functions[m](&valueA, &valueB, &expected, 1, 200, 300, x);
+            const float w = verticalInterpolationWeight(methods[m], 200, 300, x);
+            const float value = (w == 0) ? valueA : ((w == 1) ? valueB : valueA + w * (valueB - valueA));
+            TEST4FIMEX_CHECK_MESSAGE(value == expected || (std::isnan(value) && std::isnan(expected)),
+                                     "method=" << methods[m] << " x=" << x << " have " << value << " expected " << expected);
+        }
+    }
+}
+
+TEST4FIMEX_TEST_CASE(test_VerticalInterpolationPlan)
+{
+    // 2 columns, 3 input levels (z slowest), 2 output levels
+    const float in[] = {1, 10, 2, 20, 3, 30};
+    VerticalInterpolationPlan plan(2, 2, 2, 2);
+    plan.setColumn(0, 0, 0);
+    plan.setColumn(1, 1, 1);
+    plan.setLevel(0, 0, 0, 1, 0.5);
+    plan.setLevel(1, 0, 1, 2, 1);
+    plan.setLevel(0, 1, 2, 1, 0);
+    plan.setUndefined(1, 1);
+
+    vector<float> out(4);
+    plan.apply(in, &out[0]);
+    TEST4FIMEX_CHECK_EQ(out[0], 1.5);
+    TEST4FIMEX_CHECK_EQ(out[1], 30);
+    TEST4FIMEX_CHECK_EQ(out[2], 3);
+    TEST4FIMEX_CHECK(std::isnan(out[3]));
+}
@@ -38,6 +38,8 @@
 #include "testinghelpers.h"
 
 #include "fimex/CDMFileReaderFactory.h"
+#include "fimex/Data.h"
+#include "fimex/MathUtils.h"
 
 #include <stdexcept>
 #include <fstream>
@@ -51,6 +53,8 @@ const string src_share_etc(TOP_SRCDIR "/share/etc/");
 const string src_test(TOP_SRCDIR "/test/");
 
 const string extra_data_dir(TEST_EXTRADATA_DIR "/");
+
+const string output_dir(TEST_OUTPUT_DIR "/");
 } // namespace
 
 namespace MetNoFimex {
@@ -101,6 +105,11 @@ string pathTestExtra(const std::string& filename)
     return require(extra_data_dir + filename);
 }
 
+string pathTestOutput(const std::string& filename)
+{
+    return output_dir + filename;
+}
+
 bool hasTestExtra()
 {
     return exists(extra_data_dir + "flth00.dat");
@@ -123,4 +132,24 @@ bool writeToFile(CDMReader_p input, const std::string& fileName)
 #endif /* NETCDF */
 }
 
+size_t countDataSlicesDifferences(CDMReader_p reader, const DataSliceRequest_v& requests)
+{
+    const std::vector<DataPtr> slices = reader->getDataSlices(requests);
+    if (slices.size() != requests.size())
+        return requests.size();
+    size_t differences = 0;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        DataPtr expected = reader->getDataSlice(requests[i].varName, requests[i].sb);
+        bool same = (slices[i]->size() == expected->size());
+        if (same) {
+            shared_array<double> actualValues = slices[i]->asDouble(), expectedValues = expected->asDouble();
+            for (size_t j = 0; same && j < expected->size(); ++j)
+                same = (actualValues[j] == expectedValues[j]) || (mifi_isnan(actualValues[j]) && mifi_isnan(expectedValues[j]));
+        }
+        if (!same)
+            differences += 1;
+    }
+    return differences;
+}
+
 } // namespace MetNoFimex
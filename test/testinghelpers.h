@@ -32,6 +32,7 @@
 #ifndef FIMEX_TESTINGHELPERS_H
 #define FIMEX_TESTINGHELPERS_H 1
 
+#include "fimex/CDMReader.h"
 #include "fimex/CDMReaderDecl.h"
 
 #include <string>
@@ -53,11 +54,17 @@ std::string pathTest(const std::string& filename);
 bool hasTestExtra();
 std::string pathTestExtra(const std::string& filename);
 
+/*! Path for files written by the tests, in the test build directory. */
+std::string pathTestOutput(const std::string& filename);
+
 void copyFile(const std::string& from, const std::string& to);
 
 /*! Write to netcdf file, if compiledwith netcdf support, else "write" to null file. */
 bool writeToFile(CDMReader_p input, const std::string& fileName);
 
+/*! Number of requests where CDMReader::getDataSlices gives other data than one CDMReader::getDataSlice call per request. */
+size_t countDataSlicesDifferences(CDMReader_p reader, const DataSliceRequest_v& requests);
+
 } // namespace MetNoFimex
 
 #ifdef HAVE_BOOST_UNIT_TEST_FRAMEWORK